@@ -4,6 +4,10 @@ if (ENABLE_OPENMP)
     find_package(OpenMP COMPONENTS CXX REQUIRED)
 endif ()
 
+if (ENABLE_THREAD_POOL)
+    find_package(Threads REQUIRED)
+endif ()
+
 if ((NOT BUILDING_RUNTIME) OR ENABLE_VULKAN_RUNTIME)
     find_package(Vulkan REQUIRED)
 endif ()
@@ -554,6 +554,17 @@ struct op_writer<nncase::runtime::stackvm::stpaddings_op_t>
     }
 };
 
+template <>
+struct op_writer<nncase::runtime::stackvm::ldshape_op_t>
+{
+    void operator()(const nncase::runtime::stackvm::ldshape_op_t &op, binary_writer &writer) const
+    {
+        writer.write(static_cast<uint8_t>(op.opcode));
+        writer.write(op.rshape);
+        writer.write(op.index);
+    }
+};
+
 template <>
 struct op_writer<nncase::runtime::stackvm::dup_op_t>
 {
@@ -1566,6 +1577,7 @@ public:
     void ldarg_5_();
     void stshape_(uint8_t rshape, uint8_t rank);
     void stpaddings_(uint8_t rpaddings, uint8_t rank);
+    void ldshape_(uint8_t rshape, uint32_t index);
     void dup_();
     void pop_();
     void neg_();
@@ -41,10 +41,14 @@ struct compile_options
     bool is_fpga;
     bool use_dataset_as_input_stat = false;
     bool benchmark_only = false;
+    bool min_peak_memory_order = false;
+    uint32_t calibrate_threads = 1;
     bool preprocess = false;
     bool swapRB = false;
     std::string target;
     std::filesystem::path dump_dir;
+    std::filesystem::path cache_dir;
+    uint64_t cache_max_size = 1ULL << 30;
     std::string input_type = "default";
     std::string output_type = "float32";
     std::string quant_type = "uint8";
@@ -13,14 +13,21 @@
  * limitations under the License.
  */
 #pragma once
+#include <condition_variable>
+#include <deque>
+#include <exception>
 #include <filesystem>
 #include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <nncase/io_utils.h>
 #include <nncase/runtime/datatypes.h>
 #include <optional>
 #include <span>
 #include <string>
 #include <string_view>
+#include <thread>
 #include <xtensor/xarray.hpp>
 #include <xtensor/xshape.hpp>
 
@@ -33,8 +40,63 @@ struct data_batch
     std::span<const std::filesystem::path> filenames;
 };
 
+/**
+ * @brief Loads samples [0, count) in order on worker threads, at most `slots` of them ahead of the consumer.
+ *
+ * `load(index, slot)` fills slot `slot` with sample `index`. The consumer waits for a sample with acquire()
+ * and hands its slot back with release().
+ */
+class NNCASE_API sample_prefetcher
+{
+public:
+    sample_prefetcher(size_t count, size_t slots, std::function<void(size_t index, size_t slot)> load);
+    sample_prefetcher(const sample_prefetcher &) = delete;
+    sample_prefetcher &operator=(const sample_prefetcher &) = delete;
+    ~sample_prefetcher();
+
+    // Twice the hardware threads, clamped to 1..4 threads: 2 slots on one thread up to 8 from four on.
+    static size_t default_slots() noexcept;
+
+    // Index of the next sample acquire() can return.
+    size_t next() const noexcept { return next_acquire_; }
+    // Blocks until sample `next()` is loaded and returns its slot. Rethrows the error if loading it failed,
+    // throws std::out_of_range once all `count` samples have been acquired.
+    size_t acquire();
+    void release(size_t slot);
+
+private:
+    void stop() noexcept;
+    void worker_main();
+
+private:
+    size_t count_;
+    std::function<void(size_t index, size_t slot)> load_;
+    std::mutex mutex_;
+    std::condition_variable worker_cv_;
+    std::condition_variable ready_cv_;
+    std::deque<size_t> free_slots_;
+    std::map<size_t, size_t> ready_;
+    std::map<size_t, std::exception_ptr> errors_;
+    size_t next_load_ = 0;
+    size_t next_acquire_ = 0;
+    bool stop_ = false;
+    std::vector<std::thread> workers_;
+};
+
 class NNCASE_API dataset
 {
+    struct prefetch_state_base
+    {
+        virtual ~prefetch_state_base() = default;
+    };
+
+    template <class T>
+    struct prefetch_state : prefetch_state_base
+    {
+        std::vector<xt::xarray<T>> slots;
+        xt::xarray<T> spare;
+    };
+
 public:
     template <class T>
     class iterator
@@ -50,6 +112,8 @@ public:
 
         iterator &operator++()
         {
+            if (value_)
+                dataset_->recycle<T>(std::move(value_->tensor));
             value_ = dataset_->batch<T>(from_ + dataset_->batch_size());
             if (value_)
                 from_ += dataset_->batch_size();
@@ -100,6 +164,7 @@ public:
     template <class T>
     iterator<T> begin()
     {
+        start_prefetch<T>();
         return { *this, 0 };
     }
 
@@ -118,7 +183,36 @@ protected:
     virtual void process(const std::vector<uint8_t> &src, int8_t *dest, const xt::dynamic_shape<size_t> &shape, std::string layout) = 0;
     virtual bool do_normalize() const noexcept { return true; }
 
+    // Prefetch workers call process(), derived classes stop them before they are destroyed.
+    void stop_prefetch() noexcept { prefetcher_.reset(); }
+
 private:
+    template <class T>
+    void start_prefetch()
+    {
+        stop_prefetch();
+
+        auto state = std::make_unique<prefetch_state<T>>();
+        auto slots = std::min(sample_prefetcher::default_slots(), filenames_.size());
+        for (size_t i = 0; i < slots; i++)
+            state->slots.emplace_back(input_shape_);
+
+        auto s = state.get();
+        prefetch_state_ = std::move(state);
+        prefetcher_ = std::make_unique<sample_prefetcher>(filenames_.size(), slots, [this, s](size_t index, size_t slot) {
+            auto &tensor = s->slots[slot];
+            auto file = read_file(filenames_[index]);
+            process(file, tensor.data(), tensor.shape(), input_layout_);
+        });
+    }
+
+    template <class T>
+    void recycle(xt::xarray<T> &&tensor)
+    {
+        if (auto state = dynamic_cast<prefetch_state<T> *>(prefetch_state_.get()))
+            state->spare = std::move(tensor);
+    }
+
     template <class T>
     std::optional<data_batch<T>> batch(size_t from)
     {
@@ -126,9 +220,26 @@ private:
         {
             size_t start = from;
 
-            xt::xarray<T> batch(input_shape_);
-            auto file = read_file(filenames_[from++]);
-            process(file, batch.data(), batch.shape(), input_layout_);
+            xt::xarray<T> batch;
+            auto state = prefetcher_ ? dynamic_cast<prefetch_state<T> *>(prefetch_state_.get()) : nullptr;
+            if (state && prefetcher_->next() == from)
+            {
+                // Hand out the loaded slot and refill it with the buffer of the previous sample.
+                auto slot = prefetcher_->acquire();
+                batch = std::move(state->slots[slot]);
+                if (state->spare.size() == batch.size())
+                    state->slots[slot] = std::move(state->spare);
+                else
+                    state->slots[slot] = xt::xarray<T>(input_shape_);
+                prefetcher_->release(slot);
+                from++;
+            }
+            else
+            {
+                batch = xt::xarray<T>(input_shape_);
+                auto file = read_file(filenames_[from++]);
+                process(file, batch.data(), batch.shape(), input_layout_);
+            }
 
             std::span<const std::filesystem::path> filenames(filenames_.data() + start, filenames_.data() + from);
 
@@ -142,12 +253,15 @@ private:
     std::vector<std::filesystem::path> filenames_;
     xt::dynamic_shape<size_t> input_shape_;
     std::string input_layout_;
+    std::unique_ptr<prefetch_state_base> prefetch_state_;
+    std::unique_ptr<sample_prefetcher> prefetcher_;
 };
 
 class NNCASE_API image_dataset : public dataset
 {
 public:
     image_dataset(const std::filesystem::path &path, xt::dynamic_shape<size_t> input_shape, std::string input_layout);
+    ~image_dataset() override { stop_prefetch(); }
 
 protected:
     void process(const std::vector<uint8_t> &src, float *dest, const xt::dynamic_shape<size_t> &shape, std::string layout) override;
@@ -159,6 +273,7 @@ class NNCASE_API raw_dataset : public dataset
 {
 public:
     raw_dataset(const std::filesystem::path &path, xt::dynamic_shape<size_t> input_shape);
+    ~raw_dataset() override { stop_prefetch(); }
 
 protected:
     void process(const std::vector<uint8_t> &src, float *dest, const xt::dynamic_shape<size_t> &shape, std::string layout) override;
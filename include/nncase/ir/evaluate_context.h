@@ -38,6 +38,10 @@ class NNCASE_API function_evaluate_context
 {
 public:
     function_evaluate_context(const schedule::function_schedule_result &sched, module_evaluate_context &mod_eval);
+
+    // Evaluates single nodes on buffers bound by the caller, without a schedule.
+    // Bound buffers are dense and laid out as their connector's shape.
+    function_evaluate_context() noexcept;
     function_evaluate_context(const function_evaluate_context &) = delete;
     function_evaluate_context(function_evaluate_context &&) = default;
 
@@ -63,13 +67,17 @@ public:
         return memory_at(*outputs_[index]);
     }
 
-    module_evaluate_context &module() const noexcept { return mod_eval_; }
+    module_evaluate_context &module() const noexcept { return *mod_eval_; }
+
+    void bind(const output_connector &conn, std::span<std::byte> buffer);
 
     void evaluate(eval_step step, size_t stage, bool record_output_buffers);
+    void evaluate(ir::node &node);
 
 private:
-    const schedule::function_schedule_result &sched_;
-    module_evaluate_context &mod_eval_;
+    const schedule::function_schedule_result *sched_;
+    module_evaluate_context *mod_eval_;
+    std::unordered_map<const output_connector *, std::span<std::byte>> bindings_;
     std::unique_ptr<std::byte[]> input_pool_;
     std::unique_ptr<std::byte[]> output_pool_;
 
@@ -93,6 +101,7 @@ public:
     void enable_ptq(target &target, ir::calibrate_method calib_method);
     void begin_collect_distribution();
     void end_sample();
+    void merge_quantizer(module_evaluate_context &other);
     void end_collect_distribution(const std::function<void(size_t cnt, size_t total)> &progress);
 
 private:
@@ -144,6 +153,7 @@ public:
     void enable_ptq(nncase::target &target, ir::calibrate_method calib_method);
     void begin_collect_distribution();
     void end_sample();
+    void merge_quantizers(model_evaluate_context &other);
     void end_collect_distribution(const std::function<void(size_t cnt, size_t total)> &progress);
 
     void evaluate(eval_step step, size_t stage, bool record_output_buffers);
@@ -31,6 +31,7 @@ public:
     ir::quantizer *quantizer(const module_type_t &module_type);
     void begin_collect_distribution();
     void end_sample();
+    void merge_quantizers(evaluator &other);
     void end_collect_distribution(const std::function<void(size_t cnt, size_t total)> &progress);
 
     evaluate_tensor memory_at(const output_connector &conn);
@@ -52,6 +52,7 @@ public:
     void attributes(node_attributes value) noexcept { attributes_ = value; }
 
     bool equals(node &other) const;
+    size_t hash() const;
 
     void record_output_connectors_quant_map(output_connector &oc_after_quant, output_connector &oc_before_quant) noexcept { output_connectors_quant_map_.emplace(&oc_after_quant, &oc_before_quant); }
     std::unordered_map<output_connector *, output_connector *> get_output_connectors_quant_map() const noexcept { return output_connectors_quant_map_; }
@@ -77,6 +78,7 @@ protected:
     }
 
     virtual bool properties_equal(node &other) const = 0;
+    virtual size_t properties_hash() const;
 
 private:
     std::string name_;
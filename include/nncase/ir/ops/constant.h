@@ -17,6 +17,7 @@
 #include "../node.h"
 #include "../op_utils.h"
 #include <nncase/runtime/debug.h>
+#include <optional>
 #include <vector>
 
 namespace nncase::ir
@@ -132,10 +133,12 @@ public:
 
 protected:
     bool properties_equal(node &other) const override;
+    size_t properties_hash() const override;
 
 private:
     std::vector<std::byte> data_;
     datatype_t datatype_;
     size_t alignment_ = 8;
+    mutable std::optional<size_t> data_hash_;
 };
 }
@@ -47,10 +47,13 @@ class NNCASE_API quantizer
         void record(std::span<const float> data);
         void record(std::span<const bfloat16> data);
         void record(std::span<const half> data);
+        void merge(const histogram &other);
         void finish();
+        value_range<float> range() const noexcept { return range_; }
         value_range<float> optimal_range() const noexcept { return optimal_range_; }
 
     private:
+        std::vector<uint64_t> src_counts_;
         std::vector<float> src_bins_;
         std::vector<float> dest_bins_;
         value_range<float> range_;
@@ -136,6 +139,7 @@ public:
     void end_collect_distribution(std::function<void(size_t cnt, size_t total)> progress);
     size_t histograms_count() const noexcept { return histograms_.size(); }
     void end_sample() { has_record_.clear(); }
+    void merge(const quantizer &other);
     std::unordered_map<ir::output_connector *, std::vector<float>> output_buffers() const noexcept { return output_buffers_; }
     std::vector<ir::output_connector *> quant_buffers_insert_order() const noexcept { return quant_buffers_insert_order_; }
     std::unordered_map<ir::output_connector *, value_range<float>> ranges() const noexcept { return quant_ranges_; }
@@ -13,15 +13,127 @@
  * limitations under the License.
  */
 #pragma once
+#include <atomic>
+#include <memory>
 #include <nncase/runtime/result.h>
+#include <type_traits>
 
 BEGIN_NS_NNCASE_KERNELS
 
+class thread_pool;
+class weights_cache;
+
 struct NNCASE_API kernel_context
 {
     uint32_t num_threads;
+
+    // Intra-op workers used by parallel_for, see shared_thread_pool. When it is
+    // missing or has another size, parallel_for looks up the shared pool itself.
+    std::shared_ptr<thread_pool> pool;
+
+    // Memory that stays unchanged while this context is in use, e.g. a module's .rdata.
+    // Weights read from here may be transformed once and kept in `weights`.
+    const void *constants_begin = nullptr;
+    const void *constants_end = nullptr;
+
+    // Transformed constant weights. Contexts reading the same constants, e.g. the
+    // interpreters of one compiled model, should share one cache.
+    std::shared_ptr<weights_cache> weights;
 };
 
 NNCASE_API kernel_context &default_kernel_context();
 
-END_NS_NNCASE_KERNELS
\ No newline at end of file
+/**
+ * @brief Returns the process-wide pool of `threads` workers, created on first use.
+ *
+ * Every context asking for the same size shares its workers, so interpreters running side by side don't
+ * oversubscribe the CPU; a pool already running work leaves later callers to run inline. Returns nullptr
+ * when threads are unavailable.
+ */
+NNCASE_API std::shared_ptr<thread_pool> shared_thread_pool(uint32_t threads) noexcept;
+
+/** @brief Creates an empty cache for kernel_context::weights, or nullptr when memory runs out. */
+NNCASE_API std::shared_ptr<weights_cache> make_weights_cache() noexcept;
+
+/**
+ * @brief Type-erased reference to a parallel_for body. The callable must outlive the call.
+ */
+class parallel_body
+{
+public:
+    template <class Callable, class = std::enable_if_t<!std::is_same_v<std::decay_t<Callable>, parallel_body>>>
+    parallel_body(Callable &&callable) noexcept
+        : obj_(const_cast<void *>(static_cast<const void *>(std::addressof(callable))))
+        , invoke_([](void *obj, size_t begin, size_t end) {
+            (*static_cast<std::remove_reference_t<Callable> *>(obj))(begin, end);
+        })
+    {
+    }
+
+    void operator()(size_t begin, size_t end) const noexcept
+    {
+        invoke_(obj_, begin, end);
+    }
+
+private:
+    void *obj_;
+    void (*invoke_)(void *obj, size_t begin, size_t end);
+};
+
+/**
+ * @brief Runs body(begin, end) over disjoint sub-ranges covering [0, count) on the context's thread pool.
+ *
+ * Sub-ranges hold at least `grain` items (except the last one). Idle workers steal from busy ones, so
+ * uneven tiles balance out. Nested calls and calls on a context with a single thread run inline.
+ */
+NNCASE_API void parallel_for(kernel_context &context, size_t count, size_t grain, const parallel_body &body) noexcept;
+
+template <class Callable>
+void parallel_for(kernel_context &context, size_t count, Callable &&body) noexcept
+{
+    parallel_for(context, count, 1, parallel_body(body));
+}
+
+/**
+ * @brief parallel_for over a body returning result<void>. Returns the first error reported by any sub-range.
+ */
+template <class Callable>
+result<void> try_parallel_for(kernel_context &context, size_t count, size_t grain, Callable &&body) noexcept
+{
+    std::atomic<bool> failed { false };
+    std::error_condition error;
+    auto guarded = [&](size_t begin, size_t end) {
+        if (failed.load(std::memory_order_relaxed))
+            return;
+        auto ret = body(begin, end);
+        if (ret.is_err() && !failed.exchange(true))
+            error = ret.unwrap_err();
+    };
+
+    parallel_for(context, count, grain, parallel_body(guarded));
+    if (failed.load())
+        return err(error);
+    return ok();
+}
+
+namespace detail
+{
+NNCASE_API const float *cached_weights(kernel_context &context, const void *weights, size_t weights_bytes, size_t size,
+    void *fill, void (*invoke)(void *fill, float *out)) noexcept;
+}
+
+/**
+ * @brief Returns `size` floats computed by fill(out) from the weights at `weights`, computing them only on the first call.
+ *
+ * Results are kept only when the context has a weights cache and the weights lie inside its constants. Returns nullptr
+ * otherwise or when memory runs out, then the caller transforms them itself.
+ */
+template <class Fill>
+const float *cached_weights(kernel_context &context, const void *weights, size_t weights_bytes, size_t size, Fill &&fill) noexcept
+{
+    return detail::cached_weights(context, weights, weights_bytes, size, std::addressof(fill), [](void *obj, float *out) {
+        (*static_cast<std::remove_reference_t<Fill> *>(obj))(out);
+    });
+}
+
+END_NS_NNCASE_KERNELS
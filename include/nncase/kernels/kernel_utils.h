@@ -249,6 +249,14 @@ constexpr T quantize(float value, const quant_param_t &param) noexcept
     return (T)clamp((int32_t)lrintf(value / param.scale + param.zero_point), (int32_t)std::numeric_limits<T>::lowest(), (int32_t)std::numeric_limits<T>::max());
 }
 
+// Items of `item_size` elements to hand each parallel_for chunk, so that
+// scheduling costs stay small next to the work.
+inline size_t parallel_grain(size_t item_size) noexcept
+{
+    constexpr size_t chunk_elements = 16384;
+    return std::max(size_t(1), chunk_elements / std::max(item_size, size_t(1)));
+}
+
 inline std::pair<float, float> get_resize_scales(const runtime_shape_t &in_shape, int32_t out_h, int32_t out_w, bool align_corners)
 {
     auto height_scale = (float)in_shape[2] / out_h;
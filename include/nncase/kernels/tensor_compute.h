@@ -62,7 +62,7 @@ template <typename T>
 NNCASE_API result<void> matmul(const T *input_a, const T *input_b, const T *bias, T *output,
     const runtime_shape_t &in_a_shape, const runtime_shape_t &in_a_strides, const runtime_shape_t &in_b_shape,
     const runtime_shape_t &in_b_strides, const runtime_shape_t &out_shape, const runtime_shape_t &out_strides,
-    value_range<float> fused_activation) noexcept;
+    value_range<float> fused_activation, kernel_context &context = default_kernel_context()) noexcept;
 
 NNCASE_API result<void> onehot(datatype_t type, const int32_t *indices, gsl::byte *output, const runtime_shape_t &indices_shape, const runtime_shape_t &out_shape,
     const runtime_shape_t &out_strides, gsl::byte *depth, gsl::byte *off_value, gsl::byte *on_value, size_t axis, onehot_mode_t mode,
@@ -91,7 +91,7 @@ NNCASE_API result<void> reduce_arg(reduce_arg_op_t op, const float *input, T *ou
 template <typename T>
 result<void> reduce_prod(const T *input, T *output, const runtime_shape_t &in_shape,
     const runtime_shape_t &in_strides, const runtime_shape_t &out_strides,
-    const runtime_shape_t &axes, bool keep_dims) noexcept;
+    const runtime_shape_t &axes, bool keep_dims, kernel_context &context = default_kernel_context()) noexcept;
 
 NNCASE_API result<void> resize_bilinear(datatype_t type, const gsl::byte *input, gsl::byte *output, const runtime_shape_t &in_shape,
     const runtime_shape_t &in_strides, const runtime_shape_t &out_strides, int32_t out_h, int32_t out_w, bool align_corners, bool half_pixel_centers,
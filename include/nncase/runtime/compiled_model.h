@@ -0,0 +1,111 @@
+/* Copyright 2019-2021 Canaan Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+#include "model.h"
+#include "result.h"
+#include <functional>
+#include <gsl/gsl-lite.hpp>
+#include <memory>
+#include <vector>
+
+BEGIN_NS_NNCASE_RUNTIME
+
+class mapped_file;
+
+/**
+ * @brief Hints for compiled_model::load_from_file. Platforms that can't honor a hint ignore it.
+ */
+struct model_file_options
+{
+    // Start reading the whole file in the background (MADV_WILLNEED).
+    bool prefetch = false;
+    // Back the mapping with transparent huge pages (MADV_HUGEPAGE).
+    bool huge_pages = false;
+};
+
+/**
+ * @brief Read-only state a runtime module derives from its payload, such as decoded code or parsed tables.
+ *        It is built by the first interpreter that loads the module and shared by every later one.
+ */
+class NNCASE_API module_shared_state
+{
+public:
+    virtual ~module_shared_state() = default;
+};
+
+using module_shared_state_factory = std::function<result<std::shared_ptr<const module_shared_state>>()>;
+
+/**
+ * @brief A validated kmodel that is loaded once and shared, read-only, by any number of interpreters.
+ *
+ * Weights (.rdata) and code (.text) are read in place from the model buffer, so every interpreter
+ * loaded from the same compiled_model only allocates its own data pool, registers and I/O bindings.
+ * A compiled_model is immutable and may be used from several threads at once.
+ */
+class NNCASE_API compiled_model
+{
+public:
+    /**
+     * @brief Loads a model that reads from `buffer` in place. The buffer must outlive the model
+     *        and every interpreter created from it.
+     */
+    static result<std::shared_ptr<const compiled_model>> load(gsl::span<const gsl::byte> buffer) noexcept;
+
+    /**
+     * @brief Loads a model that owns its buffer.
+     */
+    static result<std::shared_ptr<const compiled_model>> load(std::vector<gsl::byte> buffer) noexcept;
+
+    /**
+     * @brief Loads a model by mapping the kmodel file read-only. Sections are read straight from
+     *        the mapping, so processes serving the same file share its pages through the page cache.
+     *        Platforms without mmap read the file into memory instead.
+     */
+    static result<std::shared_ptr<const compiled_model>> load_from_file(const char *path, const model_file_options &options = {}) noexcept;
+
+    compiled_model(const compiled_model &) = delete;
+    compiled_model &operator=(const compiled_model &) = delete;
+    ~compiled_model();
+
+    const model_header &header() const noexcept { return header_; }
+    gsl::span<const gsl::byte> buffer() const noexcept { return buffer_; }
+
+    size_t modules_size() const noexcept { return module_payloads_.size(); }
+    const module_type_t &module_type(size_t index) const noexcept;
+    gsl::span<const gsl::byte> module_payload(size_t index) const noexcept;
+
+    /**
+     * @brief Returns the shared state of module `index`, calling `create` to build it if no interpreter has yet.
+     *        A failed build is not kept, so the next load tries again.
+     */
+    result<std::shared_ptr<const module_shared_state>> module_state(size_t index, const module_shared_state_factory &create) const noexcept;
+
+private:
+    struct module_states;
+
+    compiled_model();
+
+    result<void> parse(gsl::span<const gsl::byte> buffer) noexcept;
+
+private:
+    std::vector<gsl::byte> storage_;
+    std::unique_ptr<mapped_file> mapping_;
+    gsl::span<const gsl::byte> buffer_;
+    model_header header_ {};
+    std::vector<gsl::span<const gsl::byte>> module_payloads_;
+    std::unique_ptr<module_states> module_states_;
+};
+
+END_NS_NNCASE_RUNTIME
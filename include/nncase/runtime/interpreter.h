@@ -14,15 +14,23 @@
  */
 #pragma once
 #include "allocator.h"
+#include "compiled_model.h"
 #include "model.h"
+#include "profiler.h"
 #include "result.h"
 #include "runtime_module.h"
+#include <functional>
 #include <gsl/gsl-lite.hpp>
 #include <memory>
+#include <nncase/kernels/kernel_context.h>
+#include <string>
 #include <unordered_map>
+#include <vector>
 
 BEGIN_NS_NNCASE_RUNTIME
 
+class host_executor;
+
 class NNCASE_API options_dict
 {
 public:
@@ -44,7 +52,18 @@ public:
     }
 
 private:
-    std::unordered_map<const char *, scalar> values_;
+    std::unordered_map<std::string, scalar> values_;
+};
+
+struct NNCASE_API batch_run_stats
+{
+    // Wall time of each sample in milliseconds, in input order.
+    std::vector<double> latencies;
+    // Wall time of the whole batch in milliseconds.
+    double total = 0;
+
+    // Samples per second.
+    double throughput() const noexcept { return total > 0 ? latencies.size() * 1000.0 / total : 0; }
 };
 
 class NNCASE_API interpreter
@@ -52,10 +71,23 @@ class NNCASE_API interpreter
 public:
     interpreter() noexcept;
     interpreter(interpreter &) = delete;
-    interpreter(interpreter &&) = default;
+    interpreter(interpreter &&) noexcept;
+    ~interpreter();
 
     NNCASE_NODISCARD result<void> load_model(gsl::span<const gsl::byte> buffer) noexcept;
 
+    /**
+     * @brief Maps the kmodel file read-only and loads it without copying. See compiled_model::load_from_file.
+     */
+    NNCASE_NODISCARD result<void> load_model_from_file(const char *path, const model_file_options &options = {}) noexcept;
+
+    /**
+     * @brief Creates this interpreter's execution state (data pool, registers and I/O bindings)
+     *        over a shared compiled model. Interpreters loaded from the same model may run concurrently.
+     */
+    NNCASE_NODISCARD result<void> load_model(std::shared_ptr<const compiled_model> model) noexcept;
+    const std::shared_ptr<const compiled_model> &model() const noexcept;
+
     size_t inputs_size() const noexcept;
     size_t outputs_size() const noexcept;
     const memory_range &input_desc(size_t index) const noexcept;
@@ -69,13 +101,66 @@ public:
 
     result<void> run() noexcept;
 
+    /**
+     * @brief Queues a run and returns immediately. Runs execute one at a time in submission order on a host
+     *        worker thread (inline when built without thread support), then `callback` is called on that thread
+     *        with the run's result. The callback must not throw.
+     *
+     * Combine with double_buffered(true) to fill the next inputs while the current run executes. In that mode
+     * run_async() first waits for the previous run, so one run is in flight while the other buffers are filled.
+     * Without it, bound tensors must not be touched until the callback fires. run(), run_batch() and
+     * load_model() wait for queued runs first.
+     */
+    result<void> run_async(std::function<void(result<void>)> callback) noexcept;
+
+    /**
+     * @brief Blocks until every queued run has completed and its callback has returned.
+     */
+    void wait() noexcept;
+
+    /**
+     * @brief Switches the entry function to double-buffered bindings. See runtime_function::double_buffered.
+     */
+    void double_buffered(bool enable) noexcept;
+    bool double_buffered() const noexcept;
+
+    /**
+     * @brief Runs the model over independent samples.
+     *
+     * `inputs` holds inputs_size() tensors per sample and `outputs` holds outputs_size() tensors per sample,
+     * sample-major. Every tensor is checked once up front, so a bad sample fails the batch before anything runs.
+     * With the `batch_instances` option above 1, samples are split across that many instances sharing this
+     * interpreter's compiled model and run concurrently. Otherwise they run in order on this interpreter.
+     * Afterwards this interpreter stays bound to the tensors of the last sample it ran.
+     */
+    result<void> run_batch(gsl::span<const runtime_tensor> inputs, gsl::span<const runtime_tensor> outputs, batch_run_stats *stats = nullptr) noexcept;
+
     result<runtime_module *> find_module_by_id(size_t index) noexcept;
+    // Recognized keys:
+    //   num_threads (int32_t): intra-op threads used by kernels of this interpreter.
+    //   batch_instances (int32_t): interpreter instances run_batch spreads samples across, 1 by default.
+    //   profile (int32_t): non-zero to record every executed instruction into profiler().
     options_dict &options() noexcept;
 
+    /**
+     * @brief Per-instruction records of runs made while the `profile` option is set. Records accumulate
+     *        across runs until cleared. Records of run_batch instances are merged in after each batch.
+     */
+    op_profiler &profiler() noexcept;
+
+private:
+    result<void> check_batch_tensors(gsl::span<const runtime_tensor> tensors, size_t count, bool is_input) noexcept;
+    result<void> prepare_batch_instances(size_t count) noexcept;
+
 private:
+    std::shared_ptr<const compiled_model> model_;
     std::vector<std::unique_ptr<runtime_module>> modules_;
     runtime_function *entry_function_;
     options_dict options_;
+    op_profiler profiler_;
+    std::vector<std::unique_ptr<interpreter>> batch_instances_;
+    kernels::kernel_context batch_context_;
+    std::unique_ptr<host_executor> executor_;
 };
 
 END_NS_NNCASE_RUNTIME
@@ -0,0 +1,99 @@
+/* Copyright 2019-2021 Canaan Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+#include "datatypes.h"
+#include "result.h"
+#include <chrono>
+#include <iosfwd>
+#include <vector>
+
+BEGIN_NS_NNCASE_RUNTIME
+
+/**
+ * @brief Timing of one executed instruction. Ops that report details also carry
+ *        their datatype, shapes, bytes touched and estimated arithmetic work.
+ */
+struct op_profile_record
+{
+    const char *name;
+    // Byte offset of the instruction in its function's .text.
+    uintptr_t pc;
+    // Microseconds since the profiler was last cleared.
+    double start;
+    double duration;
+    // Interpreter that ran the instruction: 0 for the profiled one, i for its run_batch instance i.
+    uint32_t thread = 0;
+
+    bool has_details = false;
+    datatype_t datatype = dt_float32;
+    runtime_shape_t in_shape;
+    runtime_shape_t out_shape;
+    uint64_t bytes = 0;
+    uint64_t flops = 0;
+};
+
+/**
+ * @brief Per-instruction profiler of an interpreter, enabled through the `profile` option.
+ *
+ * Records are appended by the thread running the interpreter, so read or export them only
+ * once runs have finished.
+ */
+class NNCASE_API op_profiler
+{
+public:
+    op_profiler() noexcept;
+
+    const std::vector<op_profile_record> &records() const noexcept { return records_; }
+    void clear() noexcept;
+
+    void begin(const char *name, uintptr_t pc) noexcept;
+    void end() noexcept;
+
+    /**
+     * @brief Attaches details to the instruction being recorded.
+     *
+     * `bytes` counts inputs and outputs touched; `flops` counts arithmetic ops, a multiply-add being two.
+     */
+    void details(datatype_t datatype, const runtime_shape_t &in_shape, const runtime_shape_t &out_shape, uint64_t bytes, uint64_t flops) noexcept;
+
+    /**
+     * @brief Adds the records of `other` as `thread`, moved onto this profiler's clock and kept in start order.
+     */
+    NNCASE_NODISCARD result<void> merge(const op_profiler &other, uint32_t thread) noexcept;
+
+    /**
+     * @brief Writes the records as Chrome trace events (chrome://tracing, Perfetto).
+     */
+    void write_chrome_trace(std::ostream &stream) const;
+    void write_csv(std::ostream &stream) const;
+
+    /**
+     * @brief Writes the total time, count and share of each op type, slowest first.
+     */
+    void write_summary(std::ostream &stream) const;
+
+    result<void> save_chrome_trace(const char *path) const noexcept;
+    result<void> save_csv(const char *path) const noexcept;
+
+private:
+    double now() const noexcept;
+
+private:
+    std::chrono::steady_clock::time_point epoch_;
+    std::vector<op_profile_record> records_;
+    bool recording_ = false;
+};
+
+END_NS_NNCASE_RUNTIME
@@ -62,6 +62,13 @@ namespace nncase
             return nncase::err(std::move(v.unwrap_err())); \
     }
 
+// Binds name to the object pointed to by a result<T *> without copying it.
+#define try_ref(name, x)                                        \
+    auto name##_ptr = (x);                                      \
+    if (!name##_ptr.is_ok())                                    \
+        return nncase::err(std::move(name##_ptr.unwrap_err())); \
+    auto &name = *name##_ptr.unwrap();
+
 template <class T>
 struct Ok
 {
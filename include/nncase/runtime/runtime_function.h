@@ -16,6 +16,7 @@
 #include "model.h"
 #include "result.h"
 #include "runtime_tensor.h"
+#include <mutex>
 
 BEGIN_NS_NNCASE_RUNTIME
 
@@ -41,6 +42,10 @@ private:
         runtime_tensor bind_tensor;
         runtime_tensor staging_tensor;
         runtime_tensor device_tensor;
+        // Double-buffered mode only: the binding the next invoke() picks up,
+        // and the outputs of the last completed invoke().
+        runtime_tensor next_tensor;
+        runtime_tensor done_tensor;
     };
 
 public:
@@ -66,6 +71,33 @@ public:
 
     result<void> invoke() noexcept;
 
+    /**
+     * @brief Binds one tensor per input and output, rebinding only those that changed since the last call, then invokes.
+     */
+    result<void> invoke(gsl::span<const runtime_tensor> inputs, gsl::span<const runtime_tensor> outputs) noexcept;
+
+    /**
+     * @brief Same as invoke(inputs, outputs), for tensors whose count, datatype and shape the caller has already checked.
+     */
+    result<void> invoke_prechecked(gsl::span<const runtime_tensor> inputs, gsl::span<const runtime_tensor> outputs) noexcept;
+
+    /**
+     * @brief Enables or disables double-buffered bindings, dropping any staged ones.
+     *
+     * When enabled, the input/output setters and the input getter address a back buffer, so the next frame can
+     * be written while the current one runs. swap_buffers() hands it to the following invoke(). Back buffers left
+     * unbound are allocated on demand, so each input and output alternates between two tensors. The output getter
+     * returns the outputs of the last completed invoke(), which stay untouched until the invoke after next.
+     */
+    void double_buffered(bool enable) noexcept;
+    bool double_buffered() const noexcept;
+
+    /**
+     * @brief Makes the back buffers the bindings of the next invoke() and hands the previous ones back.
+     *        Must not overlap invoke().
+     */
+    result<void> swap_buffers() noexcept;
+
 protected:
     virtual result<void> initialize_core(runtime_function_init_context &context) noexcept = 0;
     virtual result<runtime_tensor> allocate_input_tensor(size_t index) noexcept = 0;
@@ -76,11 +108,18 @@ protected:
     result<runtime_tensor> device_output_tensor(size_t index) noexcept;
     virtual result<void> invoke_core() noexcept = 0;
 
+private:
+    result<void> bind_input_tensor(size_t index, runtime_tensor tensor) noexcept;
+    result<void> bind_output_tensor(size_t index, runtime_tensor tensor) noexcept;
+
 private:
     function_header header_;
     std::vector<inout_tensor_info> input_tensors_;
     std::vector<inout_tensor_info> output_tensors_;
     runtime_module &rt_module_;
+    bool double_buffered_ = false;
+    // Guards next_tensor and done_tensor, which callers touch while invoke() runs on another thread.
+    std::mutex buffers_lock_;
 };
 
 END_NS_NNCASE_RUNTIME
@@ -13,6 +13,7 @@
  * limitations under the License.
  */
 #pragma once
+#include "compiled_model.h"
 #include "model.h"
 #include "result.h"
 #include "runtime_function.h"
@@ -28,6 +29,12 @@ struct NNCASE_API runtime_module_init_context
     virtual interpreter &interp() noexcept = 0;
     virtual const module_header &header() noexcept = 0;
     virtual gsl::span<const gsl::byte> section(const char *name) noexcept = 0;
+
+    /**
+     * @brief State of this module shared by every interpreter loaded from the same compiled_model.
+     *        See compiled_model::module_state.
+     */
+    virtual result<std::shared_ptr<const module_shared_state>> shared_state(const module_shared_state_factory &create) noexcept = 0;
 };
 
 class NNCASE_API runtime_module
@@ -40,7 +47,10 @@ public:
     virtual ~runtime_module() = default;
     runtime_module &operator=(const runtime_module &) = delete;
 
-    result<void> initialize(gsl::span<const gsl::byte> payload, interpreter &interp) noexcept;
+    /**
+     * @brief Loads module `index` of the interpreter's compiled model.
+     */
+    result<void> initialize(size_t index, interpreter &interp) noexcept;
     const module_type_t &type() const noexcept;
 
     interpreter &interp() const noexcept { return *interp_; }
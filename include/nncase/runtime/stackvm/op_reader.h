@@ -16,9 +16,11 @@
  */
 #pragma once
 #include "../error.h"
+#include "../profiler.h"
 #include "../result.h"
 #include "../span_reader.h"
 #include "opcode.h"
+#include <vector>
 
 BEGIN_NS_NNCASE_RT_MODULE(stackvm)
 
@@ -670,6 +672,19 @@ struct op_reader<stpaddings_op_t>
     }
 };
 
+template <>
+struct op_reader<ldshape_op_t>
+{
+    ldshape_op_t operator()(span_reader &reader) const
+    {
+        ldshape_op_t op(default_init);
+        op.opcode = static_cast<opcode_t>(reader.read_unaligned<uint8_t>());
+        op.rshape = reader.read_unaligned<uint8_t>();
+        op.index = reader.read_unaligned<uint32_t>();
+        return op;
+    }
+};
+
 template <>
 struct op_reader<dup_op_t>
 {
@@ -1766,17 +1781,65 @@ struct op_reader<tensor_tflite_detection_postprocess_op_t>
     }
 };
 
+class op_visitor;
+
+/**
+ * @brief .text decoded once into operand structs and pre-resolved visit handlers, so
+ *        repeated runs dispatch without re-parsing the bytecode.
+ */
+class NNCASE_API decoded_text
+{
+public:
+    result<void> decode(gsl::span<const gsl::byte> text) noexcept;
+
+    size_t size() const noexcept { return instructions_.size(); }
+    const char *name(size_t index) const noexcept { return instructions_[index].name; }
+
+    result<void> invoke(op_visitor &visitor, size_t index) const noexcept
+    {
+        auto &inst = instructions_[index];
+        return inst.handler(visitor, operands_.data() + inst.operand);
+    }
+
+    /** @brief Byte offset of the instruction at index, or the .text size for index == size(). */
+    uintptr_t offset(size_t index) const noexcept
+    {
+        return index < instructions_.size() ? instructions_[index].offset : text_size_;
+    }
+
+    /** @brief Index of the instruction starting at the given byte offset. */
+    result<size_t> index(uintptr_t offset) const noexcept;
+
+private:
+    struct instruction
+    {
+        result<void> (*handler)(op_visitor &visitor, const gsl::byte *op) noexcept;
+        const char *name;
+        uint32_t offset;
+        uint32_t operand;
+    };
+
+    template <class TOp>
+    void append(const TOp &op, const char *name, uintptr_t offset);
+
+private:
+    std::vector<instruction> instructions_;
+    std::vector<gsl::byte> operands_;
+    size_t text_size_ = 0;
+};
+
 class NNCASE_API op_visitor
 {
 public:
     op_visitor() noexcept
-        : reader_({})
+        : reader_({}), decoded_(nullptr), ip_(0), profiler_(nullptr)
     {
     }
 
     ~op_visitor() = default;
 
     result<void> visit(gsl::span<const gsl::byte> text) noexcept;
+    result<void> visit(const decoded_text &text) noexcept;
 
     virtual result<void> visit(NNCASE_UNUSED const nop_op_t &op) noexcept { return ok(); }
     virtual result<void> visit(NNCASE_UNUSED const br_op_t &op) noexcept { return ok(); }
@@ -1835,6 +1898,7 @@ public:
     virtual result<void> visit(NNCASE_UNUSED const ldarg_5_op_t &op) noexcept { return ok(); }
     virtual result<void> visit(NNCASE_UNUSED const stshape_op_t &op) noexcept { return ok(); }
     virtual result<void> visit(NNCASE_UNUSED const stpaddings_op_t &op) noexcept { return ok(); }
+    virtual result<void> visit(NNCASE_UNUSED const ldshape_op_t &op) noexcept { return ok(); }
     virtual result<void> visit(NNCASE_UNUSED const dup_op_t &op) noexcept { return ok(); }
     virtual result<void> visit(NNCASE_UNUSED const pop_op_t &op) noexcept { return ok(); }
     virtual result<void> visit(NNCASE_UNUSED const neg_op_t &op) noexcept { return ok(); }
@@ -1913,9 +1977,13 @@ public:
 protected:
     bool interrupted_;
     span_reader reader_;
+    const decoded_text *decoded_;
+    size_t ip_;
+    // Records every visited instruction when set.
+    op_profiler *profiler_;
 
 private:
-    result<void> next() noexcept;
+    result<void> next(uintptr_t pc) noexcept;
 };
 
 END_NS_NNCASE_RT_MODULE
@@ -118,6 +118,7 @@ enum class opcode_t
     THROW = 0x5C,
     BREAK = 0x5D,
     TENSOR = 0x5E,
+    LDSHAPE = 0x5F,
 };
 
 enum class tensor_function_t
@@ -812,6 +813,19 @@ struct stpaddings_op_t
     }
 };
 
+struct ldshape_op_t
+{
+    opcode_t opcode;
+    uint8_t rshape;
+    uint32_t index;
+
+    ldshape_op_t(default_init_t) noexcept { }
+    explicit ldshape_op_t(uint8_t rshape, uint32_t index) noexcept
+        : opcode(opcode_t::LDSHAPE), rshape(rshape), index(index)
+    {
+    }
+};
+
 struct dup_op_t
 {
     opcode_t opcode;
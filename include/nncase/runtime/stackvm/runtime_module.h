@@ -18,7 +18,8 @@
 BEGIN_NS_NNCASE_RT_MODULE(stackvm)
 
 NNCASE_INLINE_VAR constexpr module_type_t stackvm_module_type = to_module_type("stackvm");
-NNCASE_INLINE_VAR constexpr uint32_t stackvm_module_version = 1;
+NNCASE_INLINE_VAR constexpr uint32_t stackvm_module_version = 2;
+NNCASE_INLINE_VAR constexpr char SHAPE_SECTION_NAME[] = ".shape";
 
 NNCASE_API result<std::unique_ptr<runtime_module>> create_stackvm_runtime_module();
 
@@ -19,7 +19,9 @@
 #include <nncase/ir/ir_types.h>
 #include <nncase/runtime/datatypes.h>
 #include <optional>
+#include <ostream>
 #include <unordered_map>
+#include <vector>
 
 namespace nncase::schedule
 {
@@ -36,6 +38,7 @@ public:
     virtual void base_offset(size_t value) = 0;
     virtual void mark(const physical_buffer &buffer) = 0;
     virtual void finish() = 0;
+    virtual void dump(std::ostream &writer) const;
     size_t max_usage() const noexcept { return max_usage_; }
     const std::unordered_map<const physical_buffer *, allocated_buffer> &allocations() const noexcept { return allocations_; }
 
@@ -72,6 +75,32 @@ private:
     std::vector<const physical_buffer *> living_buffers_;
 };
 
+/**
+ * @brief Assigns offsets once all buffers are marked, using the whole lifetime table.
+ *
+ * Buffers are placed largest first, each into the tightest gap left by the buffers it lives with.
+ * A first fit in birth order is planned too and kept instead if it needs less memory.
+ */
+class NNCASE_API greedy_by_size_allocator : public buffer_allocator
+{
+public:
+    greedy_by_size_allocator(std::optional<size_t> fixed_size = std::nullopt);
+
+    void base_offset(size_t value) override;
+    void mark(const physical_buffer &buffer) override;
+    void finish() override;
+    void dump(std::ostream &writer) const override;
+
+private:
+    size_t plan(std::vector<allocated_buffer> &allocs, bool best_fit) const;
+
+private:
+    std::optional<size_t> fixed_size_;
+    std::vector<const physical_buffer *> buffers_;
+    size_t greedy_usage_ = 0;
+    size_t first_fit_usage_ = 0;
+};
+
 using allocator_map_t = std::unordered_map<memory_location_t, buffer_allocator *>;
 using shared_allocator_map_t = std::unordered_map<module_type_t, buffer_allocator *>;
 }
@@ -29,6 +29,9 @@ public:
     void release(ir::output_connector &conn);
     void grow_age();
 
+    // Ends the lifetime of buffers still in use at the current age.
+    void finish();
+
 private:
     size_t next_buffer_id_ = 0;
     size_t cnt_age_ = 0;
@@ -53,8 +53,11 @@ public:
 
 private:
     void create_allocators();
+    void generate_compute_order();
+    size_t data_pool_usage(std::vector<ir::node *> order);
     void generate_compute_sequence();
     void make_logical_buffers(caller_context &caller_ctx);
+    void record_lifetimes(lifetime_recorder &lr, bool visit_callees);
     void analyze_buffer_alias();
     void update_offset();
     void fix_lifetime();
@@ -72,6 +75,10 @@ private:
     std::unordered_map<const ir::output_connector *, logical_buffer *> logical_buffer_map_;
     std::list<logical_buffer> logical_buffers_;
     std::vector<physical_buffer> physical_buffers_;
+    std::vector<ir::node *> compute_order_;
+    bool reordered_ = false;
+    size_t post_order_pool_ = 0;
+    size_t min_peak_pool_ = 0;
 };
 
 class module_schedule_context
@@ -115,6 +122,8 @@ public:
     bool skip_buffer_alias() const noexcept { return skip_buffer_alias_; }
     void config_dump(std::filesystem::path dump_dir);
     const std::filesystem::path &dump_dir() const noexcept { return dump_dir_; }
+    void config_compute_order(schedule::compute_order order) noexcept { compute_order_ = order; }
+    schedule::compute_order compute_order() const noexcept { return compute_order_; }
     model_schedule_result &model_result() const noexcept { return result_; }
 
     void schedule(ir::graph &entry_function);
@@ -128,6 +137,7 @@ private:
     nncase::target &target_;
     bool skip_buffer_alias_;
     std::filesystem::path dump_dir_;
+    schedule::compute_order compute_order_ = schedule::compute_order::post_order;
     module_schedule_context *entry_module_;
     ir::graph *entry_function_;
     std::unordered_map<module_type_t, module_schedule_context> module_contexts_;
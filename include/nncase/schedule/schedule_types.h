@@ -15,6 +15,7 @@
 #pragma once
 #include "buffer_allocator.h"
 #include "buffers.h"
+#include <chrono>
 #include <nncase/ir/graph.h>
 #include <unordered_map>
 #include <vector>
@@ -67,9 +68,27 @@ struct module_schedule_result
     std::unordered_map<module_type_t, size_t> shared_max_usages;
 };
 
+enum class compute_order
+{
+    // Post order of a depth-first walk from the outputs.
+    post_order,
+    // Topological order picked to lower the peak bytes of live data buffers.
+    min_peak_memory
+};
+
+struct schedule_timings
+{
+    std::chrono::nanoseconds liveness {};
+    std::chrono::nanoseconds buffer_alias {};
+    std::chrono::nanoseconds compute_sequence {};
+    std::chrono::nanoseconds allocation {};
+    std::chrono::nanoseconds total {};
+};
+
 struct model_schedule_result
 {
     std::vector<module_schedule_result> modules;
     function_schedule_result *entry_function;
+    schedule_timings timings;
 };
 }
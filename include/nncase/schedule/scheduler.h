@@ -31,12 +31,14 @@ namespace schedule
 
         model_schedule_result schedule(bool skip_buffer_alias = false);
         void config_dump(std::filesystem::path dump_dir);
+        void config_compute_order(compute_order order);
 
     private:
         target &target_;
         ir::graph &main_graph_;
         std::span<ir::output_node *> outputs_;
         std::filesystem::path dump_dir_;
+        compute_order compute_order_ = compute_order::post_order;
     };
 }
 }
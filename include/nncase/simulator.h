@@ -39,6 +39,7 @@ class NNCASE_API simulator
 {
 public:
     static std::unique_ptr<simulator> create(std::vector<uint8_t> model, const simulate_options &options);
+    static std::unique_ptr<simulator> create(const std::filesystem::path &model_path, const simulate_options &options);
 
     virtual ~simulator();
     virtual void run() = 0;
@@ -19,6 +19,7 @@
 #include <nncase/schedule/buffer_allocator.h>
 #include <unordered_map>
 #include <unordered_set>
+#include <utility>
 #include <vector>
 
 namespace nncase::ir
@@ -46,6 +47,13 @@ struct target_options
 {
     virtual ~target_options() = default;
 
+    /**
+     * @brief Lists every option as name/value pairs for the compilation cache key.
+     *
+     * Targets that extend the options must override this and append their own after the base ones.
+     */
+    virtual std::vector<std::pair<std::string, std::string>> cache_values() const;
+
     std::string input_type;
     std::string inference_type;
     float weights_quantize_threshold;
@@ -17,25 +17,26 @@
 
 namespace nncase::ir::transforms
 {
-#define DEFINE_DEQ_MOTION(name)                                                   \
+#define DEFINE_DEQ_MOTION(name, radius)                                           \
     class NNCASE_API dequantize_##name##_motion_transform : public transform      \
     {                                                                             \
     public:                                                                       \
         void process(transform_context &context) override;                        \
+        size_t match_radius() const noexcept override { return radius; }          \
                                                                                   \
     protected:                                                                    \
         bool skip_self_contained_check() const noexcept override { return true; } \
         bool on_try_match(ir::node &node, transform_context &context) override;   \
     };
 
-DEFINE_DEQ_MOTION(pad)
-DEFINE_DEQ_MOTION(transpose)
-DEFINE_DEQ_MOTION(slice)
-DEFINE_DEQ_MOTION(resize_image)
-DEFINE_DEQ_MOTION(reshape)
-DEFINE_DEQ_MOTION(transbin)
-DEFINE_DEQ_MOTION(bitcast)
-DEFINE_DEQ_MOTION(s2b)
+DEFINE_DEQ_MOTION(pad, 1)
+DEFINE_DEQ_MOTION(transpose, 2)
+DEFINE_DEQ_MOTION(slice, 1)
+DEFINE_DEQ_MOTION(resize_image, 1)
+DEFINE_DEQ_MOTION(reshape, 4)
+DEFINE_DEQ_MOTION(transbin, 1)
+DEFINE_DEQ_MOTION(bitcast, 1)
+DEFINE_DEQ_MOTION(s2b, 1)
 
 #undef DEFINE_DEQ_MOTION
 }
@@ -21,6 +21,7 @@ class NNCASE_API fold_constant_transform : public transform
 {
 public:
     void process(transform_context &context) override;
+    size_t match_radius() const noexcept override { return 1; }
 
 protected:
     bool skip_self_contained_check() const noexcept override { return true; }
@@ -21,6 +21,7 @@ class NNCASE_API fold_convert_transform : public transform
 {
 public:
     void process(transform_context &context) override;
+    size_t match_radius() const noexcept override { return 1; }
 
 protected:
     bool skip_self_contained_check() const noexcept override { return true; }
@@ -31,6 +32,7 @@ class NNCASE_API fold_nop_convert_transform : public transform
 {
 public:
     void process(transform_context &context) override;
+    size_t match_radius() const noexcept override { return 1; }
 
 protected:
     bool skip_self_contained_check() const noexcept override { return true; }
@@ -40,6 +42,7 @@ class NNCASE_API fold_convert_around_bitcast_transform : public transform
 {
 public:
     void process(transform_context &context) override;
+    size_t match_radius() const noexcept override { return 2; }
 
 protected:
     bool skip_self_contained_check() const noexcept override { return true; }
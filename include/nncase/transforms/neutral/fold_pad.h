@@ -21,6 +21,7 @@ class NNCASE_API fold_nop_pad_transform : public transform
 {
 public:
     void process(transform_context &context) override;
+    size_t match_radius() const noexcept override { return 1; }
 
 protected:
     bool skip_self_contained_check() const noexcept override { return true; }
@@ -31,6 +32,7 @@ class NNCASE_API fold_pad_pad_transform : public transform
 {
 public:
     void process(transform_context &context) override;
+    size_t match_radius() const noexcept override { return 1; }
 
 protected:
     bool skip_self_contained_check() const noexcept override { return true; }
@@ -41,6 +43,7 @@ class NNCASE_API fold_pad_strided_slice_transform : public transform
 {
 public:
     void process(transform_context &context) override;
+    size_t match_radius() const noexcept override { return 1; }
 
 protected:
     bool skip_self_contained_check() const noexcept override { return true; }
@@ -51,6 +54,7 @@ class NNCASE_API strided_slice_to_pad_transform : public transform
 {
 public:
     void process(transform_context &context) override;
+    size_t match_radius() const noexcept override { return 1; }
 
 protected:
     bool skip_self_contained_check() const noexcept override { return true; }
@@ -61,6 +65,7 @@ class NNCASE_API pad_to_slice_transform : public transform
 {
 public:
     void process(transform_context &context) override;
+    size_t match_radius() const noexcept override { return 1; }
 
 protected:
     bool skip_self_contained_check() const noexcept override { return true; }
@@ -71,6 +76,7 @@ class NNCASE_API pad_to_maxpool_transform : public transform
 {
 public:
     void process(transform_context &context) override;
+    size_t match_radius() const noexcept override { return 1; }
 
 protected:
     bool skip_self_contained_check() const noexcept override { return true; }
@@ -17,23 +17,24 @@
 
 namespace nncase::ir::transforms
 {
-#define DEFINE_Q_MOTION(name)                                                     \
+#define DEFINE_Q_MOTION(name, radius)                                             \
     class NNCASE_API quantize_##name##_motion_transform : public transform        \
     {                                                                             \
     public:                                                                       \
         void process(transform_context &context) override;                        \
+        size_t match_radius() const noexcept override { return radius; }          \
                                                                                   \
     protected:                                                                    \
         bool skip_self_contained_check() const noexcept override { return true; } \
         bool on_try_match(ir::node &node, transform_context &context) override;   \
     };
 
-DEFINE_Q_MOTION(pad)
-DEFINE_Q_MOTION(transpose)
-DEFINE_Q_MOTION(slice)
-DEFINE_Q_MOTION(resize_image)
-DEFINE_Q_MOTION(reshape)
-DEFINE_Q_MOTION(bitcast)
-DEFINE_Q_MOTION(b2s)
+DEFINE_Q_MOTION(pad, 1)
+DEFINE_Q_MOTION(transpose, 1)
+DEFINE_Q_MOTION(slice, 4)
+DEFINE_Q_MOTION(resize_image, 1)
+DEFINE_Q_MOTION(reshape, 4)
+DEFINE_Q_MOTION(bitcast, 1)
+DEFINE_Q_MOTION(b2s, 1)
 #undef DEFINE_Q_MOTION
 }
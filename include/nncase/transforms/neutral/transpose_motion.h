@@ -17,25 +17,26 @@
 
 namespace nncase::ir::transforms
 {
-#define DEFINE_TP_MOTION(name)                                                    \
+#define DEFINE_TP_MOTION(name, radius)                                            \
     class NNCASE_API transpose_##name##_motion_transform : public transform       \
     {                                                                             \
     public:                                                                       \
         void process(transform_context &context) override;                        \
+        size_t match_radius() const noexcept override { return radius; }          \
                                                                                   \
     protected:                                                                    \
         bool skip_self_contained_check() const noexcept override { return true; } \
         bool on_try_match(ir::node &node, transform_context &context) override;   \
     };
 
-DEFINE_TP_MOTION(binary)
-DEFINE_TP_MOTION(constant_binary)
-DEFINE_TP_MOTION(concat)
-DEFINE_TP_MOTION(pad)
-DEFINE_TP_MOTION(reduce)
-DEFINE_TP_MOTION(unary)
-DEFINE_TP_MOTION(clamp)
-DEFINE_TP_MOTION(sigmoid)
+DEFINE_TP_MOTION(binary, 1)
+DEFINE_TP_MOTION(constant_binary, 1)
+DEFINE_TP_MOTION(concat, 1)
+DEFINE_TP_MOTION(pad, 1)
+DEFINE_TP_MOTION(reduce, 1)
+DEFINE_TP_MOTION(unary, 1)
+DEFINE_TP_MOTION(clamp, 1)
+DEFINE_TP_MOTION(sigmoid, 1)
 
 #undef DEFINE_TP_MOTION
 }
@@ -14,8 +14,10 @@
  */
 #pragma once
 #include "transform.h"
+#include <chrono>
 #include <filesystem>
 #include <optional>
+#include <span>
 #include <vector>
 
 namespace nncase
@@ -32,6 +34,15 @@ struct run_pass_options
     std::optional<std::filesystem::path> dump_dir;
 };
 
+struct transform_stats
+{
+    std::string name;
+    size_t tries = 0;
+    size_t matches = 0;
+    std::chrono::nanoseconds match_time {};
+    std::chrono::nanoseconds process_time {};
+};
+
 class NNCASE_API pass
 {
 public:
@@ -49,6 +60,7 @@ public:
 
 protected:
     virtual void run_core(graph &graph, nncase::target &target, const run_pass_options &options) = 0;
+    virtual void dump_core(const std::filesystem::path &dump_path);
 
 private:
     std::string dump_name_;
@@ -70,11 +82,23 @@ public:
         return static_cast<T *>(transforms_.emplace_back(new T(std::forward<TArgs>(args)...)).get());
     }
 
+    /**
+     * @brief Transforms in priority order.
+     */
+    std::span<const std::unique_ptr<transform>> transforms() const noexcept { return transforms_; }
+
+    /**
+     * @brief Match counts and timings of each transform in the last run, in priority order.
+     */
+    std::span<const transform_stats> stats() const noexcept { return stats_; }
+
 protected:
     void run_core(graph &graph, nncase::target &target, const run_pass_options &options) override;
+    void dump_core(const std::filesystem::path &dump_path) override;
 
 private:
     std::vector<std::unique_ptr<transform>> transforms_;
+    std::vector<transform_stats> stats_;
 };
 
 class NNCASE_API graph_pass : public pass
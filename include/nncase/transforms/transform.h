@@ -14,6 +14,7 @@
  */
 #pragma once
 #include <filesystem>
+#include <limits>
 #include <nncase/ir/graph.h>
 #include <nncase/ir/quantizer.h>
 #include <vector>
@@ -55,6 +56,8 @@ namespace ir
         class NNCASE_API transform
         {
         public:
+            static constexpr size_t unbounded_match_radius = std::numeric_limits<size_t>::max();
+
             transform(std::string name = "noname")
                 : name_(name) { }
             virtual ~transform() = default;
@@ -66,6 +69,14 @@ namespace ir
 
             virtual void process(transform_context &context) = 0;
 
+            /**
+             * @brief Upper bound on how many hops from the node passed to try_match the match,
+             *        self-contained check included, reads ops, attributes, shapes or connections
+             *        to decide whether it matches. transform_pass only rematches nodes this close
+             *        to a rewrite, the default makes it rescan the whole graph instead.
+             */
+            virtual size_t match_radius() const noexcept;
+
         protected:
             virtual bool skip_self_contained_check() const noexcept;
             virtual bool on_try_match(node &node, transform_context &context) = 0;
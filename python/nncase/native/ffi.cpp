@@ -159,7 +159,11 @@ PYBIND11_MODULE(_nncase, m)
         .def_readwrite("dump_quant_error", &compile_options::dump_quant_error)
         .def_readwrite("dump_import_op_range", &compile_options::dump_import_op_range)
         .def_readwrite("dump_dir", &compile_options::dump_dir)
-        .def_readwrite("benchmark_only", &compile_options::benchmark_only);
+        .def_readwrite("cache_dir", &compile_options::cache_dir)
+        .def_readwrite("cache_max_size", &compile_options::cache_max_size)
+        .def_readwrite("benchmark_only", &compile_options::benchmark_only)
+        .def_readwrite("min_peak_memory_order", &compile_options::min_peak_memory_order)
+        .def_readwrite("calibrate_threads", &compile_options::calibrate_threads);
 
     py::class_<import_options>(m, "ImportOptions")
         .def(py::init())
@@ -219,6 +223,7 @@ PYBIND11_MODULE(_nncase, m)
     py::class_<interpreter>(m, "Simulator")
         .def(py::init())
         .def("load_model", [](interpreter &interp, gsl::span<const gsl::byte> buffer) { interp.load_model(buffer).unwrap_or_throw(); })
+        .def("load_model_from_file", [](interpreter &interp, const std::string &path) { interp.load_model_from_file(path.c_str()).unwrap_or_throw(); })
         .def_property_readonly("inputs_size", &interpreter::inputs_size)
         .def_property_readonly("outputs_size", &interpreter::outputs_size)
         .def("get_input_desc", &interpreter::input_desc)
@@ -37,6 +37,7 @@ compile_command::compile_command(lyra::cli &cli)
                          .add_argument(lyra::opt(dump_range_dataset_, "dataset path").name("--dump-range-dataset").optional().help("dump import op range dataset"))
                          .add_argument(lyra::opt(dump_range_dataset_format_, "dataset format").name("--dump-range-dataset-format").optional().help("datset format: e.g. image|raw, default is " + dump_range_dataset_format_))
                          .add_argument(lyra::opt(calibrate_method_, "calibrate method").name("--calibrate-method").optional().help("calibrate method: e.g. no_clip|l2|kld_m0|kld_m1|kld_m2|cdf, default is " + calibrate_method_))
+                         .add_argument(lyra::opt(calibrate_threads_, "calibrate threads").name("--calibrate-threads").optional().help("threads used to run calibration samples, each keeps its own copy of the model, 0 means hardware concurrency, default is " + std::to_string(calibrate_threads_)))
                          .add_argument(lyra::opt(preprocess_).name("--preprocess").optional().help("enable preprocess, default is " + std::to_string(preprocess_)))
                          .add_argument(lyra::opt(swapRB_).name("--swapRB").optional().help("swap red and blue channel, default is " + std::to_string(swapRB_)))
                          .add_argument(lyra::opt(cli_mean_, "normalize mean").name("--mean").optional().help("normalize mean, default is " + cli_mean_))
@@ -56,7 +57,10 @@ compile_command::compile_command(lyra::cli &cli)
                          .add_argument(lyra::opt(dump_quant_error_).name("--dump-quant-error").optional().help("dump quant error, default is " + std::to_string(dump_quant_error_)))
                          .add_argument(lyra::opt(dump_import_op_range_).name("--dump-import-op-range").optional().help("dump import op range, default is " + std::to_string(dump_import_op_range_)))
                          .add_argument(lyra::opt(dump_dir_, "dump directory").name("--dump-dir").optional().help("dump to directory"))
-                         .add_argument(lyra::opt(benchmark_only_).name("--benchmark-only").optional().help("compile kmodel only for benchmark use, default is " + std::to_string(benchmark_only_))));
+                         .add_argument(lyra::opt(cache_dir_, "cache directory").name("--cache-dir").optional().help("reuse kmodels compiled with the same model and options from directory"))
+                         .add_argument(lyra::opt(cache_max_size_, "cache max size").name("--cache-max-size").optional().help("evict least recently used kmodels when the cache exceeds this size in bytes, default is " + std::to_string(cache_max_size_)))
+                         .add_argument(lyra::opt(benchmark_only_).name("--benchmark-only").optional().help("compile kmodel only for benchmark use, default is " + std::to_string(benchmark_only_)))
+                         .add_argument(lyra::opt(min_peak_memory_order_).name("--min-peak-memory-order").optional().help("reorder nodes to lower peak memory when the estimate is lower than post order, default is " + std::to_string(min_peak_memory_order_))));
 }
 
 void compile_command::run()
@@ -85,6 +89,8 @@ void compile_command::run()
     c_options.dump_quant_error = dump_quant_error_;
     c_options.dump_import_op_range = dump_import_op_range_;
     c_options.dump_dir = dump_dir_;
+    c_options.cache_dir = cache_dir_;
+    c_options.cache_max_size = cache_max_size_;
     c_options.target = target_name_;
     c_options.is_fpga = is_fpga_;
     c_options.input_type = input_type_;
@@ -98,6 +104,8 @@ void compile_command::run()
     c_options.input_shape = input_shape_;
     c_options.w_quant_type = w_quant_type_;
     c_options.benchmark_only = benchmark_only_;
+    c_options.min_peak_memory_order = min_peak_memory_order_;
+    c_options.calibrate_threads = calibrate_threads_;
     c_options.preprocess = preprocess_;
     c_options.use_mse_quant_w = use_mse_quant_w_;
     c_options.split_w_to_act = split_w_to_act_;
@@ -64,6 +64,7 @@ private:
     std::string target_name_;
     std::string output_arrays_;
     std::string dump_dir_;
+    std::string cache_dir_;
     std::string dataset_;
     std::string dataset_format_ = "image";
     std::string dump_range_dataset_;
@@ -98,6 +99,9 @@ private:
     bool dump_import_op_range_ = false;
     bool is_fpga_ = false;
     bool benchmark_only_ = false;
+    bool min_peak_memory_order_ = false;
     bool preprocess_ = false;
+    uint32_t calibrate_threads_ = 1;
+    uint64_t cache_max_size_ = 1ULL << 30;
 };
 }
@@ -14,7 +14,6 @@
  */
 #include "inference.h"
 #include "ProgressBar.hpp"
-#include <nncase/io_utils.h>
 #include <nncase/simulator.h>
 
 using namespace nncase;
@@ -38,6 +37,6 @@ void inference_command::run()
     options.output_path = output_path_;
     options.input_layout = input_layout_;
 
-    auto sim = simulator::create(read_file(model_filename_), options);
+    auto sim = simulator::create(std::filesystem::path(model_filename_), options);
     sim->run();
 }
@@ -59,9 +59,15 @@ void stackvm_module_builder::end_emit_function([[maybe_unused]] const schedule::
     set_current_function_text_end(text_writer().position());
 }
 
+void stackvm_module_builder::end_emit_module()
+{
+    if (!shapes_.empty())
+        shapes_.write(writer(SHAPE_SECTION_NAME));
+}
+
 void stackvm_module_builder::emit(ir::node &node)
 {
-    stackvm_op_builder builder(node, text_writer());
+    stackvm_op_builder builder(node, text_writer(), shapes_);
 #define DEFINE_OP(op)                          \
     if (node.runtime_opcode() == op::opcode()) \
         return emit(static_cast<op &>(node), builder);
@@ -70,20 +76,44 @@ void stackvm_module_builder::emit(ir::node &node)
     module_builder::emit(node);
 }
 
+uint32_t shape_table::add(std::vector<int32_t> dims)
+{
+    auto it = indices_.find(dims);
+    if (it != indices_.end())
+        return it->second;
+
+    auto index = (uint32_t)entries_.size();
+    indices_.emplace(dims, index);
+    entries_.emplace_back(std::move(dims));
+    return index;
+}
+
+void shape_table::write(section_writer &writer) const
+{
+    writer.write((uint32_t)entries_.size());
+    for (auto &dims : entries_)
+    {
+        writer.write((uint32_t)dims.size());
+        writer.write_array<int32_t>(dims);
+    }
+}
+
+stackvm_op_builder::stackvm_op_builder(ir::node &node, section_writer &writer, shape_table &shapes)
+    : op_builder(node, writer), shapes_(shapes)
+{
+}
+
 void stackvm_op_builder::stshape(uint8_t rshape, const ir::shape_t &shape)
 {
-    assert(shape.size() <= std::numeric_limits<uint8_t>::max());
-    for (auto dim : shape)
-        ldc_i4_((int32_t)dim);
-    stshape_(rshape, (uint8_t)shape.size());
+    std::vector<int32_t> dims(shape.size());
+    for (size_t i = 0; i < shape.size(); i++)
+        dims[i] = (int32_t)shape[i];
+    ldshape_(rshape, shapes_.add(std::move(dims)));
 }
 
 void stackvm_op_builder::staxis(uint8_t rshape, const ir::axis_t &axis)
 {
-    assert(axis.size() <= std::numeric_limits<uint8_t>::max());
-    for (auto dim : axis)
-        ldc_i4_(dim);
-    stshape_(rshape, (uint8_t)axis.size());
+    ldshape_(rshape, shapes_.add(std::vector<int32_t>(axis.begin(), axis.end())));
 }
 
 void stackvm_op_builder::stpaddings(uint8_t rpaddings, std::span<padding const> paddings)
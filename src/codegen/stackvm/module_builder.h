@@ -57,10 +57,26 @@
 
 namespace nncase::codegen::stackvm
 {
+/**
+ * @brief Deduplicated static shapes, strides and axes written to the .shape section.
+ *        Ops bind shape registers to entries with ldshape instead of rebuilding them each run.
+ */
+class shape_table
+{
+public:
+    bool empty() const noexcept { return entries_.empty(); }
+    uint32_t add(std::vector<int32_t> dims);
+    void write(section_writer &writer) const;
+
+private:
+    std::vector<std::vector<int32_t>> entries_;
+    std::map<std::vector<int32_t>, uint32_t> indices_;
+};
+
 class stackvm_op_builder : public op_builder
 {
 public:
-    using op_builder::op_builder;
+    stackvm_op_builder(ir::node &node, section_writer &writer, shape_table &shapes);
 
     void stshape(uint8_t rshape, const ir::shape_t &shape);
     void staxis(uint8_t rshape, const ir::axis_t &axis);
@@ -68,6 +84,9 @@ public:
     void lea_buffer(const schedule::buffer_allocation &alloc);
     void ldpadding(const padding &pad);
     void ldscalar(const scalar &value);
+
+private:
+    shape_table &shapes_;
 };
 
 class stackvm_module_builder : public module_builder
@@ -84,10 +103,14 @@ protected:
     void begin_emit_function(const schedule::function_schedule_result &function) override;
     void end_emit_function(const schedule::function_schedule_result &function) override;
     void emit(ir::node &node) override;
+    void end_emit_module() override;
 
 private:
 #define DEFINE_OP(op_) void emit(ir::op_ &op, stackvm_op_builder &builder);
 #include "ops.def"
 #undef DEFINE_OP
+
+private:
+    shape_table shapes_;
 };
 }
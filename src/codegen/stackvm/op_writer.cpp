@@ -313,6 +313,11 @@ void op_builder::stpaddings_(uint8_t rpaddings, uint8_t rank)
     op_writer<stpaddings_op_t>()(stpaddings_op_t(rpaddings, rank), writer_);
 }
 
+void op_builder::ldshape_(uint8_t rshape, uint32_t index)
+{
+    op_writer<ldshape_op_t>()(ldshape_op_t(rshape, index), writer_);
+}
+
 void op_builder::dup_()
 {
     op_writer<dup_op_t>()(dup_op_t(), writer_);
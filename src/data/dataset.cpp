@@ -12,16 +12,191 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  */
+#include <algorithm>
 #include <fstream>
 #include <nncase/data/dataset.h>
 #include <opencv2/core.hpp>
 #include <opencv2/imgcodecs.hpp>
 #include <opencv2/imgproc.hpp>
+#include <stdexcept>
 #include <string>
 
 using namespace nncase;
 using namespace nncase::data;
 
+namespace
+{
+// Resizes a decoded BGR image into dest as RGB, or as its first channel for single channel inputs.
+// The shuffles run through OpenCV's vectorized cvtColor/split, writing straight into dest.
+void write_image(const cv::Mat &img, void *dest, int depth, const xt::dynamic_shape<size_t> &shape, const std::string &layout)
+{
+    size_t channels, height, width;
+    if (layout == "NHWC")
+    {
+        height = shape[1];
+        width = shape[2];
+        channels = shape[3];
+    }
+    else if (layout == "NCHW")
+    {
+        channels = shape[1];
+        height = shape[2];
+        width = shape[3];
+    }
+    else
+    {
+        throw std::runtime_error("Unsupported layout type!");
+    }
+
+    cv::Mat resized;
+    cv::resize(img, resized, cv::Size((int)width, (int)height));
+    if (resized.depth() != depth)
+        resized = cv::Mat(resized.size(), CV_MAKETYPE(depth, resized.channels()), resized.data, resized.step);
+
+    auto plane = [&](size_t c) {
+        auto base = reinterpret_cast<uint8_t *>(dest) + c * height * width * CV_ELEM_SIZE1(depth);
+        return cv::Mat((int)height, (int)width, depth, base);
+    };
+
+    if (channels == 3)
+    {
+        if (layout == "NHWC")
+        {
+            cv::Mat dest_img((int)height, (int)width, CV_MAKETYPE(depth, 3), dest);
+            cv::cvtColor(resized, dest_img, cv::COLOR_BGR2RGB);
+        }
+        else
+        {
+            cv::Mat planes[] = { plane(2), plane(1), plane(0) };
+            cv::split(resized, planes);
+        }
+    }
+    else if (channels == 1)
+    {
+        auto dest_img = plane(0);
+        cv::extractChannel(resized, dest_img, 0);
+    }
+    else
+    {
+        throw std::runtime_error("Unsupported image channels: " + std::to_string(channels));
+    }
+}
+}
+
+sample_prefetcher::sample_prefetcher(size_t count, size_t slots, std::function<void(size_t index, size_t slot)> load)
+    : count_(count), load_(std::move(load))
+{
+    for (size_t i = 0; i < slots; i++)
+        free_slots_.emplace_back(i);
+
+    auto workers = std::min(slots, (size_t)std::max(std::thread::hardware_concurrency(), 1U));
+    try
+    {
+        for (size_t i = 0; i < workers; i++)
+            workers_.emplace_back([this] { worker_main(); });
+    }
+    catch (...)
+    {
+        stop();
+        throw;
+    }
+}
+
+sample_prefetcher::~sample_prefetcher()
+{
+    stop();
+}
+
+void sample_prefetcher::stop() noexcept
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+
+    worker_cv_.notify_all();
+    for (auto &worker : workers_)
+        worker.join();
+    workers_.clear();
+}
+
+size_t sample_prefetcher::default_slots() noexcept
+{
+    // Twice the hardware threads, counting at most four: 2 slots on one thread up to 8 slots
+    // from four threads on. Workers are capped by the hardware threads too, so a small host
+    // has a spare slot per worker for the consumer to hold, while from 8 threads on each of
+    // the 8 workers has one slot.
+    return 2 * std::clamp(std::thread::hardware_concurrency(), 1U, 4U);
+}
+
+void sample_prefetcher::worker_main()
+{
+    while (true)
+    {
+        size_t index, slot;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            worker_cv_.wait(lock, [this] { return stop_ || (next_load_ < count_ && errors_.empty() && !free_slots_.empty()); });
+            if (stop_)
+                return;
+            index = next_load_++;
+            slot = free_slots_.front();
+            free_slots_.pop_front();
+        }
+
+        std::exception_ptr error;
+        try
+        {
+            load_(index, slot);
+        }
+        catch (...)
+        {
+            error = std::current_exception();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (error)
+            {
+                errors_.emplace(index, error);
+                free_slots_.emplace_back(slot);
+            }
+            else
+            {
+                ready_.emplace(index, slot);
+            }
+        }
+
+        ready_cv_.notify_all();
+    }
+}
+
+size_t sample_prefetcher::acquire()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto index = next_acquire_;
+    if (index >= count_)
+        throw std::out_of_range("No samples left to acquire");
+    ready_cv_.wait(lock, [&] { return ready_.contains(index) || errors_.contains(index); });
+    if (auto it = errors_.find(index); it != errors_.end())
+        std::rethrow_exception(it->second);
+
+    auto slot = ready_.at(index);
+    ready_.erase(index);
+    next_acquire_++;
+    return slot;
+}
+
+void sample_prefetcher::release(size_t slot)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        free_slots_.emplace_back(slot);
+    }
+
+    worker_cv_.notify_one();
+}
+
 dataset::dataset(const std::filesystem::path &path, std::function<bool(const std::filesystem::path &)> file_filter, xt::dynamic_shape<size_t> input_shape, std::string input_layout)
     : input_shape_(std::move(input_shape)), input_layout_(input_layout)
 {
@@ -63,62 +238,7 @@ void image_dataset::process(const std::vector<uint8_t> &src, float *dest, const
     else
         img.convertTo(f_img, CV_32F);
 
-    cv::Mat dest_img;
-    if (layout == "NHWC")
-    {
-        cv::resize(f_img, dest_img, cv::Size((int)shape[2], (int)shape[1]));
-
-        if (shape[3] == 3)
-        {
-            dest_img.forEach<cv::Vec3f>([&](cv::Vec3f v, const int *idx) {
-                auto i = idx[0] * shape[2] + idx[1];
-                dest[i * 3] = v[2];
-                dest[i * 3 + 1] = v[1];
-                dest[i * 3 + 2] = v[0];
-            });
-        }
-        else if (shape[3] == 1)
-        {
-            dest_img.forEach<cv::Vec3f>([&](cv::Vec3f v, const int *idx) {
-                auto i = idx[0] * shape[2] + idx[1];
-                dest[i] = v[0];
-            });
-        }
-        else
-        {
-            throw std::runtime_error("Unsupported image channels: " + std::to_string(shape[0]));
-        }
-    }
-    else if (layout == "NCHW")
-    {
-        cv::resize(f_img, dest_img, cv::Size((int)shape[3], (int)shape[2]));
-
-        size_t channel_size = xt::compute_size(xt::dynamic_shape<size_t> { shape[2], shape[3] });
-        if (shape[1] == 3)
-        {
-            dest_img.forEach<cv::Vec3f>([&](cv::Vec3f v, const int *idx) {
-                auto i = idx[0] * shape[3] + idx[1];
-                dest[i] = v[2];
-                dest[i + channel_size] = v[1];
-                dest[i + channel_size * 2] = v[0];
-            });
-        }
-        else if (shape[1] == 1)
-        {
-            dest_img.forEach<cv::Vec3f>([&](cv::Vec3f v, const int *idx) {
-                auto i = idx[0] * shape[3] + idx[1];
-                dest[i] = v[0];
-            });
-        }
-        else
-        {
-            throw std::runtime_error("Unsupported image channels: " + std::to_string(shape[0]));
-        }
-    }
-    else
-    {
-        throw std::runtime_error("Unsupported layout type!");
-    }
+    write_image(f_img, dest, CV_32F, shape, layout);
 }
 
 void image_dataset::process(const std::vector<uint8_t> &src, uint8_t *dest, const xt::dynamic_shape<size_t> &shape, std::string layout)
@@ -126,67 +246,9 @@ void image_dataset::process(const std::vector<uint8_t> &src, uint8_t *dest, cons
     auto img = cv::imdecode(src, cv::IMREAD_COLOR);
 
     cv::Mat f_img;
-    if ((img.type() & CV_8U) == 0)
-        img.convertTo(f_img, CV_8U);
-    else
-        img.convertTo(f_img, CV_8U);
-
-    cv::Mat dest_img;
-    if (layout == "NHWC")
-    {
-        cv::resize(f_img, dest_img, cv::Size((int)shape[2], (int)shape[1]));
-
-        if (shape[0] == 3)
-        {
-            dest_img.forEach<cv::Vec3b>([&](cv::Vec3b v, const int *idx) {
-                auto i = idx[0] * shape[2] + idx[1];
-                dest[i * 3] = v[2];
-                dest[i * 3 + 1] = v[1];
-                dest[i * 3 + 2] = v[0];
-            });
-        }
-        else if (shape[0] == 1)
-        {
-            dest_img.forEach<cv::Vec3b>([&](cv::Vec3b v, const int *idx) {
-                auto i = idx[0] * shape[2] + idx[1];
-                dest[i] = v[0];
-            });
-        }
-        else
-        {
-            throw std::runtime_error("Unsupported image channels: " + std::to_string(shape[0]));
-        }
-    }
-    else if (layout == "NCHW")
-    {
-        cv::resize(f_img, dest_img, cv::Size((int)shape[3], (int)shape[2]));
+    img.convertTo(f_img, CV_8U);
 
-        size_t channel_size = xt::compute_size(xt::dynamic_shape<size_t> { shape[2], shape[3] });
-        if (shape[1] == 3)
-        {
-            dest_img.forEach<cv::Vec3b>([&](cv::Vec3b v, const int *idx) {
-                auto i = idx[0] * shape[2] + idx[1];
-                dest[i] = v[2];
-                dest[i + channel_size] = v[1];
-                dest[i + channel_size * 2] = v[0];
-            });
-        }
-        else if (shape[1] == 1)
-        {
-            dest_img.forEach<cv::Vec3b>([&](cv::Vec3b v, const int *idx) {
-                auto i = idx[0] * shape[2] + idx[1];
-                dest[i] = v[0];
-            });
-        }
-        else
-        {
-            throw std::runtime_error("Unsupported image channels: " + std::to_string(shape[0]));
-        }
-    }
-    else
-    {
-        throw std::runtime_error("Unsupported layout type!");
-    }
+    write_image(f_img, dest, CV_8U, shape, layout);
 }
 
 void image_dataset::process(const std::vector<uint8_t> &src, int8_t *dest, const xt::dynamic_shape<size_t> &shape, std::string layout)
@@ -194,67 +256,10 @@ void image_dataset::process(const std::vector<uint8_t> &src, int8_t *dest, const
     auto img = cv::imdecode(src, cv::IMREAD_COLOR);
 
     cv::Mat f_img;
-    if ((img.type() & CV_8S) == 0)
-        img.convertTo(f_img, CV_8S);
-    else
-        img.convertTo(f_img, CV_8S);
-
-    cv::Mat dest_img;
-    if (layout == "NHWC")
-    {
-        cv::resize(f_img, dest_img, cv::Size((int)shape[2], (int)shape[1]));
+    img.convertTo(f_img, CV_8S);
 
-        if (shape[0] == 3)
-        {
-            dest_img.forEach<cv::Vec3b>([&](cv::Vec3b v, const int *idx) {
-                auto i = idx[0] * shape[2] + idx[1];
-                dest[i * 3] = v[2];
-                dest[i * 3 + 1] = v[1];
-                dest[i * 3 + 2] = v[0];
-            });
-        }
-        else if (shape[0] == 1)
-        {
-            dest_img.forEach<cv::Vec3b>([&](cv::Vec3b v, const int *idx) {
-                auto i = idx[0] * shape[2] + idx[1];
-                dest[i] = v[0];
-            });
-        }
-        else
-        {
-            throw std::runtime_error("Unsupported image channels: " + std::to_string(shape[0]));
-        }
-    }
-    else if (layout == "NCHW")
-    {
-        cv::resize(f_img, dest_img, cv::Size((int)shape[3], (int)shape[2]));
-
-        size_t channel_size = xt::compute_size(xt::dynamic_shape<size_t> { shape[2], shape[3] });
-        if (shape[1] == 3)
-        {
-            dest_img.forEach<cv::Vec3b>([&](cv::Vec3b v, const int *idx) {
-                auto i = idx[0] * shape[2] + idx[1];
-                dest[i] = v[2];
-                dest[i + channel_size] = v[1];
-                dest[i + channel_size * 2] = v[0];
-            });
-        }
-        else if (shape[1] == 1)
-        {
-            dest_img.forEach<cv::Vec3b>([&](cv::Vec3b v, const int *idx) {
-                auto i = idx[0] * shape[2] + idx[1];
-                dest[i] = v[0];
-            });
-        }
-        else
-        {
-            throw std::runtime_error("Unsupported image channels: " + std::to_string(shape[0]));
-        }
-    }
-    else
-    {
-        throw std::runtime_error("Unsupported layout type!");
-    }
+    // Channel shuffles only move bytes, so int8 goes through the uint8 path.
+    write_image(f_img, dest, CV_8U, shape, layout);
 }
 
 raw_dataset::raw_dataset(const std::filesystem::path &path, xt::dynamic_shape<size_t> input_shape)
@@ -50,7 +50,7 @@ evaluate_tensor::evaluate_tensor(datatype_t datatype, runtime_shape_t shape, run
 }
 
 function_evaluate_context::function_evaluate_context(const function_schedule_result &sched, module_evaluate_context &mod_eval)
-    : sched_(sched), mod_eval_(mod_eval)
+    : sched_(&sched), mod_eval_(&mod_eval)
 {
     input_pool_ = std::make_unique<std::byte[]>(sched.input_pool_size);
     output_pool_ = std::make_unique<std::byte[]>(sched.output_pool_size);
@@ -76,8 +76,27 @@ function_evaluate_context::function_evaluate_context(const function_schedule_res
     }
 }
 
+function_evaluate_context::function_evaluate_context() noexcept
+    : sched_(nullptr), mod_eval_(nullptr)
+{
+}
+
+void function_evaluate_context::bind(const output_connector &conn, std::span<std::byte> buffer)
+{
+    if (buffer.size() < ir::get_bytes(conn.type(), conn.shape()))
+        throw std::runtime_error("Buffer bound to " + conn.owner().name() + " is too small");
+    bindings_[&conn] = buffer;
+}
+
 evaluate_tensor function_evaluate_context::memory_at(const output_connector &conn)
 {
+    if (!sched_)
+    {
+        auto buffer = bindings_.at(&conn);
+        return evaluate_tensor(conn.type(), to(conn.shape()), to(to_strides(conn.shape())),
+            gsl::span<gsl::byte>(reinterpret_cast<gsl::byte *>(buffer.data()), buffer.size()));
+    }
+
     auto &alloc = module().sched().allocations.at(&conn);
     std::byte *base;
     switch (alloc.memory_location)
@@ -125,7 +144,7 @@ void function_evaluate_context::evaluate(eval_step step = nncase::ir::eval_step:
     chrono::nanoseconds total_duration = {};
     auto quantizer = module().quantizer();
 
-    for (auto &&node : sched_.compute_sequence)
+    for (auto &&node : sched_->compute_sequence)
     {
         auto &evaluator = get_evaluator(node->runtime_opcode());
 
@@ -158,6 +177,11 @@ void function_evaluate_context::evaluate(eval_step step = nncase::ir::eval_step:
     }
 }
 
+void function_evaluate_context::evaluate(ir::node &node)
+{
+    get_evaluator(node.runtime_opcode())(node, *this);
+}
+
 module_evaluate_context::module_evaluate_context(const module_schedule_result &sched, model_evaluate_context &model_eval)
     : sched_(sched), model_eval_(model_eval), quantizer_(nullptr)
 {
@@ -199,6 +223,12 @@ void module_evaluate_context::end_sample()
         quantizer_->end_sample();
 }
 
+void module_evaluate_context::merge_quantizer(module_evaluate_context &other)
+{
+    if (quantizer_ && other.quantizer_)
+        quantizer_->merge(*other.quantizer_);
+}
+
 void module_evaluate_context::end_collect_distribution(const std::function<void(size_t cnt, size_t total)> &progress)
 {
     if (quantizer_)
@@ -241,6 +271,12 @@ void model_evaluate_context::end_sample()
         mod.second.end_sample();
 }
 
+void model_evaluate_context::merge_quantizers(model_evaluate_context &other)
+{
+    for (auto &mod : module_ctxs_)
+        mod.second.merge_quantizer(other.module(mod.first));
+}
+
 void model_evaluate_context::end_collect_distribution(const std::function<void(size_t cnt, size_t total)> &progress)
 {
     for (auto &mod : module_ctxs_)
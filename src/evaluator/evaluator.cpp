@@ -51,6 +51,11 @@ void evaluator::end_sample()
     model_eval_.end_sample();
 }
 
+void evaluator::merge_quantizers(evaluator &other)
+{
+    model_eval_.merge_quantizers(other.model_eval_);
+}
+
 void evaluator::end_collect_distribution(const std::function<void(size_t cnt, size_t total)> &progress)
 {
     model_eval_.end_collect_distribution(progress);
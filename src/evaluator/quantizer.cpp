@@ -12,14 +12,22 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  */
+#include <algorithm>
 #include <chrono>
 #include <cmath>
 #include <cstddef>
 #include <cstdint>
+#include <functional>
+#include <iostream>
 #include <limits>
+#include <mutex>
 #include <nncase/ir/ops/constant.h>
 #include <nncase/ir/quantizer.h>
 #include <nncase/ir/visitor.h>
+#include <nncase/kernels/kernel_context.h>
+#include <numeric>
+#include <optional>
+#include <tuple>
 
 using namespace nncase;
 using namespace nncase::ir;
@@ -120,7 +128,7 @@ float compute_kld(xtl::span<float> p, xtl::span<float> q)
     return d;
 }
 
-float compute_l2(xtl::span<float> p, value_range<float> p_range, value_range<float> q_range, size_t q_bins)
+float compute_l2(std::span<const float> p, value_range<float> p_range, value_range<float> q_range, size_t q_bins)
 {
     auto p_interval = (p_range.max - p_range.min) / p.size();
     auto q_interval = (q_range.max - q_range.min) / (q_bins - 1);
@@ -136,6 +144,536 @@ float compute_l2(xtl::span<float> p, value_range<float> p_range, value_range<flo
 
     return d;
 }
+
+// Same values as smooth_distribution, computed in place. Returns false where that returns an empty distribution.
+bool smooth_distribution_inplace(std::vector<float> &p, const float eps = 0.0001)
+{
+    size_t n_zeros = std::count(p.begin(), p.end(), 0.f);
+    size_t n_nonzeros = p.size() - n_zeros;
+    if (!n_nonzeros)
+        return false;
+    float eps1 = eps * static_cast<float>(n_zeros) / static_cast<float>(n_nonzeros);
+    if (eps1 >= 1.0)
+        return false;
+    for (auto &value : p)
+        value += value == 0.f ? eps : -eps1;
+    return true;
+}
+
+// Same value as compute_kld, without normalizing the inputs in place.
+float compute_kld_const(std::span<const float> p, std::span<const float> q)
+{
+    if (!(p.size() && q.size()) || p.size() != q.size())
+        return std::numeric_limits<float>::max();
+
+    auto p_sum = std::reduce(p.begin(), p.end());
+    auto q_sum = std::reduce(q.begin(), q.end());
+    float d = 0.f;
+    for (size_t i = 0; i < p.size(); i++)
+    {
+        auto p_value = p[i] / p_sum;
+        auto q_value = q[i] / q_sum;
+        if (p_value)
+            d += q_value ? p_value * std::log(p_value / q_value) : 1.f;
+    }
+
+    return d;
+}
+
+// The kld_m0 and l2 searches evaluate every candidate in float, which prefix sums cannot reproduce bit for bit.
+// Instead each candidate gets a lower bound on that float value: an estimate from prefix sums in O(dest_bins),
+// minus the worst case rounding of the float evaluation. Candidates are then evaluated in increasing order of
+// their bounds until the bound exceeds the best value, which finds the same threshold as the full sweep.
+constexpr double float_roundoff = std::numeric_limits<float>::epsilon() / 2;
+
+// Same result as sweeping all candidates and keeping each value strictly below the current minimum,
+// starting from FLT_MAX. `coarse` and `bound` must not exceed `value` for any candidate. `bound` is only
+// computed for candidates whose coarse bound does not already exceed the best value.
+template <class Coarse, class Bound, class Value>
+std::optional<std::pair<size_t, size_t>> search_threshold(size_t bins, size_t zero_threshold, size_t dest_bins, Coarse &&coarse, Bound &&bound, Value &&value)
+{
+    // Candidates in sweep order, where the first of equal values wins
+    std::vector<std::pair<size_t, size_t>> candidates;
+    for (size_t lower_threshold = 0; lower_threshold <= zero_threshold; lower_threshold++)
+    {
+        for (size_t upper_threshold = bins; upper_threshold >= lower_threshold + dest_bins && upper_threshold >= zero_threshold; upper_threshold--)
+            candidates.emplace_back(lower_threshold, upper_threshold);
+    }
+
+    // Min heap of (bound, candidate, refined)
+    using entry = std::tuple<double, size_t, bool>;
+    auto checked = [](double b) { return std::isnan(b) ? -std::numeric_limits<double>::infinity() : b; };
+    std::vector<entry> heap(candidates.size());
+    for (size_t i = 0; i < candidates.size(); i++)
+        heap[i] = { checked(coarse(candidates[i].first, candidates[i].second)), i, false };
+    std::make_heap(heap.begin(), heap.end(), std::greater<>());
+
+    std::optional<size_t> best;
+    auto min_value = std::numeric_limits<float>::max();
+    while (!heap.empty())
+    {
+        std::pop_heap(heap.begin(), heap.end(), std::greater<>());
+        auto [b, i, refined] = heap.back();
+        if (b > min_value)
+            break;
+
+        auto [lower_threshold, upper_threshold] = candidates[i];
+        if (!refined)
+        {
+            heap.back() = { checked(bound(lower_threshold, upper_threshold)), i, true };
+            std::push_heap(heap.begin(), heap.end(), std::greater<>());
+            continue;
+        }
+
+        heap.pop_back();
+        auto v = value(lower_threshold, upper_threshold);
+        if (v < min_value || (v == min_value && best && i < *best))
+        {
+            min_value = v;
+            best = i;
+        }
+    }
+
+    if (!best)
+        return std::nullopt;
+    return candidates[*best];
+}
+
+// Lower bounds of the KLD search_kld_m0 computes, from prefix sums of the source bins.
+//
+// Source bins inside a dest bin get its upsampled value, a source bin cut by the edge of two dest bins gets
+// both values by the cut fractions. With p' and q' the smoothed distributions,
+// KLD = (sum p' log p' - sum p' log q') / sum p' + log(sum q' / sum p').
+// - sum p' log p' expands (x - e) log(x - e) to second order in e, using prefix sums of x log x, log x and 1 / x.
+// - sum p' log q' is bounded above per group of dest bins by Jensen's inequality, with one log per group.
+class kld_m0_bound
+{
+public:
+    kld_m0_bound(const std::vector<float> &src_bins, size_t dest_bins, bool exact)
+        : src_bins_(src_bins), dest_bins_(dest_bins), exact_(exact)
+    {
+        const auto bins = src_bins.size();
+        sums_.resize(bins + 1);
+        nonzeros_.resize(bins + 1);
+        xlogx_.resize(bins + 1);
+        logx_.resize(bins + 1);
+        inv_.resize(bins + 1);
+        min_nonzero_ = std::numeric_limits<double>::infinity();
+        for (size_t i = 0; i < bins; i++)
+        {
+            double x = src_bins[i];
+            sums_[i + 1] = sums_[i] + x;
+            nonzeros_[i + 1] = nonzeros_[i] + (x ? 1 : 0);
+            xlogx_[i + 1] = xlogx_[i] + (x ? x * std::log(x) : 0);
+            logx_[i + 1] = logx_[i] + (x ? std::log(x) : 0);
+            inv_[i + 1] = inv_[i] + (x ? 1 / x : 0);
+            if (x)
+                min_nonzero_ = std::min(min_nonzero_, x);
+        }
+    }
+
+    double operator()(size_t lower_threshold, size_t upper_threshold)
+    {
+        constexpr auto unknown = -std::numeric_limits<double>::infinity();
+        constexpr auto never = std::numeric_limits<double>::infinity();
+        constexpr size_t group_size = 8;
+        const float eps = 0.0001f;
+        const auto bins = src_bins_.size();
+        const auto src_range = upper_threshold - lower_threshold;
+        const auto src_per_bin = (float)src_range / dest_bins_;
+        const auto range_dist = src_bins_.data() + lower_threshold;
+        auto window = [&](const std::vector<double> &prefix, size_t begin, size_t end) { return prefix[lower_threshold + end] - prefix[lower_threshold + begin]; };
+
+        // The first and last source bins also hold the outliers
+        const double first = range_dist[0] + sums_[lower_threshold];
+        const double last = range_dist[src_range - 1] + sums_[bins] - sums_[upper_threshold];
+
+        groups_.assign((dest_bins_ + group_size - 1) / group_size, group {});
+        double ups_sum = 0, unmatched_sum = 0, min_ups = std::numeric_limits<double>::infinity();
+        size_t ups_nonzeros = 0, unmatched_count = 0;
+        auto add = [&](group &g, double sum, double count, double upsample) {
+            if (!count)
+                return;
+            if (!upsample)
+            {
+                unmatched_sum += sum;
+                unmatched_count += (size_t)count;
+                return;
+            }
+
+            g.add(sum, count, upsample);
+            ups_sum += count * upsample;
+            ups_nonzeros += (size_t)count;
+            min_ups = std::min(min_ups, upsample);
+        };
+
+        float prev_end = 0, prev_right = 0;
+        double prev_upsample = 0;
+        for (size_t i = 0; i < dest_bins_; i++)
+        {
+            auto start = i * src_per_bin;
+            auto end = start + src_per_bin;
+            auto left_upper = (size_t)std::ceil(start);
+            auto right_lower = (size_t)std::floor(end);
+            auto left = left_upper > start ? left_upper - start : 0.f;
+            auto right = right_lower < end ? end - right_lower : 0.f;
+
+            // Adjacent dest bins must share their edge, and the last one must end at the window end
+            if (start != prev_end || left_upper > right_lower || (i + 1 == dest_bins_ && end != src_range))
+                return unknown;
+
+            double value = window(sums_, left_upper, right_lower);
+            double count = window(nonzeros_, left_upper, right_lower);
+            if (left)
+            {
+                value += left * range_dist[left_upper - 1];
+                count += range_dist[left_upper - 1] ? left : 0;
+            }
+            if (right)
+            {
+                value += right * range_dist[right_lower];
+                count += range_dist[right_lower] ? right : 0;
+            }
+
+            auto upsample = count ? value / count : 0;
+            auto &g = groups_[i / group_size];
+
+            // Source bin cut by the edge to the previous dest bin
+            if (left && range_dist[left_upper - 1])
+                add(g, range_dist[left_upper - 1], 1, prev_right * prev_upsample + left * upsample);
+
+            // Source bins inside, the first and last ones on their own
+            auto inner_begin = std::max<size_t>(left_upper, 1), inner_end = std::min(right_lower, src_range - 1);
+            if (inner_begin < inner_end)
+                add(g, window(sums_, inner_begin, inner_end), window(nonzeros_, inner_begin, inner_end), upsample);
+            if (left_upper == 0 && first)
+                add(g, first, 1, upsample);
+            if (right_lower == src_range && last)
+                add(g, last, 1, upsample);
+
+            prev_end = end;
+            prev_right = right;
+            prev_upsample = upsample;
+        }
+
+        const auto mid_nonzeros = window(nonzeros_, 1, src_range - 1);
+        const auto ref_nonzeros = (size_t)mid_nonzeros + (first ? 1 : 0) + (last ? 1 : 0);
+        auto ref_eps = smooth_epsilon(src_range, ref_nonzeros, eps);
+        auto ups_eps = smooth_epsilon(src_range, ups_nonzeros, eps);
+        if (!ref_eps || !ups_eps)
+            return never;
+
+        const double e_p = *ref_eps, e_q = *ups_eps;
+        auto min_ref = std::min({ min_nonzero_, first ? first : min_nonzero_, last ? last : min_nonzero_ });
+        if (e_p > min_ref / 2 || e_q > min_ups / 2)
+            return unknown;
+
+        // sum p' log p', the remainder of the expansion is in [0, e^3 / (6 (x - e)^2)] per source bin
+        const double log_eps = std::log((double)eps);
+        const auto ref_zeros = src_range - ref_nonzeros;
+        auto p_log_p = window(xlogx_, 1, src_range - 1) - e_p * (window(logx_, 1, src_range - 1) + mid_nonzeros)
+            + e_p * e_p / 2 * window(inv_, 1, src_range - 1) + ref_zeros * eps * log_eps;
+        if (first)
+            p_log_p += (first - e_p) * std::log(first - e_p);
+        if (last)
+            p_log_p += (last - e_p) * std::log(last - e_p);
+        auto remainder = mid_nonzeros * e_p * e_p * e_p / (6 * (min_nonzero_ - e_p) * (min_nonzero_ - e_p));
+
+        // sum p' log q' between per group bounds, source bins without an upsampled value get q' = eps
+        auto p_log_q_upper = (ref_zeros * eps + unmatched_sum - e_p * unmatched_count) * log_eps;
+        auto p_log_q_lower = p_log_q_upper;
+        for (auto &g : groups_)
+        {
+            if (!g.count)
+                continue;
+            auto weight = g.sum - e_p * g.count;
+            auto weighted = g.sum_upsample - e_q * g.sum - e_p * g.count_upsample + e_p * e_q * g.count;
+            p_log_q_upper += weight * std::log(weighted / weight);
+            p_log_q_lower += weight * std::log(g.min_upsample - e_q);
+        }
+
+        const double p_sum = sums_[bins] - e_p * ref_nonzeros + eps * ref_zeros;
+        const double q_sum = ups_sum - e_q * ups_nonzeros + eps * (src_range - ups_nonzeros);
+        const auto log_ratio = std::log(q_sum / p_sum);
+        const auto kld_lower = (p_log_p - p_log_q_upper) / p_sum + log_ratio;
+        const auto kld_upper = (p_log_p + remainder - p_log_q_lower) / p_sum + log_ratio;
+
+        // Rounding of the float KLD: p' and q' are within a and b relative roundings of their exact values, the sums
+        // normalizing them within src_range roundings. Summing the terms adds src_range roundings of
+        // sum |P log(P / Q)|, which is at most KLD + 2 TV <= KLD + sqrt(2 KLD) by Pinsker's inequality.
+        const auto u = float_roundoff;
+        const auto a = (exact_ ? 6 : 6 + 2 * bins) * u, b = (exact_ ? 30 : 30 + 2 * bins) * u, gamma = src_range * u;
+        const auto kld_max = std::max(kld_upper, 0.) + 1e-9;
+        const auto abs_terms = kld_max + std::sqrt(2 * kld_max);
+        auto tolerance = 2 * (abs_terms * (2 * a + 5 * u + 2 * gamma) + 2 * a + 2 * b + 2 * gamma + 6 * u)
+            + remainder / p_sum + 1e-12 * (std::abs(p_log_p) + std::abs(p_log_q_upper)) / p_sum + 1e-12;
+        return kld_lower - tolerance;
+    }
+
+private:
+    struct group
+    {
+        double sum = 0;
+        double count = 0;
+        double sum_upsample = 0;
+        double count_upsample = 0;
+        double min_upsample = std::numeric_limits<double>::infinity();
+
+        void add(double s, double c, double upsample) noexcept
+        {
+            sum += s;
+            count += c;
+            sum_upsample += s * upsample;
+            count_upsample += c * upsample;
+            min_upsample = std::min(min_upsample, upsample);
+        }
+    };
+
+    // Same epsilon as smooth_distribution_inplace, nullopt where it fails
+    static std::optional<double> smooth_epsilon(size_t size, size_t nonzeros, float eps)
+    {
+        if (!nonzeros)
+            return std::nullopt;
+        float eps1 = eps * static_cast<float>(size - nonzeros) / static_cast<float>(nonzeros);
+        if (eps1 >= 1.0)
+            return std::nullopt;
+        return eps1;
+    }
+
+private:
+    const std::vector<float> &src_bins_;
+    size_t dest_bins_;
+    bool exact_;
+    std::vector<double> sums_, nonzeros_, xlogx_, logx_, inv_;
+    double min_nonzero_;
+    std::vector<group> groups_;
+};
+
+// Lower bounds of compute_l2, built from prefix sums of the source bins. Source bins rounding to the same
+// quant value form a run whose loss is a quadratic in the bin index.
+class l2_bound
+{
+public:
+    l2_bound(const std::vector<float> &p, value_range<float> p_range, size_t q_bins)
+        : p_min_(p_range.min), p_interval_((p_range.max - p_range.min) / p.size()), q_bins_(q_bins)
+    {
+        const auto bins = p.size();
+        s0_.resize(bins + 1);
+        s1_.resize(bins + 1);
+        s2_.resize(bins + 1);
+        for (size_t i = 0; i < bins; i++)
+        {
+            double x = p[i];
+            s0_[i + 1] = s0_[i] + x;
+            s1_[i + 1] = s1_[i] + x * i;
+            s2_[i + 1] = s2_[i] + x * i * i;
+        }
+    }
+
+    double operator()(value_range<float> q_range) const
+    {
+        const auto bins = s0_.size() - 1;
+        const double p_min = p_min_, p_interval = p_interval_;
+        const double q_min = q_range.min, q_interval = (q_range.max - q_range.min) / (q_bins_ - 1);
+        if (!(p_interval > 0 && q_interval > 0))
+            return -std::numeric_limits<double>::infinity();
+
+        // Bins [begin, end) round to quant value k, the first bin of the next run is the first one >= k + 0.5
+        double loss = 0;
+        size_t begin = 0;
+        for (size_t k = 0; k < q_bins_; k++)
+        {
+            size_t end = bins;
+            if (k + 1 < q_bins_)
+            {
+                auto boundary = std::ceil((q_min + (k + 0.5) * q_interval - p_min) / p_interval);
+                end = std::max(begin, (size_t)std::clamp(boundary, 0., (double)bins));
+            }
+
+            loss += run_loss(begin, end, q_min + q_interval * k);
+            begin = end;
+        }
+
+        return lower_bound(loss, q_range);
+    }
+
+    // Loss of the bins clamped to the first and last quant values alone, in O(1)
+    double outliers(size_t lower_threshold, size_t upper_threshold, value_range<float> q_range) const
+    {
+        const auto bins = s0_.size() - 1;
+        const double q_interval = (q_range.max - q_range.min) / (q_bins_ - 1);
+        if (!(p_interval_ > 0 && q_interval > 0))
+            return -std::numeric_limits<double>::infinity();
+
+        auto loss = run_loss(0, lower_threshold, q_range.min) + run_loss(std::min(upper_threshold + 1, bins), bins, q_range.min + q_interval * (q_bins_ - 1));
+
+        // The float loss is only known to grow with the exact loss above this, see lower_bound
+        const auto e = distance_error(q_range, q_interval);
+        if (loss <= 16 * e * e * s0_[bins])
+            return -std::numeric_limits<double>::infinity();
+        return lower_bound(loss, q_range);
+    }
+
+private:
+    // Squared distances of bins [begin, end) to quant value q
+    double run_loss(size_t begin, size_t end, double q) const
+    {
+        auto n = s0_[end] - s0_[begin];
+        if (begin >= end || !n)
+            return 0;
+
+        // Moments of (i - begin), which keep the cancellation small
+        const double p_interval = p_interval_;
+        auto s1 = s1_[end] - s1_[begin];
+        auto i_sum = s1 - begin * n;
+        auto i2_sum = s2_[end] - s2_[begin] - 2. * begin * s1 + (double)begin * begin * n;
+        auto offset = p_min_ + p_interval * begin - q;
+        return offset * offset * n + 2 * offset * p_interval * i_sum + p_interval * p_interval * i2_sum;
+    }
+
+    double distance_error(value_range<float> q_range, double q_interval) const
+    {
+        const auto bins = s0_.size() - 1;
+        return 4 * float_roundoff * (std::abs(p_min_) + p_interval_ * bins + std::abs(q_range.min) + q_interval * q_bins_);
+    }
+
+    // compute_l2 differs by float rounding of each distance (E), of the sum, and by bins within
+    // rounding of a tie between two quant values (eta), whose squared distances differ by 2 eta q_interval^2.
+    double lower_bound(double loss, value_range<float> q_range) const
+    {
+        const auto bins = s0_.size() - 1;
+        const double q_interval = (q_range.max - q_range.min) / (q_bins_ - 1);
+        const auto u = float_roundoff;
+        const auto n = s0_[bins];
+        const auto e = distance_error(q_range, q_interval);
+        const auto eta = 4 * u * ((std::abs(p_min_) + p_interval_ * bins + std::abs(q_range.min)) / q_interval + q_bins_ + 1);
+        const auto cross = 2 * e * std::sqrt(n * loss) + e * e * n;
+        auto tolerance = cross + (bins + 8) * u * (loss + cross) + 2 * q_interval * q_interval * eta * n;
+        return loss - 2 * tolerance - 1e-9 * loss;
+    }
+
+private:
+    float p_min_;
+    float p_interval_;
+    size_t q_bins_;
+    std::vector<double> s0_, s1_, s2_;
+};
+
+// kld_m0 threshold search. Bin counts are integers, so while their total fits in a float mantissa
+// every window sum is exact and can be taken from prefix sums without changing any KLD bit.
+std::optional<std::pair<size_t, size_t>> search_kld_m0(const std::vector<float> &src_bins, size_t zero_threshold, size_t dest_bins)
+{
+    const auto bins = src_bins.size();
+    std::vector<uint64_t> sums(bins + 1), nonzeros(bins + 1);
+    bool exact = true;
+    for (size_t i = 0; i < bins; i++)
+    {
+        auto value = src_bins[i];
+        exact = exact && value >= 0 && value == std::floor(value);
+        sums[i + 1] = sums[i] + (exact ? (uint64_t)value : 0);
+        nonzeros[i + 1] = nonzeros[i] + (value ? 1 : 0);
+    }
+
+    exact = exact && sums[bins] <= (uint64_t(1) << std::numeric_limits<float>::digits);
+    auto sum = [&](size_t begin, size_t end) {
+        return exact ? (float)(sums[end] - sums[begin]) : std::reduce(src_bins.begin() + begin, src_bins.begin() + end);
+    };
+
+    std::vector<float> ref_dist;
+    std::vector<float> q_dist(dest_bins);
+    std::vector<float> ups_q_dist;
+    auto kld = [&](size_t lower_threshold, size_t upper_threshold) {
+        auto src_range = upper_threshold - lower_threshold;
+        auto src_per_bin = (float)src_range / dest_bins;
+        auto range_dist = src_bins.data() + lower_threshold;
+
+        // ref dist
+        ref_dist.assign(range_dist, range_dist + src_range);
+        ref_dist.front() += sum(0, lower_threshold);
+        ref_dist.back() += sum(upper_threshold, bins);
+
+        // quant dist
+        for (size_t i = 0; i < dest_bins; i++)
+        {
+            auto start = i * src_per_bin;
+            auto end = start + src_per_bin;
+            auto value = 0.f;
+
+            auto left_upper = (size_t)std::ceil(start);
+            auto right_lower = (size_t)std::floor(end);
+            if (left_upper > start)
+                value += (left_upper - start) * range_dist[left_upper - 1];
+            if (right_lower < end)
+                value += (end - right_lower) * range_dist[right_lower];
+            value += sum(lower_threshold + left_upper, lower_threshold + right_lower);
+            q_dist[i] = value;
+        }
+
+        // upsample quant dist
+        ups_q_dist.assign(src_range, 0.f);
+        for (size_t i = 0; i < dest_bins; i++)
+        {
+            auto start = i * src_per_bin;
+            auto end = start + src_per_bin;
+            auto count = 0.f;
+
+            auto left_upper = (size_t)std::ceil(start);
+            auto right_lower = (size_t)std::floor(end);
+            if (left_upper > start)
+            {
+                if (range_dist[left_upper - 1])
+                    count += (left_upper - start);
+            }
+            if (right_lower < end)
+            {
+                if (range_dist[right_lower])
+                    count += (end - right_lower);
+            }
+
+            count += (ptrdiff_t)(nonzeros[lower_threshold + right_lower] - nonzeros[lower_threshold + left_upper]);
+            if (!count)
+                continue;
+            auto upsample_value = q_dist[i] / count;
+            if (left_upper > start)
+            {
+                if (ref_dist[left_upper - 1])
+                    ups_q_dist[left_upper - 1] += (left_upper - start) * upsample_value;
+            }
+            if (right_lower < end)
+            {
+                if (ref_dist[right_lower])
+                    ups_q_dist[right_lower] += (end - right_lower) * upsample_value;
+            }
+
+            for (size_t j = left_upper; j < right_lower; j++)
+            {
+                if (ref_dist[j])
+                    ups_q_dist[j] += upsample_value;
+            }
+        }
+
+        return smooth_distribution_inplace(ref_dist) && smooth_distribution_inplace(ups_q_dist)
+            ? compute_kld_const(ref_dist, ups_q_dist)
+            : std::numeric_limits<float>::max();
+    };
+
+    // No bound cheaper than kld_m0_bound
+    auto coarse = [](size_t, size_t) { return -std::numeric_limits<double>::infinity(); };
+    return search_threshold(bins, zero_threshold, dest_bins, coarse, kld_m0_bound(src_bins, dest_bins, exact), kld);
+}
+
+std::optional<std::pair<size_t, size_t>> search_l2(const std::vector<float> &src_bins, value_range<float> range, float src_bin_interval, size_t zero_threshold, size_t dest_bins)
+{
+    auto q_range = [&](size_t lower_threshold, size_t upper_threshold) {
+        return value_range<float> { lower_threshold * src_bin_interval + range.min, upper_threshold * src_bin_interval + range.min };
+    };
+    l2_bound bound(src_bins, range, dest_bins);
+    return search_threshold(
+        src_bins.size(), zero_threshold, dest_bins,
+        [&](size_t lower_threshold, size_t upper_threshold) { return bound.outliers(lower_threshold, upper_threshold, q_range(lower_threshold, upper_threshold)); },
+        [&](size_t lower_threshold, size_t upper_threshold) { return bound(q_range(lower_threshold, upper_threshold)); },
+        [&](size_t lower_threshold, size_t upper_threshold) { return compute_l2(src_bins, range, q_range(lower_threshold, upper_threshold), dest_bins); });
+}
 }
 
 quantizer::quantizer([[maybe_unused]] calibrate_method cali_method, size_t bins)
@@ -274,6 +812,31 @@ void quantizer::record_quant_buffers(output_connector &connector, std::span<cons
         quant_buffers_insert_order_.push_back(&connector);
 }
 
+void quantizer::merge(const quantizer &other)
+{
+    for (auto &&p : other.quant_ranges_)
+        record(*p.first, p.second);
+    for (auto conn : other.ranges_insert_order_)
+    {
+        if (std::find(ranges_insert_order_.begin(), ranges_insert_order_.end(), conn) == ranges_insert_order_.end())
+            ranges_insert_order_.push_back(conn);
+    }
+
+    if (stage_ == quantize_stage::collect_distribution && other.stage_ == quantize_stage::collect_distribution)
+    {
+        for (auto &&h : other.histograms_)
+            histograms_.at(h.first).merge(h.second);
+    }
+
+    for (auto &&b : other.output_buffers_)
+        output_buffers_.emplace(b.first, b.second);
+    for (auto conn : other.quant_buffers_insert_order_)
+    {
+        if (std::find(quant_buffers_insert_order_.begin(), quant_buffers_insert_order_.end(), conn) == quant_buffers_insert_order_.end())
+            quant_buffers_insert_order_.push_back(conn);
+    }
+}
+
 void quantizer::begin_collect_distribution()
 {
     for (auto &&p : quant_ranges_)
@@ -287,14 +850,49 @@ void quantizer::begin_collect_distribution()
 
 void quantizer::end_collect_distribution(std::function<void(size_t cnt, size_t total)> progress)
 {
-    size_t i = 0;
+    std::vector<std::pair<ir::output_connector *const, histogram> *> items;
+    items.reserve(histograms_.size());
     for (auto &&h : histograms_)
+        items.emplace_back(&h);
+
+    // Histograms are independent, search their thresholds on the kernel thread pool.
+    std::mutex mutex;
+    std::exception_ptr error;
+    size_t done = 0;
+    kernels::parallel_for(kernels::default_kernel_context(), items.size(), [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++)
+        {
+            auto &hist = items[i]->second;
+            try
+            {
+                hist.finish();
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!error)
+                    error = std::current_exception();
+                continue;
+            }
+
+            std::lock_guard<std::mutex> lock(mutex);
+            if (progress)
+                progress(done++, items.size());
+        }
+    });
+
+    if (error)
+        std::rethrow_exception(error);
+
+    // Ranges are printed here in histogram order, so the log doesn't depend on which worker finished first.
+    for (auto item : items)
     {
-        std::cout << h.first->owner().name() << std::endl;
-        h.second.finish();
-        quant_ranges_.at(h.first) = h.second.optimal_range();
-        if (progress)
-            progress(i++, histograms_.size());
+        auto &[conn, hist] = *item;
+        auto range = hist.range();
+        auto optimal_range = hist.optimal_range();
+        std::cout << conn->owner().name() << std::endl
+                  << "{" << range.min << ", " << range.max << "} -> {" << optimal_range.min << ", " << optimal_range.max << "}" << std::endl;
+        quant_ranges_.at(conn) = optimal_range;
     }
 }
 
@@ -414,19 +1012,19 @@ void quantizer::broadcast_output(ir::node &node, const value_range<float> &range
 quantizer::histogram::histogram(value_range<float> range, size_t src_bins, size_t dest_bins, calibrate_method cali_method)
     : range_(range), optimal_range_(range_), cali_method_(cali_method)
 {
-    src_bins_.resize(src_bins);
+    src_counts_.resize(src_bins);
     dest_bins_.resize(dest_bins);
 
     auto r = range_.max - range_.min;
-    src_bin_interval_ = r / src_bins_.size();
+    src_bin_interval_ = r / src_counts_.size();
 }
 void quantizer::histogram::record(std::span<const bfloat16> data)
 {
     for (auto value : data)
     {
         auto r_index = (value - range_.min) / src_bin_interval_;
-        auto index = (size_t)std::clamp(r_index, 0.f, (float)src_bins_.size() - 1);
-        src_bins_[index]++;
+        auto index = (size_t)std::clamp(r_index, 0.f, (float)src_counts_.size() - 1);
+        src_counts_[index]++;
     }
 }
 void quantizer::histogram::record(std::span<const float> data)
@@ -434,8 +1032,8 @@ void quantizer::histogram::record(std::span<const float> data)
     for (auto value : data)
     {
         auto r_index = (value - range_.min) / src_bin_interval_;
-        auto index = (size_t)std::clamp(r_index, 0.f, (float)src_bins_.size() - 1);
-        src_bins_[index]++;
+        auto index = (size_t)std::clamp(r_index, 0.f, (float)src_counts_.size() - 1);
+        src_counts_[index]++;
     }
 }
 void quantizer::histogram::record(std::span<const half> data)
@@ -443,19 +1041,31 @@ void quantizer::histogram::record(std::span<const half> data)
     for (auto value : data)
     {
         auto r_index = (value - range_.min) / src_bin_interval_;
-        auto index = (size_t)std::clamp(r_index, 0.f, (float)src_bins_.size() - 1);
-        src_bins_[index]++;
+        auto index = (size_t)std::clamp(r_index, 0.f, (float)src_counts_.size() - 1);
+        src_counts_[index]++;
     }
 }
 
+void quantizer::histogram::merge(const histogram &other)
+{
+    assert(src_counts_.size() == other.src_counts_.size());
+    for (size_t i = 0; i < src_counts_.size(); i++)
+        src_counts_[i] += other.src_counts_[i];
+}
+
 void quantizer::histogram::finish()
 {
+    src_bins_.assign(src_counts_.begin(), src_counts_.end());
     auto zero_threshold = (size_t)std::clamp((0 - range_.min) / src_bin_interval_, 0.f, (float)src_bins_.size() - 1);
     assert(zero_threshold < src_bins_.size());
     std::optional<std::pair<size_t, size_t>> threshold;
     const auto dest_bins = dest_bins_.size();
 
-    if (cali_method_ == calibrate_method::kld_m0 || cali_method_ == calibrate_method::kld_m1)
+    if (cali_method_ == calibrate_method::kld_m0)
+    {
+        threshold = search_kld_m0(src_bins_, zero_threshold, dest_bins);
+    }
+    else if (cali_method_ == calibrate_method::kld_m1)
     {
         auto min_kld = std::numeric_limits<float>::max();
 
@@ -473,11 +1083,8 @@ void quantizer::histogram::finish()
                 ref_dist.front() += std::reduce(src_bins_.begin(), src_bins_.begin() + lower_threshold);
                 ref_dist.back() += std::reduce(src_bins_.begin() + upper_threshold, src_bins_.end());
 
-                if (cali_method_ == calibrate_method::kld_m1)
-                {
-                    range_dist.front() += std::reduce(src_bins_.begin(), src_bins_.begin() + lower_threshold);
-                    range_dist.back() += std::reduce(src_bins_.begin() + upper_threshold, src_bins_.end());
-                }
+                range_dist.front() += std::reduce(src_bins_.begin(), src_bins_.begin() + lower_threshold);
+                range_dist.back() += std::reduce(src_bins_.begin() + upper_threshold, src_bins_.end());
 
                 // quant dist
                 std::vector<float> q_dist(dest_bins);
@@ -540,21 +1147,13 @@ void quantizer::histogram::finish()
                     }
                 }
 
-                float kld = 0.f;
-                if (cali_method_ == calibrate_method::kld_m1)
-                {
-                    std::vector<float> ups2_q_dist(src_bins_.size());
-                    std::copy(ups_q_dist.begin(), ups_q_dist.end(), ups2_q_dist.begin() + lower_threshold);
-                    src_bins_ = smooth_distribution(src_bins_);
-                    ups2_q_dist = smooth_distribution(ups2_q_dist);
-                    kld = compute_kld(src_bins_, ups2_q_dist);
-                }
-                else
-                {
-                    ref_dist = smooth_distribution(ref_dist);
-                    ups_q_dist = smooth_distribution(ups_q_dist);
-                    kld = compute_kld(ref_dist, ups_q_dist);
-                }
+                // kld_m1 compares against the whole source histogram, which compute_kld renormalizes in place,
+                // so every candidate depends on the previous ones and the search stays sequential.
+                std::vector<float> ups2_q_dist(src_bins_.size());
+                std::copy(ups_q_dist.begin(), ups_q_dist.end(), ups2_q_dist.begin() + lower_threshold);
+                src_bins_ = smooth_distribution(src_bins_);
+                ups2_q_dist = smooth_distribution(ups2_q_dist);
+                auto kld = compute_kld(src_bins_, ups2_q_dist);
                 if (kld < min_kld)
                 {
                     min_kld = kld;
@@ -666,23 +1265,7 @@ void quantizer::histogram::finish()
     }
     else if (cali_method_ == calibrate_method::l2)
     {
-        auto min_loss = std::numeric_limits<float>::max();
-
-        for (size_t lower_threshold = 0; lower_threshold <= zero_threshold; lower_threshold++)
-        {
-            for (size_t upper_threshold = src_bins_.size(); upper_threshold >= lower_threshold + dest_bins && upper_threshold >= zero_threshold; upper_threshold--)
-            {
-                auto dest_min = lower_threshold * src_bin_interval_ + range_.min;
-                auto dest_max = upper_threshold * src_bin_interval_ + range_.min;
-
-                auto loss = compute_l2(src_bins_, range_, { dest_min, dest_max }, dest_bins);
-                if (loss < min_loss)
-                {
-                    min_loss = loss;
-                    threshold = { lower_threshold, upper_threshold };
-                }
-            }
-        }
+        threshold = search_l2(src_bins_, range_, src_bin_interval_, zero_threshold, dest_bins);
     }
     else if (cali_method_ == calibrate_method::cdf)
     {
@@ -712,6 +1295,4 @@ void quantizer::histogram::finish()
         auto opt_max = (threshold->second + 0.5f) * src_bin_interval_ + range_.min;
         optimal_range_ = { opt_min, opt_max };
     }
-
-    std::cout << "{" << range_.min << ", " << range_.max << "} -> {" << optimal_range_.min << ", " << optimal_range_.max << "}" << std::endl;
 }
@@ -13,6 +13,7 @@
  * limitations under the License.
  */
 #include <nncase/ir/graph.h>
+#include <algorithm>
 #include <nncase/ir/ops/call.h>
 #include <nncase/ir/visitor.h>
 #include <nncase/runtime/stackvm/runtime_module.h>
@@ -23,7 +24,7 @@ using namespace nncase::ir;
 
 namespace
 {
-std::unordered_set<node_opcode> dontcse_ops { op_input_node, op_output_node, op_uninitialized, op_constant, op_ignore_node };
+std::unordered_set<node_opcode> dontcse_ops { op_input_node, op_output_node, op_uninitialized, op_ignore_node };
 std::unordered_set<char> char_need_escape = { '/', ':' };
 
 void add_reachable_graphs(graph &root, std::vector<graph *> &graphs)
@@ -240,49 +241,47 @@ graph &graph::add_subgraph(std::unique_ptr<graph> subgraph)
 
 void graph::cse()
 {
-    std::unordered_set<node *> csed_nodes;
-
-    while (true)
+    // Value numbering: each sweep buckets nodes by structural hash and merges a node into the
+    // first earlier node it equals. Merging rewires consumers, which may make them equal too,
+    // so sweep again until nothing changes.
+    std::unordered_map<size_t, std::vector<node *>> values;
+    bool merged;
+    do
     {
-        for (size_t i = 0; i < nodes_.size() - 1; i++)
+        merged = false;
+        values.clear();
+        values.reserve(nodes_.size());
+        for (auto &jnode : nodes_)
         {
-            auto &inode = nodes_[i];
-            if (csed_nodes.contains(inode.get()))
+            if (dontcse_ops.contains(jnode->runtime_opcode()))
                 continue;
 
-            for (size_t j = i + 1; j < nodes_.size(); j++)
+            auto &bucket = values[jnode->hash()];
+            auto it = std::find_if(bucket.begin(), bucket.end(), [&](node *inode) {
+                return inode->module_type() == jnode->module_type() && inode->equals(*jnode);
+            });
+
+            if (it == bucket.end())
             {
-                auto &jnode = nodes_[j];
-                if (csed_nodes.contains(jnode.get()))
-                    continue;
+                bucket.emplace_back(jnode.get());
+                continue;
+            }
 
-                if (!dontcse_ops.contains(inode->runtime_opcode())
-                    && inode->module_type() == jnode->module_type()
-                    && inode->equals(*jnode))
-                {
-                    for (size_t oi = 0; oi < inode->outputs().size(); oi++)
-                    {
-                        auto &output = inode->output_at(oi);
-                        auto inputs = dup(jnode->output_at(oi).connections());
-                        for (auto in : inputs)
-                            in->connect(output);
-                    }
-
-                    csed_nodes.emplace(jnode.get());
-                }
+            auto inode = *it;
+            for (size_t oi = 0; oi < inode->outputs().size(); oi++)
+            {
+                auto &output = inode->output_at(oi);
+                auto inputs = dup(jnode->output_at(oi).connections());
+                for (auto in : inputs)
+                    in->connect(output);
             }
+
+            merged = true;
         }
 
-        if (!csed_nodes.empty())
-        {
+        if (merged)
             dce();
-            csed_nodes.clear();
-        }
-        else
-        {
-            break;
-        }
-    }
+    } while (merged);
 }
 
 std::vector<graph *> graph::reachable_graphs() noexcept
@@ -46,3 +46,20 @@ bool node::equals(node &other) const
 
     return false;
 }
+
+size_t node::hash() const
+{
+    // Nodes that are equal must hash the same, so only fields compared by equals are mixed in.
+    auto seed = std::hash<node_opcode>()(runtime_opcode());
+    auto combine = [&](size_t value) { seed ^= value + 0x9e3779b9 + (seed << 6) + (seed >> 2); };
+    combine((size_t)attributes());
+    for (auto in : inputs())
+        combine(std::hash<output_connector *>()(in->connection()));
+    combine(properties_hash());
+    return seed;
+}
+
+size_t node::properties_hash() const
+{
+    return 0;
+}
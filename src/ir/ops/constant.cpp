@@ -14,6 +14,7 @@
  */
 #include <nncase/ir/op_utils.h>
 #include <nncase/ir/ops/constant.h>
+#include <string_view>
 
 using namespace nncase;
 using namespace nncase::ir;
@@ -21,5 +22,17 @@ using namespace nncase::ir;
 bool constant::properties_equal(node &other) const
 {
     auto &r = static_cast<constant &>(other);
-    return datatype_ == r.datatype_ && data_ == r.data_ && this->output_at(0).shape() == other.output_at(0).shape();
+    return datatype_ == r.datatype_ && alignment_ == r.alignment_
+        && output().memory_location() == r.output().memory_location()
+        && output().attributes() == r.output().attributes()
+        && output().shape() == r.output().shape()
+        && data_ == r.data_;
+}
+
+size_t constant::properties_hash() const
+{
+    // Data never changes after construction, so weights are hashed only once.
+    if (!data_hash_)
+        data_hash_ = std::hash<std::string_view>()(std::string_view(reinterpret_cast<const char *>(data_.data()), data_.size()));
+    return *data_hash_ ^ ((size_t)datatype_ << 1) ^ ((size_t)output().memory_location() << 9);
 }
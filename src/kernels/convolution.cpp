@@ -35,9 +35,7 @@ result<void> kernels::conv2d(const float *input, const float *weights, const flo
 
     if (is_contiguous(in_shape, in_strides)
         && is_contiguous(w_shape, w_strides)
-        && is_contiguous({ batch, out_channels, out_h, out_w }, w_strides)
-        && dilation_h == 1
-        && dilation_w == 1)
+        && is_contiguous({ batch, out_channels, out_h, out_w }, out_strides))
     {
         if (cpu::optimized::conv2d(input, weights, bias, output,
                 in_shape, in_strides, w_shape,
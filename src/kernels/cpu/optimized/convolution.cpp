@@ -12,18 +12,17 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  */
+#include <algorithm>
 #include <nncase/kernels/cpu/optimized/tensor_compute.h>
 #include <nncase/kernels/kernel_utils.h>
 #include <nncase/runtime/runtime_op_utility.h>
 #include <utility>
+#include <vector>
 #ifdef NNCASE_HALIDE
 #include <hkg/export/HalideBuffer.h>
 #include <hkg/export/halide_conv2d.h>
 #include <hkg/export/halide_conv2d_depthwise.h>
 #endif
-#ifdef NNCASE_OPENMP
-#include <omp.h>
-#endif
 
 #define CONV_ARGS input, weights, bias, output,           \
                   in_shape, in_strides, w_shape,          \
@@ -71,18 +70,12 @@ result<void> conv2d_1x1_s1(const float *input, const float *weights, const float
     NNCASE_UNUSED int32_t dilation_h, NNCASE_UNUSED int32_t dilation_w, value_range<float> fused_activation, NNCASE_UNUSED kernels::kernel_context &context) noexcept
 {
     const auto widths = in_shape[2] * in_shape[3];
-    // if oc's type is size_t, openmp will throw error in visual studio
-    // if no cast, compiler will throw warning because of comparison of integer expressions of different signedness
-    // warning be treated as errors
     const auto out_channels = w_shape[0];
 
-    for (size_t batch = 0; batch < in_shape[0]; batch++)
-    {
-#ifdef NNCASE_OPENMP
-#pragma omp parallel for num_threads(context.num_threads)
-#endif
-        for (size_t oc = 0; oc < out_channels; oc++)
+    parallel_for(context, in_shape[0] * out_channels, [&](size_t begin, size_t end) {
+        for (size_t task = begin; task < end; task++)
         {
+            const size_t batch = task / out_channels, oc = task % out_channels;
             const auto out_c = oc;
             const float *now_weights = weights + out_c * w_strides[0];
             const float *now_img_start = input + batch * in_strides[0];
@@ -144,7 +137,7 @@ result<void> conv2d_1x1_s1(const float *input, const float *weights, const float
                 *(now_output_channel_start + i) = kernels::detail::apply_activation(*(now_output_channel_start + i), fused_activation);
             }
         }
-    }
+    });
     return ok();
 }
 
@@ -163,13 +156,10 @@ result<void> conv2d_1x1_s2(const float *input, const float *weights, const float
 
     const size_t tailstep = in_w - (out_w * stride_w);
 
-    for (size_t b = 0; b < batch; b++)
-    {
-#ifdef NNCASE_OPENMP
-#pragma omp parallel for num_threads(context.num_threads)
-#endif
-        for (size_t oc = 0; oc < out_channels; oc++)
+    parallel_for(context, batch * out_channels, [&](size_t begin, size_t end) {
+        for (size_t task = begin; task < end; task++)
         {
+            const size_t b = task / out_channels, oc = task % out_channels;
             float *out = output + (b * out_strides[0] + oc * out_strides[1]);
 
             std::fill(out, out + out_h * out_w, bias[oc]);
@@ -239,7 +229,7 @@ result<void> conv2d_1x1_s2(const float *input, const float *weights, const float
                 }
             }
         }
-    }
+    });
     return ok();
 }
 
@@ -393,13 +383,10 @@ result<void> conv2d_nxm(const float *input, const float *weights, const float *b
     const auto out_h = kernels::detail::get_windowed_output_size(in_h, Filter_h, Stride_h, dilation_h, padding::zero());
     const auto out_w = kernels::detail::get_windowed_output_size(in_w, Filter_w, Stride_w, dilation_w, padding::zero());
     const size_t tail_step = in_strides[2] - (out_w * Stride_w);
-    for (size_t b = 0; b < batch; b++) // batch
-    {
-#ifdef NNCASE_OPENMP
-#pragma omp parallel for num_threads(context.num_threads)
-#endif
-        for (size_t oc = 0; oc < out_channels; oc++) // out channel
+    parallel_for(context, batch * out_channels, [&](size_t begin, size_t end) {
+        for (size_t task = begin; task < end; task++) // (batch, out channel)
         {
+            const size_t b = task / out_channels, oc = task % out_channels;
             std::array<float *, Parallel> outptr;
             std::array<const float *, compute_rsize<Parallel, Stride_h, Filter_h>()> r;
             std::array<const float *, Filter_h> k;
@@ -424,7 +411,7 @@ result<void> conv2d_nxm(const float *input, const float *weights, const float *b
                 }
             }
         }
-    }
+    });
     return ok();
 }
 
@@ -441,14 +428,10 @@ result<void> conv2d_depthwise_nxm(const float *input, const float *weights, cons
     const auto out_w = kernels::detail::get_windowed_output_size(in_w, Filter_w, Stride_w, dilation_w, padding::zero());
 
     const size_t tail_step = in_strides[2] - (out_w * Stride_w);
-    for (size_t b = 0; b < batch; b++) // batch
-    {
-
-#ifdef NNCASE_OPENMP
-#pragma omp parallel for num_threads(context.num_threads)
-#endif
-        for (size_t c = 0; c < channels; c++) // channel
+    parallel_for(context, batch * channels, [&](size_t begin, size_t end) {
+        for (size_t task = begin; task < end; task++) // (batch, channel)
         {
+            const size_t b = task / channels, c = task % channels;
             std::array<float *, Parallel> outptr;
             std::array<const float *, compute_rsize<Parallel, Stride_h, Filter_h>()> r;
             std::array<const float *, Filter_h> k;
@@ -470,9 +453,337 @@ result<void> conv2d_depthwise_nxm(const float *input, const float *weights, cons
                 }
             }
         }
+    });
+    return ok();
+}
+
+namespace
+{
+// Conv kernels below read contiguous NCHW input, OIHW weights and write contiguous NCHW output.
+struct conv_geometry
+{
+    size_t batch, in_channels, in_h, in_w;
+    size_t out_channels, out_h, out_w;
+    size_t filter_h, filter_w;
+    size_t groups;
+    int32_t pad_top, pad_left;
+    int32_t stride_h, stride_w, dilation_h, dilation_w;
+
+    size_t in_group_channels() const noexcept { return in_channels / groups; }
+    size_t out_group_channels() const noexcept { return out_channels / groups; }
+};
+
+// Budget of a scratch block (im2col rows, Winograd transformed tiles), about the size of L2.
+constexpr size_t conv_block_bytes = 2 * 1024 * 1024;
+
+// Kernel selection thresholds, see optimized::conv2d.
+constexpr size_t winograd_min_channels = 16;
+constexpr size_t gemm_min_reduction = 16;
+constexpr size_t gemm_min_group_channels = 4;
+
+/* im2col + GEMM */
+
+// Unfolds output rows [oh_begin, oh_begin + rows) of one group into col, a [ic * kh * kw, rows * out_w]
+// matrix whose row (ic, ky, kx) holds the input pixels that tap (ky, kx) sees, zero where it hits padding.
+void im2col(const conv_geometry &g, const float *input, size_t oh_begin, size_t rows, float *col, kernel_context &context) noexcept
+{
+    const auto k_size = g.in_group_channels() * g.filter_h * g.filter_w;
+    const auto cols = rows * g.out_w;
+    parallel_for(context, k_size, kernels::detail::parallel_grain(cols), [&](size_t begin, size_t end) {
+        for (size_t k = begin; k < end; k++)
+        {
+            const auto kx = k % g.filter_w;
+            const auto ky = k / g.filter_w % g.filter_h;
+            const auto ic = k / (g.filter_w * g.filter_h);
+            const float *in_c = input + ic * g.in_h * g.in_w;
+            float *dst = col + k * cols;
+
+            // Output columns [x_begin, x_end) read inside the image on this tap.
+            const auto x_offset = (int32_t)kx * g.dilation_w - g.pad_left;
+            const auto x_begin = (size_t)std::clamp<int64_t>((-x_offset + g.stride_w - 1) / g.stride_w, 0, g.out_w);
+            const auto x_end = (size_t)std::clamp<int64_t>(((int64_t)g.in_w - x_offset + g.stride_w - 1) / g.stride_w, x_begin, g.out_w);
+            for (size_t r = 0; r < rows; r++, dst += g.out_w)
+            {
+                const auto iy = (int64_t)(oh_begin + r) * g.stride_h - g.pad_top + (int64_t)ky * g.dilation_h;
+                if (iy < 0 || iy >= (int64_t)g.in_h)
+                {
+                    std::fill_n(dst, g.out_w, 0.f);
+                    continue;
+                }
+
+                const float *in_row = in_c + iy * g.in_w;
+                std::fill_n(dst, x_begin, 0.f);
+                if (g.stride_w == 1)
+                {
+                    std::copy_n(in_row + x_begin + x_offset, x_end - x_begin, dst + x_begin);
+                }
+                else
+                {
+                    for (size_t x = x_begin; x < x_end; x++)
+                        dst[x] = in_row[(int64_t)x * g.stride_w + x_offset];
+                }
+                std::fill(dst + x_end, dst + g.out_w, 0.f);
+            }
+        }
+    });
+}
+
+// out[oc, p] = act(out[oc, p] + bias[oc]) over a [channels, pixels] block with row stride ldo.
+void add_bias_activation(float *out, size_t ldo, const float *src, size_t lds, const float *bias, size_t channels, size_t pixels,
+    value_range<float> fused_activation, kernel_context &context) noexcept
+{
+    parallel_for(context, channels, kernels::detail::parallel_grain(pixels), [&](size_t begin, size_t end) {
+        for (size_t oc = begin; oc < end; oc++)
+        {
+            const float *s = src + oc * lds;
+            float *o = out + oc * ldo;
+            for (size_t p = 0; p < pixels; p++)
+                o[p] = kernels::detail::apply_activation(s[p] + bias[oc], fused_activation);
+        }
+    });
+}
+
+result<void> conv2d_im2col(const conv_geometry &g, const float *input, const float *weights, const float *bias, float *output,
+    value_range<float> fused_activation, kernel_context &context) noexcept
+{
+    const auto ic_g = g.in_group_channels(), oc_g = g.out_group_channels();
+    const auto k_size = ic_g * g.filter_h * g.filter_w;
+    const auto out_pixels = g.out_h * g.out_w;
+    const bool pointwise = g.filter_h == 1 && g.filter_w == 1 && g.stride_h == 1 && g.stride_w == 1
+        && g.pad_top == 0 && g.pad_left == 0 && g.out_h == g.in_h && g.out_w == g.in_w;
+
+    // A 1x1 stride-1 conv is already a GEMM over the input, otherwise unfold enough
+    // output rows at a time to keep the col block within budget.
+    const auto rows = pointwise ? g.out_h : std::clamp(conv_block_bytes / sizeof(float) / std::max(k_size * g.out_w, size_t(1)), size_t(1), g.out_h);
+    const auto block_pixels = rows * g.out_w;
+    const bool whole_image = rows == g.out_h;
+
+    std::vector<float> col, zeros, scratch;
+    try
+    {
+        if (!pointwise)
+            col.resize(k_size * block_pixels);
+        zeros.resize(block_pixels);
+        if (!whole_image)
+            scratch.resize(oc_g * block_pixels);
+    }
+    catch (...)
+    {
+        return err(std::errc::not_enough_memory);
+    }
+
+    for (size_t b = 0; b < g.batch; b++)
+    {
+        for (size_t group = 0; group < g.groups; group++)
+        {
+            const float *in_g = input + (b * g.in_channels + group * ic_g) * g.in_h * g.in_w;
+            const float *w_g = weights + group * oc_g * k_size;
+            const float *bias_g = bias + group * oc_g;
+            float *out_g = output + (b * g.out_channels + group * oc_g) * out_pixels;
+
+            for (size_t oh = 0; oh < g.out_h; oh += rows)
+            {
+                const auto block_rows = std::min(rows, g.out_h - oh);
+                const auto pixels = block_rows * g.out_w;
+                const float *b_mat = in_g;
+                if (!pointwise)
+                {
+                    im2col(g, in_g, oh, block_rows, col.data(), context);
+                    b_mat = col.data();
+                }
+
+                // The GEMM's bias runs along pixels, so it gets zeros and the channel bias is added after.
+                float *dst = whole_image ? out_g : scratch.data();
+                try_(optimized::matmul(w_g, b_mat, zeros.data(), dst, { oc_g, k_size }, { k_size, 1 }, { k_size, pixels }, { pixels, 1 },
+                    { oc_g, pixels }, { pixels, 1 }, value_range<float>::full(), context));
+                add_bias_activation(out_g + oh * g.out_w, out_pixels, dst, pixels, bias_g, oc_g, pixels, fused_activation, context);
+            }
+        }
     }
+
+    return ok();
+}
+
+/* Winograd F(4x4, 3x3) */
+
+constexpr size_t wino_in = 6;
+constexpr size_t wino_out = 4;
+constexpr size_t wino_points = wino_in * wino_in;
+
+// u = G g G^T, the 3x3 kernel g expanded to 6x6.
+void winograd_weights(const float *g, float *u, size_t u_stride) noexcept
+{
+    static constexpr float G[wino_in][3] = {
+        { 1.f / 4, 0, 0 },
+        { -1.f / 6, -1.f / 6, -1.f / 6 },
+        { -1.f / 6, 1.f / 6, -1.f / 6 },
+        { 1.f / 24, 1.f / 12, 1.f / 6 },
+        { 1.f / 24, -1.f / 12, 1.f / 6 },
+        { 0, 0, 1 }
+    };
+
+    float tmp[wino_in][3];
+    for (size_t i = 0; i < wino_in; i++)
+        for (size_t j = 0; j < 3; j++)
+            tmp[i][j] = G[i][0] * g[j] + G[i][1] * g[3 + j] + G[i][2] * g[6 + j];
+
+    for (size_t i = 0; i < wino_in; i++)
+        for (size_t j = 0; j < wino_in; j++)
+            u[(i * wino_in + j) * u_stride] = tmp[i][0] * G[j][0] + tmp[i][1] * G[j][1] + tmp[i][2] * G[j][2];
+}
+
+// One 6-point row or column of B^T d B.
+inline void winograd_input_1d(const float *d, size_t step, float *v, size_t v_step) noexcept
+{
+    const auto d0 = d[0], d1 = d[step], d2 = d[2 * step], d3 = d[3 * step], d4 = d[4 * step], d5 = d[5 * step];
+    v[0] = 4 * d0 - 5 * d2 + d4;
+    v[v_step] = -4 * (d1 + d2) + d3 + d4;
+    v[2 * v_step] = 4 * (d1 - d2) - d3 + d4;
+    v[3 * v_step] = 2 * (d3 - d1) - d2 + d4;
+    v[4 * v_step] = 2 * (d1 - d3) - d2 + d4;
+    v[5 * v_step] = 4 * d1 - 5 * d3 + d5;
+}
+
+// One 6-point row or column of A^T m A.
+inline void winograd_output_1d(const float *m, size_t step, float *y, size_t y_step) noexcept
+{
+    const auto m0 = m[0], m1 = m[step], m2 = m[2 * step], m3 = m[3 * step], m4 = m[4 * step], m5 = m[5 * step];
+    const auto a = m1 + m2, b = m1 - m2, c = m3 + m4, d = m3 - m4;
+    y[0] = m0 + a + c;
+    y[y_step] = b + 2 * d;
+    y[2 * y_step] = a + 4 * c;
+    y[3 * y_step] = b + 8 * d + m5;
+}
+
+result<void> conv2d_winograd(const conv_geometry &g, const float *input, const float *weights, const float *bias, float *output,
+    value_range<float> fused_activation, kernel_context &context) noexcept
+{
+    const auto ic = g.in_channels, oc = g.out_channels;
+    const auto tiles_h = (g.out_h + wino_out - 1) / wino_out;
+    const auto tiles_w = (g.out_w + wino_out - 1) / wino_out;
+    const auto tiles = tiles_h * tiles_w;
+    // Transformed input and products of a block of tiles stay within budget.
+    const auto block = std::clamp(conv_block_bytes / sizeof(float) / (wino_points * (ic + oc)), size_t(1), tiles);
+
+    // u[p][oc][ic], v[p][ic][t], m[p][oc][t] for each of the 36 points p of a tile.
+    auto transform_weights = [&](float *out) {
+        parallel_for(context, oc * ic, kernels::detail::parallel_grain(wino_points * 9), [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++)
+                winograd_weights(weights + i * 9, out + i, oc * ic);
+        });
+    };
+
+    // Constant weights are transformed on the first call only.
+    const float *u = cached_weights(context, weights, oc * ic * 9 * sizeof(float), wino_points * oc * ic, transform_weights);
+    std::vector<float> u_local, v, m, zeros;
+    try
+    {
+        if (!u)
+            u_local.resize(wino_points * oc * ic);
+        v.resize(wino_points * ic * block);
+        m.resize(wino_points * oc * block);
+        zeros.resize(block);
+    }
+    catch (...)
+    {
+        return err(std::errc::not_enough_memory);
+    }
+
+    if (!u)
+    {
+        transform_weights(u_local.data());
+        u = u_local.data();
+    }
+
+    for (size_t b = 0; b < g.batch; b++)
+    {
+        const float *in_b = input + b * ic * g.in_h * g.in_w;
+        float *out_b = output + b * oc * g.out_h * g.out_w;
+        for (size_t t0 = 0; t0 < tiles; t0 += block)
+        {
+            const auto count = std::min(block, tiles - t0);
+
+            // 1. v = B^T d B for every input channel of every tile, zero outside the image.
+            parallel_for(context, ic, kernels::detail::parallel_grain(count * wino_points * 4), [&](size_t begin, size_t end) {
+                float d[wino_points], tmp[wino_points];
+                for (size_t c = begin; c < end; c++)
+                {
+                    const float *in_c = in_b + c * g.in_h * g.in_w;
+                    for (size_t t = 0; t < count; t++)
+                    {
+                        const auto ty = (t0 + t) / tiles_w, tx = (t0 + t) % tiles_w;
+                        const auto y0 = (int64_t)(ty * wino_out) - g.pad_top;
+                        const auto x0 = (int64_t)(tx * wino_out) - g.pad_left;
+                        for (size_t i = 0; i < wino_in; i++)
+                        {
+                            const auto y = y0 + (int64_t)i;
+                            for (size_t j = 0; j < wino_in; j++)
+                            {
+                                const auto x = x0 + (int64_t)j;
+                                d[i * wino_in + j] = y >= 0 && y < (int64_t)g.in_h && x >= 0 && x < (int64_t)g.in_w ? in_c[y * g.in_w + x] : 0.f;
+                            }
+                        }
+
+                        for (size_t j = 0; j < wino_in; j++)
+                            winograd_input_1d(d + j, wino_in, tmp + j, wino_in);
+                        float *v_ct = v.data() + c * count + t;
+                        const auto v_step = ic * count;
+                        for (size_t i = 0; i < wino_in; i++)
+                            winograd_input_1d(tmp + i * wino_in, 1, v_ct + i * wino_in * v_step, v_step);
+                    }
+                }
+            });
+
+            // 2. m[p] = u[p] * v[p], one small GEMM per point. Nested calls run inline,
+            //    so the points rather than the GEMMs are spread across threads.
+            //    try_ declares its own v, so v is only named outside of it.
+            auto gemms = try_parallel_for(context, wino_points, 1, [&](size_t begin, size_t end) -> result<void> {
+                for (size_t p = begin; p < end; p++)
+                {
+                    const auto v_p = v.data() + p * ic * count;
+                    try_(optimized::matmul(u + p * oc * ic, v_p, zeros.data(),
+                        m.data() + p * oc * count, { oc, ic }, { ic, 1 }, { ic, count }, { count, 1 }, { oc, count }, { count, 1 },
+                        value_range<float>::full(), context));
+                }
+
+                return ok();
+            });
+            try_(gemms);
+
+            // 3. y = A^T m A plus bias, clipped to the output.
+            parallel_for(context, oc, kernels::detail::parallel_grain(count * wino_points * 4), [&](size_t begin, size_t end) {
+                float mt[wino_points], tmp[wino_out * wino_in], y[wino_out * wino_out];
+                for (size_t c = begin; c < end; c++)
+                {
+                    float *out_c = out_b + c * g.out_h * g.out_w;
+                    for (size_t t = 0; t < count; t++)
+                    {
+                        const float *m_ct = m.data() + c * count + t;
+                        for (size_t p = 0; p < wino_points; p++)
+                            mt[p] = m_ct[p * oc * count];
+                        for (size_t j = 0; j < wino_in; j++)
+                            winograd_output_1d(mt + j, wino_in, tmp + j, wino_in);
+                        for (size_t i = 0; i < wino_out; i++)
+                            winograd_output_1d(tmp + i * wino_in, 1, y + i * wino_out, 1);
+
+                        const auto ty = (t0 + t) / tiles_w, tx = (t0 + t) % tiles_w;
+                        const auto rows = std::min(wino_out, g.out_h - ty * wino_out);
+                        const auto cols = std::min(wino_out, g.out_w - tx * wino_out);
+                        for (size_t i = 0; i < rows; i++)
+                        {
+                            float *out_row = out_c + (ty * wino_out + i) * g.out_w + tx * wino_out;
+                            for (size_t j = 0; j < cols; j++)
+                                out_row[j] = kernels::detail::apply_activation(y[i * wino_out + j] + bias[c], fused_activation);
+                        }
+                    }
+                }
+            });
+        }
+    }
+
     return ok();
 }
+}
 
 #ifdef NNCASE_HALIDE
 #define HALIDE_CONV2D_NXM_S1_S2(KH, KW)                                                                                               \
@@ -527,9 +838,12 @@ result<void> optimized::conv2d(const float *input, const float *weights, const f
 {
     const auto filter_h = w_shape[2];
     const auto filter_w = w_shape[3];
+    const bool unpadded = padding_h.before == 0 && padding_h.after == 0 && padding_w.before == 0 && padding_w.after == 0;
+    const bool undilated = dilation_h == 1 && dilation_w == 1;
+    const bool depthwise = (size_t)groups == in_shape[1] && (size_t)groups == w_shape[0];
 
 #ifdef NNCASE_HALIDE
-    if (groups == 1 && runtime::is_contiguous(in_shape, in_strides))
+    if (undilated && groups == 1 && runtime::is_contiguous(in_shape, in_strides))
     {
         // clang-format off
         HALIDE_CONV2D_NXM_S1_S2(1, 1)
@@ -539,7 +853,7 @@ result<void> optimized::conv2d(const float *input, const float *weights, const f
         // clang-format on
     }
 
-    if ((size_t)groups == in_shape[1] && (size_t)groups == w_shape[0] && runtime::is_contiguous(in_shape, in_strides))
+    if (undilated && depthwise && runtime::is_contiguous(in_shape, in_strides))
     {
         // clang-format off
         HALIDE_CONV2D_DEPTHWISE_NXM_S1_S2(1, 1)
@@ -548,9 +862,26 @@ result<void> optimized::conv2d(const float *input, const float *weights, const f
         else HALIDE_CONV2D_DEPTHWISE_NXM_S1_S2(7, 7)
         // clang-format on
     }
+#endif
 
-#else
-    if (groups == 1 && padding_h.before == 0 && padding_h.after == 0 && padding_w.before == 0 && padding_w.after == 0)
+    if (padding_h.interior != 0 || padding_w.interior != 0 || stride_h <= 0 || stride_w <= 0 || groups <= 0)
+        return err(std::errc::not_supported);
+
+    const conv_geometry geometry { in_shape[0], in_shape[1], in_shape[2], in_shape[3], w_shape[0],
+        kernels::detail::get_windowed_output_size(in_shape[2], (int32_t)filter_h, stride_h, dilation_h, padding_h),
+        kernels::detail::get_windowed_output_size(in_shape[3], (int32_t)filter_w, stride_w, dilation_w, padding_w),
+        filter_h, filter_w, (size_t)groups, padding_h.before, padding_w.before, stride_h, stride_w, dilation_h, dilation_w };
+    const auto ic_g = geometry.in_group_channels(), oc_g = geometry.out_group_channels();
+
+    // Winograd cuts the multiplies of a 3x3 stride-1 conv by 4x, which pays for
+    // its transforms once there are enough channels to reuse them across.
+    if (groups == 1 && filter_h == 3 && filter_w == 3 && stride_h == 1 && stride_w == 1 && undilated
+        && ic_g >= winograd_min_channels && oc_g >= winograd_min_channels && geometry.out_h >= wino_out && geometry.out_w >= wino_out)
+        return conv2d_winograd(geometry, input, weights, bias, output, fused_activation, context);
+
+#ifndef NNCASE_HALIDE
+    // The direct kernels only win over GEMM when the reduction is too short to fill its tiles.
+    if (undilated && unpadded && groups == 1 && ic_g * filter_h * filter_w < gemm_min_reduction)
     {
         if (filter_h == 1 && filter_w == 1)
         {
@@ -565,23 +896,29 @@ result<void> optimized::conv2d(const float *input, const float *weights, const f
         }
         // clang-format off
         else CONV2D_NXM_S1_S2(1, 3)
-        else CONV2D_NXM_S1_S2(3, 1) 
-        else CONV2D_NXM_S1_S2(3, 3) 
-        else CONV2D_NXM_S1_S2(5, 5) 
+        else CONV2D_NXM_S1_S2(3, 1)
+        else CONV2D_NXM_S1_S2(3, 3)
+        else CONV2D_NXM_S1_S2(5, 5)
         else CONV2D_NXM_S1_S2(7, 7)
         // clang-format on
     }
 
-    if ((size_t)groups == in_shape[1] && (size_t)groups == w_shape[0] && padding_h.before == 0 && padding_h.after == 0 && padding_w.before == 0 && padding_w.after == 0)
+    if (undilated && unpadded && depthwise)
     {
         // clang-format off
         CONV2D_DEPTHWISE_NXM_S1_S2(1, 3)
-        else CONV2D_DEPTHWISE_NXM_S1_S2(3, 1) 
-        else CONV2D_DEPTHWISE_NXM_S1_S2(3, 3) 
-        else CONV2D_DEPTHWISE_NXM_S1_S2(5, 5) 
+        else CONV2D_DEPTHWISE_NXM_S1_S2(3, 1)
+        else CONV2D_DEPTHWISE_NXM_S1_S2(3, 3)
+        else CONV2D_DEPTHWISE_NXM_S1_S2(5, 5)
         else CONV2D_DEPTHWISE_NXM_S1_S2(7, 7)
         // clang-format on
     }
+#else
+    NNCASE_UNUSED auto unused = unpadded;
 #endif
+
+    // Depthwise-like groups leave GEMM a single row per group, the reference loop does better.
+    if (oc_g >= gemm_min_group_channels)
+        return conv2d_im2col(geometry, input, weights, bias, output, fused_activation, context);
     return err(std::errc::not_supported);
-}
\ No newline at end of file
+}
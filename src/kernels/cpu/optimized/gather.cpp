@@ -37,15 +37,14 @@ result<void> gather_impl(const T *input, T *output, const runtime_shape_t &in_sh
     auto *out_ptr = output;
     for (size_t o = 0; o < outer_count; ++o)
     {
-#ifdef NNCASE_OPENMP
-#pragma omp parallel for num_threads(context.num_threads)
-#endif
-        for (size_t i = 0; i < indices_count; ++i)
-        {
-            auto *o_ptr = out_ptr + i * block_size;
-            auto indices_ptr = indices[i];
-            memcpy(o_ptr, in_ptr + (indices_ptr * block_size), block_size * sizeof(T));
-        }
+        parallel_for(context, indices_count, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i)
+            {
+                auto *o_ptr = out_ptr + i * block_size;
+                auto indices_ptr = indices[i];
+                memcpy(o_ptr, in_ptr + (indices_ptr * block_size), block_size * sizeof(T));
+            }
+        });
         in_ptr += in_shape[axis] * block_size;
         out_ptr += indices_count * block_size;
     }
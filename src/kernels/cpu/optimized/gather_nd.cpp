@@ -42,23 +42,22 @@ result<void> gather_nd_impl(const T *input, T *output, const runtime_shape_t &in
     size_t indices_batch_block_size = std::accumulate(indices_shape.begin() + batch_dims, indices_shape.end(), 1, std::multiplies<size_t> {});
     for (size_t i = 0; i < batch_size; ++i)
     {
-#ifdef NNCASE_OPENMP
-#pragma omp parallel for num_threads(context.num_threads)
-#endif
-        for (size_t j = 0; j < indices_block_count; ++j)
-        {
-            const auto *indices_ptr = indices + j * indices_list_size;
-            auto *out_ptr = output + j * block_size;
-            auto *batch_begin_input = input;
-            // set batch_dims value used for select input
-
-            // get offset
-            for (size_t k = 0; k < indices_list_size; ++k)
+        parallel_for(context, indices_block_count, [&](size_t begin, size_t end) {
+            for (size_t j = begin; j < end; ++j)
             {
-                batch_begin_input += indices_ptr[k] * in_strides[k + batch_dims];
+                const auto *indices_ptr = indices + j * indices_list_size;
+                auto *out_ptr = output + j * block_size;
+                auto *batch_begin_input = input;
+                // set batch_dims value used for select input
+
+                // get offset
+                for (size_t k = 0; k < indices_list_size; ++k)
+                {
+                    batch_begin_input += indices_ptr[k] * in_strides[k + batch_dims];
+                }
+                memcpy(out_ptr, batch_begin_input, block_size * sizeof(T));
             }
-            memcpy(out_ptr, batch_begin_input, block_size * sizeof(T));
-        }
+        });
         input += input_batch_block_size;
         output += output_batch_block_size;
         indices += indices_batch_block_size;
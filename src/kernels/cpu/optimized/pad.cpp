@@ -0,0 +1,49 @@
+/* Copyright 2019-2021 Canaan Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <nncase/kernels/cpu/optimized/tensor_compute.h>
+#include <nncase/kernels/cpu/reference/tensor_compute.h>
+#include <nncase/kernels/kernel_utils.h>
+#include <nncase/runtime/runtime_op_utility.h>
+
+using namespace nncase;
+using namespace nncase::runtime;
+using namespace nncase::kernels;
+using namespace nncase::kernels::cpu;
+using namespace nncase::kernels::cpu::optimized;
+
+result<void> optimized::pad(datatype_t type, const gsl::byte *input, gsl::byte *output, const runtime_shape_t &in_shape,
+    const runtime_shape_t &in_strides, const runtime_shape_t &out_strides, const runtime_paddings_t &paddings, pad_mode_t mode, const scalar &pad_value,
+    kernel_context &context) noexcept
+{
+    // Split the outermost unpadded axis, input and output rows then map one to one.
+    size_t axis = 0;
+    while (axis < in_shape.size() && (paddings[axis].before != 0 || paddings[axis].after != 0 || in_shape[axis] == 1))
+        axis++;
+
+    const bool interior = std::any_of(paddings.begin(), paddings.end(), [](const padding &p) { return p.interior != 0; });
+    if (axis == in_shape.size() || interior)
+        return cpu::reference::pad(type, input, output, in_shape, in_strides, out_strides, paddings, mode, pad_value, context);
+
+    const auto unit = runtime::get_bytes(type);
+    size_t inner_size = 1;
+    for (size_t i = axis + 1; i < in_shape.size(); i++)
+        inner_size *= (size_t)((int32_t)in_shape[i] + paddings[i].sum());
+    return try_parallel_for(context, in_shape[axis], kernels::detail::parallel_grain(inner_size), [&](size_t begin, size_t end) {
+        auto chunk_shape = in_shape;
+        chunk_shape[axis] = end - begin;
+        return cpu::reference::pad(type, input + begin * in_strides[axis] * unit, output + begin * out_strides[axis] * unit,
+            chunk_shape, in_strides, out_strides, paddings, mode, pad_value, context);
+    });
+}
@@ -0,0 +1,543 @@
+/* Copyright 2019-2021 Canaan Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "reduce_utils.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <nncase/kernels/cpu/optimized/tensor_compute.h>
+#include <nncase/kernels/cpu/reference/tensor_compute.h>
+#include <nncase/kernels/kernel_utils.h>
+#include <nncase/runtime/runtime_op_utility.h>
+#if !defined(__riscv)
+#include "x86_64/vector_math.h"
+#endif
+
+using namespace nncase;
+using namespace nncase::runtime;
+using namespace nncase::kernels;
+using namespace nncase::kernels::cpu;
+using namespace nncase::kernels::cpu::optimized;
+
+namespace
+{
+// Sums split their inputs in halves down to blocks of this many elements (or
+// rows), so rounding errors grow with the log of the reduced size.
+constexpr size_t pairwise_block = 128;
+
+// Outputs along a contiguous kept axis are accumulated this many at a time
+constexpr size_t column_block = 64;
+
+// One input axis after dropping unit axes and merging neighbours that are both
+// reduced, or both kept and laid out alike in the output. Strides are in elements.
+struct reduce_dim
+{
+    size_t extent;
+    size_t in_stride;
+    size_t out_stride;
+    bool reduced;
+};
+
+using reduce_dims_t = itlib::small_vector<reduce_dim, 4>;
+
+// Input offsets of consecutive positions along `dims` in row major order, starting
+// from the index-th one. Rows are walked rather than listed, so reductions over many
+// positions need no memory.
+class offset_walker
+{
+public:
+    offset_walker(const reduce_dims_t &dims, size_t index) noexcept
+        : dims_(dims), pos_(dims.size())
+    {
+        for (size_t i = dims.size(); i-- > 0;)
+        {
+            pos_[i] = index % dims[i].extent;
+            index /= dims[i].extent;
+            offset_ += pos_[i] * dims[i].in_stride;
+        }
+    }
+
+    size_t offset() const noexcept { return offset_; }
+
+    void next() noexcept
+    {
+        for (size_t i = dims_.size(); i-- > 0;)
+        {
+            offset_ += dims_[i].in_stride;
+            if (++pos_[i] < dims_[i].extent)
+                return;
+            offset_ -= dims_[i].extent * dims_[i].in_stride;
+            pos_[i] = 0;
+        }
+    }
+
+private:
+    const reduce_dims_t &dims_;
+    itlib::small_vector<size_t, 4> pos_;
+    size_t offset_ = 0;
+};
+
+// Reduces rows [first, first + count) of `n` contiguous elements, the rows being the positions along `dims`
+template <class T>
+using reduce_rows_t = T (*)(const T *input, const reduce_dims_t &dims, size_t first, size_t count, size_t n);
+
+// Reduces the same rows, of `cols` <= column_block contiguous elements, column by column
+template <class T>
+using reduce_columns_t = void (*)(const T *input, const reduce_dims_t &dims, size_t first, size_t count, size_t cols, T *output);
+
+template <class T>
+struct generic_reduce
+{
+    template <reduce_kind Kind>
+    static T row(const T *input, size_t n) noexcept
+    {
+        if (std::is_floating_point_v<T> && Kind == reduce_kind::sum && n > pairwise_block)
+            return row<Kind>(input, n / 2) + row<Kind>(input + n / 2, n - n / 2);
+
+        auto acc = identity_value<Kind, T>();
+        for (size_t i = 0; i < n; i++)
+            acc = combine<Kind>(acc, input[i]);
+        return acc;
+    }
+
+    template <reduce_kind Kind>
+    static T rows(const T *input, const reduce_dims_t &dims, size_t first, size_t count, size_t n) noexcept
+    {
+        if (std::is_floating_point_v<T> && Kind == reduce_kind::sum && count > pairwise_block)
+            return rows<Kind>(input, dims, first, count / 2, n) + rows<Kind>(input, dims, first + count / 2, count - count / 2, n);
+
+        auto acc = identity_value<Kind, T>();
+        offset_walker offsets(dims, first);
+        for (size_t r = 0; r < count; r++, offsets.next())
+            acc = combine<Kind>(acc, row<Kind>(input + offsets.offset(), n));
+        return acc;
+    }
+
+    template <reduce_kind Kind>
+    static void columns(const T *input, const reduce_dims_t &dims, size_t first, size_t count, size_t cols, T *output) noexcept
+    {
+        if (std::is_floating_point_v<T> && Kind == reduce_kind::sum && count > pairwise_block)
+        {
+            T upper[column_block];
+            columns<Kind>(input, dims, first, count / 2, cols, output);
+            columns<Kind>(input, dims, first + count / 2, count - count / 2, cols, upper);
+            for (size_t j = 0; j < cols; j++)
+                output[j] += upper[j];
+            return;
+        }
+
+        std::fill_n(output, cols, identity_value<Kind, T>());
+        offset_walker offsets(dims, first);
+        for (size_t r = 0; r < count; r++, offsets.next())
+        {
+            const auto row = input + offsets.offset();
+            for (size_t j = 0; j < cols; j++)
+                output[j] = combine<Kind>(output[j], row[j]);
+        }
+    }
+};
+
+#if NNCASE_X86_SIMD
+#define REDUCE_KERNELS(target)                                                                                  \
+    template <reduce_kind Kind>                                                                                 \
+    target static reg combine(reg acc, reg v) noexcept                                                          \
+    {                                                                                                           \
+        if constexpr (Kind == reduce_kind::sum)                                                                 \
+            return add(acc, v);                                                                                 \
+        else if constexpr (Kind == reduce_kind::prod)                                                           \
+            return mul(acc, v);                                                                                 \
+        else if constexpr (Kind == reduce_kind::min)                                                            \
+            return min(v, acc);                                                                                 \
+        else                                                                                                    \
+            return max(v, acc);                                                                                 \
+    }                                                                                                           \
+                                                                                                                \
+    /* Four independent accumulators hide the add latency */                                                    \
+    template <reduce_kind Kind>                                                                                 \
+    target static float row(const float *input, size_t n) noexcept                                              \
+    {                                                                                                           \
+        if (Kind == reduce_kind::sum && n > pairwise_block)                                                     \
+        {                                                                                                       \
+            const auto half = n / 2 / lanes * lanes;                                                            \
+            return row<Kind>(input, half) + row<Kind>(input + half, n - half);                                  \
+        }                                                                                                       \
+                                                                                                                \
+        const auto identity = set1(identity_value<Kind, float>());                                             \
+        reg acc[4] = { identity, identity, identity, identity };                                                \
+        size_t i = 0;                                                                                           \
+        for (; i + 4 * lanes <= n; i += 4 * lanes)                                                              \
+        {                                                                                                       \
+            NNCASE_UNROLL                                                                                       \
+            for (size_t k = 0; k < 4; k++)                                                                      \
+                acc[k] = combine<Kind>(acc[k], load(input + i + k * lanes));                                    \
+        }                                                                                                       \
+        for (; i + lanes <= n; i += lanes)                                                                      \
+            acc[0] = combine<Kind>(acc[0], load(input + i));                                                    \
+        acc[0] = combine<Kind>(combine<Kind>(acc[0], acc[1]), combine<Kind>(acc[2], acc[3]));                   \
+                                                                                                                \
+        alignas(64) float values[lanes];                                                                        \
+        store(values, acc[0]);                                                                                  \
+        auto result = values[0];                                                                                \
+        for (size_t k = 1; k < lanes; k++)                                                                      \
+            result = optimized::combine<Kind>(result, values[k]);                                               \
+        for (; i < n; i++)                                                                                      \
+            result = optimized::combine<Kind>(result, input[i]);                                                \
+        return result;                                                                                          \
+    }                                                                                                           \
+                                                                                                                \
+    template <reduce_kind Kind>                                                                                 \
+    target static float rows(const float *input, const reduce_dims_t &dims, size_t first, size_t count, size_t n) noexcept \
+    {                                                                                                           \
+        if (Kind == reduce_kind::sum && count > pairwise_block)                                                 \
+            return rows<Kind>(input, dims, first, count / 2, n)                                                 \
+                + rows<Kind>(input, dims, first + count / 2, count - count / 2, n);                             \
+                                                                                                                \
+        auto result = identity_value<Kind, float>();                                                            \
+        offset_walker offsets(dims, first);                                                                     \
+        for (size_t r = 0; r < count; r++, offsets.next())                                                      \
+            result = optimized::combine<Kind>(result, row<Kind>(input + offsets.offset(), n));                  \
+        return result;                                                                                          \
+    }                                                                                                           \
+                                                                                                                \
+    template <reduce_kind Kind>                                                                                 \
+    target static void columns(const float *input, const reduce_dims_t &dims, size_t first, size_t count, size_t cols, float *output) noexcept \
+    {                                                                                                           \
+        if (Kind == reduce_kind::sum && count > pairwise_block)                                                 \
+        {                                                                                                       \
+            alignas(64) float upper[column_block];                                                              \
+            columns<Kind>(input, dims, first, count / 2, cols, output);                                         \
+            columns<Kind>(input, dims, first + count / 2, count - count / 2, cols, upper);                      \
+            for (size_t j = 0; j < cols; j += lanes)                                                            \
+            {                                                                                                   \
+                const auto n = std::min(lanes, cols - j);                                                       \
+                store_partial(output + j, add(load_partial(output + j, n), load_partial(upper + j, n)), n);                \
+            }                                                                                                   \
+            return;                                                                                             \
+        }                                                                                                       \
+                                                                                                                \
+        constexpr size_t regs = column_block / lanes;                                                           \
+        const auto used = (cols + lanes - 1) / lanes;                                                           \
+        const auto tail = cols - (used - 1) * lanes;                                                            \
+        reg acc[regs];                                                                                          \
+        NNCASE_UNROLL                                                                                           \
+        for (size_t k = 0; k < regs; k++)                                                                       \
+            acc[k] = set1(identity_value<Kind, float>());                                                       \
+        offset_walker offsets(dims, first);                                                                     \
+        for (size_t r = 0; r < count; r++, offsets.next())                                                      \
+        {                                                                                                       \
+            const auto row = input + offsets.offset();                                                          \
+            for (size_t k = 0; k + 1 < used; k++)                                                               \
+                acc[k] = combine<Kind>(acc[k], load(row + k * lanes));                                          \
+            acc[used - 1] = combine<Kind>(acc[used - 1], load_partial(row + (used - 1) * lanes, tail));         \
+        }                                                                                                       \
+        for (size_t k = 0; k + 1 < used; k++)                                                                   \
+            store(output + k * lanes, acc[k]);                                                                  \
+        store_partial(output + (used - 1) * lanes, acc[used - 1], tail);                                        \
+    }
+
+struct avx2_reduce : avx2_math
+{
+    REDUCE_KERNELS(NNCASE_TARGET_AVX2)
+};
+
+struct avx512_reduce : avx512_math
+{
+    REDUCE_KERNELS(NNCASE_TARGET_AVX512)
+};
+
+#undef REDUCE_KERNELS
+#endif
+
+template <class T>
+struct reduce_kernels
+{
+    reduce_rows_t<T> rows;
+    reduce_columns_t<T> columns;
+};
+
+template <class T, reduce_kind Kind>
+reduce_kernels<T> select_kernels() noexcept
+{
+#if NNCASE_X86_SIMD
+    if constexpr (std::is_same_v<T, float>)
+    {
+        const auto &features = cpu_features();
+        if (features.avx512)
+            return { avx512_reduce::rows<Kind>, avx512_reduce::columns<Kind> };
+        if (features.avx2)
+            return { avx2_reduce::rows<Kind>, avx2_reduce::columns<Kind> };
+    }
+#endif
+    return { generic_reduce<T>::template rows<Kind>, generic_reduce<T>::template columns<Kind> };
+}
+
+reduce_dims_t collapse_dims(const runtime_shape_t &in_shape, const runtime_shape_t &axes,
+    const runtime_shape_t &in_strides, const runtime_shape_t &out_strides, bool keep_dims) noexcept
+{
+    reduce_dims_t dims;
+    size_t out_axis = 0;
+    for (size_t i = 0; i < in_shape.size(); i++)
+    {
+        const bool reduced = std::find(axes.begin(), axes.end(), i) != axes.end();
+        const reduce_dim dim { in_shape[i], in_strides[i], reduced ? 0 : out_strides[out_axis], reduced };
+        if (!reduced || keep_dims)
+            out_axis++;
+        if (dim.extent == 1)
+            continue;
+
+        if (!dims.empty())
+        {
+            auto &outer = dims.back();
+            if (outer.reduced == reduced && outer.in_stride == dim.in_stride * dim.extent
+                && outer.out_stride == dim.out_stride * dim.extent)
+            {
+                outer = { outer.extent * dim.extent, dim.in_stride, dim.out_stride, reduced };
+                continue;
+            }
+        }
+
+        dims.push_back(dim);
+    }
+
+    // Everything unit sized: a single element, kept
+    if (dims.empty())
+        dims.push_back({ 1, 1, 1, false });
+    return dims;
+}
+
+// Input and output offsets of the index-th position along the kept axes `dims`
+std::pair<size_t, size_t> kept_offsets(const reduce_dims_t &dims, size_t index) noexcept
+{
+    size_t in_offset = 0, out_offset = 0;
+    for (size_t i = dims.size(); i-- > 0;)
+    {
+        const auto pos = index % dims[i].extent;
+        index /= dims[i].extent;
+        in_offset += pos * dims[i].in_stride;
+        out_offset += pos * dims[i].out_stride;
+    }
+
+    return { in_offset, out_offset };
+}
+
+size_t dims_size(const reduce_dims_t &dims) noexcept
+{
+    size_t size = 1;
+    for (auto &dim : dims)
+        size *= dim.extent;
+    return size;
+}
+
+// Every output is finish(reduced value); the layout picks one of three loops:
+//  - inner: the innermost axis is reduced and contiguous, rows along it are reduced across lanes
+//  - outer: the innermost axis is kept and contiguous, rows of outputs are accumulated lane-wise
+//  - otherwise every input element is a row of its own
+template <reduce_kind Kind, class T, class TFinish>
+void reduce_impl(const T *input, T *output, const reduce_dims_t &dims, TFinish &&finish, kernel_context &context) noexcept
+{
+    const auto kernel = select_kernels<T, Kind>();
+    reduce_dims_t kept, reduced;
+    for (auto &dim : dims)
+        (dim.reduced ? reduced : kept).push_back(dim);
+
+    const auto &inner = dims.back();
+    const auto reduce_size = dims_size(reduced);
+    if (!inner.reduced && inner.in_stride == 1 && inner.out_stride == 1)
+    {
+        const auto cols = inner.extent;
+        const auto blocks = (cols + column_block - 1) / column_block;
+        kept.pop_back();
+        parallel_for(context, dims_size(kept) * blocks, kernels::detail::parallel_grain(reduce_size * column_block), [&](size_t begin, size_t end) {
+            T values[column_block];
+            for (size_t task = begin; task < end; task++)
+            {
+                const auto [in_offset, out_offset] = kept_offsets(kept, task / blocks);
+                const auto col = task % blocks * column_block;
+                const auto count = std::min(column_block, cols - col);
+                kernel.columns(input + in_offset + col, reduced, 0, reduce_size, count, values);
+                for (size_t j = 0; j < count; j++)
+                    output[out_offset + col + j] = finish(values[j]);
+            }
+        });
+        return;
+    }
+
+    size_t row_size = 1;
+    if (inner.reduced && inner.in_stride == 1)
+    {
+        row_size = inner.extent;
+        reduced.pop_back();
+    }
+
+    const auto rows = dims_size(reduced);
+    parallel_for(context, dims_size(kept), kernels::detail::parallel_grain(reduce_size), [&](size_t begin, size_t end) {
+        for (size_t o = begin; o < end; o++)
+        {
+            const auto [in_offset, out_offset] = kept_offsets(kept, o);
+            output[out_offset] = finish(kernel.rows(input + in_offset, reduced, 0, rows, row_size));
+        }
+    });
+}
+
+bool has_empty_axis(const runtime_shape_t &in_shape) noexcept
+{
+    return std::find(in_shape.begin(), in_shape.end(), 0) != in_shape.end();
+}
+
+// Follows reference::reduce_arg: a value within epsilon of the best so far
+// ties with it, and a strictly better one starts a new run of ties.
+template <class TCompare>
+struct arg_state
+{
+    float best;
+    size_t first;
+    size_t last;
+
+    void update(float v, size_t index, TCompare compare) noexcept
+    {
+        if (compare(v, best))
+        {
+            best = v;
+            first = last = index;
+        }
+        else if (std::fabs(v - best) < 0.000001f)
+        {
+            last = index;
+        }
+    }
+};
+
+template <class T, class TCompare>
+void reduce_arg_impl(TCompare compare, float init_value, const float *input, T *output, size_t outer, size_t axis, size_t inner,
+    bool select_last_idx, kernel_context &context) noexcept
+{
+    // Columns of `inner` positions are scanned together, so every row read is contiguous
+    const auto cols = std::min(inner, column_block);
+    const auto blocks = (inner + cols - 1) / cols;
+    parallel_for(context, outer * blocks, kernels::detail::parallel_grain(axis * cols), [&](size_t begin, size_t end) {
+        arg_state<TCompare> states[column_block];
+        for (size_t task = begin; task < end; task++)
+        {
+            const auto o = task / blocks;
+            const auto col = task % blocks * cols;
+            const auto count = std::min(cols, inner - col);
+            const auto src = input + o * axis * inner + col;
+            std::fill_n(states, count, arg_state<TCompare> { init_value, 0, 0 });
+            for (size_t i = 0; i < axis; i++)
+            {
+                for (size_t j = 0; j < count; j++)
+                    states[j].update(src[i * inner + j], i, compare);
+            }
+
+            for (size_t j = 0; j < count; j++)
+                output[o * inner + col + j] = (T)(select_last_idx ? states[j].last : states[j].first);
+        }
+    });
+}
+}
+
+template result<void> optimized::reduce<float>(reduce_op_t op, float init_value, const float *input, float *output, const runtime_shape_t &in_shape, const runtime_shape_t &axis,
+    const runtime_shape_t &in_strides, const runtime_shape_t &out_strides, bool keep_dims, kernel_context &context) noexcept;
+
+template result<void> optimized::reduce<int32_t>(reduce_op_t op, int32_t init_value, const int32_t *input, int32_t *output, const runtime_shape_t &in_shape, const runtime_shape_t &axis,
+    const runtime_shape_t &in_strides, const runtime_shape_t &out_strides, bool keep_dims, kernel_context &context) noexcept;
+
+template <typename T>
+result<void> optimized::reduce(reduce_op_t op, T init_value, const T *input, T *output, const runtime_shape_t &in_shape, const runtime_shape_t &axis,
+    const runtime_shape_t &in_strides, const runtime_shape_t &out_strides, bool keep_dims, kernel_context &context) noexcept
+{
+    if (has_empty_axis(in_shape))
+        return cpu::reference::reduce(op, init_value, input, output, in_shape, axis, in_strides, out_strides, keep_dims, context);
+
+    const auto dims = collapse_dims(in_shape, axis, in_strides, out_strides, keep_dims);
+    switch (op)
+    {
+    case reduce_mean:
+    {
+        const auto block_size = (T)kernels::detail::get_reduce_block_size(in_shape, axis);
+        reduce_impl<reduce_kind::sum>(input, output, dims, [=](T v) { return (init_value + v) / block_size; }, context);
+        return ok();
+    }
+    case reduce_sum:
+        reduce_impl<reduce_kind::sum>(input, output, dims, [=](T v) { return init_value + v; }, context);
+        return ok();
+    case reduce_min:
+        reduce_impl<reduce_kind::min>(input, output, dims, [](T v) { return v; }, context);
+        return ok();
+    case reduce_max:
+        reduce_impl<reduce_kind::max>(input, output, dims, [](T v) { return v; }, context);
+        return ok();
+    default:
+        return err(std::errc::not_supported);
+    }
+}
+
+template result<void> optimized::reduce_arg<int32_t>(reduce_arg_op_t op, const float *input, int32_t *output, const runtime_shape_t &in_shape,
+    const runtime_shape_t &in_strides, const runtime_shape_t &out_strides,
+    const runtime_shape_t &axis, bool keep_dims, bool select_last_idx, kernel_context &context) noexcept;
+
+template result<void> optimized::reduce_arg<int64_t>(reduce_arg_op_t op, const float *input, int64_t *output, const runtime_shape_t &in_shape,
+    const runtime_shape_t &in_strides, const runtime_shape_t &out_strides,
+    const runtime_shape_t &axis, bool keep_dims, bool select_last_idx, kernel_context &context) noexcept;
+
+template <typename T>
+result<void> optimized::reduce_arg(reduce_arg_op_t op, const float *input, T *output, const runtime_shape_t &in_shape,
+    const runtime_shape_t &in_strides, const runtime_shape_t &out_strides,
+    const runtime_shape_t &axes, bool keep_dims, bool select_last_idx, kernel_context &context) noexcept
+{
+    const auto out_shape = kernels::detail::get_reduced_shape(in_shape, axes, keep_dims);
+    if (axes.size() != 1 || has_empty_axis(in_shape) || !is_contiguous(in_shape, in_strides) || !is_contiguous(out_shape, out_strides))
+        return cpu::reference::reduce_arg(op, input, output, in_shape, in_strides, out_strides, axes, keep_dims, select_last_idx, context);
+
+    size_t outer = 1, inner = 1;
+    for (size_t i = 0; i < axes[0]; i++)
+        outer *= in_shape[i];
+    for (size_t i = axes[0] + 1; i < in_shape.size(); i++)
+        inner *= in_shape[i];
+
+    switch (op)
+    {
+    case reduce_arg_min:
+        reduce_arg_impl([](float a, float b) { return a < b; }, std::numeric_limits<float>::max(),
+            input, output, outer, in_shape[axes[0]], inner, select_last_idx, context);
+        return ok();
+    case reduce_arg_max:
+        reduce_arg_impl([](float a, float b) { return a > b; }, std::numeric_limits<float>::lowest(),
+            input, output, outer, in_shape[axes[0]], inner, select_last_idx, context);
+        return ok();
+    default:
+        return err(std::errc::not_supported);
+    }
+}
+
+template result<void> optimized::reduce_prod<float>(const float *input, float *output, const runtime_shape_t &in_shape,
+    const runtime_shape_t &in_strides, const runtime_shape_t &out_strides,
+    const runtime_shape_t &axes, bool keep_dims, kernel_context &context) noexcept;
+
+template result<void> optimized::reduce_prod<int32_t>(const int32_t *input, int32_t *output, const runtime_shape_t &in_shape,
+    const runtime_shape_t &in_strides, const runtime_shape_t &out_strides,
+    const runtime_shape_t &axes, bool keep_dims, kernel_context &context) noexcept;
+
+template <typename T>
+result<void> optimized::reduce_prod(const T *input, T *output, const runtime_shape_t &in_shape,
+    const runtime_shape_t &in_strides, const runtime_shape_t &out_strides,
+    const runtime_shape_t &axes, bool keep_dims, kernel_context &context) noexcept
+{
+    if (has_empty_axis(in_shape))
+        return cpu::reference::reduce_prod(input, output, in_shape, in_strides, out_strides, axes, keep_dims);
+
+    const auto dims = collapse_dims(in_shape, axes, in_strides, out_strides, keep_dims);
+    reduce_impl<reduce_kind::prod>(input, output, dims, [](T v) { return v; }, context);
+    return ok();
+}
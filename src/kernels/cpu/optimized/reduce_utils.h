@@ -0,0 +1,57 @@
+/* Copyright 2019-2021 Canaan Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+#include <limits>
+#include <nncase/kernels/cpu/optimized/runtime_types.h>
+
+BEGIN_NS_NNCASE_KERNELS_CPU_OPT
+
+// The reductions shared by reduce and reduce_window2d
+enum class reduce_kind
+{
+    sum,
+    min,
+    max,
+    prod
+};
+
+template <reduce_kind Kind, class T>
+T identity_value() noexcept
+{
+    if constexpr (Kind == reduce_kind::sum)
+        return 0;
+    else if constexpr (Kind == reduce_kind::prod)
+        return 1;
+    else if constexpr (Kind == reduce_kind::min)
+        return std::numeric_limits<T>::max();
+    else
+        return std::numeric_limits<T>::lowest();
+}
+
+// acc is the running value, min and max keep it unless v compares past it (so NaNs are skipped)
+template <reduce_kind Kind, class T>
+T combine(T acc, T v) noexcept
+{
+    if constexpr (Kind == reduce_kind::sum)
+        return acc + v;
+    else if constexpr (Kind == reduce_kind::prod)
+        return acc * v;
+    else if constexpr (Kind == reduce_kind::min)
+        return v < acc ? v : acc;
+    else
+        return v > acc ? v : acc;
+}
+
+END_NS_NNCASE_KERNELS_CPU_OPT
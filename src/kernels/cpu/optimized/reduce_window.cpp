@@ -0,0 +1,309 @@
+/* Copyright 2019-2021 Canaan Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "reduce_utils.h"
+#include <algorithm>
+#include <nncase/kernels/cpu/optimized/tensor_compute.h>
+#include <nncase/kernels/kernel_utils.h>
+#include <nncase/runtime/runtime_op_utility.h>
+#include <vector>
+#if !defined(__riscv)
+#include "x86_64/vector_math.h"
+#endif
+
+using namespace nncase;
+using namespace nncase::runtime;
+using namespace nncase::kernels;
+using namespace nncase::kernels::cpu;
+using namespace nncase::kernels::cpu::optimized;
+
+namespace
+{
+// Windows are reduced in two passes per output row: the window's input rows are
+// combined element-wise into one row, then windows along that row are combined.
+
+// v[x] = input rows [0, rows) combined at x, for x < width
+using window_vertical_t = void (*)(const float *input, size_t row_stride, size_t rows, size_t width, float *v);
+
+// out[i] = v[i * stride .. i * stride + filter) combined, for i < count
+using window_horizontal_t = void (*)(const float *v, float *out, size_t count, size_t filter, size_t stride);
+
+template <reduce_kind Kind>
+void horizontal_scalar(const float *v, float *out, size_t begin, size_t count, size_t filter, size_t stride) noexcept
+{
+    for (size_t i = begin; i < count; i++)
+    {
+        auto acc = v[i * stride];
+        for (size_t k = 1; k < filter; k++)
+            acc = combine<Kind>(acc, v[i * stride + k]);
+        out[i] = acc;
+    }
+}
+
+struct generic_window
+{
+    template <reduce_kind Kind>
+    static void vertical(const float *input, size_t row_stride, size_t rows, size_t width, float *v) noexcept
+    {
+        std::fill_n(v, width, identity_value<Kind, float>());
+        for (size_t r = 0; r < rows; r++)
+        {
+            for (size_t x = 0; x < width; x++)
+                v[x] = combine<Kind>(v[x], input[r * row_stride + x]);
+        }
+    }
+
+    // Filter and Stride are fixed for the common windows, 0 takes the runtime values
+    template <reduce_kind Kind, size_t Filter, size_t Stride>
+    static void horizontal(const float *v, float *out, size_t count, size_t filter, size_t stride) noexcept
+    {
+        horizontal_scalar<Kind>(v, out, 0, count, Filter ? Filter : filter, Stride ? Stride : stride);
+    }
+};
+
+#if NNCASE_X86_SIMD
+// Stride 2 windows read their columns through load_even, which reads one element
+// past the last window; callers leave that element readable.
+#define WINDOW_KERNELS(target)                                                                               \
+    template <reduce_kind Kind>                                                                              \
+    target static reg combine(reg acc, reg v) noexcept                                                       \
+    {                                                                                                        \
+        if constexpr (Kind == reduce_kind::sum)                                                              \
+            return add(acc, v);                                                                              \
+        else if constexpr (Kind == reduce_kind::min)                                                         \
+            return min(v, acc);                                                                              \
+        else                                                                                                 \
+            return max(v, acc);                                                                              \
+    }                                                                                                        \
+                                                                                                             \
+    template <reduce_kind Kind>                                                                              \
+    target static void vertical(const float *input, size_t row_stride, size_t rows, size_t width, float *v) noexcept \
+    {                                                                                                        \
+        size_t x = 0;                                                                                        \
+        for (; x + lanes <= width; x += lanes)                                                               \
+        {                                                                                                    \
+            auto acc = set1(identity_value<Kind, float>());                                                  \
+            for (size_t r = 0; r < rows; r++)                                                                \
+                acc = combine<Kind>(acc, load(input + r * row_stride + x));                                  \
+            store(v + x, acc);                                                                               \
+        }                                                                                                    \
+        for (; x < width; x++)                                                                               \
+        {                                                                                                    \
+            auto acc = identity_value<Kind, float>();                                                        \
+            for (size_t r = 0; r < rows; r++)                                                                \
+                acc = optimized::combine<Kind>(acc, input[r * row_stride + x]);                              \
+            v[x] = acc;                                                                                      \
+        }                                                                                                    \
+    }                                                                                                        \
+                                                                                                             \
+    template <reduce_kind Kind, size_t Filter, size_t Stride>                                                \
+    target static void horizontal(const float *v, float *out, size_t count, size_t filter, size_t stride) noexcept \
+    {                                                                                                        \
+        const auto window = Filter ? Filter : filter;                                                        \
+        const auto step = Stride ? Stride : stride;                                                          \
+        size_t i = 0;                                                                                        \
+        if (step == 1)                                                                                       \
+        {                                                                                                    \
+            for (; i + lanes <= count; i += lanes)                                                           \
+            {                                                                                                \
+                auto acc = load(v + i);                                                                      \
+                for (size_t k = 1; k < window; k++)                                                          \
+                    acc = combine<Kind>(acc, load(v + i + k));                                               \
+                store(out + i, acc);                                                                         \
+            }                                                                                                \
+        }                                                                                                    \
+        else if (step == 2)                                                                                  \
+        {                                                                                                    \
+            for (; i + lanes <= count; i += lanes)                                                           \
+            {                                                                                                \
+                auto acc = load_even(v + i * 2);                                                             \
+                for (size_t k = 1; k < window; k++)                                                          \
+                    acc = combine<Kind>(acc, load_even(v + i * 2 + k));                                      \
+                store(out + i, acc);                                                                         \
+            }                                                                                                \
+        }                                                                                                    \
+                                                                                                             \
+        horizontal_scalar<Kind>(v, out, i, count, window, step);                                             \
+    }
+
+struct avx2_window : avx2_math
+{
+    WINDOW_KERNELS(NNCASE_TARGET_AVX2)
+};
+
+struct avx512_window : avx512_math
+{
+    WINDOW_KERNELS(NNCASE_TARGET_AVX512)
+};
+
+#undef WINDOW_KERNELS
+#endif
+
+struct window_kernels
+{
+    window_vertical_t vertical;
+    window_horizontal_t horizontal;
+};
+
+template <class V, reduce_kind Kind>
+window_kernels select_window_kernels(size_t filter, size_t stride) noexcept
+{
+    const window_vertical_t vertical = V::template vertical<Kind>;
+    if (filter == 2 && stride == 2)
+        return { vertical, V::template horizontal<Kind, 2, 2> };
+    if (filter == 3 && stride == 1)
+        return { vertical, V::template horizontal<Kind, 3, 1> };
+    if (filter == 3 && stride == 2)
+        return { vertical, V::template horizontal<Kind, 3, 2> };
+    return { vertical, V::template horizontal<Kind, 0, 0> };
+}
+
+template <reduce_kind Kind>
+window_kernels select_window_kernels(size_t filter, size_t stride) noexcept
+{
+#if NNCASE_X86_SIMD
+    const auto &features = cpu_features();
+    if (features.avx512)
+        return select_window_kernels<avx512_window, Kind>(filter, stride);
+    if (features.avx2)
+        return select_window_kernels<avx2_window, Kind>(filter, stride);
+#endif
+    return select_window_kernels<generic_window, Kind>(filter, stride);
+}
+
+// Each output is finish(init_value combined with its window, number of elements in the window)
+template <reduce_kind Kind, class TFinish>
+result<void> reduce_window2d_impl(const float *input, float init_value, float *output, const runtime_shape_t &in_shape,
+    const padding &padding_h, const padding &padding_w, int32_t filter_h, int32_t filter_w, int32_t stride_h, int32_t stride_w,
+    TFinish &&finish, kernel_context &context) noexcept
+{
+    const auto in_h = (int32_t)in_shape[2], in_w = (int32_t)in_shape[3];
+    const auto out_h = (int32_t)kernels::detail::get_windowed_output_size(in_h, filter_h, stride_h, 1, padding_h);
+    const auto out_w = (int32_t)kernels::detail::get_windowed_output_size(in_w, filter_w, stride_w, 1, padding_w);
+    const auto kernel = select_window_kernels<Kind>(filter_w, stride_w);
+
+    // Outputs [ox_begin, ox_end) have their whole window inside the row
+    const auto ox_begin = std::min(out_w, (padding_w.before + stride_w - 1) / stride_w);
+    const auto ox_end = in_w + padding_w.before < filter_w
+        ? ox_begin
+        : std::max(ox_begin, std::min(out_w, (in_w + padding_w.before - filter_w) / stride_w + 1));
+
+    const auto planes = in_shape[0] * in_shape[1];
+    return try_parallel_for(context, planes, kernels::detail::parallel_grain((size_t)in_h * in_w), [&](size_t begin, size_t end) -> result<void> {
+        // One spare element for load_even, the rest keeps the buffer end aligned to vectors.
+        // Kept per thread, so it is only allocated when a wider row comes along.
+        thread_local std::vector<float> v;
+        try
+        {
+            v.resize(std::max(v.size(), (size_t)in_w + 16));
+        }
+        catch (...)
+        {
+            return err(std::errc::not_enough_memory);
+        }
+
+        for (size_t plane = begin; plane < end; plane++)
+        {
+            const auto src = input + plane * in_h * in_w;
+            const auto dest = output + plane * out_h * out_w;
+            for (int32_t oy = 0; oy < out_h; oy++)
+            {
+                const auto y0 = oy * stride_h - padding_h.before;
+                const auto ky_begin = std::max(0, -y0);
+                const auto ky_end = std::max(ky_begin, std::min(filter_h, in_h - y0));
+                const auto rows = ky_end - ky_begin;
+                kernel.vertical(rows ? src + (y0 + ky_begin) * in_w : src, in_w, rows, in_w, v.data());
+
+                const auto row = dest + oy * out_w;
+                if (ox_end > ox_begin)
+                    kernel.horizontal(v.data() + ox_begin * stride_w - padding_w.before, row + ox_begin, ox_end - ox_begin, filter_w, stride_w);
+
+                for (int32_t ox = 0; ox < out_w; ox++)
+                {
+                    const auto x0 = ox * stride_w - padding_w.before;
+                    const auto kx_begin = std::max(0, -x0);
+                    const auto kx_end = std::max(kx_begin, std::min(filter_w, in_w - x0));
+                    auto value = row[ox];
+                    if (ox < ox_begin || ox >= ox_end)
+                    {
+                        value = identity_value<Kind, float>();
+                        for (auto kx = kx_begin; kx < kx_end; kx++)
+                            value = combine<Kind>(value, v[x0 + kx]);
+                    }
+
+                    row[ox] = finish(combine<Kind>(init_value, value), rows * (kx_end - kx_begin));
+                }
+            }
+        }
+
+        return ok();
+    });
+}
+}
+
+result<void> optimized::reduce_window2d(reduce_op_t op, const float *input, float init_value, float *output, const runtime_shape_t &in_shape,
+    const runtime_shape_t &in_strides, const runtime_shape_t &out_strides, const padding &padding_h, const padding &padding_w,
+    int32_t filter_h, int32_t filter_w, int32_t stride_h, int32_t stride_w, int32_t dilation_h, int32_t dilation_w, value_range<float> fused_activation,
+    kernel_context &context) noexcept
+{
+    if (dilation_h != 1 || dilation_w != 1 || padding_h.before < 0 || padding_h.after < 0 || padding_w.before < 0 || padding_w.after < 0)
+        return err(std::errc::not_supported);
+
+    const auto in_h = in_shape[2], in_w = in_shape[3];
+    const auto planes = in_shape[0] * in_shape[1];
+    const runtime_shape_t out_shape { in_shape[0], in_shape[1],
+        kernels::detail::get_windowed_output_size(in_h, filter_h, stride_h, 1, padding_h),
+        kernels::detail::get_windowed_output_size(in_w, filter_w, stride_w, 1, padding_w) };
+    if (!is_contiguous(in_shape, in_strides) || !is_contiguous(out_shape, out_strides) || compute_size(out_shape) == 0)
+        return err(std::errc::not_supported);
+
+    // Global pooling is a plain reduction over H and W
+    if (filter_h == (int32_t)in_h && filter_w == (int32_t)in_w && padding_h.sum() == 0 && padding_w.sum() == 0)
+    {
+        if (op != reduce_mean && op != reduce_sum && op != reduce_min && op != reduce_max)
+            return err(std::errc::not_supported);
+
+        try_(optimized::reduce(op, init_value, input, output, in_shape, { 2, 3 }, in_strides, out_strides, true, context));
+        for (size_t i = 0; i < planes; i++)
+        {
+            // reduce starts min and max from the type's limits, the window from init_value
+            if (op == reduce_min)
+                output[i] = combine<reduce_kind::min>(init_value, output[i]);
+            else if (op == reduce_max)
+                output[i] = combine<reduce_kind::max>(init_value, output[i]);
+            output[i] = kernels::detail::apply_activation(output[i], fused_activation);
+        }
+
+        return ok();
+    }
+
+    const auto activation = [=](float v) { return kernels::detail::apply_activation(v, fused_activation); };
+    switch (op)
+    {
+    case reduce_mean:
+        return reduce_window2d_impl<reduce_kind::sum>(input, init_value, output, in_shape, padding_h, padding_w, filter_h, filter_w, stride_h, stride_w,
+            [=](float v, int32_t count) { return activation(v / (float)count); }, context);
+    case reduce_sum:
+        return reduce_window2d_impl<reduce_kind::sum>(input, init_value, output, in_shape, padding_h, padding_w, filter_h, filter_w, stride_h, stride_w,
+            [=](float v, NNCASE_UNUSED int32_t count) { return activation(v); }, context);
+    case reduce_min:
+        return reduce_window2d_impl<reduce_kind::min>(input, init_value, output, in_shape, padding_h, padding_w, filter_h, filter_w, stride_h, stride_w,
+            [=](float v, NNCASE_UNUSED int32_t count) { return activation(v); }, context);
+    case reduce_max:
+        return reduce_window2d_impl<reduce_kind::max>(input, init_value, output, in_shape, padding_h, padding_w, filter_h, filter_w, stride_h, stride_w,
+            [=](float v, NNCASE_UNUSED int32_t count) { return activation(v); }, context);
+    default:
+        return err(std::errc::not_supported);
+    }
+}
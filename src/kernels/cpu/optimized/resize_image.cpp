@@ -37,15 +37,12 @@ result<void> resize_bilinear_impl(const T *input, T *output, const runtime_shape
     const auto in_img_size = in_shape[2] * in_shape[3];
     const auto out_img_size = out_w * out_h;
 
-    for (size_t batch = 0; batch < in_shape[0]; batch++)
-    {
-        auto in_batch = input + (size_t)batch * in_shape[1] * in_img_size;
-        auto *begin_output_ptr = output + batch * in_shape[1] * out_w * out_h;
-#ifdef NNCASE_OPENMP
-#pragma omp parallel for num_threads(kernels::default_kernel_context().num_threads)
-#endif
-        for (size_t oc = 0; oc < in_shape[1]; oc++)
+    parallel_for(context, in_shape[0] * in_shape[1], [&](size_t begin, size_t end) {
+        for (size_t task = begin; task < end; task++)
         {
+            const size_t batch = task / in_shape[1], oc = task % in_shape[1];
+            auto in_batch = input + (size_t)batch * in_shape[1] * in_img_size;
+            auto *begin_output_ptr = output + batch * in_shape[1] * out_w * out_h;
             auto in_c = in_batch + (size_t)oc * in_img_size;
             auto *output_ptr = begin_output_ptr + oc * out_img_size;
             for (int oy = 0; oy < out_h; oy++)
@@ -74,7 +71,7 @@ result<void> resize_bilinear_impl(const T *input, T *output, const runtime_shape
                 }
             }
         }
-    }
+    });
     return ok();
 }
 
@@ -88,15 +85,12 @@ result<void> resize_nearest_neighbor_impl(const T *input, T *output, const runti
 
     const auto in_image_size = in_shape[2] * in_shape[3];
     const auto out_image_size = out_h * out_w;
-    for (size_t batch = 0; batch < in_shape[0]; batch++)
-    {
-        auto *begin_input_ptr = input + batch * in_shape[1] * in_image_size;
-        auto *begin_output_ptr = output + batch * in_shape[1] * out_image_size;
-#ifdef NNCASE_OPENMP
-#pragma omp parallel for num_threads(kernels::default_kernel_context().num_threads)
-#endif
-        for (size_t oc = 0; oc < in_shape[1]; oc++)
+    parallel_for(context, in_shape[0] * in_shape[1], [&](size_t begin, size_t end) {
+        for (size_t task = begin; task < end; task++)
         {
+            const size_t batch = task / in_shape[1], oc = task % in_shape[1];
+            auto *begin_input_ptr = input + batch * in_shape[1] * in_image_size;
+            auto *begin_output_ptr = output + batch * in_shape[1] * out_image_size;
             auto *input_ptr = begin_input_ptr + oc * in_image_size;
             auto *output_ptr = begin_output_ptr + oc * out_image_size;
 
@@ -112,7 +106,7 @@ result<void> resize_nearest_neighbor_impl(const T *input, T *output, const runti
                 }
             }
         }
-    }
+    });
     return ok();
 }
 
@@ -130,15 +124,12 @@ inline result<void> gnne_resize_nearest_neighbor(const bfloat16 *input, bfloat16
 
     const auto in_image_size = in_shape[2] * in_shape[3];
     const auto out_image_size = out_h * out_w;
-    for (size_t batch = 0; batch < in_shape[0]; batch++)
-    {
-        auto *begin_input_ptr = input + batch * in_shape[1] * in_image_size;
-        auto *begin_output_ptr = output + batch * in_shape[1] * out_image_size;
-#ifdef NNCASE_OPENMP
-#pragma omp parallel for num_threads(kernels::default_kernel_context().num_threads)
-#endif
-        for (size_t oc = 0; oc < in_shape[1]; oc++)
+    parallel_for(context, in_shape[0] * in_shape[1], [&](size_t begin, size_t end) {
+        for (size_t task = begin; task < end; task++)
         {
+            const size_t batch = task / in_shape[1], oc = task % in_shape[1];
+            auto *begin_input_ptr = input + batch * in_shape[1] * in_image_size;
+            auto *begin_output_ptr = output + batch * in_shape[1] * out_image_size;
             auto *input_ptr = begin_input_ptr + oc * in_image_size;
             auto *output_ptr = begin_output_ptr + oc * out_image_size;
 
@@ -154,7 +145,7 @@ inline result<void> gnne_resize_nearest_neighbor(const bfloat16 *input, bfloat16
                 }
             }
         }
-    }
+    });
     return ok();
 }
 
@@ -179,15 +170,12 @@ inline result<void> resize_bilinear_impl(const bfloat16 *input, bfloat16 *output
     const auto in_img_size = in_shape[2] * in_shape[3];
     const auto out_img_size = out_w * out_h;
 
-    for (size_t batch = 0; batch < in_shape[0]; batch++)
-    {
-        auto in_batch = input + (size_t)batch * in_shape[1] * in_img_size;
-        auto *begin_output_ptr = output + batch * in_shape[1] * out_w * out_h;
-#ifdef NNCASE_OPENMP
-#pragma omp parallel for num_threads(kernels::default_kernel_context().num_threads)
-#endif
-        for (size_t oc = 0; oc < in_shape[1]; oc++)
+    parallel_for(context, in_shape[0] * in_shape[1], [&](size_t begin, size_t end) {
+        for (size_t task = begin; task < end; task++)
         {
+            const size_t batch = task / in_shape[1], oc = task % in_shape[1];
+            auto in_batch = input + (size_t)batch * in_shape[1] * in_img_size;
+            auto *begin_output_ptr = output + batch * in_shape[1] * out_w * out_h;
             auto in_c = in_batch + (size_t)oc * in_img_size;
             auto *output_ptr = begin_output_ptr + oc * out_img_size;
             for (int oy = 0; oy < out_h; oy++)
@@ -217,7 +205,7 @@ inline result<void> resize_bilinear_impl(const bfloat16 *input, bfloat16 *output
                 }
             }
         }
-    }
+    });
     return ok();
 }
 
@@ -112,13 +112,13 @@ result<void> optimized_matmul_impl(const float *input_a, const float *input_b, c
 template result<void> optimized::matmul<float>(const float *input_a, const float *input_b, const float *bias, float *output,
     const runtime_shape_t &in_a_shape, const runtime_shape_t &in_a_strides, const runtime_shape_t &in_b_shape,
     const runtime_shape_t &in_b_strides, const runtime_shape_t &out_shape, const runtime_shape_t &out_strides,
-    value_range<float> fused_activation) noexcept;
+    value_range<float> fused_activation, kernel_context &context) noexcept;
 
 template <typename T>
 result<void> optimized::matmul(const T *input_a, const T *input_b, const T *bias, T *output,
     const runtime_shape_t &in_a_shape, const runtime_shape_t &in_a_strides, const runtime_shape_t &in_b_shape,
     const runtime_shape_t &in_b_strides, const runtime_shape_t &out_shape, const runtime_shape_t &out_strides,
-    value_range<float> fused_activation) noexcept
+    value_range<float> fused_activation, NNCASE_UNUSED kernel_context &context) noexcept
 {
 #if __riscv_vector
     return optimized_matmul_impl(input_a, input_b, bias, output, in_a_shape, in_a_strides, in_b_shape, in_b_strides, out_shape, out_strides, fused_activation);
@@ -0,0 +1,349 @@
+/* Copyright 2019-2021 Canaan Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <algorithm>
+#include <cstring>
+#include <nncase/kernels/cpu/optimized/tensor_compute.h>
+#include <nncase/kernels/cpu/reference/tensor_compute.h>
+#include <nncase/kernels/kernel_utils.h>
+#include <nncase/runtime/runtime_op_utility.h>
+#if !defined(__riscv)
+#include "x86_64/utils.h"
+#endif
+
+using namespace nncase;
+using namespace nncase::runtime;
+using namespace nncase::kernels;
+using namespace nncase::kernels::cpu;
+using namespace nncase::kernels::cpu::optimized;
+
+namespace
+{
+// One output axis after dropping unit axes and merging neighbours that are
+// also neighbours in the input. Strides are in elements.
+struct transpose_dim
+{
+    size_t extent;
+    size_t in_stride;
+    size_t out_stride;
+};
+
+using transpose_dims_t = itlib::small_vector<transpose_dim, 4>;
+
+transpose_dims_t collapse_dims(const runtime_shape_t &in_shape, const runtime_shape_t &perm,
+    const runtime_shape_t &in_strides, const runtime_shape_t &out_strides) noexcept
+{
+    transpose_dims_t dims;
+    for (size_t i = 0; i < perm.size(); i++)
+    {
+        const transpose_dim dim { in_shape[perm[i]], in_strides[perm[i]], out_strides[i] };
+        if (dim.extent == 1)
+            continue;
+
+        if (!dims.empty())
+        {
+            auto &outer = dims.back();
+            if (outer.in_stride == dim.in_stride * dim.extent && outer.out_stride == dim.out_stride * dim.extent)
+            {
+                outer = { outer.extent * dim.extent, dim.in_stride, dim.out_stride };
+                continue;
+            }
+        }
+
+        dims.push_back(dim);
+    }
+
+    return dims;
+}
+
+// Axes not handled by the inner kernel, walked by decoding a flat index
+struct batch_offsets
+{
+    transpose_dims_t dims;
+
+    size_t count() const noexcept
+    {
+        size_t count = 1;
+        for (auto &dim : dims)
+            count *= dim.extent;
+        return count;
+    }
+
+    std::pair<size_t, size_t> operator[](size_t index) const noexcept
+    {
+        size_t in_offset = 0, out_offset = 0;
+        for (size_t i = dims.size(); i-- > 0;)
+        {
+            const auto pos = index % dims[i].extent;
+            index /= dims[i].extent;
+            in_offset += pos * dims[i].in_stride;
+            out_offset += pos * dims[i].out_stride;
+        }
+
+        return { in_offset, out_offset };
+    }
+};
+
+// dest[k * dest_stride + i] = src[i * src_stride + k] for i < rows, k < cols
+template <class T>
+using transpose_2d_t = void (*)(const T *src, size_t src_stride, T *dest, size_t dest_stride, size_t rows, size_t cols);
+
+template <class T>
+void transpose_2d_generic(const T *src, size_t src_stride, T *dest, size_t dest_stride, size_t rows, size_t cols) noexcept
+{
+    // Square blocks keep both the rows read and the rows written in cache
+    constexpr size_t block = 32;
+    for (size_t i0 = 0; i0 < rows; i0 += block)
+    {
+        const auto i1 = std::min(rows, i0 + block);
+        for (size_t k0 = 0; k0 < cols; k0 += block)
+        {
+            const auto k1 = std::min(cols, k0 + block);
+            for (size_t i = i0; i < i1; i++)
+                for (size_t k = k0; k < k1; k++)
+                    dest[k * dest_stride + i] = src[i * src_stride + k];
+        }
+    }
+}
+
+#if NNCASE_X86_SIMD
+// Full tiles go through the register transpose, the ragged edges through scalar loops.
+#define TRANSPOSE_2D_TILED(target, name, tile)                                                                         \
+    target void name(const uint32_t *src, size_t src_stride, uint32_t *dest, size_t dest_stride, size_t rows, size_t cols) \
+    {                                                                                                                  \
+        const auto full_rows = rows / tile * tile;                                                                     \
+        const auto full_cols = cols / tile * tile;                                                                     \
+        for (size_t i = 0; i < full_rows; i += tile)                                                                   \
+        {                                                                                                              \
+            for (size_t k = 0; k < full_cols; k += tile)                                                               \
+                name##_tile(src + i * src_stride + k, src_stride, dest + k * dest_stride + i, dest_stride);            \
+            for (size_t ii = i; ii < i + tile; ii++)                                                                   \
+                for (size_t k = full_cols; k < cols; k++)                                                              \
+                    dest[k * dest_stride + ii] = src[ii * src_stride + k];                                             \
+        }                                                                                                              \
+        for (size_t k = 0; k < cols; k++)                                                                              \
+            for (size_t i = full_rows; i < rows; i++)                                                                  \
+                dest[k * dest_stride + i] = src[i * src_stride + k];                                                   \
+    }
+
+NNCASE_TARGET_AVX2 inline void avx2_transpose_2d_tile(const uint32_t *src, size_t src_stride, uint32_t *dest, size_t dest_stride)
+{
+    __m256 r[8], t[8];
+    NNCASE_UNROLL
+    for (size_t i = 0; i < 8; i++)
+        r[i] = _mm256_loadu_ps(reinterpret_cast<const float *>(src + i * src_stride));
+
+    NNCASE_UNROLL
+    for (size_t i = 0; i < 8; i += 2)
+    {
+        t[i] = _mm256_unpacklo_ps(r[i], r[i + 1]);
+        t[i + 1] = _mm256_unpackhi_ps(r[i], r[i + 1]);
+    }
+
+    // r[g * 4 + c] holds column c (and c + 4 in the high half) of rows g * 4 .. g * 4 + 3
+    NNCASE_UNROLL
+    for (size_t g = 0; g < 8; g += 4)
+    {
+        r[g] = _mm256_shuffle_ps(t[g], t[g + 2], 0x44);
+        r[g + 1] = _mm256_shuffle_ps(t[g], t[g + 2], 0xee);
+        r[g + 2] = _mm256_shuffle_ps(t[g + 1], t[g + 3], 0x44);
+        r[g + 3] = _mm256_shuffle_ps(t[g + 1], t[g + 3], 0xee);
+    }
+
+    NNCASE_UNROLL
+    for (size_t c = 0; c < 4; c++)
+    {
+        _mm256_storeu_ps(reinterpret_cast<float *>(dest + c * dest_stride), _mm256_permute2f128_ps(r[c], r[c + 4], 0x20));
+        _mm256_storeu_ps(reinterpret_cast<float *>(dest + (c + 4) * dest_stride), _mm256_permute2f128_ps(r[c], r[c + 4], 0x31));
+    }
+}
+
+// The two source permutes stand in for unpack and shuffle_f32x4, whose GCC 12
+// headers trip -Wuninitialized through _mm512_undefined_ps.
+NNCASE_TARGET_AVX512 inline void avx512_transpose_2d_tile(const uint32_t *src, size_t src_stride, uint32_t *dest, size_t dest_stride)
+{
+    __m512 r[16], t[16];
+    NNCASE_UNROLL
+    for (size_t i = 0; i < 16; i++)
+        r[i] = _mm512_loadu_ps(reinterpret_cast<const float *>(src + i * src_stride));
+
+    const auto unpack_lo = _mm512_setr_epi32(0, 16, 1, 17, 4, 20, 5, 21, 8, 24, 9, 25, 12, 28, 13, 29);
+    const auto unpack_hi = _mm512_setr_epi32(2, 18, 3, 19, 6, 22, 7, 23, 10, 26, 11, 27, 14, 30, 15, 31);
+    NNCASE_UNROLL
+    for (size_t i = 0; i < 16; i += 2)
+    {
+        t[i] = _mm512_permutex2var_ps(r[i], unpack_lo, r[i + 1]);
+        t[i + 1] = _mm512_permutex2var_ps(r[i], unpack_hi, r[i + 1]);
+    }
+
+    // r[g * 4 + c], 128-bit lane l holds column l * 4 + c of rows g * 4 .. g * 4 + 3
+    NNCASE_UNROLL
+    for (size_t g = 0; g < 16; g += 4)
+    {
+        r[g] = _mm512_shuffle_ps(t[g], t[g + 2], 0x44);
+        r[g + 1] = _mm512_shuffle_ps(t[g], t[g + 2], 0xee);
+        r[g + 2] = _mm512_shuffle_ps(t[g + 1], t[g + 3], 0x44);
+        r[g + 3] = _mm512_shuffle_ps(t[g + 1], t[g + 3], 0xee);
+    }
+
+    // Gather lane l of r[c], r[c + 4], r[c + 8], r[c + 12] into output row l * 4 + c
+    const auto even_lanes = _mm512_setr_epi32(0, 1, 2, 3, 8, 9, 10, 11, 16, 17, 18, 19, 24, 25, 26, 27);
+    const auto odd_lanes = _mm512_setr_epi32(4, 5, 6, 7, 12, 13, 14, 15, 20, 21, 22, 23, 28, 29, 30, 31);
+    NNCASE_UNROLL
+    for (size_t c = 0; c < 4; c++)
+    {
+        const auto even_lo = _mm512_permutex2var_ps(r[c], even_lanes, r[c + 4]);
+        const auto odd_lo = _mm512_permutex2var_ps(r[c], odd_lanes, r[c + 4]);
+        const auto even_hi = _mm512_permutex2var_ps(r[c + 8], even_lanes, r[c + 12]);
+        const auto odd_hi = _mm512_permutex2var_ps(r[c + 8], odd_lanes, r[c + 12]);
+        _mm512_storeu_ps(reinterpret_cast<float *>(dest + c * dest_stride), _mm512_permutex2var_ps(even_lo, even_lanes, even_hi));
+        _mm512_storeu_ps(reinterpret_cast<float *>(dest + (c + 4) * dest_stride), _mm512_permutex2var_ps(odd_lo, even_lanes, odd_hi));
+        _mm512_storeu_ps(reinterpret_cast<float *>(dest + (c + 8) * dest_stride), _mm512_permutex2var_ps(even_lo, odd_lanes, even_hi));
+        _mm512_storeu_ps(reinterpret_cast<float *>(dest + (c + 12) * dest_stride), _mm512_permutex2var_ps(odd_lo, odd_lanes, odd_hi));
+    }
+}
+
+TRANSPOSE_2D_TILED(NNCASE_TARGET_AVX2, avx2_transpose_2d, 8)
+TRANSPOSE_2D_TILED(NNCASE_TARGET_AVX512, avx512_transpose_2d, 16)
+
+#undef TRANSPOSE_2D_TILED
+#endif
+
+template <class T>
+transpose_2d_t<T> select_transpose_2d() noexcept
+{
+#if NNCASE_X86_SIMD
+    // The register tiles only move bits, so they serve every 4 byte type
+    if constexpr (std::is_same_v<T, uint32_t>)
+    {
+        const auto &features = cpu_features();
+        if (features.avx512)
+            return avx512_transpose_2d;
+        if (features.avx2)
+            return avx2_transpose_2d;
+    }
+#endif
+    return transpose_2d_generic<T>;
+}
+
+template <class T>
+result<void> transpose_impl(const T *src, T *dest, const transpose_dims_t &dims, kernel_context &context) noexcept
+{
+    if (dims.empty())
+    {
+        *dest = *src;
+        return ok();
+    }
+
+    // The innermost axis stays innermost: copy whole runs
+    auto &inner = dims.back();
+    if (inner.in_stride == 1 && inner.out_stride == 1)
+    {
+        const batch_offsets batch { transpose_dims_t(dims.begin(), dims.end() - 1) };
+        parallel_for(context, batch.count(), kernels::detail::parallel_grain(inner.extent), [&](size_t begin, size_t end) {
+            for (size_t b = begin; b < end; b++)
+            {
+                const auto [in_offset, out_offset] = batch[b];
+                std::memcpy(dest + out_offset, src + in_offset, inner.extent * sizeof(T));
+            }
+        });
+        return ok();
+    }
+
+    // Otherwise the output's innermost axis and the input's innermost axis form
+    // a 2-D transpose, batched over the rest
+    const auto column = std::find_if(dims.begin(), dims.end(), [](const transpose_dim &dim) { return dim.in_stride == 1; });
+    if (inner.out_stride != 1 || column == dims.end())
+        return err(std::errc::not_supported);
+
+    batch_offsets batch;
+    for (auto it = dims.begin(); it != dims.end() - 1; ++it)
+    {
+        if (it != column)
+            batch.dims.push_back(*it);
+    }
+
+    // Each task transposes a stripe of rows across all columns
+    constexpr size_t stripe = 64;
+    const auto rows = inner.extent, cols = column->extent;
+    const auto src_stride = inner.in_stride, dest_stride = column->out_stride;
+    const auto stripes = (rows + stripe - 1) / stripe;
+    const auto transpose_2d = select_transpose_2d<T>();
+    parallel_for(context, batch.count() * stripes, kernels::detail::parallel_grain(stripe * cols), [&](size_t begin, size_t end) {
+        for (size_t task = begin; task < end; task++)
+        {
+            const auto [in_offset, out_offset] = batch[task / stripes];
+            const auto row = task % stripes * stripe;
+            transpose_2d(src + in_offset + row * src_stride, src_stride, dest + out_offset + row, dest_stride,
+                std::min(stripe, rows - row), cols);
+        }
+    });
+    return ok();
+}
+
+result<void> transpose_chunked(datatype_t type, const gsl::byte *src, gsl::byte *dest, const runtime_shape_t &in_shape,
+    const runtime_shape_t &perm, const runtime_shape_t &in_strides, const runtime_shape_t &out_strides, kernel_context &context) noexcept
+{
+    // Split the outermost output axis that has more than one element; it reads input axis perm[axis].
+    runtime_shape_t out_shape(in_shape.size());
+    for (size_t i = 0; i < in_shape.size(); i++)
+        out_shape[i] = in_shape[perm[i]];
+
+    size_t axis = 0;
+    while (axis < out_shape.size() && out_shape[axis] == 1)
+        axis++;
+    if (axis == out_shape.size())
+        return cpu::reference::transpose(type, src, dest, in_shape, perm, in_strides, out_strides, context);
+
+    const auto unit = runtime::get_bytes(type);
+    const auto in_axis = perm[axis];
+    const auto inner_size = compute_size(out_shape) / out_shape[axis];
+    return try_parallel_for(context, out_shape[axis], kernels::detail::parallel_grain(inner_size), [&](size_t begin, size_t end) {
+        auto chunk_shape = in_shape;
+        chunk_shape[in_axis] = end - begin;
+        return cpu::reference::transpose(type, src + begin * in_strides[in_axis] * unit, dest + begin * out_strides[axis] * unit,
+            chunk_shape, perm, in_strides, out_strides, context);
+    });
+}
+}
+
+#define TRANSPOSE_IMPL(size, type) \
+    case size:                     \
+        return transpose_impl(reinterpret_cast<const type *>(src), reinterpret_cast<type *>(dest), dims, context)
+
+result<void> optimized::transpose(datatype_t type, const gsl::byte *src, gsl::byte *dest, const runtime_shape_t &in_shape,
+    const runtime_shape_t &perm, const runtime_shape_t &in_strides, const runtime_shape_t &out_strides, kernel_context &context) noexcept
+{
+    if (compute_size(in_shape) == 0)
+        return ok();
+
+    // Layouts without a unit stride axis on both sides keep the per element path
+    const auto dims = collapse_dims(in_shape, perm, in_strides, out_strides);
+    const bool has_unit_in_stride = dims.empty()
+        || std::any_of(dims.begin(), dims.end(), [](const transpose_dim &dim) { return dim.in_stride == 1; });
+    if (has_unit_in_stride && (dims.empty() || dims.back().out_stride == 1))
+    {
+        switch (runtime::get_bytes(type))
+        {
+            TRANSPOSE_IMPL(1, uint8_t);
+            TRANSPOSE_IMPL(2, uint16_t);
+            TRANSPOSE_IMPL(4, uint32_t);
+            TRANSPOSE_IMPL(8, uint64_t);
+        default:
+            break;
+        }
+    }
+
+    return transpose_chunked(type, src, dest, in_shape, perm, in_strides, out_strides, context);
+}
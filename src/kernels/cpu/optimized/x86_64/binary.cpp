@@ -12,6 +12,9 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  */
+#include "utils.h"
+#include <cmath>
+#include <limits>
 #include <nncase/kernels/cpu/optimized/tensor_compute.h>
 #include <nncase/kernels/cpu/reference/tensor_compute.h>
 #include <nncase/kernels/kernel_utils.h>
@@ -23,6 +26,513 @@ using namespace nncase::kernels;
 using namespace nncase::kernels::cpu;
 using namespace nncase::kernels::cpu::optimized;
 
+namespace
+{
+// Contiguous inputs broadcast to the output are walked as rows of the innermost output
+// dimension. Output dimensions are merged while both inputs broadcast along them the same
+// way, so same-shape, scalar, per-channel and inner-dim broadcasts all end up as a few
+// long rows. Within a row each input is either a vector or a single repeated value.
+struct binary_layout
+{
+    // Outer dimensions, innermost first. Strides are 0 along broadcast dimensions.
+    runtime_shape_t outer_shape;
+    runtime_shape_t a_strides;
+    runtime_shape_t b_strides;
+    size_t inner = 1;
+    bool a_scalar = false;
+    bool b_scalar = false;
+};
+
+bool make_layout(const runtime_shape_t &in_a_shape, const runtime_shape_t &in_b_shape, const runtime_shape_t &out_shape, binary_layout &layout)
+{
+    const auto rank = out_shape.size();
+    if (in_a_shape.size() > rank || in_b_shape.size() > rank)
+        return false;
+
+    bool has_inner = false, last_a_bcast = false, last_b_bcast = false;
+    size_t a_size = 1, b_size = 1;
+    for (size_t i = 0; i < rank; i++)
+    {
+        const auto extent = out_shape[rank - 1 - i];
+        const auto a_dim = i < in_a_shape.size() ? in_a_shape[in_a_shape.size() - 1 - i] : 1;
+        const auto b_dim = i < in_b_shape.size() ? in_b_shape[in_b_shape.size() - 1 - i] : 1;
+        if ((a_dim != extent && a_dim != 1) || (b_dim != extent && b_dim != 1))
+            return false;
+        if (extent == 1)
+            continue;
+
+        const bool a_bcast = a_dim == 1;
+        const bool b_bcast = b_dim == 1;
+        if (a_bcast && b_bcast)
+            return false;
+
+        if (!has_inner)
+        {
+            has_inner = true;
+            layout.inner = extent;
+            layout.a_scalar = a_bcast;
+            layout.b_scalar = b_bcast;
+        }
+        else if (a_bcast == last_a_bcast && b_bcast == last_b_bcast)
+        {
+            // Contiguous dimensions broadcast alike merge into the inner one
+            if (layout.outer_shape.empty())
+                layout.inner *= extent;
+            else
+                layout.outer_shape.back() *= extent;
+        }
+        else
+        {
+            layout.outer_shape.push_back(extent);
+            layout.a_strides.push_back(a_bcast ? 0 : a_size);
+            layout.b_strides.push_back(b_bcast ? 0 : b_size);
+        }
+
+        last_a_bcast = a_bcast;
+        last_b_bcast = b_bcast;
+        a_size *= a_dim;
+        b_size *= b_dim;
+    }
+
+    return true;
+}
+
+template <binary_op_t Op, class T>
+T scalar_binary(T a, T b) noexcept
+{
+    if constexpr (Op == binary_add)
+        return a + b;
+    else if constexpr (Op == binary_sub)
+        return a - b;
+    else if constexpr (Op == binary_mul)
+        return a * b;
+    else if constexpr (Op == binary_div)
+        return a / b;
+    else if constexpr (Op == binary_min)
+        return std::min(a, b);
+    else
+        return std::max(a, b);
+}
+
+template <binary_op_t Op, class T, size_t N>
+void scalar_binary_lanes(T *a, const T *b) noexcept
+{
+    for (size_t i = 0; i < N; i++)
+        a[i] = scalar_binary<Op>(a[i], b[i]);
+}
+
+// The fused clamp. Integer outputs are clamped to the integer bounds inside the range,
+// so they stay exact instead of round-tripping through float.
+template <class T>
+struct activation
+{
+    T lo;
+    T hi;
+    bool enabled;
+
+    activation(value_range<float> range) noexcept
+    {
+        if constexpr (std::is_floating_point_v<T>)
+        {
+            lo = range.min;
+            hi = range.max;
+            enabled = !(std::isinf(range.min) && range.min < 0 && std::isinf(range.max) && range.max > 0);
+        }
+        else
+        {
+            lo = to_bound(std::ceil(range.min));
+            hi = to_bound(std::floor(range.max));
+            enabled = lo != std::numeric_limits<T>::lowest() || hi != std::numeric_limits<T>::max();
+        }
+    }
+
+    static T to_bound(float value) noexcept
+    {
+        constexpr auto lowest = std::numeric_limits<T>::lowest();
+        constexpr auto highest = std::numeric_limits<T>::max();
+        return value <= (float)lowest ? lowest : (value >= (float)highest ? highest : (T)value);
+    }
+
+    T operator()(T value) const noexcept
+    {
+        return kernels::detail::apply_activation(value, value_range<T> { lo, hi });
+    }
+};
+
+// Row kernel shared by all ISAs. It is stamped into each of them so it gets compiled for
+// that ISA's target and its register helpers inline into it.
+#define BINARY_ROW(target)                                                                                                     \
+    template <binary_op_t Op, bool AScalar, bool BScalar>                                                                      \
+    target static void row(const value_type *a, const value_type *b, value_type *output, size_t count,                         \
+        const activation<value_type> &act) noexcept                                                                            \
+    {                                                                                                                          \
+        const auto lo = set1(act.lo);                                                                                          \
+        const auto hi = set1(act.hi);                                                                                          \
+        const auto a_value = set1(*a);                                                                                         \
+        const auto b_value = set1(*b);                                                                                         \
+        size_t i = 0;                                                                                                          \
+        for (; i + lanes <= count; i += lanes)                                                                                 \
+        {                                                                                                                      \
+            auto value = apply<Op>(AScalar ? a_value : load(a + i), BScalar ? b_value : load(b + i));                          \
+            if (act.enabled)                                                                                                   \
+                value = clamp(value, lo, hi);                                                                                  \
+            store(output + i, value);                                                                                          \
+        }                                                                                                                      \
+                                                                                                                               \
+        for (; i < count; i++)                                                                                                 \
+        {                                                                                                                      \
+            auto value = scalar_binary<Op>(AScalar ? *a : a[i], BScalar ? *b : b[i]);                                          \
+            output[i] = act.enabled ? act(value) : value;                                                                      \
+        }                                                                                                                      \
+    }
+
+template <class T>
+struct generic_isa
+{
+    using value_type = T;
+    using reg = T;
+    static constexpr size_t lanes = 1;
+
+    static reg load(const T *p) noexcept { return *p; }
+    static void store(T *p, reg v) noexcept { *p = v; }
+    static reg set1(T v) noexcept { return v; }
+
+    template <binary_op_t Op>
+    static reg apply(reg a, reg b) noexcept { return scalar_binary<Op>(a, b); }
+
+    static reg clamp(reg v, reg lo, reg hi) noexcept { return kernels::detail::apply_activation(v, value_range<T> { lo, hi }); }
+
+    BINARY_ROW()
+};
+
+#if NNCASE_X86_SIMD
+// Float min/max and the clamp pass their operands in the order that returns the same
+// value as std::min/std::max when one of them is NaN.
+struct avx2_f32
+{
+    using value_type = float;
+    using reg = __m256;
+    static constexpr size_t lanes = 8;
+
+    NNCASE_TARGET_AVX2 static reg load(const float *p) noexcept { return _mm256_loadu_ps(p); }
+    NNCASE_TARGET_AVX2 static void store(float *p, reg v) noexcept { _mm256_storeu_ps(p, v); }
+    NNCASE_TARGET_AVX2 static reg set1(float v) noexcept { return _mm256_set1_ps(v); }
+
+    template <binary_op_t Op>
+    NNCASE_TARGET_AVX2 static reg apply(reg a, reg b) noexcept
+    {
+        if constexpr (Op == binary_add)
+            return _mm256_add_ps(a, b);
+        else if constexpr (Op == binary_sub)
+            return _mm256_sub_ps(a, b);
+        else if constexpr (Op == binary_mul)
+            return _mm256_mul_ps(a, b);
+        else if constexpr (Op == binary_div)
+            return _mm256_div_ps(a, b);
+        else if constexpr (Op == binary_min)
+            return _mm256_min_ps(b, a);
+        else
+            return _mm256_max_ps(b, a);
+    }
+
+    NNCASE_TARGET_AVX2 static reg clamp(reg v, reg lo, reg hi) noexcept { return _mm256_max_ps(lo, _mm256_min_ps(hi, v)); }
+
+    BINARY_ROW(NNCASE_TARGET_AVX2)
+};
+
+struct avx2_i32
+{
+    using value_type = int32_t;
+    using reg = __m256i;
+    static constexpr size_t lanes = 8;
+
+    NNCASE_TARGET_AVX2 static reg load(const int32_t *p) noexcept { return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p)); }
+    NNCASE_TARGET_AVX2 static void store(int32_t *p, reg v) noexcept { _mm256_storeu_si256(reinterpret_cast<__m256i *>(p), v); }
+    NNCASE_TARGET_AVX2 static reg set1(int32_t v) noexcept { return _mm256_set1_epi32(v); }
+
+    template <binary_op_t Op>
+    NNCASE_TARGET_AVX2 static reg apply(reg a, reg b) noexcept
+    {
+        if constexpr (Op == binary_add)
+            return _mm256_add_epi32(a, b);
+        else if constexpr (Op == binary_sub)
+            return _mm256_sub_epi32(a, b);
+        else if constexpr (Op == binary_mul)
+            return _mm256_mullo_epi32(a, b);
+        else if constexpr (Op == binary_min)
+            return _mm256_min_epi32(a, b);
+        else if constexpr (Op == binary_max)
+            return _mm256_max_epi32(a, b);
+        else
+        {
+            alignas(32) int32_t x[lanes], y[lanes];
+            store(x, a);
+            store(y, b);
+            scalar_binary_lanes<Op, int32_t, lanes>(x, y);
+            return load(x);
+        }
+    }
+
+    NNCASE_TARGET_AVX2 static reg clamp(reg v, reg lo, reg hi) noexcept { return _mm256_max_epi32(lo, _mm256_min_epi32(hi, v)); }
+
+    BINARY_ROW(NNCASE_TARGET_AVX2)
+};
+
+struct avx2_i64
+{
+    using value_type = int64_t;
+    using reg = __m256i;
+    static constexpr size_t lanes = 4;
+
+    NNCASE_TARGET_AVX2 static reg load(const int64_t *p) noexcept { return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p)); }
+    NNCASE_TARGET_AVX2 static void store(int64_t *p, reg v) noexcept { _mm256_storeu_si256(reinterpret_cast<__m256i *>(p), v); }
+    NNCASE_TARGET_AVX2 static reg set1(int64_t v) noexcept { return _mm256_set1_epi64x(v); }
+    NNCASE_TARGET_AVX2 static reg min(reg a, reg b) noexcept { return _mm256_blendv_epi8(a, b, _mm256_cmpgt_epi64(a, b)); }
+    NNCASE_TARGET_AVX2 static reg max(reg a, reg b) noexcept { return _mm256_blendv_epi8(a, b, _mm256_cmpgt_epi64(b, a)); }
+
+    // AVX2 has no 64-bit multiply or divide
+    template <binary_op_t Op>
+    NNCASE_TARGET_AVX2 static reg apply(reg a, reg b) noexcept
+    {
+        if constexpr (Op == binary_add)
+            return _mm256_add_epi64(a, b);
+        else if constexpr (Op == binary_sub)
+            return _mm256_sub_epi64(a, b);
+        else if constexpr (Op == binary_min)
+            return min(a, b);
+        else if constexpr (Op == binary_max)
+            return max(a, b);
+        else
+        {
+            alignas(32) int64_t x[lanes], y[lanes];
+            store(x, a);
+            store(y, b);
+            scalar_binary_lanes<Op, int64_t, lanes>(x, y);
+            return load(x);
+        }
+    }
+
+    NNCASE_TARGET_AVX2 static reg clamp(reg v, reg lo, reg hi) noexcept { return max(lo, min(hi, v)); }
+
+    BINARY_ROW(NNCASE_TARGET_AVX2)
+};
+
+struct avx512_f32
+{
+    using value_type = float;
+    using reg = __m512;
+    static constexpr size_t lanes = 16;
+
+    NNCASE_TARGET_AVX512 static reg load(const float *p) noexcept { return _mm512_loadu_ps(p); }
+    NNCASE_TARGET_AVX512 static void store(float *p, reg v) noexcept { _mm512_storeu_ps(p, v); }
+    NNCASE_TARGET_AVX512 static reg set1(float v) noexcept { return _mm512_set1_ps(v); }
+
+    template <binary_op_t Op>
+    NNCASE_TARGET_AVX512 static reg apply(reg a, reg b) noexcept
+    {
+        if constexpr (Op == binary_add)
+            return _mm512_add_ps(a, b);
+        else if constexpr (Op == binary_sub)
+            return _mm512_sub_ps(a, b);
+        else if constexpr (Op == binary_mul)
+            return _mm512_mul_ps(a, b);
+        else if constexpr (Op == binary_div)
+            return _mm512_div_ps(a, b);
+        else if constexpr (Op == binary_min)
+            return _mm512_min_ps(b, a);
+        else
+            return _mm512_max_ps(b, a);
+    }
+
+    NNCASE_TARGET_AVX512 static reg clamp(reg v, reg lo, reg hi) noexcept { return _mm512_max_ps(lo, _mm512_min_ps(hi, v)); }
+
+    BINARY_ROW(NNCASE_TARGET_AVX512)
+};
+
+struct avx512_i32
+{
+    using value_type = int32_t;
+    using reg = __m512i;
+    static constexpr size_t lanes = 16;
+
+    NNCASE_TARGET_AVX512 static reg load(const int32_t *p) noexcept { return _mm512_loadu_si512(p); }
+    NNCASE_TARGET_AVX512 static void store(int32_t *p, reg v) noexcept { _mm512_storeu_si512(p, v); }
+    NNCASE_TARGET_AVX512 static reg set1(int32_t v) noexcept { return _mm512_set1_epi32(v); }
+
+    template <binary_op_t Op>
+    NNCASE_TARGET_AVX512 static reg apply(reg a, reg b) noexcept
+    {
+        if constexpr (Op == binary_add)
+            return _mm512_add_epi32(a, b);
+        else if constexpr (Op == binary_sub)
+            return _mm512_sub_epi32(a, b);
+        else if constexpr (Op == binary_mul)
+            return _mm512_mullo_epi32(a, b);
+        else if constexpr (Op == binary_min)
+            return _mm512_min_epi32(a, b);
+        else if constexpr (Op == binary_max)
+            return _mm512_max_epi32(a, b);
+        else
+        {
+            alignas(64) int32_t x[lanes], y[lanes];
+            store(x, a);
+            store(y, b);
+            scalar_binary_lanes<Op, int32_t, lanes>(x, y);
+            return load(x);
+        }
+    }
+
+    NNCASE_TARGET_AVX512 static reg clamp(reg v, reg lo, reg hi) noexcept { return _mm512_max_epi32(lo, _mm512_min_epi32(hi, v)); }
+
+    BINARY_ROW(NNCASE_TARGET_AVX512)
+};
+
+struct avx512_i64
+{
+    using value_type = int64_t;
+    using reg = __m512i;
+    static constexpr size_t lanes = 8;
+
+    NNCASE_TARGET_AVX512 static reg load(const int64_t *p) noexcept { return _mm512_loadu_si512(p); }
+    NNCASE_TARGET_AVX512 static void store(int64_t *p, reg v) noexcept { _mm512_storeu_si512(p, v); }
+    NNCASE_TARGET_AVX512 static reg set1(int64_t v) noexcept { return _mm512_set1_epi64(v); }
+
+    template <binary_op_t Op>
+    NNCASE_TARGET_AVX512 static reg apply(reg a, reg b) noexcept
+    {
+        if constexpr (Op == binary_add)
+            return _mm512_add_epi64(a, b);
+        else if constexpr (Op == binary_sub)
+            return _mm512_sub_epi64(a, b);
+        else if constexpr (Op == binary_mul)
+            return _mm512_mullo_epi64(a, b);
+        else if constexpr (Op == binary_min)
+            return _mm512_min_epi64(a, b);
+        else if constexpr (Op == binary_max)
+            return _mm512_max_epi64(a, b);
+        else
+        {
+            alignas(64) int64_t x[lanes], y[lanes];
+            store(x, a);
+            store(y, b);
+            scalar_binary_lanes<Op, int64_t, lanes>(x, y);
+            return load(x);
+        }
+    }
+
+    NNCASE_TARGET_AVX512 static reg clamp(reg v, reg lo, reg hi) noexcept { return _mm512_max_epi64(lo, _mm512_min_epi64(hi, v)); }
+
+    BINARY_ROW(NNCASE_TARGET_AVX512)
+};
+#endif
+
+#undef BINARY_ROW
+
+template <class T>
+using binary_row_t = void (*)(const T *a, const T *b, T *output, size_t count, const activation<T> &act) noexcept;
+
+template <class V, binary_op_t Op>
+binary_row_t<typename V::value_type> select_row_kind(const binary_layout &layout) noexcept
+{
+    if (layout.a_scalar)
+        return &V::template row<Op, true, false>;
+    if (layout.b_scalar)
+        return &V::template row<Op, false, true>;
+    return &V::template row<Op, false, false>;
+}
+
+template <class V>
+binary_row_t<typename V::value_type> select_row_op(binary_op_t op, const binary_layout &layout) noexcept
+{
+#define SELECT_ROW(op) \
+    case op:           \
+        return select_row_kind<V, op>(layout)
+
+    switch (op)
+    {
+        SELECT_ROW(binary_add);
+        SELECT_ROW(binary_sub);
+        SELECT_ROW(binary_mul);
+        SELECT_ROW(binary_div);
+        SELECT_ROW(binary_min);
+        SELECT_ROW(binary_max);
+    default:
+        return nullptr;
+    }
+
+#undef SELECT_ROW
+}
+
+#if NNCASE_X86_SIMD
+template <class T>
+using avx2_isa = std::conditional_t<std::is_same_v<T, float>, avx2_f32, std::conditional_t<std::is_same_v<T, int32_t>, avx2_i32, avx2_i64>>;
+
+template <class T>
+using avx512_isa = std::conditional_t<std::is_same_v<T, float>, avx512_f32, std::conditional_t<std::is_same_v<T, int32_t>, avx512_i32, avx512_i64>>;
+#endif
+
+template <class T>
+binary_row_t<T> select_row(binary_op_t op, const binary_layout &layout) noexcept
+{
+#if NNCASE_X86_SIMD
+    const auto &features = cpu_features();
+    if (features.avx512)
+        return select_row_op<avx512_isa<T>>(op, layout);
+    if (features.avx2)
+        return select_row_op<avx2_isa<T>>(op, layout);
+#endif
+    return select_row_op<generic_isa<T>>(op, layout);
+}
+
+// Rows are cut into blocks, so that a few long rows still spread over all threads.
+constexpr size_t row_block = 16384;
+
+template <class T>
+void binary_blocks(const binary_layout &layout, binary_row_t<T> row_kernel, const T *input_a, const T *input_b, T *output,
+    size_t begin, size_t end, const activation<T> &act) noexcept
+{
+    const auto dims = layout.outer_shape.size();
+    const auto blocks = (layout.inner + row_block - 1) / row_block;
+    auto row = begin / blocks;
+    auto block = begin % blocks;
+
+    runtime_shape_t index(dims);
+    size_t a_offset = 0, b_offset = 0;
+    for (size_t d = 0, rest = row; d < dims; d++)
+    {
+        index[d] = rest % layout.outer_shape[d];
+        rest /= layout.outer_shape[d];
+        a_offset += index[d] * layout.a_strides[d];
+        b_offset += index[d] * layout.b_strides[d];
+    }
+
+    for (size_t task = begin; task < end; task++)
+    {
+        const auto first = block * row_block;
+        const auto count = std::min(row_block, layout.inner - first);
+        row_kernel(input_a + a_offset + (layout.a_scalar ? 0 : first), input_b + b_offset + (layout.b_scalar ? 0 : first),
+            output + row * layout.inner + first, count, act);
+
+        if (++block < blocks)
+            continue;
+
+        block = 0;
+        row++;
+        for (size_t d = 0; d < dims; d++)
+        {
+            a_offset += layout.a_strides[d];
+            b_offset += layout.b_strides[d];
+            if (++index[d] < layout.outer_shape[d])
+                break;
+
+            a_offset -= layout.a_strides[d] * index[d];
+            b_offset -= layout.b_strides[d] * index[d];
+            index[d] = 0;
+        }
+    }
+}
+}
+
 template result<void> optimized::binary<float>(binary_op_t op, const float *input_a, const float *input_b, float *output,
     const runtime_shape_t &in_a_shape, const runtime_shape_t &in_a_strides, const runtime_shape_t &in_b_shape,
     const runtime_shape_t &in_b_strides, const runtime_shape_t &out_shape, const runtime_shape_t &out_strides,
@@ -44,6 +554,20 @@ result<void> optimized::binary(binary_op_t op, const T *input_a, const T *input_
     const runtime_shape_t &in_b_strides, const runtime_shape_t &out_shape, const runtime_shape_t &out_strides,
     value_range<float> fused_activation, kernel_context &context) noexcept
 {
-    return cpu::reference::binary(op, input_a, input_b, output, in_a_shape, in_a_strides, in_b_shape, in_b_strides, out_shape, out_strides,
-        fused_activation, context);
+    binary_layout layout;
+    if (!is_optimized_binary_op(op) || !is_contiguous(in_a_shape, in_a_strides) || !is_contiguous(in_b_shape, in_b_strides)
+        || !is_contiguous(out_shape, out_strides) || !make_layout(in_a_shape, in_b_shape, out_shape, layout))
+        return cpu::reference::binary(op, input_a, input_b, output, in_a_shape, in_a_strides, in_b_shape, in_b_strides, out_shape, out_strides,
+            fused_activation, context);
+
+    if (compute_size(out_shape) == 0)
+        return ok();
+
+    const activation<T> act(fused_activation);
+    const auto row_kernel = select_row<T>(op, layout);
+    const auto tasks = compute_size(layout.outer_shape) * ((layout.inner + row_block - 1) / row_block);
+    parallel_for(context, tasks, kernels::detail::parallel_grain(std::min(layout.inner, row_block)), [&](size_t begin, size_t end) {
+        binary_blocks(layout, row_kernel, input_a, input_b, output, begin, end, act);
+    });
+    return ok();
 }
@@ -12,11 +12,15 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  */
-#include <iostream>
+#include "utils.h"
+#include <array>
+#include <cstdint>
 #include <nncase/kernels/cpu/optimized/tensor_compute.h>
 #include <nncase/kernels/cpu/reference/tensor_compute.h>
 #include <nncase/kernels/kernel_utils.h>
 #include <nncase/runtime/runtime_op_utility.h>
+#include <utility>
+#include <vector>
 
 using namespace nncase;
 using namespace nncase::runtime;
@@ -24,16 +28,432 @@ using namespace nncase::kernels;
 using namespace nncase::kernels::cpu;
 using namespace nncase::kernels::cpu::optimized;
 
+namespace
+{
+// C[M, N] = clamp(A[M, K] * B[K, N] + bias[N]), all row-major.
+struct gemm_args
+{
+    size_t M;
+    size_t N;
+    size_t K;
+    const float *a;
+    const float *b;
+    const float *bias;
+    float *c;
+    value_range<float> act;
+};
+
+// Micro-kernel contract:
+//   a    : packed A panel, MR floats per k (rows beyond R are padding)
+//   b    : packed B panel, NR floats per k
+//   c    : R x NR tile with row stride ldc
+//   bias : non-null on the first K block, accumulators start from it instead of c
+//   last : apply the fused clamp before storing
+using micro_kernel_t = void (*)(size_t kc, const float *a, const float *b, float *c, size_t ldc,
+    const float *bias, bool last, value_range<float> act);
+
+struct generic_kernel
+{
+    static constexpr size_t MR = 4;
+    static constexpr size_t NR = 8;
+    static constexpr size_t KC = 256;
+    static constexpr size_t MC = 96;
+    static constexpr size_t NC = 1024;
+
+    template <size_t R>
+    static void run(size_t kc, const float *a, const float *b, float *c, size_t ldc, const float *bias, bool last, value_range<float> act)
+    {
+        float acc[R][NR];
+        for (size_t r = 0; r < R; r++)
+            for (size_t n = 0; n < NR; n++)
+                acc[r][n] = bias ? bias[n] : c[r * ldc + n];
+
+        for (size_t k = 0; k < kc; k++)
+        {
+            for (size_t r = 0; r < R; r++)
+            {
+                const auto av = a[r];
+                for (size_t n = 0; n < NR; n++)
+                    acc[r][n] += av * b[n];
+            }
+
+            a += MR;
+            b += NR;
+        }
+
+        for (size_t r = 0; r < R; r++)
+            for (size_t n = 0; n < NR; n++)
+                c[r * ldc + n] = last ? kernels::detail::apply_activation(acc[r][n], act) : acc[r][n];
+    }
+};
+
+#if NNCASE_X86_SIMD
+struct avx2_kernel
+{
+    static constexpr size_t MR = 6;
+    static constexpr size_t NR = 16;
+    static constexpr size_t KC = 256;
+    static constexpr size_t MC = 96;
+    static constexpr size_t NC = 2048;
+
+    template <size_t R>
+    NNCASE_TARGET_AVX2 static void run(size_t kc, const float *a, const float *b, float *c, size_t ldc, const float *bias, bool last, value_range<float> act)
+    {
+        __m256 acc0[R], acc1[R];
+        if (bias)
+        {
+            const auto b0 = _mm256_loadu_ps(bias);
+            const auto b1 = _mm256_loadu_ps(bias + 8);
+            NNCASE_UNROLL
+            for (size_t r = 0; r < R; r++)
+            {
+                acc0[r] = b0;
+                acc1[r] = b1;
+            }
+        }
+        else
+        {
+            NNCASE_UNROLL
+            for (size_t r = 0; r < R; r++)
+            {
+                acc0[r] = _mm256_loadu_ps(c + r * ldc);
+                acc1[r] = _mm256_loadu_ps(c + r * ldc + 8);
+            }
+        }
+
+        for (size_t k = 0; k < kc; k++)
+        {
+            const auto b0 = _mm256_loadu_ps(b);
+            const auto b1 = _mm256_loadu_ps(b + 8);
+            NNCASE_UNROLL
+            for (size_t r = 0; r < R; r++)
+            {
+                const auto av = _mm256_broadcast_ss(a + r);
+                acc0[r] = _mm256_fmadd_ps(av, b0, acc0[r]);
+                acc1[r] = _mm256_fmadd_ps(av, b1, acc1[r]);
+            }
+
+            a += MR;
+            b += NR;
+        }
+
+        if (last)
+        {
+            const auto lo = _mm256_set1_ps(act.min);
+            const auto hi = _mm256_set1_ps(act.max);
+            NNCASE_UNROLL
+            for (size_t r = 0; r < R; r++)
+            {
+                acc0[r] = _mm256_max_ps(_mm256_min_ps(acc0[r], hi), lo);
+                acc1[r] = _mm256_max_ps(_mm256_min_ps(acc1[r], hi), lo);
+            }
+        }
+
+        NNCASE_UNROLL
+        for (size_t r = 0; r < R; r++)
+        {
+            _mm256_storeu_ps(c + r * ldc, acc0[r]);
+            _mm256_storeu_ps(c + r * ldc + 8, acc1[r]);
+        }
+    }
+};
+
+struct avx512_kernel
+{
+    static constexpr size_t MR = 12;
+    static constexpr size_t NR = 32;
+    static constexpr size_t KC = 192;
+    static constexpr size_t MC = 96;
+    static constexpr size_t NC = 2048;
+
+    template <size_t R>
+    NNCASE_TARGET_AVX512 static void run(size_t kc, const float *a, const float *b, float *c, size_t ldc, const float *bias, bool last, value_range<float> act)
+    {
+        __m512 acc0[R], acc1[R];
+        if (bias)
+        {
+            const auto b0 = _mm512_loadu_ps(bias);
+            const auto b1 = _mm512_loadu_ps(bias + 16);
+            NNCASE_UNROLL
+            for (size_t r = 0; r < R; r++)
+            {
+                acc0[r] = b0;
+                acc1[r] = b1;
+            }
+        }
+        else
+        {
+            NNCASE_UNROLL
+            for (size_t r = 0; r < R; r++)
+            {
+                acc0[r] = _mm512_loadu_ps(c + r * ldc);
+                acc1[r] = _mm512_loadu_ps(c + r * ldc + 16);
+            }
+        }
+
+        for (size_t k = 0; k < kc; k++)
+        {
+            const auto b0 = _mm512_loadu_ps(b);
+            const auto b1 = _mm512_loadu_ps(b + 16);
+            NNCASE_UNROLL
+            for (size_t r = 0; r < R; r++)
+            {
+                const auto av = _mm512_set1_ps(a[r]);
+                acc0[r] = _mm512_fmadd_ps(av, b0, acc0[r]);
+                acc1[r] = _mm512_fmadd_ps(av, b1, acc1[r]);
+            }
+
+            a += MR;
+            b += NR;
+        }
+
+        if (last)
+        {
+            const auto lo = _mm512_set1_ps(act.min);
+            const auto hi = _mm512_set1_ps(act.max);
+            NNCASE_UNROLL
+            for (size_t r = 0; r < R; r++)
+            {
+                acc0[r] = _mm512_max_ps(_mm512_min_ps(acc0[r], hi), lo);
+                acc1[r] = _mm512_max_ps(_mm512_min_ps(acc1[r], hi), lo);
+            }
+        }
+
+        NNCASE_UNROLL
+        for (size_t r = 0; r < R; r++)
+        {
+            _mm512_storeu_ps(c + r * ldc, acc0[r]);
+            _mm512_storeu_ps(c + r * ldc + 16, acc1[r]);
+        }
+    }
+};
+#endif
+
+template <class Kernel, size_t... R>
+constexpr std::array<micro_kernel_t, sizeof...(R)> make_micro_kernels(std::index_sequence<R...>) noexcept
+{
+    return { &Kernel::template run<R + 1>... };
+}
+
+// Packs A[mc, kc] (row stride lda) into MR-row panels laid out k-major, padding short panels with zeros.
+template <size_t MR>
+void pack_a(const float *a, size_t lda, size_t mc, size_t kc, float *packed) noexcept
+{
+    for (size_t i = 0; i < mc; i += MR)
+    {
+        const auto mr = std::min(MR, mc - i);
+        for (size_t r = 0; r < mr; r++)
+        {
+            const float *src = a + (i + r) * lda;
+            for (size_t k = 0; k < kc; k++)
+                packed[k * MR + r] = src[k];
+        }
+
+        for (size_t r = mr; r < MR; r++)
+            for (size_t k = 0; k < kc; k++)
+                packed[k * MR + r] = 0.f;
+        packed += MR * kc;
+    }
+}
+
+// Packs B[kc, nc] (row stride ldb) into NR-column panels laid out k-major, padding short panels with zeros.
+template <size_t NR>
+void pack_b(const float *b, size_t ldb, size_t kc, size_t nc, float *packed) noexcept
+{
+    for (size_t j = 0; j < nc; j += NR)
+    {
+        const auto nr = std::min(NR, nc - j);
+        for (size_t k = 0; k < kc; k++)
+        {
+            const float *src = b + k * ldb + j;
+            std::copy(src, src + nr, packed);
+            std::fill(packed + nr, packed + NR, 0.f);
+            packed += NR;
+        }
+    }
+}
+
+template <class Kernel>
+result<void> gemm(const gemm_args &args, kernel_context &context) noexcept
+{
+    constexpr auto MR = Kernel::MR;
+    constexpr auto NR = Kernel::NR;
+    constexpr auto KC = Kernel::KC;
+    constexpr auto MC = Kernel::MC;
+    constexpr auto NC = Kernel::NC;
+    static_assert(MC % MR == 0, "MC must be a multiple of MR");
+    static_assert(NC % NR == 0, "NC must be a multiple of NR");
+    static constexpr auto micro_kernels = make_micro_kernels<Kernel>(std::make_index_sequence<MR>());
+
+    const auto M = args.M, N = args.N, K = args.K;
+    if (M == 0 || N == 0)
+        return ok();
+
+    const auto lda = K, ldb = N, ldc = N;
+    const auto kc_max = std::min(K, KC);
+    const auto mc_max = std::min((M + MR - 1) / MR * MR, MC);
+    const auto nc_max = std::min((N + NR - 1) / NR * NR, NC);
+    std::vector<float> b_packed;
+    try
+    {
+        b_packed.resize(kc_max * nc_max);
+    }
+    catch (...)
+    {
+        return err(std::errc::not_enough_memory);
+    }
+
+    // Each task owns one MC row block and a group of NR column panels, so tasks write disjoint
+    // tiles of C. Panels are grouped just finely enough to give every thread a couple of tasks.
+    const auto m_blocks = (M + MC - 1) / MC;
+    const auto threads = std::max(size_t(1), (size_t)context.num_threads);
+    const auto groups_wanted = threads == 1 ? 1 : (2 * threads + m_blocks - 1) / m_blocks;
+
+    for (size_t jc = 0; jc < N; jc += NC)
+    {
+        const auto nc = std::min(NC, N - jc);
+        const auto n_panels = (nc + NR - 1) / NR;
+        const auto groups = std::min(groups_wanted, n_panels);
+        for (size_t pc = 0; pc < K; pc += KC)
+        {
+            const auto kc = std::min(KC, K - pc);
+            const bool first = pc == 0;
+            const bool last = pc + kc == K;
+            pack_b<NR>(args.b + pc * ldb + jc, ldb, kc, nc, b_packed.data());
+
+            try_(try_parallel_for(context, m_blocks * groups, 1, [&](size_t task_begin, size_t task_end) -> result<void> {
+                thread_local std::vector<float> a_packed;
+                try
+                {
+                    a_packed.resize(std::max(a_packed.size(), mc_max * kc_max));
+                }
+                catch (...)
+                {
+                    return err(std::errc::not_enough_memory);
+                }
+
+                float edge_c[MR * NR];
+                float edge_bias[NR];
+                size_t packed_block = SIZE_MAX;
+
+                for (size_t task = task_begin; task < task_end; task++)
+                {
+                    const auto block = task / groups, group = task % groups;
+                    const auto ic = block * MC;
+                    const auto mc = std::min(MC, M - ic);
+                    if (block != packed_block)
+                    {
+                        pack_a<MR>(args.a + ic * lda + pc, lda, mc, kc, a_packed.data());
+                        packed_block = block;
+                    }
+
+                    const auto jr_begin = n_panels * group / groups * NR;
+                    const auto jr_end = std::min(nc, n_panels * (group + 1) / groups * NR);
+                    for (size_t jr = jr_begin; jr < jr_end; jr += NR)
+                    {
+                        const auto nr = std::min(NR, nc - jr);
+                        const float *bp = b_packed.data() + jr * kc;
+                        const float *bias = first ? args.bias + jc + jr : nullptr;
+                        if (bias && nr != NR)
+                        {
+                            std::copy(bias, bias + nr, edge_bias);
+                            std::fill(edge_bias + nr, edge_bias + NR, 0.f);
+                            bias = edge_bias;
+                        }
+
+                        for (size_t ir = 0; ir < mc; ir += MR)
+                        {
+                            const auto mr = std::min(MR, mc - ir);
+                            const float *ap = a_packed.data() + ir * kc;
+                            float *c = args.c + (ic + ir) * ldc + jc + jr;
+                            const auto kernel = micro_kernels[mr - 1];
+                            if (nr == NR)
+                            {
+                                kernel(kc, ap, bp, c, ldc, bias, last, args.act);
+                            }
+                            else
+                            {
+                                // Right edge: run the full-width kernel on a scratch tile.
+                                if (!first)
+                                {
+                                    for (size_t r = 0; r < mr; r++)
+                                        std::copy(c + r * ldc, c + r * ldc + nr, edge_c + r * NR);
+                                }
+
+                                kernel(kc, ap, bp, edge_c, NR, bias, last, args.act);
+                                for (size_t r = 0; r < mr; r++)
+                                    std::copy(edge_c + r * NR, edge_c + r * NR + nr, c + r * ldc);
+                            }
+                        }
+                    }
+                }
+
+                return ok();
+            }));
+        }
+    }
+
+    return ok();
+}
+
+result<void> gemm(const gemm_args &args, kernel_context &context) noexcept
+{
+    if (args.K == 0)
+    {
+        for (size_t m = 0; m < args.M; m++)
+            for (size_t n = 0; n < args.N; n++)
+                args.c[m * args.N + n] = kernels::detail::apply_activation(args.bias[n], args.act);
+        return ok();
+    }
+
+#if NNCASE_X86_SIMD
+    const auto &features = cpu_features();
+    if (features.avx512)
+        return gemm<avx512_kernel>(args, context);
+    if (features.avx2)
+        return gemm<avx2_kernel>(args, context);
+#endif
+    return gemm<generic_kernel>(args, context);
+}
+}
+
 template result<void> optimized::matmul<float>(const float *input_a, const float *input_b, const float *bias, float *output,
     const runtime_shape_t &in_a_shape, const runtime_shape_t &in_a_strides, const runtime_shape_t &in_b_shape,
     const runtime_shape_t &in_b_strides, const runtime_shape_t &out_shape, const runtime_shape_t &out_strides,
-    value_range<float> fused_activation) noexcept;
+    value_range<float> fused_activation, kernel_context &context) noexcept;
 
 template <typename T>
 result<void> optimized::matmul(const T *input_a, const T *input_b, const T *bias, T *output, const runtime_shape_t &in_a_shape,
     const runtime_shape_t &in_a_strides, const runtime_shape_t &in_b_shape, const runtime_shape_t &in_b_strides,
-    const runtime_shape_t &out_shape, const runtime_shape_t &out_strides, value_range<float> fused_activation) noexcept
+    const runtime_shape_t &out_shape, const runtime_shape_t &out_strides, value_range<float> fused_activation, kernel_context &context) noexcept
 {
-    return cpu::reference::matmul(input_a, input_b, bias, output, in_a_shape, in_a_strides, in_b_shape, in_b_strides, out_shape, out_strides,
-        fused_activation);
-}
\ No newline at end of file
+    const auto M = in_a_shape[in_a_shape.size() - 2];
+    const auto K = in_a_shape.back();
+    const auto N = in_b_shape.back();
+
+    // batch
+    size_t batch_a = 1;
+    for (size_t i = 0; i < in_a_shape.size() - 2; i++)
+        batch_a *= in_a_shape[i];
+    const auto step_a = batch_a == 1 ? 0 : in_a_strides[in_a_shape.size() - 3];
+
+    size_t batch_b = 1;
+    for (size_t i = 0; i < in_b_shape.size() - 2; i++)
+        batch_b *= in_b_shape[i];
+    const auto step_b = batch_b == 1 ? 0 : in_b_strides[in_b_shape.size() - 3];
+
+    size_t batch_out = 1;
+    for (size_t i = 0; i < out_shape.size() - 2; i++)
+        batch_out *= out_shape[i];
+    const auto step_out = batch_out == 1 ? 0 : out_strides[out_shape.size() - 3];
+
+    const auto batch_max = std::max(batch_a, batch_b);
+
+    // B is shared by every batch of A: stack the batches into one taller GEMM so B is packed once.
+    if (batch_b == 1 && batch_a > 1 && step_a == M * K && step_out == M * N)
+        return gemm({ M * batch_a, N, K, input_a, input_b, bias, output, fused_activation }, context);
+
+    for (size_t b = 0; b < batch_max; b++)
+        try_(gemm({ M, N, K, input_a + b * step_a, input_b + b * step_b, bias, output + b * step_out, fused_activation }, context));
+    return ok();
+}
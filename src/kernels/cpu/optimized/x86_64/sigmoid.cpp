@@ -12,7 +12,7 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  */
-#include <iostream>
+#include "vector_math.h"
 #include <nncase/kernels/cpu/optimized/tensor_compute.h>
 #include <nncase/kernels/cpu/reference/tensor_compute.h>
 #include <nncase/kernels/kernel_utils.h>
@@ -24,6 +24,34 @@ using namespace nncase::kernels;
 using namespace nncase::kernels::cpu;
 using namespace nncase::kernels::cpu::optimized;
 
+namespace
+{
+#if NNCASE_X86_SIMD
+#define SIGMOID_ROW(target)                                                                          \
+    target static void row(const float *input, float *output, size_t count) noexcept                 \
+    {                                                                                                \
+        size_t i = 0;                                                                                \
+        for (; i + lanes <= count; i += lanes)                                                       \
+            store(output + i, sigmoid(load(input + i)));                                             \
+                                                                                                     \
+        if (i < count)                                                                               \
+            store_partial(output + i, sigmoid(load_partial(input + i, count - i)), count - i);       \
+    }
+
+struct avx2_sigmoid : avx2_math
+{
+    SIGMOID_ROW(NNCASE_TARGET_AVX2)
+};
+
+struct avx512_sigmoid : avx512_math
+{
+    SIGMOID_ROW(NNCASE_TARGET_AVX512)
+};
+
+#undef SIGMOID_ROW
+#endif
+}
+
 template result<void> optimized::sigmoid<float>(const float *input, float *output, const runtime_shape_t &in_shape,
     const runtime_shape_t &in_strides, const runtime_shape_t &out_strides) noexcept;
 
@@ -31,5 +59,25 @@ template <typename T>
 result<void> optimized::sigmoid(const T *input, T *output, const runtime_shape_t &in_shape, const runtime_shape_t &in_strides,
     const runtime_shape_t &out_strides) noexcept
 {
+#if NNCASE_X86_SIMD
+    if constexpr (std::is_same_v<T, float>)
+    {
+        if (is_contiguous(in_shape, in_strides) && is_contiguous(in_shape, out_strides))
+        {
+            const auto &features = cpu_features();
+            if (features.avx512)
+            {
+                avx512_sigmoid::row(input, output, compute_size(in_shape));
+                return ok();
+            }
+            if (features.avx2)
+            {
+                avx2_sigmoid::row(input, output, compute_size(in_shape));
+                return ok();
+            }
+        }
+    }
+#endif
+
     return cpu::reference::sigmoid(input, output, in_shape, in_strides, out_strides);
-}
\ No newline at end of file
+}
@@ -12,7 +12,8 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  */
-#include <iostream>
+#include "vector_math.h"
+#include <limits>
 #include <nncase/kernels/cpu/optimized/tensor_compute.h>
 #include <nncase/kernels/cpu/reference/tensor_compute.h>
 #include <nncase/kernels/kernel_utils.h>
@@ -24,6 +25,115 @@ using namespace nncase::kernels;
 using namespace nncase::kernels::cpu;
 using namespace nncase::kernels::cpu::optimized;
 
+namespace
+{
+#if NNCASE_X86_SIMD
+// Each softmax reads its axis three times: for the max, for exp(x - max) and its sum,
+// which go to the output, and to divide the output by the sum.
+#define SOFTMAX_ROWS(target)                                                                                \
+    /* A contiguous axis, reduced across lanes */                                                           \
+    target static void contiguous(const float *input, float *output, size_t axis, float beta) noexcept      \
+    {                                                                                                       \
+        const auto tail = axis % lanes;                                                                     \
+        const auto body = axis - tail;                                                                      \
+        auto max_value = set1(std::numeric_limits<float>::lowest());                                        \
+        for (size_t i = 0; i < body; i += lanes)                                                            \
+            max_value = max(max_value, load(input + i));                                                    \
+        auto max_scalar = reduce_max(max_value);                                                            \
+        for (size_t i = body; i < axis; i++)                                                                \
+            max_scalar = std::max(max_scalar, input[i]);                                                    \
+                                                                                                            \
+        max_value = set1(max_scalar);                                                                       \
+        const auto beta_value = set1(beta);                                                                 \
+        auto sum = set1(0.f);                                                                               \
+        for (size_t i = 0; i < body; i += lanes)                                                            \
+        {                                                                                                   \
+            const auto e = exp(mul(sub(load(input + i), max_value), beta_value));                           \
+            store(output + i, e);                                                                           \
+            sum = add(sum, e);                                                                              \
+        }                                                                                                   \
+                                                                                                            \
+        if (tail)                                                                                           \
+        {                                                                                                   \
+            /* Lanes past the tail hold exp(-max * beta), the sum reloads the stored ones */               \
+            const auto e = exp(mul(sub(load_partial(input + body, tail), max_value), beta_value));          \
+            store_partial(output + body, e, tail);                                                          \
+            sum = add(sum, load_partial(output + body, tail));                                              \
+        }                                                                                                   \
+                                                                                                            \
+        sum = set1(reduce_add(sum));                                                                        \
+        for (size_t i = 0; i < body; i += lanes)                                                            \
+            store(output + i, div(load(output + i), sum));                                                  \
+        if (tail)                                                                                           \
+            store_partial(output + body, div(load_partial(output + body, tail), sum), tail);                \
+    }                                                                                                       \
+                                                                                                            \
+    /* An axis `inner` elements apart, reduced for up to `lanes` consecutive positions at once */          \
+    target static void strided(const float *input, float *output, size_t axis, size_t inner, float beta) noexcept \
+    {                                                                                                       \
+        const auto beta_value = set1(beta);                                                                 \
+        for (size_t j = 0; j < inner; j += lanes)                                                           \
+        {                                                                                                   \
+            const auto count = std::min(lanes, inner - j);                                                  \
+            const auto full = count == lanes;                                                               \
+            auto max_value = set1(std::numeric_limits<float>::lowest());                                    \
+            for (size_t i = 0; i < axis; i++)                                                               \
+            {                                                                                               \
+                const auto p = input + i * inner + j;                                                       \
+                max_value = max(max_value, full ? load(p) : load_partial(p, count));                        \
+            }                                                                                               \
+                                                                                                            \
+            auto sum = set1(0.f);                                                                           \
+            for (size_t i = 0; i < axis; i++)                                                               \
+            {                                                                                               \
+                const auto p = input + i * inner + j;                                                       \
+                const auto e = exp(mul(sub(full ? load(p) : load_partial(p, count), max_value), beta_value)); \
+                full ? store(output + i * inner + j, e) : store_partial(output + i * inner + j, e, count);  \
+                sum = add(sum, e);                                                                          \
+            }                                                                                               \
+                                                                                                            \
+            for (size_t i = 0; i < axis; i++)                                                               \
+            {                                                                                               \
+                const auto p = output + i * inner + j;                                                      \
+                const auto value = div(full ? load(p) : load_partial(p, count), sum);                       \
+                full ? store(p, value) : store_partial(p, value, count);                                    \
+            }                                                                                               \
+        }                                                                                                   \
+    }
+
+struct avx2_softmax : avx2_math
+{
+    SOFTMAX_ROWS(NNCASE_TARGET_AVX2)
+};
+
+struct avx512_softmax : avx512_math
+{
+    SOFTMAX_ROWS(NNCASE_TARGET_AVX512)
+};
+
+#undef SOFTMAX_ROWS
+
+template <class V>
+void softmax_impl(const float *input, float *output, const runtime_shape_t &in_shape, size_t axis, float beta) noexcept
+{
+    size_t outer = 1, inner = 1;
+    for (size_t i = 0; i < axis; i++)
+        outer *= in_shape[i];
+    for (size_t i = axis + 1; i < in_shape.size(); i++)
+        inner *= in_shape[i];
+
+    const auto size = in_shape[axis] * inner;
+    for (size_t o = 0; o < outer; o++)
+    {
+        if (inner == 1)
+            V::contiguous(input + o * size, output + o * size, in_shape[axis], beta);
+        else
+            V::strided(input + o * size, output + o * size, in_shape[axis], inner, beta);
+    }
+}
+#endif
+}
+
 template result<void> optimized::softmax<float>(const float *input, float *output, const runtime_shape_t &in_shape, const runtime_shape_t &in_strides,
     const runtime_shape_t &out_strides, int32_t axis, float beta) noexcept;
 
@@ -31,5 +141,26 @@ template <typename T>
 result<void> optimized::softmax(const T *input, T *output, const runtime_shape_t &in_shape, const runtime_shape_t &in_strides,
     const runtime_shape_t &out_strides, int32_t axis, float beta) noexcept
 {
+#if NNCASE_X86_SIMD
+    if constexpr (std::is_same_v<T, float>)
+    {
+        if (is_contiguous(in_shape, in_strides) && is_contiguous(in_shape, out_strides))
+        {
+            const size_t positive_axis = axis < 0 ? in_shape.size() + axis : axis;
+            const auto &features = cpu_features();
+            if (features.avx512)
+            {
+                softmax_impl<avx512_softmax>(input, output, in_shape, positive_axis, beta);
+                return ok();
+            }
+            if (features.avx2)
+            {
+                softmax_impl<avx2_softmax>(input, output, in_shape, positive_axis, beta);
+                return ok();
+            }
+        }
+    }
+#endif
+
     return cpu::reference::softmax(input, output, in_shape, in_strides, out_strides, axis, beta);
-}
\ No newline at end of file
+}
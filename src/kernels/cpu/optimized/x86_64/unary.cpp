@@ -12,6 +12,7 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  */
+#include "vector_math.h"
 #include <nncase/kernels/cpu/optimized/tensor_compute.h>
 #include <nncase/kernels/cpu/reference/tensor_compute.h>
 #include <nncase/kernels/kernel_utils.h>
@@ -23,8 +24,136 @@ using namespace nncase::kernels;
 using namespace nncase::kernels::cpu;
 using namespace nncase::kernels::cpu::optimized;
 
+namespace
+{
+using unary_row_t = void (*)(const float *input, float *output, size_t count) noexcept;
+
+#if NNCASE_X86_SIMD
+// Stamped into each ISA, so the row loop is compiled for its target.
+#define UNARY_ROW(target)                                                                                    \
+    template <unary_op_t Op>                                                                                 \
+    target static reg apply(reg x) noexcept                                                                  \
+    {                                                                                                        \
+        if constexpr (Op == unary_abs)                                                                       \
+            return abs(x);                                                                                   \
+        else if constexpr (Op == unary_ceil)                                                                 \
+            return ceil(x);                                                                                  \
+        else if constexpr (Op == unary_cos)                                                                  \
+            return cos(x);                                                                                   \
+        else if constexpr (Op == unary_erf)                                                                  \
+            return erf(x);                                                                                   \
+        else if constexpr (Op == unary_exp)                                                                  \
+            return exp(x);                                                                                   \
+        else if constexpr (Op == unary_floor)                                                                \
+            return floor(x);                                                                                 \
+        else if constexpr (Op == unary_log)                                                                  \
+            return log(x);                                                                                   \
+        else if constexpr (Op == unary_neg)                                                                  \
+            return neg(x);                                                                                   \
+        else if constexpr (Op == unary_round)                                                                \
+            return round(x);                                                                                 \
+        else if constexpr (Op == unary_rsqrt)                                                                \
+            return rsqrt(x);                                                                                 \
+        else if constexpr (Op == unary_sign)                                                                 \
+            return select(gt(x, set1(0.f)), set1(1.f), select(lt(x, set1(0.f)), set1(-1.f), set1(0.f)));    \
+        else if constexpr (Op == unary_sin)                                                                  \
+            return sin(x);                                                                                   \
+        else if constexpr (Op == unary_sqrt)                                                                 \
+            return sqrt(x);                                                                                  \
+        else if constexpr (Op == unary_square)                                                               \
+            return mul(x, x);                                                                                \
+        else                                                                                                 \
+            return tanh(x);                                                                                  \
+    }                                                                                                        \
+                                                                                                             \
+    template <unary_op_t Op>                                                                                 \
+    target static void row(const float *input, float *output, size_t count) noexcept                         \
+    {                                                                                                        \
+        size_t i = 0;                                                                                        \
+        for (; i + lanes <= count; i += lanes)                                                               \
+            store(output + i, apply<Op>(load(input + i)));                                                   \
+                                                                                                             \
+        if (i < count)                                                                                       \
+            store_partial(output + i, apply<Op>(load_partial(input + i, count - i)), count - i);             \
+    }
+
+struct avx2_unary : avx2_math
+{
+    UNARY_ROW(NNCASE_TARGET_AVX2)
+};
+
+struct avx512_unary : avx512_math
+{
+    UNARY_ROW(NNCASE_TARGET_AVX512)
+};
+
+#undef UNARY_ROW
+
+template <class V>
+unary_row_t select_row(unary_op_t op) noexcept
+{
+#define SELECT_ROW(op) \
+    case op:           \
+        return &V::template row<op>
+
+    switch (op)
+    {
+        SELECT_ROW(unary_abs);
+        SELECT_ROW(unary_ceil);
+        SELECT_ROW(unary_cos);
+        SELECT_ROW(unary_erf);
+        SELECT_ROW(unary_exp);
+        SELECT_ROW(unary_floor);
+        SELECT_ROW(unary_log);
+        SELECT_ROW(unary_neg);
+        SELECT_ROW(unary_round);
+        SELECT_ROW(unary_rsqrt);
+        SELECT_ROW(unary_sign);
+        SELECT_ROW(unary_sin);
+        SELECT_ROW(unary_sqrt);
+        SELECT_ROW(unary_square);
+        SELECT_ROW(unary_tanh);
+    default:
+        return nullptr;
+    }
+
+#undef SELECT_ROW
+}
+#endif
+
+// Null when the op or the CPU has no vector kernel
+unary_row_t select_row(unary_op_t op) noexcept
+{
+#if NNCASE_X86_SIMD
+    const auto &features = cpu_features();
+    if (features.avx512)
+        return select_row<avx512_unary>(op);
+    if (features.avx2)
+        return select_row<avx2_unary>(op);
+#endif
+    (void)op;
+    return nullptr;
+}
+}
+
 result<void> optimized::unary(unary_op_t op, const float *input, float *output, const runtime_shape_t &shape,
     const runtime_shape_t &in_strides, const runtime_shape_t &out_strides, kernel_context &context) noexcept
 {
-    return cpu::reference::unary(op, input, output, shape, in_strides, out_strides, context);
+    if (!is_contiguous(shape, in_strides) || !is_contiguous(shape, out_strides))
+        return cpu::reference::unary(op, input, output, shape, in_strides, out_strides, context);
+
+    if (auto row = select_row(op))
+    {
+        parallel_for(context, compute_size(shape), kernels::detail::parallel_grain(1), [&](size_t begin, size_t end) {
+            row(input + begin, output + begin, end - begin);
+        });
+        return ok();
+    }
+
+    // Contiguous tensors split into flat element ranges.
+    return try_parallel_for(context, compute_size(shape), kernels::detail::parallel_grain(1), [&](size_t begin, size_t end) {
+        const runtime_shape_t chunk_shape { end - begin };
+        const runtime_shape_t chunk_strides { 1 };
+        return cpu::reference::unary(op, input + begin, output + begin, chunk_shape, chunk_strides, chunk_strides, context);
+    });
 }
@@ -0,0 +1,103 @@
+/* Copyright 2019-2021 Canaan Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+#include <nncase/kernels/cpu/optimized/runtime_types.h>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define NNCASE_X86_SIMD 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// Kernels are built without global -mavx flags, so every SIMD function is
+// compiled for its own ISA and chosen at runtime through cpu_features().
+#if defined(__GNUC__) || defined(__clang__)
+#define NNCASE_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#define NNCASE_TARGET_AVX512 __attribute__((target("avx512f,avx512dq,avx2,fma")))
+#else
+#define NNCASE_TARGET_AVX2
+#define NNCASE_TARGET_AVX512
+#endif
+
+// Micro-kernels keep their accumulators in registers only if the fixed-size
+// loops over them are fully unrolled.
+#if defined(__clang__)
+#define NNCASE_UNROLL _Pragma("unroll")
+#elif defined(__GNUC__)
+#define NNCASE_UNROLL _Pragma("GCC unroll 32")
+#else
+#define NNCASE_UNROLL
+#endif
+
+BEGIN_NS_NNCASE_KERNELS_CPU_OPT
+
+struct cpu_features_t
+{
+    bool avx2 = false;
+    bool avx512 = false;
+};
+
+#if NNCASE_X86_SIMD
+#ifdef _MSC_VER
+inline cpu_features_t detect_cpu_features() noexcept
+{
+    cpu_features_t features;
+    int info[4];
+    __cpuid(info, 0);
+    const int max_leaf = info[0];
+    if (max_leaf < 7)
+        return features;
+
+    __cpuid(info, 1);
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    const bool fma = (info[2] & (1 << 12)) != 0;
+    if (!osxsave)
+        return features;
+
+    const auto xcr0 = _xgetbv(0);
+    const bool os_avx = (xcr0 & 0x6) == 0x6;
+    const bool os_avx512 = (xcr0 & 0xe6) == 0xe6;
+
+    __cpuidex(info, 7, 0);
+    features.avx2 = os_avx && fma && (info[1] & (1 << 5)) != 0;
+    features.avx512 = features.avx2 && os_avx512 && (info[1] & (1 << 16)) != 0 && (info[1] & (1 << 17)) != 0;
+    return features;
+}
+#else
+inline cpu_features_t detect_cpu_features() noexcept
+{
+    cpu_features_t features;
+    __builtin_cpu_init();
+    features.avx2 = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    features.avx512 = features.avx2 && __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512dq");
+    return features;
+}
+#endif
+#else
+inline cpu_features_t detect_cpu_features() noexcept
+{
+    return {};
+}
+#endif
+
+inline const cpu_features_t &cpu_features() noexcept
+{
+    static const cpu_features_t features = detect_cpu_features();
+    return features;
+}
+
+END_NS_NNCASE_KERNELS_CPU_OPT
@@ -0,0 +1,212 @@
+/* Copyright 2019-2021 Canaan Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+#include "utils.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#if NNCASE_X86_SIMD
+BEGIN_NS_NNCASE_KERNELS_CPU_OPT
+
+// Vectorized float math. Each ISA struct supplies a few register primitives and
+// includes vector_math.inl, which builds the functions below on top of them:
+//
+//   function   max error     notes
+//   exp        1.3 ulp       inf from x = 0x1.62e43p+6 (88.7228394, just above ln(FLT_MAX)),
+//                            as rounding e^x gives, underflows through denormals
+//   log        0.9 ulp       log(0) = -inf, log(x < 0) = NaN
+//   tanh       1.4 ulp
+//   sigmoid    2.7 ulp       denormal results for large negative inputs
+//   erf        7.5 ulp       absolute error below 5e-7
+//   sin, cos   1.6 ulp       |x| > 8192 is computed by libm
+//   rsqrt      1.5 ulp       1 / sqrt(x), both steps rounded
+//
+// The bounds are the largest errors over every float input, against libm in double
+// precision. NaN inputs return NaN.
+// Kernels add their loops to a struct derived from these, so the loops are compiled
+// for the same target and the register functions inline into them.
+
+struct avx2_math
+{
+    using reg = __m256;
+    using ireg = __m256i;
+    using mask = __m256;
+    static constexpr size_t lanes = 8;
+
+    NNCASE_TARGET_AVX2 static reg load(const float *p) noexcept { return _mm256_loadu_ps(p); }
+    NNCASE_TARGET_AVX2 static void store(float *p, reg v) noexcept { _mm256_storeu_ps(p, v); }
+    NNCASE_TARGET_AVX2 static reg set1(float v) noexcept { return _mm256_set1_ps(v); }
+    // The first n <= lanes elements, the rest of the register is zero
+    NNCASE_TARGET_AVX2 static reg load_partial(const float *p, size_t n) noexcept { return _mm256_maskload_ps(p, first_lanes(n)); }
+    NNCASE_TARGET_AVX2 static void store_partial(float *p, reg v, size_t n) noexcept { _mm256_maskstore_ps(p, first_lanes(n), v); }
+    // p[0], p[2], ..., p[14], reading p[0..15]
+    NNCASE_TARGET_AVX2 static reg load_even(const float *p) noexcept
+    {
+        const auto even = _mm256_shuffle_ps(_mm256_loadu_ps(p), _mm256_loadu_ps(p + 8), 0x88);
+        return _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(even), 0xd8));
+    }
+    NNCASE_TARGET_AVX2 static __m256i first_lanes(size_t n) noexcept { return _mm256_cmpgt_epi32(_mm256_set1_epi32((int32_t)n), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7)); }
+    NNCASE_TARGET_AVX2 static ireg iset1(int32_t v) noexcept { return _mm256_set1_epi32(v); }
+
+    NNCASE_TARGET_AVX2 static reg add(reg a, reg b) noexcept { return _mm256_add_ps(a, b); }
+    NNCASE_TARGET_AVX2 static reg sub(reg a, reg b) noexcept { return _mm256_sub_ps(a, b); }
+    NNCASE_TARGET_AVX2 static reg mul(reg a, reg b) noexcept { return _mm256_mul_ps(a, b); }
+    NNCASE_TARGET_AVX2 static reg div(reg a, reg b) noexcept { return _mm256_div_ps(a, b); }
+    // a * b + c and c - a * b, rounded once
+    NNCASE_TARGET_AVX2 static reg fmadd(reg a, reg b, reg c) noexcept { return _mm256_fmadd_ps(a, b, c); }
+    NNCASE_TARGET_AVX2 static reg fnmadd(reg a, reg b, reg c) noexcept { return _mm256_fnmadd_ps(a, b, c); }
+    // Return b when either operand is NaN
+    NNCASE_TARGET_AVX2 static reg min(reg a, reg b) noexcept { return _mm256_min_ps(a, b); }
+    NNCASE_TARGET_AVX2 static reg max(reg a, reg b) noexcept { return _mm256_max_ps(a, b); }
+    NNCASE_TARGET_AVX2 static reg sqrt(reg a) noexcept { return _mm256_sqrt_ps(a); }
+    NNCASE_TARGET_AVX2 static reg round(reg a) noexcept { return _mm256_round_ps(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+    NNCASE_TARGET_AVX2 static reg floor(reg a) noexcept { return _mm256_round_ps(a, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC); }
+    NNCASE_TARGET_AVX2 static reg ceil(reg a) noexcept { return _mm256_round_ps(a, _MM_FROUND_TO_POS_INF | _MM_FROUND_NO_EXC); }
+
+    NNCASE_TARGET_AVX2 static reg bit_and(reg a, reg b) noexcept { return _mm256_and_ps(a, b); }
+    NNCASE_TARGET_AVX2 static reg bit_or(reg a, reg b) noexcept { return _mm256_or_ps(a, b); }
+    NNCASE_TARGET_AVX2 static reg bit_xor(reg a, reg b) noexcept { return _mm256_xor_ps(a, b); }
+
+    NNCASE_TARGET_AVX2 static ireg to_int(reg a) noexcept { return _mm256_cvtps_epi32(a); }
+    NNCASE_TARGET_AVX2 static reg to_float(ireg a) noexcept { return _mm256_cvtepi32_ps(a); }
+    NNCASE_TARGET_AVX2 static ireg as_int(reg a) noexcept { return _mm256_castps_si256(a); }
+    NNCASE_TARGET_AVX2 static reg as_float(ireg a) noexcept { return _mm256_castsi256_ps(a); }
+    NNCASE_TARGET_AVX2 static ireg iadd(ireg a, ireg b) noexcept { return _mm256_add_epi32(a, b); }
+    NNCASE_TARGET_AVX2 static ireg isub(ireg a, ireg b) noexcept { return _mm256_sub_epi32(a, b); }
+    NNCASE_TARGET_AVX2 static ireg iand(ireg a, ireg b) noexcept { return _mm256_and_si256(a, b); }
+    NNCASE_TARGET_AVX2 static ireg ior(ireg a, ireg b) noexcept { return _mm256_or_si256(a, b); }
+    template <int N>
+    NNCASE_TARGET_AVX2 static ireg shl(ireg a) noexcept { return _mm256_slli_epi32(a, N); }
+    template <int N>
+    NNCASE_TARGET_AVX2 static ireg sra(ireg a) noexcept { return _mm256_srai_epi32(a, N); }
+
+    NNCASE_TARGET_AVX2 static mask lt(reg a, reg b) noexcept { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+    NNCASE_TARGET_AVX2 static mask gt(reg a, reg b) noexcept { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+    NNCASE_TARGET_AVX2 static mask eq(reg a, reg b) noexcept { return _mm256_cmp_ps(a, b, _CMP_EQ_OQ); }
+    NNCASE_TARGET_AVX2 static mask is_nan(reg a) noexcept { return _mm256_cmp_ps(a, a, _CMP_UNORD_Q); }
+    NNCASE_TARGET_AVX2 static mask ieq(ireg a, ireg b) noexcept { return _mm256_castsi256_ps(_mm256_cmpeq_epi32(a, b)); }
+    NNCASE_TARGET_AVX2 static mask mask_or(mask a, mask b) noexcept { return _mm256_or_ps(a, b); }
+    NNCASE_TARGET_AVX2 static bool any(mask m) noexcept { return _mm256_movemask_ps(m) != 0; }
+    // m ? a : b
+    NNCASE_TARGET_AVX2 static reg select(mask m, reg a, reg b) noexcept { return _mm256_blendv_ps(b, a, m); }
+
+    NNCASE_TARGET_AVX2 static float reduce_max(reg a) noexcept
+    {
+        auto v = _mm_max_ps(_mm256_castps256_ps128(a), _mm256_extractf128_ps(a, 1));
+        v = _mm_max_ps(v, _mm_movehl_ps(v, v));
+        v = _mm_max_ss(v, _mm_movehdup_ps(v));
+        return _mm_cvtss_f32(v);
+    }
+
+    NNCASE_TARGET_AVX2 static float reduce_add(reg a) noexcept
+    {
+        auto v = _mm_add_ps(_mm256_castps256_ps128(a), _mm256_extractf128_ps(a, 1));
+        v = _mm_add_ps(v, _mm_movehl_ps(v, v));
+        v = _mm_add_ss(v, _mm_movehdup_ps(v));
+        return _mm_cvtss_f32(v);
+    }
+
+#define NNCASE_VECTOR_MATH_TARGET NNCASE_TARGET_AVX2
+#include "vector_math.inl"
+#undef NNCASE_VECTOR_MATH_TARGET
+};
+
+struct avx512_math
+{
+    using reg = __m512;
+    using ireg = __m512i;
+    using mask = __mmask16;
+    static constexpr size_t lanes = 16;
+
+    NNCASE_TARGET_AVX512 static reg load(const float *p) noexcept { return _mm512_loadu_ps(p); }
+    NNCASE_TARGET_AVX512 static void store(float *p, reg v) noexcept { _mm512_storeu_ps(p, v); }
+    NNCASE_TARGET_AVX512 static reg set1(float v) noexcept { return _mm512_set1_ps(v); }
+    NNCASE_TARGET_AVX512 static reg load_partial(const float *p, size_t n) noexcept { return _mm512_maskz_loadu_ps(first_lanes(n), p); }
+    NNCASE_TARGET_AVX512 static void store_partial(float *p, reg v, size_t n) noexcept { _mm512_mask_storeu_ps(p, first_lanes(n), v); }
+    // p[0], p[2], ..., p[30], reading p[0..31]
+    NNCASE_TARGET_AVX512 static reg load_even(const float *p) noexcept
+    {
+        const auto even = _mm512_setr_epi32(0, 2, 4, 6, 8, 10, 12, 14, 16, 18, 20, 22, 24, 26, 28, 30);
+        return _mm512_permutex2var_ps(_mm512_loadu_ps(p), even, _mm512_loadu_ps(p + 16));
+    }
+    NNCASE_TARGET_AVX512 static __mmask16 first_lanes(size_t n) noexcept { return (__mmask16)((1u << n) - 1); }
+    NNCASE_TARGET_AVX512 static ireg iset1(int32_t v) noexcept { return _mm512_set1_epi32(v); }
+
+    NNCASE_TARGET_AVX512 static reg add(reg a, reg b) noexcept { return _mm512_add_ps(a, b); }
+    NNCASE_TARGET_AVX512 static reg sub(reg a, reg b) noexcept { return _mm512_sub_ps(a, b); }
+    NNCASE_TARGET_AVX512 static reg mul(reg a, reg b) noexcept { return _mm512_mul_ps(a, b); }
+    NNCASE_TARGET_AVX512 static reg div(reg a, reg b) noexcept { return _mm512_div_ps(a, b); }
+    NNCASE_TARGET_AVX512 static reg fmadd(reg a, reg b, reg c) noexcept { return _mm512_fmadd_ps(a, b, c); }
+    NNCASE_TARGET_AVX512 static reg fnmadd(reg a, reg b, reg c) noexcept { return _mm512_fnmadd_ps(a, b, c); }
+    // The zero-masked forms avoid GCC 12's -Wuninitialized on _mm512_undefined_ps
+    NNCASE_TARGET_AVX512 static reg min(reg a, reg b) noexcept { return _mm512_maskz_min_ps(0xffff, a, b); }
+    NNCASE_TARGET_AVX512 static reg max(reg a, reg b) noexcept { return _mm512_maskz_max_ps(0xffff, a, b); }
+    NNCASE_TARGET_AVX512 static reg sqrt(reg a) noexcept { return _mm512_sqrt_ps(a); }
+    NNCASE_TARGET_AVX512 static reg round(reg a) noexcept { return _mm512_roundscale_ps(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+    NNCASE_TARGET_AVX512 static reg floor(reg a) noexcept { return _mm512_roundscale_ps(a, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC); }
+    NNCASE_TARGET_AVX512 static reg ceil(reg a) noexcept { return _mm512_roundscale_ps(a, _MM_FROUND_TO_POS_INF | _MM_FROUND_NO_EXC); }
+
+    NNCASE_TARGET_AVX512 static reg bit_and(reg a, reg b) noexcept { return _mm512_and_ps(a, b); }
+    NNCASE_TARGET_AVX512 static reg bit_or(reg a, reg b) noexcept { return _mm512_or_ps(a, b); }
+    NNCASE_TARGET_AVX512 static reg bit_xor(reg a, reg b) noexcept { return _mm512_xor_ps(a, b); }
+
+    NNCASE_TARGET_AVX512 static ireg to_int(reg a) noexcept { return _mm512_cvtps_epi32(a); }
+    NNCASE_TARGET_AVX512 static reg to_float(ireg a) noexcept { return _mm512_cvtepi32_ps(a); }
+    NNCASE_TARGET_AVX512 static ireg as_int(reg a) noexcept { return _mm512_castps_si512(a); }
+    NNCASE_TARGET_AVX512 static reg as_float(ireg a) noexcept { return _mm512_castsi512_ps(a); }
+    NNCASE_TARGET_AVX512 static ireg iadd(ireg a, ireg b) noexcept { return _mm512_add_epi32(a, b); }
+    NNCASE_TARGET_AVX512 static ireg isub(ireg a, ireg b) noexcept { return _mm512_sub_epi32(a, b); }
+    NNCASE_TARGET_AVX512 static ireg iand(ireg a, ireg b) noexcept { return _mm512_and_si512(a, b); }
+    NNCASE_TARGET_AVX512 static ireg ior(ireg a, ireg b) noexcept { return _mm512_or_si512(a, b); }
+    template <int N>
+    NNCASE_TARGET_AVX512 static ireg shl(ireg a) noexcept { return _mm512_slli_epi32(a, N); }
+    template <int N>
+    NNCASE_TARGET_AVX512 static ireg sra(ireg a) noexcept { return _mm512_srai_epi32(a, N); }
+
+    NNCASE_TARGET_AVX512 static mask lt(reg a, reg b) noexcept { return _mm512_cmp_ps_mask(a, b, _CMP_LT_OQ); }
+    NNCASE_TARGET_AVX512 static mask gt(reg a, reg b) noexcept { return _mm512_cmp_ps_mask(a, b, _CMP_GT_OQ); }
+    NNCASE_TARGET_AVX512 static mask eq(reg a, reg b) noexcept { return _mm512_cmp_ps_mask(a, b, _CMP_EQ_OQ); }
+    NNCASE_TARGET_AVX512 static mask is_nan(reg a) noexcept { return _mm512_cmp_ps_mask(a, a, _CMP_UNORD_Q); }
+    NNCASE_TARGET_AVX512 static mask ieq(ireg a, ireg b) noexcept { return _mm512_cmpeq_epi32_mask(a, b); }
+    NNCASE_TARGET_AVX512 static mask mask_or(mask a, mask b) noexcept { return a | b; }
+    NNCASE_TARGET_AVX512 static bool any(mask m) noexcept { return m != 0; }
+    NNCASE_TARGET_AVX512 static reg select(mask m, reg a, reg b) noexcept { return _mm512_mask_blend_ps(m, b, a); }
+
+    // Spilled, as the 512-bit shuffles trip -Wuninitialized in GCC 12
+    NNCASE_TARGET_AVX512 static float reduce_max(reg a) noexcept
+    {
+        alignas(64) float values[lanes];
+        store(values, a);
+        return *std::max_element(values, values + lanes);
+    }
+
+    NNCASE_TARGET_AVX512 static float reduce_add(reg a) noexcept
+    {
+        alignas(64) float values[lanes];
+        store(values, a);
+        float sum = 0.f;
+        for (auto v : values)
+            sum += v;
+        return sum;
+    }
+
+#define NNCASE_VECTOR_MATH_TARGET NNCASE_TARGET_AVX512
+#include "vector_math.inl"
+#undef NNCASE_VECTOR_MATH_TARGET
+};
+
+END_NS_NNCASE_KERNELS_CPU_OPT
+#endif
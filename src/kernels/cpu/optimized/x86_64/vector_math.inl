@@ -0,0 +1,170 @@
+/* Copyright 2019-2021 Canaan Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+// Included into the body of each ISA struct in vector_math.h, with
+// NNCASE_VECTOR_MATH_TARGET set to that ISA's target attribute.
+// Polynomials are the Cephes single precision ones, except for erf.
+
+NNCASE_VECTOR_MATH_TARGET static reg abs(reg x) noexcept { return bit_and(x, as_float(iset1(0x7fffffff))); }
+NNCASE_VECTOR_MATH_TARGET static reg neg(reg x) noexcept { return bit_xor(x, set1(-0.f)); }
+
+// 2^n for n in [-126, 127]
+NNCASE_VECTOR_MATH_TARGET static reg pow2(ireg n) noexcept { return as_float(shl<23>(iadd(n, iset1(127)))); }
+
+NNCASE_VECTOR_MATH_TARGET static reg exp(reg x) noexcept
+{
+    // Past these bounds the result is inf or 0, min/max keep NaN. 0x1.62e43p+6 is the first
+    // float whose e^x rounds to inf, the one below it gives 3.40279852e38.
+    x = max(set1(-104.f), min(set1(0x1.62e43p+6f), x));
+
+    // e^x = 2^n * e^r, n = round(x / ln2), |r| <= ln2 / 2
+    const auto n = round(mul(x, set1(1.44269504088896341f)));
+    auto r = fnmadd(n, set1(0.693359375f), x);
+    r = fnmadd(n, set1(-2.12194440e-4f), r);
+
+    auto p = set1(1.9875691500e-4f);
+    p = fmadd(p, r, set1(1.3981999507e-3f));
+    p = fmadd(p, r, set1(8.3334519073e-3f));
+    p = fmadd(p, r, set1(4.1665795894e-2f));
+    p = fmadd(p, r, set1(1.6666665459e-1f));
+    p = fmadd(p, r, set1(5.0000001201e-1f));
+    p = fmadd(p, mul(r, r), add(r, set1(1.f)));
+
+    // Scaling by 2^n in two steps lets n reach the overflow and denormal ranges
+    const auto ni = to_int(n);
+    const auto n1 = sra<1>(ni);
+    return mul(mul(p, pow2(n1)), pow2(isub(ni, n1)));
+}
+
+NNCASE_VECTOR_MATH_TARGET static reg log(reg x) noexcept
+{
+    // x = m * 2^e, m in [sqrt(0.5), sqrt(2)), denormals are scaled up first
+    const auto denormal = lt(x, set1(1.17549435e-38f));
+    const auto bits = as_int(select(denormal, mul(x, set1(8388608.f)), x));
+    auto e = to_float(isub(sra<23>(bits), iset1(126)));
+    e = select(denormal, sub(e, set1(23.f)), e);
+    const auto m = as_float(ior(iand(bits, iset1(0x007fffff)), iset1(0x3f000000)));
+    const auto below = lt(m, set1(0.707106781186547524f));
+    e = select(below, sub(e, set1(1.f)), e);
+    const auto f = sub(select(below, add(m, m), m), set1(1.f));
+    const auto z = mul(f, f);
+
+    auto p = set1(7.0376836292e-2f);
+    p = fmadd(p, f, set1(-1.1514610310e-1f));
+    p = fmadd(p, f, set1(1.1676998740e-1f));
+    p = fmadd(p, f, set1(-1.2420140846e-1f));
+    p = fmadd(p, f, set1(1.4249322787e-1f));
+    p = fmadd(p, f, set1(-1.6668057665e-1f));
+    p = fmadd(p, f, set1(2.0000714765e-1f));
+    p = fmadd(p, f, set1(-2.4999993993e-1f));
+    p = fmadd(p, f, set1(3.3333331174e-1f));
+
+    auto y = mul(mul(p, f), z);
+    y = fmadd(e, set1(-2.12194440e-4f), y);
+    y = fnmadd(set1(0.5f), z, y);
+    auto result = fmadd(e, set1(0.693359375f), add(f, y));
+
+    result = select(eq(x, set1(INFINITY)), x, result);
+    result = select(lt(x, set1(0.f)), set1(NAN), result);
+    result = select(eq(x, set1(0.f)), set1(-INFINITY), result);
+    return select(is_nan(x), x, result);
+}
+
+NNCASE_VECTOR_MATH_TARGET static reg tanh(reg x) noexcept
+{
+    // |x| < 0.625 uses a polynomial, larger inputs 1 - 2 / (e^2|x| + 1)
+    const auto sign = bit_and(x, set1(-0.f));
+    const auto z = bit_xor(x, sign);
+    const auto x2 = mul(x, x);
+    auto p = set1(-5.70498872745e-3f);
+    p = fmadd(p, x2, set1(2.06390887954e-2f));
+    p = fmadd(p, x2, set1(-5.37397155531e-2f));
+    p = fmadd(p, x2, set1(1.33314422036e-1f));
+    p = fmadd(p, x2, set1(-3.33332819422e-1f));
+    const auto small = fmadd(mul(p, x2), x, x);
+
+    const auto large = sub(set1(1.f), div(set1(2.f), add(exp(add(z, z)), set1(1.f))));
+    return select(lt(z, set1(0.625f)), small, bit_or(large, sign));
+}
+
+NNCASE_VECTOR_MATH_TARGET static reg sigmoid(reg x) noexcept
+{
+    // 1 / (1 + e^-x), or e^x / (1 + e^x) for negative inputs, so that e^-|x|
+    // never overflows and large negative inputs keep their denormal results
+    const auto e = exp(neg(abs(x)));
+    return div(select(lt(x, set1(0.f)), e, set1(1.f)), add(set1(1.f), e));
+}
+
+NNCASE_VECTOR_MATH_TARGET static reg erf(reg x) noexcept
+{
+    // Rational approximation x * P(x^2) / Q(x^2), erf(x) rounds to +-1 past |x| = 4
+    x = max(set1(-4.f), min(set1(4.f), x));
+    const auto x2 = mul(x, x);
+    auto p = set1(-2.72614225801306e-10f);
+    p = fmadd(p, x2, set1(2.77068142495902e-08f));
+    p = fmadd(p, x2, set1(-2.10102402082508e-06f));
+    p = fmadd(p, x2, set1(-5.69250639462346e-05f));
+    p = fmadd(p, x2, set1(-7.34990630326855e-04f));
+    p = fmadd(p, x2, set1(-2.95459980854025e-03f));
+    p = fmadd(p, x2, set1(-1.60960333262415e-02f));
+    auto q = set1(-1.45660718464996e-05f);
+    q = fmadd(q, x2, set1(-2.13374055278905e-04f));
+    q = fmadd(q, x2, set1(-1.68282697438203e-03f));
+    q = fmadd(q, x2, set1(-7.37332916720468e-03f));
+    q = fmadd(q, x2, set1(-1.42647390514189e-02f));
+    return mul(x, div(p, q));
+}
+
+// sin(x + quadrant * pi / 2)
+NNCASE_VECTOR_MATH_TARGET static reg sin_quadrant(reg x, int32_t quadrant) noexcept
+{
+    // The reduction below is checked up to this bound, libm takes over past it
+    if (any(gt(abs(x), set1(8192.f))))
+    {
+        alignas(64) float values[lanes];
+        store(values, x);
+        for (auto &v : values)
+            v = quadrant & 1 ? ((quadrant & 2) ? -std::cos(v) : std::cos(v)) : ((quadrant & 2) ? -std::sin(v) : std::sin(v));
+        return load(values);
+    }
+
+    // x = q * pi / 2 + r, |r| <= pi / 4. pi / 2 is split into three floats, each
+    // the rounded remainder of the previous ones. The first fmadd is exact and the
+    // others round relative to r, so r stays accurate near multiples of pi.
+    const auto q = round(mul(x, set1(0.636619772367581343f)));
+    auto r = fnmadd(q, set1(1.57079637f), x);
+    r = fnmadd(q, set1(-4.37113883e-8f), r);
+    r = fnmadd(q, set1(-1.71512451e-15f), r);
+    const auto z = mul(r, r);
+
+    auto s = set1(-1.9515295891e-4f);
+    s = fmadd(s, z, set1(8.3321608736e-3f));
+    s = fmadd(s, z, set1(-1.6666654611e-1f));
+    s = fmadd(mul(s, z), r, r);
+
+    auto c = set1(2.443315711809948e-5f);
+    c = fmadd(c, z, set1(-1.388731625493765e-3f));
+    c = fmadd(c, z, set1(4.166664568298827e-2f));
+    c = fmadd(mul(c, z), z, fnmadd(set1(0.5f), z, set1(1.f)));
+
+    // Odd quadrants swap sin and cos, quadrants 2 and 3 negate
+    const auto k = iadd(to_int(q), iset1(quadrant));
+    const auto result = select(ieq(iand(k, iset1(1)), iset1(1)), c, s);
+    return bit_xor(result, as_float(shl<30>(iand(k, iset1(2)))));
+}
+
+NNCASE_VECTOR_MATH_TARGET static reg sin(reg x) noexcept { return sin_quadrant(x, 0); }
+NNCASE_VECTOR_MATH_TARGET static reg cos(reg x) noexcept { return sin_quadrant(x, 1); }
+
+NNCASE_VECTOR_MATH_TARGET static reg rsqrt(reg x) noexcept { return div(set1(1.f), sqrt(x)); }
@@ -12,14 +12,243 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  */
+#include <algorithm>
+#include <map>
 #include <nncase/kernels/kernel_context.h>
 #ifdef NNCASE_OPENMP
 #include <omp.h>
 #endif
+#ifdef NNCASE_THREAD_POOL
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#endif
 
 using namespace nncase;
 using namespace nncase::kernels;
 
+#ifdef NNCASE_THREAD_POOL
+namespace
+{
+thread_local bool in_parallel_region = false;
+std::mutex pool_create_mutex;
+std::map<uint32_t, std::shared_ptr<kernels::thread_pool>> shared_pools;
+}
+
+class kernels::thread_pool
+{
+    // A contiguous run of chunk indices owned by one participant. The owner
+    // pops from the front, thieves split off the back half.
+    struct work_queue
+    {
+        std::mutex lock;
+        size_t begin = 0;
+        size_t end = 0;
+    };
+
+public:
+    explicit thread_pool(size_t threads)
+        : queues_(new work_queue[threads])
+    {
+        try
+        {
+            workers_.reserve(threads - 1);
+            for (size_t i = 1; i < threads; i++)
+                workers_.emplace_back([this, i] { worker_main(i); });
+        }
+        catch (...)
+        {
+            stop();
+            throw;
+        }
+    }
+
+    ~thread_pool()
+    {
+        stop();
+    }
+
+    size_t threads() const noexcept { return workers_.size() + 1; }
+
+    bool try_run(size_t count, size_t grain, const parallel_body &body) noexcept
+    {
+        std::unique_lock<std::mutex> run_lock(run_mutex_, std::try_to_lock);
+        if (!run_lock.owns_lock())
+            return false;
+
+        count_ = count;
+        grain_ = grain;
+        body_ = &body;
+
+        const auto chunks = (count + grain - 1) / grain;
+        const auto participants = threads();
+        for (size_t i = 0; i < participants; i++)
+        {
+            queues_[i].begin = chunks * i / participants;
+            queues_[i].end = chunks * (i + 1) / participants;
+        }
+
+        pending_.store(workers_.size(), std::memory_order_relaxed);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            generation_++;
+        }
+
+        wake_cv_.notify_all();
+        in_parallel_region = true;
+        work(0);
+        in_parallel_region = false;
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        done_cv_.wait(lock, [this] { return pending_.load(std::memory_order_acquire) == 0; });
+        body_ = nullptr;
+        return true;
+    }
+
+private:
+    void stop() noexcept
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+
+        wake_cv_.notify_all();
+        for (auto &worker : workers_)
+            worker.join();
+    }
+
+    void worker_main(size_t id)
+    {
+        in_parallel_region = true;
+        size_t seen_generation = 0;
+        while (true)
+        {
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                wake_cv_.wait(lock, [&] { return stop_ || generation_ != seen_generation; });
+                if (stop_)
+                    return;
+                seen_generation = generation_;
+            }
+
+            work(id);
+            if (pending_.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                done_cv_.notify_one();
+            }
+        }
+    }
+
+    void work(size_t id) noexcept
+    {
+        size_t chunk;
+        while (pop(id, chunk) || steal(id, chunk))
+        {
+            const auto begin = chunk * grain_;
+            const auto end = std::min(begin + grain_, count_);
+            (*body_)(begin, end);
+        }
+    }
+
+    bool pop(size_t id, size_t &chunk) noexcept
+    {
+        auto &queue = queues_[id];
+        std::lock_guard<std::mutex> lock(queue.lock);
+        if (queue.begin == queue.end)
+            return false;
+        chunk = queue.begin++;
+        return true;
+    }
+
+    bool steal(size_t id, size_t &chunk) noexcept
+    {
+        const auto participants = threads();
+        for (size_t i = 1; i < participants; i++)
+        {
+            auto &victim = queues_[(id + i) % participants];
+            size_t begin, end;
+            {
+                std::lock_guard<std::mutex> lock(victim.lock);
+                const auto remain = victim.end - victim.begin;
+                if (remain == 0)
+                    continue;
+                const auto take = (remain + 1) / 2;
+                end = victim.end;
+                begin = end - take;
+                victim.end = begin;
+            }
+
+            // Keep the first stolen chunk, queue the rest so others can steal them back.
+            chunk = begin;
+            auto &queue = queues_[id];
+            std::lock_guard<std::mutex> lock(queue.lock);
+            queue.begin = begin + 1;
+            queue.end = end;
+            return true;
+        }
+
+        return false;
+    }
+
+private:
+    std::unique_ptr<work_queue[]> queues_;
+    std::vector<std::thread> workers_;
+    std::mutex run_mutex_;
+    std::mutex mutex_;
+    std::condition_variable wake_cv_;
+    std::condition_variable done_cv_;
+    size_t generation_ = 0;
+    bool stop_ = false;
+    std::atomic<size_t> pending_ { 0 };
+    size_t count_ = 0;
+    size_t grain_ = 1;
+    const parallel_body *body_ = nullptr;
+};
+#else
+class kernels::thread_pool
+{
+};
+#endif
+
+class kernels::weights_cache
+{
+public:
+    const float *get(const void *weights, size_t size, void *fill, void (*invoke)(void *fill, float *out)) noexcept
+    {
+#ifdef NNCASE_THREAD_POOL
+        std::lock_guard<std::mutex> lock(mutex_);
+#endif
+        try
+        {
+            auto &entry = entries_[{ weights, size }];
+            if (!entry)
+            {
+                std::unique_ptr<float[]> data(new (std::nothrow) float[size]);
+                if (!data)
+                    return nullptr;
+                invoke(fill, data.get());
+                entry = std::move(data);
+            }
+
+            return entry.get();
+        }
+        catch (...)
+        {
+            return nullptr;
+        }
+    }
+
+private:
+#ifdef NNCASE_THREAD_POOL
+    std::mutex mutex_;
+#endif
+    std::map<std::pair<const void *, size_t>, std::unique_ptr<float[]>> entries_;
+};
+
 namespace
 {
 struct default_kernel_context_holder
@@ -30,6 +259,8 @@ struct default_kernel_context_holder
     {
 #ifdef NNCASE_OPENMP
         ctx.num_threads = (uint32_t)omp_get_max_threads();
+#elif defined(NNCASE_THREAD_POOL)
+        ctx.num_threads = std::max(1U, std::thread::hardware_concurrency());
 #else
         ctx.num_threads = 1;
 #endif
@@ -42,3 +273,59 @@ kernel_context &kernels::default_kernel_context()
     static default_kernel_context_holder holder;
     return holder.ctx;
 }
+
+std::shared_ptr<thread_pool> kernels::shared_thread_pool(uint32_t threads) noexcept
+{
+#ifdef NNCASE_THREAD_POOL
+    std::lock_guard<std::mutex> lock(pool_create_mutex);
+    try
+    {
+        auto &pool = shared_pools[threads];
+        if (!pool)
+            pool = std::make_shared<thread_pool>(threads);
+        return pool;
+    }
+    catch (...)
+    {
+        return nullptr;
+    }
+#else
+    NNCASE_UNUSED auto &unused = threads;
+    return nullptr;
+#endif
+}
+
+void kernels::parallel_for(kernel_context &context, size_t count, size_t grain, const parallel_body &body) noexcept
+{
+    grain = std::max(grain, size_t(1));
+#ifdef NNCASE_THREAD_POOL
+    if (count > grain && context.num_threads > 1 && !in_parallel_region)
+    {
+        auto pool = context.pool;
+        if (!pool || pool->threads() != context.num_threads)
+            pool = shared_thread_pool(context.num_threads);
+        if (pool && pool->try_run(count, grain, body))
+            return;
+    }
+#else
+    NNCASE_UNUSED auto &unused = context;
+#endif
+
+    if (count)
+        body(0, count);
+}
+
+std::shared_ptr<weights_cache> kernels::make_weights_cache() noexcept
+{
+    return std::shared_ptr<weights_cache>(new (std::nothrow) weights_cache);
+}
+
+const float *kernels::detail::cached_weights(kernel_context &context, const void *weights, size_t weights_bytes, size_t size,
+    void *fill, void (*invoke)(void *fill, float *out)) noexcept
+{
+    auto begin = reinterpret_cast<uintptr_t>(weights);
+    if (!context.weights || begin < reinterpret_cast<uintptr_t>(context.constants_begin)
+        || begin + weights_bytes > reinterpret_cast<uintptr_t>(context.constants_end))
+        return nullptr;
+    return context.weights->get(weights, size, fill, invoke);
+}
@@ -12,6 +12,7 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  */
+#include <nncase/kernels/cpu/optimized/tensor_compute.h>
 #include <nncase/kernels/cpu/reference/reduce_window.h>
 #include <nncase/kernels/kernel_context.h>
 #include <nncase/kernels/reduce_window.h>
@@ -25,6 +26,12 @@ result<void> kernels::reduce_window2d(reduce_op_t op, const float *input, float
     int32_t filter_h, int32_t filter_w, int32_t stride_h, int32_t stride_w, int32_t dilation_h, int32_t dilation_w, value_range<float> fused_activation,
     kernel_context &context) noexcept
 {
+    if (cpu::optimized::reduce_window2d(op, input, init_value, output, in_shape, in_strides, out_strides, padding_h,
+            padding_w, filter_h, filter_w, stride_h, stride_w, dilation_h, dilation_w, fused_activation, context)
+            .is_ok())
+        return ok();
+
+    // dilated, padded with negative amounts or strided layouts
     return cpu::reference::reduce_window2d(op, input, init_value, output, in_shape, in_strides, out_strides, padding_h,
         padding_w, filter_h, filter_w, stride_h, stride_w, dilation_h, dilation_w, fused_activation, context);
 }
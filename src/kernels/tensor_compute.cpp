@@ -140,18 +140,18 @@ result<void> kernels::lut1d(datatype_t type, const gsl::byte *input, const gsl::
 template result<void> kernels::matmul<float>(const float *input_a, const float *input_b, const float *bias, float *output,
     const runtime_shape_t &in_a_shape, const runtime_shape_t &in_a_strides, const runtime_shape_t &in_b_shape,
     const runtime_shape_t &in_b_strides, const runtime_shape_t &out_shape, const runtime_shape_t &out_strides,
-    value_range<float> fused_activation) noexcept;
+    value_range<float> fused_activation, kernel_context &context) noexcept;
 
 template <typename T>
 result<void> kernels::matmul(const T *input_a, const T *input_b, const T *bias, T *output,
     const runtime_shape_t &in_a_shape, const runtime_shape_t &in_a_strides, const runtime_shape_t &in_b_shape,
     const runtime_shape_t &in_b_strides, const runtime_shape_t &out_shape, const runtime_shape_t &out_strides,
-    value_range<float> fused_activation) noexcept
+    value_range<float> fused_activation, kernel_context &context) noexcept
 {
     // if (is_contiguous(in_a_shape, in_a_strides) && is_contiguous(in_b_shape, in_b_strides) && is_contiguous(out_shape, out_strides))
     // {
     return cpu::optimized::matmul(input_a, input_b, bias, output, in_a_shape, in_a_strides, in_b_shape, in_b_strides,
-        out_shape, out_strides, fused_activation);
+        out_shape, out_strides, fused_activation, context);
     // }
 
     return cpu::reference::matmul(input_a, input_b, bias, output, in_a_shape, in_a_strides, in_b_shape, in_b_strides,
@@ -175,7 +175,7 @@ result<void> kernels::pad(datatype_t type, const gsl::byte *input, gsl::byte *ou
     const runtime_shape_t &in_strides, const runtime_shape_t &out_strides, const runtime_paddings_t &paddings, pad_mode_t mode,
     const scalar &pad_value, kernel_context &context) noexcept
 {
-    return cpu::reference::pad(type, input, output, in_shape, in_strides, out_strides, paddings, mode, pad_value, context);
+    return cpu::optimized::pad(type, input, output, in_shape, in_strides, out_strides, paddings, mode, pad_value, context);
 }
 
 result<void> kernels::quantize(datatype_t in_type, datatype_t out_type, const gsl::byte *input, gsl::byte *output,
@@ -192,7 +192,7 @@ result<void> kernels::quantize(datatype_t in_type, datatype_t out_type, const gs
 result<void> kernels::transpose(datatype_t type, const gsl::byte *src, gsl::byte *dest, const runtime_shape_t &in_shape,
     const runtime_shape_t &perm, const runtime_shape_t &in_strides, const runtime_shape_t &out_strides, kernel_context &context) noexcept
 {
-    return cpu::reference::transpose(type, src, dest, in_shape, perm, in_strides, out_strides, context);
+    return cpu::optimized::transpose(type, src, dest, in_shape, perm, in_strides, out_strides, context);
 }
 
 template result<void> kernels::binary<float>(binary_op_t op, const float *input_a, const float *input_b, float *output,
@@ -217,7 +217,12 @@ result<void> kernels::binary(binary_op_t op, const T *input_a, const T *input_b,
     if (is_contiguous(in_a_shape, in_a_strides) && is_contiguous(in_b_shape, in_b_strides) && is_contiguous(out_shape, out_strides))
     {
         // optimization
+#if defined(__riscv)
         if (is_optimized_binary_op(op) && is_optimized_input_shape(in_a_shape, out_shape) && is_optimized_input_shape(in_b_shape, out_shape) && (std::is_same_v<T, float> || std::is_same_v<T, int32_t>))
+#else
+        // x86_64 kernels take any broadcast of contiguous tensors
+        if (is_optimized_binary_op(op))
+#endif
             return cpu::optimized::binary(op, input_a, input_b, output, in_a_shape, in_a_strides, in_b_shape, in_b_strides, out_shape, out_strides, fused_activation, context);
     }
     return cpu::reference::binary(op, input_a, input_b, output, in_a_shape, in_a_strides, in_b_shape, in_b_strides, out_shape, out_strides, fused_activation, context);
@@ -226,7 +231,12 @@ result<void> kernels::binary(binary_op_t op, const T *input_a, const T *input_b,
 result<void> kernels::unary(unary_op_t op, const float *input, float *output, const runtime_shape_t &shape,
     const runtime_shape_t &in_strides, const runtime_shape_t &out_strides, kernel_context &context) noexcept
 {
+#if defined(__riscv)
     if (is_contiguous(shape, in_strides) && is_contiguous(shape, out_strides) && is_optimized_unary_op(op))
+#else
+    // x86_64 kernels also vectorize erf
+    if (is_contiguous(shape, in_strides) && is_contiguous(shape, out_strides) && (is_optimized_unary_op(op) || op == unary_erf))
+#endif
     {
         // optimization
         return cpu::optimized::unary(op, input, output, shape, in_strides, out_strides, context);
@@ -244,7 +254,7 @@ template <typename T>
 result<void> kernels::reduce(reduce_op_t op, T init_value, const T *input, T *output, const runtime_shape_t &in_shape, const runtime_shape_t &axis,
     const runtime_shape_t &in_strides, const runtime_shape_t &out_strides, bool keep_dims, kernel_context &context) noexcept
 {
-    return cpu::reference::reduce(op, init_value, input, output, in_shape, axis, in_strides, out_strides, keep_dims, context);
+    return cpu::optimized::reduce(op, init_value, input, output, in_shape, axis, in_strides, out_strides, keep_dims, context);
 }
 
 template result<void> kernels::reduce_arg<int32_t>(reduce_arg_op_t op, const float *input, int32_t *output, const runtime_shape_t &in_shape,
@@ -260,23 +270,23 @@ result<void> kernels::reduce_arg(reduce_arg_op_t op, const float *input, T *outp
     const runtime_shape_t &in_strides, const runtime_shape_t &out_strides, const runtime_shape_t &axis,
     bool keep_dims, bool select_last_idx, kernel_context &context) noexcept
 {
-    return cpu::reference::reduce_arg(op, input, output, in_shape, in_strides, out_strides, axis, keep_dims, select_last_idx, context);
+    return cpu::optimized::reduce_arg(op, input, output, in_shape, in_strides, out_strides, axis, keep_dims, select_last_idx, context);
 }
 
 template result<void> kernels::reduce_prod<float>(const float *input, float *output, const runtime_shape_t &in_shape,
     const runtime_shape_t &in_strides, const runtime_shape_t &out_strides,
-    const runtime_shape_t &axes, bool keep_dims) noexcept;
+    const runtime_shape_t &axes, bool keep_dims, kernel_context &context) noexcept;
 
 template result<void> kernels::reduce_prod<int32_t>(const int32_t *input, int32_t *output, const runtime_shape_t &in_shape,
     const runtime_shape_t &in_strides, const runtime_shape_t &out_strides,
-    const runtime_shape_t &axes, bool keep_dims) noexcept;
+    const runtime_shape_t &axes, bool keep_dims, kernel_context &context) noexcept;
 
 template <typename T>
 result<void> kernels::reduce_prod(const T *input, T *output, const runtime_shape_t &in_shape,
     const runtime_shape_t &in_strides, const runtime_shape_t &out_strides,
-    const runtime_shape_t &axes, bool keep_dims) noexcept
+    const runtime_shape_t &axes, bool keep_dims, kernel_context &context) noexcept
 {
-    return cpu::reference::reduce_prod(input, output, in_shape, in_strides, out_strides, axes, keep_dims);
+    return cpu::optimized::reduce_prod(input, output, in_shape, in_strides, out_strides, axes, keep_dims, context);
 }
 
 #define DISPATCH_RESIZE(resize_fun)                                                                                                                          \
@@ -0,0 +1,276 @@
+/* Copyright 2019-2021 Canaan Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "compile_cache.h"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+
+using namespace nncase;
+namespace fs = std::filesystem;
+
+namespace
+{
+// Temporary files older than this were left by a compiler that stopped between write and rename.
+constexpr auto stale_temp_age = std::chrono::hours(1);
+
+constexpr std::array<uint32_t, 64> sha256_k {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+void sha256_block(std::array<uint32_t, 8> &state, const uint8_t *block) noexcept
+{
+    auto rotr = [](uint32_t x, int n) { return (x >> n) | (x << (32 - n)); };
+    std::array<uint32_t, 64> w;
+    for (size_t i = 0; i < 16; i++)
+        w[i] = (uint32_t)block[i * 4] << 24 | (uint32_t)block[i * 4 + 1] << 16 | (uint32_t)block[i * 4 + 2] << 8 | block[i * 4 + 3];
+    for (size_t i = 16; i < 64; i++)
+    {
+        auto s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        auto s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+
+    auto [a, b, c, d, e, f, g, h] = state;
+    for (size_t i = 0; i < 64; i++)
+    {
+        auto t1 = h + (rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25)) + ((e & f) ^ (~e & g)) + sha256_k[i] + w[i];
+        auto t2 = (rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+        h = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+    }
+
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+    state[4] += e;
+    state[5] += f;
+    state[6] += g;
+    state[7] += h;
+}
+
+// Hex SHA-256 of `data`, so a wrong cache entry needs a practical collision rather than a 64-bit one.
+std::string sha256(std::span<const uint8_t> data)
+{
+    std::array<uint32_t, 8> state { 0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19 };
+    size_t offset = 0;
+    for (; data.size() - offset >= 64; offset += 64)
+        sha256_block(state, data.data() + offset);
+
+    // Padding: 0x80, zeros, then the message length in bits as a big-endian 64-bit integer
+    std::array<uint8_t, 128> tail {};
+    auto rest = data.size() - offset;
+    std::copy(data.begin() + offset, data.end(), tail.begin());
+    tail[rest] = 0x80;
+    auto tail_size = rest < 56 ? 64 : 128;
+    auto bits = (uint64_t)data.size() * 8;
+    for (size_t i = 0; i < 8; i++)
+        tail[tail_size - 1 - i] = (uint8_t)(bits >> (i * 8));
+    for (size_t i = 0; i < (size_t)tail_size; i += 64)
+        sha256_block(state, tail.data() + i);
+
+    std::ostringstream ss;
+    ss << std::hex << std::setfill('0');
+    for (auto word : state)
+        ss << std::setw(8) << word;
+    return ss.str();
+}
+
+std::vector<uint8_t> read_file(const fs::path &path)
+{
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file)
+        throw std::runtime_error("Cannot open " + path.string());
+
+    std::vector<uint8_t> data((size_t)file.tellg());
+    file.seekg(0);
+    if (!file.read(reinterpret_cast<char *>(data.data()), data.size()))
+        throw std::runtime_error("Cannot read " + path.string());
+    return data;
+}
+
+// Writes to a temporary file first, so concurrent compilers never see a partial entry.
+void write_file(const fs::path &path, std::span<const uint8_t> data)
+{
+    auto temp = path;
+    temp += "." + std::to_string(std::random_device()()) + ".tmp";
+    {
+        std::ofstream file(temp, std::ios::binary);
+        if (!file.write(reinterpret_cast<const char *>(data.data()), data.size()))
+            throw std::runtime_error("Cannot write " + temp.string());
+    }
+
+    fs::rename(temp, path);
+}
+
+std::span<const uint8_t> as_bytes(std::string_view text) noexcept
+{
+    return { reinterpret_cast<const uint8_t *>(text.data()), text.size() };
+}
+}
+
+void compile_cache_key::add(std::string_view name, std::string_view value)
+{
+    manifest_.append(name).append("=").append(value).append("\n");
+}
+
+void compile_cache_key::add(std::string_view name, std::span<const uint8_t> data)
+{
+    add(name, std::to_string(data.size()) + ":" + sha256(data));
+}
+
+void compile_cache_key::add_directory(std::string_view name, const fs::path &dir)
+{
+    std::vector<fs::path> files;
+    for (auto &entry : fs::recursive_directory_iterator(dir))
+    {
+        if (entry.is_regular_file())
+            files.emplace_back(entry.path());
+    }
+
+    std::sort(files.begin(), files.end());
+    add(name, std::to_string(files.size()) + " files");
+    for (auto &file : files)
+        add(std::string(name) + "/" + fs::relative(file, dir).generic_string(), read_file(file));
+}
+
+std::string compile_cache_key::digest() const
+{
+    return sha256(as_bytes(manifest_));
+}
+
+compile_cache::compile_cache(fs::path dir, uint64_t max_size)
+    : dir_(std::move(dir)), max_size_(max_size)
+{
+}
+
+std::optional<std::vector<uint8_t>> compile_cache::load(const compile_cache_key &key)
+{
+    auto digest = key.digest();
+    auto model_path = dir_ / (digest + ".kmodel");
+    try
+    {
+        if (!fs::exists(model_path))
+            return std::nullopt;
+
+        // The entry manifest also records the kmodel, so a truncated or corrupt file is a miss
+        auto manifest = read_file(dir_ / (digest + ".key"));
+        auto kmodel = read_file(model_path);
+        auto entry_key = key;
+        entry_key.add("kmodel", kmodel);
+        if (!std::ranges::equal(manifest, as_bytes(entry_key.manifest())))
+        {
+            std::cerr << "Warning: ignoring corrupt compilation cache entry " << digest << std::endl;
+            return std::nullopt;
+        }
+
+        // Entries are evicted by last use
+        fs::last_write_time(model_path, fs::file_time_type::clock::now());
+        return kmodel;
+    }
+    catch (const std::exception &ex)
+    {
+        std::cerr << "Warning: cannot read compilation cache entry " << digest << ": " << ex.what() << std::endl;
+        return std::nullopt;
+    }
+}
+
+void compile_cache::store(const compile_cache_key &key, std::span<const uint8_t> kmodel)
+{
+    auto digest = key.digest();
+    auto model_path = dir_ / (digest + ".kmodel");
+    try
+    {
+        fs::create_directories(dir_);
+        auto entry_key = key;
+        entry_key.add("kmodel", kmodel);
+        write_file(dir_ / (digest + ".key"), as_bytes(entry_key.manifest()));
+        write_file(model_path, kmodel);
+        evict(model_path);
+    }
+    catch (const std::exception &ex)
+    {
+        std::cerr << "Warning: cannot write compilation cache entry " << digest << ": " << ex.what() << std::endl;
+    }
+}
+
+void compile_cache::evict(const fs::path &keep)
+{
+    struct entry
+    {
+        fs::path model_path;
+        uint64_t size;
+        fs::file_time_type last_use;
+    };
+
+    std::vector<entry> entries;
+    uint64_t total_size = 0;
+    const auto now = fs::file_time_type::clock::now();
+    for (auto &file : fs::directory_iterator(dir_))
+    {
+        std::error_code ec;
+        if (!file.is_regular_file(ec))
+            continue;
+
+        if (file.path().extension() == ".tmp")
+        {
+            // Recent ones may still be written by another compiler
+            auto last_write = file.last_write_time(ec);
+            if (!ec && now - last_write > stale_temp_age)
+                fs::remove(file.path(), ec);
+            continue;
+        }
+
+        if (file.path().extension() != ".kmodel")
+            continue;
+
+        auto key_size = fs::file_size(fs::path(file.path()).replace_extension(".key"), ec);
+        auto &e = entries.emplace_back(entry { file.path(), file.file_size() + (ec ? 0 : key_size), file.last_write_time() });
+        total_size += e.size;
+    }
+
+    std::sort(entries.begin(), entries.end(), [](const entry &lhs, const entry &rhs) { return lhs.last_use < rhs.last_use; });
+    for (auto &e : entries)
+    {
+        if (total_size <= max_size_)
+            break;
+        if (e.model_path == keep)
+            continue;
+
+        // Another compiler may be evicting the same entry
+        std::error_code ec;
+        fs::remove(e.model_path, ec);
+        fs::remove(fs::path(e.model_path).replace_extension(".key"), ec);
+        total_size -= e.size;
+    }
+}
@@ -0,0 +1,76 @@
+/* Copyright 2019-2021 Canaan Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <nncase/runtime/compiler_defs.h>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace nncase
+{
+/**
+ * @brief Describes everything a compiled model depends on.
+ *
+ * Values are recorded in a text manifest, binary data by its size and SHA-256. The manifest
+ * is stored with each cache entry and compared on lookup, so only a SHA-256 collision of
+ * the data can return a wrong entry.
+ */
+class NNCASE_API compile_cache_key
+{
+public:
+    void add(std::string_view name, std::string_view value);
+    void add(std::string_view name, std::span<const uint8_t> data);
+
+    /**
+     * @brief Adds the names and contents of all regular files under `dir`.
+     */
+    void add_directory(std::string_view name, const std::filesystem::path &dir);
+
+    const std::string &manifest() const noexcept { return manifest_; }
+    std::string digest() const;
+
+private:
+    std::string manifest_;
+};
+
+/**
+ * @brief Compiled kmodels stored in a local directory, evicted least recently used first
+ * once their total size exceeds a limit.
+ *
+ * Each entry stores the key manifest and the kmodel's SHA-256 next to the kmodel. An entry
+ * that does not match is a miss. Temporary files left by an interrupted store are removed
+ * by the eviction scan once they are an hour old. Failing to read or write the cache never fails a
+ * compilation: it is reported and the model is compiled as if the cache was disabled.
+ */
+class NNCASE_API compile_cache
+{
+public:
+    compile_cache(std::filesystem::path dir, uint64_t max_size);
+
+    std::optional<std::vector<uint8_t>> load(const compile_cache_key &key);
+    void store(const compile_cache_key &key, std::span<const uint8_t> kmodel);
+
+private:
+    void evict(const std::filesystem::path &keep);
+
+private:
+    std::filesystem::path dir_;
+    uint64_t max_size_;
+};
+}
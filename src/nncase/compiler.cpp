@@ -12,10 +12,12 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  */
+#include "compile_cache.h"
 #include "nncase/ir/quantizer.h"
 #include "xtensor/xadapt.hpp"
 #include <fstream>
 #include <magic_enum.hpp>
+#include <mutex>
 #include <nncase/codegen/model_builder.h>
 #include <nncase/compiler.h>
 #include <nncase/data/dataset.h>
@@ -31,6 +33,8 @@
 #include <nncase/transforms/neutral/post_process_transform.h>
 #include <nncase/transforms/neutral/pre_process_setting.h>
 #include <nncase/transforms/pass.h>
+#include <nncase/version.h>
+#include <thread>
 #include <variant>
 #include <xtensor/xarray.hpp>
 #include <xtensor/xcsv.hpp>
@@ -125,6 +129,41 @@ std::string format_size(size_t size)
     return ss.str();
 }
 
+template <class T>
+std::string to_cache_value(const T &value)
+{
+    std::ostringstream ss;
+    ss << std::setprecision(9) << value;
+    return ss.str();
+}
+
+// Elements are length-prefixed, so {"a b"} and {"a", "b"} get different values.
+template <class T>
+std::string to_cache_value(const std::vector<T> &values)
+{
+    auto result = std::to_string(values.size());
+    for (auto &value : values)
+    {
+        auto item = to_cache_value(value);
+        result.append(" ").append(std::to_string(item.size())).append(":").append(item);
+    }
+    return result;
+}
+
+void add_cache_key(compile_cache_key &key, const ptq_dataset_options &options)
+{
+    key.add("calibrate_method", options.calibrate_method);
+    key.add("dataset_format", options.dataset_format);
+    key.add_directory("dataset", options.dataset);
+}
+
+void add_cache_key(compile_cache_key &key, const ptq_tensor_options &options)
+{
+    key.add("calibrate_method", options.calibrate_method);
+    key.add("samples_count", to_cache_value(options.samples_count));
+    key.add("tensor_data", options.tensor_data);
+}
+
 class compiler_impl : public compiler
 {
 public:
@@ -135,16 +174,19 @@ public:
         if (!options.dump_dir.empty())
             std::filesystem::create_directories(options.dump_dir);
         set_target(options.target);
+
+        if (!options.cache_dir.empty())
+        {
+            // Dumps are only produced by a real compilation
+            if (options.dump_ir || options.dump_asm || options.dump_quant_error || options.dump_import_op_range)
+                std::cout << "Compilation cache is disabled when dumping" << std::endl;
+            else
+                cache_ = std::make_unique<compile_cache>(options.cache_dir, options.cache_max_size);
+        }
     }
 
     nncase::target &target() noexcept override { return *target_; }
 
-#define BEGIN_IMPORT()                              \
-    std::cout << "1. Import graph..." << std::endl; \
-                                                    \
-    importer::import_options imp_options;           \
-    imp_options.output_arrays = options.output_arrays;
-
 #define END_IMPORT()                                                  \
     if (compile_options_.dump_ir)                                     \
     {                                                                 \
@@ -155,23 +197,23 @@ public:
 
     void import_tflite(std::span<const uint8_t> model, const import_options &options) override
     {
-        BEGIN_IMPORT()
-        importer::import_tflite(graph_, model, imp_options, real_inlayout_, real_outlayout_);
-        END_IMPORT()
+        import_model("tflite", model, {}, options.output_arrays, [this](std::span<const uint8_t> model, std::span<const uint8_t>, const importer::import_options &imp_options) {
+            importer::import_tflite(graph_, model, imp_options, real_inlayout_, real_outlayout_);
+        });
     }
 
     void import_onnx(std::span<const uint8_t> model, const import_options &options) override
     {
-        BEGIN_IMPORT()
-        importer::import_onnx(graph_, model, imp_options, real_inlayout_, real_outlayout_);
-        END_IMPORT()
+        import_model("onnx", model, {}, options.output_arrays, [this](std::span<const uint8_t> model, std::span<const uint8_t>, const importer::import_options &imp_options) {
+            importer::import_onnx(graph_, model, imp_options, real_inlayout_, real_outlayout_);
+        });
     }
 
     void import_caffe(std::span<const uint8_t> model, std::span<const uint8_t> prototxt) override
     {
-        std::cout << "1. Import graph..." << std::endl;
-        importer::import_caffe(graph_, model, prototxt, real_inlayout_, real_outlayout_);
-        END_IMPORT()
+        import_model("caffe", model, prototxt, {}, [this](std::span<const uint8_t> model, std::span<const uint8_t> prototxt, const importer::import_options &) {
+            importer::import_caffe(graph_, model, prototxt, real_inlayout_, real_outlayout_);
+        });
     }
 
     void use_ptq(ptq_dataset_options options) override
@@ -198,6 +240,19 @@ public:
 
     void compile() override
     {
+        if (cache_)
+        {
+            cache_key_ = make_cache_key();
+            if (cache_key_)
+            {
+                cached_kmodel_ = cache_->load(*cache_key_);
+                std::cout << "Compilation cache " << (cached_kmodel_ ? "hit: " : "miss: ") << cache_key_->digest() << std::endl;
+                if (cached_kmodel_)
+                    return;
+            }
+        }
+
+        run_pending_import();
         if (use_ptq_)
         {
             if (compile_options_.input_type == "default")
@@ -380,6 +435,7 @@ public:
 
     ir::graph &graph(uint32_t stage) override
     {
+        run_pending_import();
         if (stage > 1)
         {
             std::cout << "2. Optimize target independent..." << std::endl;
@@ -403,11 +459,19 @@ public:
 
     void gencode(std::ostream &output) override
     {
+        if (cached_kmodel_)
+        {
+            output.write(reinterpret_cast<const char *>(cached_kmodel_->data()), cached_kmodel_->size());
+            return;
+        }
+
         std::cout << "8. Generate code..." << std::endl;
         using namespace nncase::schedule;
         using namespace nncase::codegen;
 
         scheduler sch(*target_, graph_, graph_.outputs());
+        if (compile_options_.min_peak_memory_order)
+            sch.config_compute_order(compute_order::min_peak_memory);
         if (compile_options_.dump_ir)
         {
             auto dump_path = compile_options_.dump_dir / "codegen";
@@ -418,12 +482,114 @@ public:
         auto schr = sch.schedule();
         model_builder builder(*target_, schr);
         builder.config_dump(compile_options_.dump_dir, compile_options_.dump_asm);
-        auto result = builder.build(output);
+        build_model_result result;
+        if (cache_key_)
+        {
+            std::stringstream kmodel(std::ios::in | std::ios::out | std::ios::binary);
+            result = builder.build(kmodel);
+            auto data = kmodel.str();
+            output.write(data.data(), data.size());
+            cache_->store(*cache_key_, { reinterpret_cast<const uint8_t *>(data.data()), data.size() });
+        }
+        else
+        {
+            result = builder.build(output);
+        }
 
         dump_summary(graph_, builder, result);
     }
 
 private:
+    struct pending_import
+    {
+        std::vector<uint8_t> model;
+        std::vector<uint8_t> extra;
+        std::vector<std::string> output_arrays;
+        std::function<void(std::span<const uint8_t> model, std::span<const uint8_t> extra, const importer::import_options &options)> import;
+    };
+
+    void import_model(std::string_view format, std::span<const uint8_t> model, std::span<const uint8_t> extra, std::span<const std::string> output_arrays, decltype(pending_import::import) import)
+    {
+        if (cache_)
+        {
+            import_key_.add("format", format);
+            import_key_.add("model", model);
+            import_key_.add("model_extra", extra);
+            import_key_.add("output_arrays", to_cache_value(std::vector<std::string>(output_arrays.begin(), output_arrays.end())));
+        }
+
+        if (!cache_)
+        {
+            run_import(model, extra, output_arrays, import);
+            return;
+        }
+
+        // Importing waits for compile, which skips it on a cache hit
+        pending_import_ = { { model.begin(), model.end() }, { extra.begin(), extra.end() }, { output_arrays.begin(), output_arrays.end() }, std::move(import) };
+    }
+
+    void run_pending_import()
+    {
+        if (pending_import_)
+        {
+            auto pending = std::move(*pending_import_);
+            pending_import_.reset();
+            run_import(pending.model, pending.extra, pending.output_arrays, pending.import);
+        }
+    }
+
+    void run_import(std::span<const uint8_t> model, std::span<const uint8_t> extra, std::span<const std::string> output_arrays, const decltype(pending_import::import) &import)
+    {
+        std::cout << "1. Import graph..." << std::endl;
+        importer::import_options imp_options;
+        imp_options.output_arrays = output_arrays;
+        import(model, extra, imp_options);
+        END_IMPORT()
+    }
+
+    std::optional<compile_cache_key> make_cache_key()
+    {
+        try
+        {
+            auto key = import_key_;
+            key.add("nncase", NNCASE_VERSION NNCASE_VERSION_SUFFIX);
+#define ADD_OPTION(name) key.add(#name, to_cache_value(compile_options_.name))
+            ADD_OPTION(target);
+            ADD_OPTION(use_dataset_as_input_stat);
+            ADD_OPTION(benchmark_only);
+            ADD_OPTION(min_peak_memory_order);
+            ADD_OPTION(preprocess);
+            ADD_OPTION(swapRB);
+            ADD_OPTION(input_type);
+            ADD_OPTION(output_type);
+            ADD_OPTION(quant_type);
+            ADD_OPTION(mean);
+            ADD_OPTION(std);
+            ADD_OPTION(input_range);
+            ADD_OPTION(output_range);
+            ADD_OPTION(letterbox_value);
+            ADD_OPTION(input_shape);
+            ADD_OPTION(w_quant_type);
+            ADD_OPTION(use_mse_quant_w);
+            ADD_OPTION(split_w_to_act);
+            ADD_OPTION(input_layout);
+            ADD_OPTION(output_layout);
+            ADD_OPTION(model_layout);
+#undef ADD_OPTION
+            for (auto &[name, value] : target_->options().cache_values())
+                key.add("target." + name, value);
+            key.add("use_ptq", to_cache_value(use_ptq_));
+            if (use_ptq_)
+                std::visit([&](auto &options) { add_cache_key(key, options); }, ptq_options_);
+            return key;
+        }
+        catch (const std::exception &ex)
+        {
+            std::cerr << "Warning: compilation cache is disabled: " << ex.what() << std::endl;
+            return std::nullopt;
+        }
+    }
+
     void set_target(std::string_view type)
     {
         target_ = plugin_loader::create_target(type);
@@ -565,16 +731,26 @@ private:
         auto sched_result = sched.schedule(true);
         ir::evaluator evaluator(sched_result);
 
-        if (step != eval_step::after_import)
-        {
-            auto calib_method = std::visit([](auto &options) { return to_calibrate_method(options.calibrate_method); }, ptq_options_);
-            evaluator.enable_ptq(*target_, calib_method);
-        }
-        else
-        {
-            auto calib_method = std::visit([](auto &options) { return to_calibrate_method(options.calibrate_method); }, dump_range_options_);
-            evaluator.enable_ptq(*target_, calib_method);
-        }
+        auto calib_method = step != eval_step::after_import
+            ? std::visit([](auto &options) { return to_calibrate_method(options.calibrate_method); }, ptq_options_)
+            : std::visit([](auto &options) { return to_calibrate_method(options.calibrate_method); }, dump_range_options_);
+        evaluator.enable_ptq(*target_, calib_method);
+
+        // Replicas share the schedule but own their pools and quantizers, the first evaluator collects the merged results.
+        std::vector<std::unique_ptr<ir::evaluator>> replicas;
+        auto evaluators = [&](size_t samples) {
+            auto threads = std::clamp(calibrate_threads(), size_t(1), std::max(samples, size_t(1)));
+            while (replicas.size() + 1 < threads)
+            {
+                auto &replica = replicas.emplace_back(std::make_unique<ir::evaluator>(sched_result));
+                replica->enable_ptq(*target_, calib_method);
+            }
+
+            std::vector<ir::evaluator *> result { &evaluator };
+            for (auto &replica : replicas)
+                result.emplace_back(replica.get());
+            return result;
+        };
 
         if (step != eval_step::after_import)
         {
@@ -595,13 +771,13 @@ private:
                 switch (in_type)
                 {
                 case dt_float32:
-                    run_calibration_eval<float, ptq_dataset_options>(options, *ds, evaluator, step);
+                    run_calibration_eval<float, ptq_dataset_options>(options, *ds, evaluators(ds->total_size()), step);
                     break;
                 case dt_uint8:
-                    run_calibration_eval<uint8_t, ptq_dataset_options>(options, *ds, evaluator, step);
+                    run_calibration_eval<uint8_t, ptq_dataset_options>(options, *ds, evaluators(ds->total_size()), step);
                     break;
                 case dt_int8:
-                    run_calibration_eval<int8_t, ptq_dataset_options>(options, *ds, evaluator, step);
+                    run_calibration_eval<int8_t, ptq_dataset_options>(options, *ds, evaluators(ds->total_size()), step);
                     break;
                 default:
                     throw std::runtime_error("Unsupported input datatype: " + std::string(datatype_names(in_type)));
@@ -610,7 +786,7 @@ private:
             else
             {
                 auto &options = std::get<ptq_tensor_options>(ptq_options_);
-                run_calibration_eval<ptq_tensor_options>(options, evaluator, step);
+                run_calibration_eval<ptq_tensor_options>(options, evaluators(options.samples_count), step);
             }
         }
         else
@@ -632,13 +808,13 @@ private:
                 switch (in_type)
                 {
                 case dt_float32:
-                    run_calibration_eval<float, dump_range_dataset_options>(options, *ds, evaluator, step);
+                    run_calibration_eval<float, dump_range_dataset_options>(options, *ds, evaluators(ds->total_size()), step);
                     break;
                 case dt_uint8:
-                    run_calibration_eval<uint8_t, dump_range_dataset_options>(options, *ds, evaluator, step);
+                    run_calibration_eval<uint8_t, dump_range_dataset_options>(options, *ds, evaluators(ds->total_size()), step);
                     break;
                 case dt_int8:
-                    run_calibration_eval<int8_t, dump_range_dataset_options>(options, *ds, evaluator, step);
+                    run_calibration_eval<int8_t, dump_range_dataset_options>(options, *ds, evaluators(ds->total_size()), step);
                     break;
                 default:
                     throw std::runtime_error("Unsupported input datatype: " + std::string(datatype_names(in_type)));
@@ -647,15 +823,86 @@ private:
             else
             {
                 auto &options = std::get<dump_range_tensor_options>(dump_range_options_);
-                run_calibration_eval<dump_range_tensor_options>(options, evaluator, step);
+                run_calibration_eval<dump_range_tensor_options>(options, evaluators(options.samples_count), step);
             }
         }
 
         return evaluator;
     }
 
+    // Every replica copies the constants and owns its memory pools, so running more than one is opt-in.
+    size_t calibrate_threads() const noexcept
+    {
+        if (compile_options_.calibrate_threads)
+            return compile_options_.calibrate_threads;
+        return std::max(std::thread::hardware_concurrency(), 1U);
+    }
+
+    // Runs samples [0, count) on the evaluators concurrently, then merges the records of the replicas into evaluators[0].
+    // `load` fills the inputs of an evaluator with a sample. Calls to it are serialized and made in sample order.
+    template <class TLoad>
+    void run_calibration_samples(std::span<ir::evaluator *const> evaluators, size_t count, eval_step step, size_t stage, TLoad &&load, const std::function<void(size_t cnt, size_t total)> &progress)
+    {
+        std::mutex mutex;
+        size_t next = 0, done = 0;
+        std::exception_ptr error;
+
+        auto worker = [&](ir::evaluator &evaluator) {
+            while (true)
+            {
+                size_t index;
+                try
+                {
+                    {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        if (error || next == count)
+                            return;
+                        index = next++;
+                        load(index, evaluator);
+                    }
+
+                    // Only the first sample's buffers are kept, so only it needs to record them.
+                    evaluator.evaluate(step, stage, compile_options_.dump_quant_error && index == 0);
+                    evaluator.end_sample();
+                }
+                catch (...)
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    if (!error)
+                        error = std::current_exception();
+                    return;
+                }
+
+                std::lock_guard<std::mutex> lock(mutex);
+                if (progress)
+                    progress(done++, count);
+            }
+        };
+
+        std::vector<std::thread> threads;
+        for (size_t i = 1; i < evaluators.size(); i++)
+            threads.emplace_back(worker, std::ref(*evaluators[i]));
+        worker(*evaluators[0]);
+        for (auto &thread : threads)
+            thread.join();
+        if (error)
+            std::rethrow_exception(error);
+
+        for (size_t i = 1; i < evaluators.size(); i++)
+            evaluators[0]->merge_quantizers(*evaluators[i]);
+    }
+
+    void begin_collect_distribution(std::span<ir::evaluator *const> evaluators)
+    {
+        // Histograms are binned over the merged ranges, hand them to the replicas first.
+        for (size_t i = 1; i < evaluators.size(); i++)
+            evaluators[i]->merge_quantizers(*evaluators[0]);
+        for (auto evaluator : evaluators)
+            evaluator->begin_collect_distribution();
+    }
+
     template <class T, class TOpt>
-    void run_calibration_eval(TOpt &options, dataset &dataset, ir::evaluator &evaluator, eval_step step)
+    void run_calibration_eval(TOpt &options, dataset &dataset, std::span<ir::evaluator *const> evaluators, eval_step step)
     {
         std::string step_str = step == nncase::ir::eval_step::after_import ? "1" : (step == nncase::ir::eval_step::after_calib ? "4.2" : "4.4");
         const size_t max_stages = options.calibrate_method == "no_clip" ? 1 : 2;
@@ -669,32 +916,29 @@ private:
             else
             {
                 std::cout << step_str + ".2. Collecting distribution..." << std::endl;
-                evaluator.begin_collect_distribution();
+                begin_collect_distribution(evaluators);
             }
 
-            size_t i = 0;
-            for (auto it = dataset.begin<T>(); it != dataset.end<T>(); ++it)
-            {
-                auto input_buffer = evaluator.input_at(0).buffer();
-                auto &tensor = it->tensor;
-                std::memcpy(input_buffer.data(), tensor.data(), input_buffer.size_bytes());
-
-                evaluator.evaluate(step, stage, compile_options_.dump_quant_error);
-                evaluator.end_sample();
-                if (options.progress)
-                    options.progress(i++, dataset.total_size());
-            }
+            auto it = dataset.begin<T>();
+            run_calibration_samples(
+                evaluators, dataset.total_size(), step, stage, [&](size_t, ir::evaluator &evaluator) {
+                    auto input_buffer = evaluator.input_at(0).buffer();
+                    auto &tensor = it->tensor;
+                    std::memcpy(input_buffer.data(), tensor.data(), input_buffer.size_bytes());
+                    ++it;
+                },
+                options.progress);
 
             if (stage == 1)
             {
                 std::cout << step_str + ".3. Find optimal quantization ranges..." << std::endl;
-                evaluator.end_collect_distribution(options.progress);
+                evaluators[0]->end_collect_distribution(options.progress);
             }
         }
     }
 
     template <class TOpt>
-    void run_calibration_eval(TOpt &options, ir::evaluator &evaluator, eval_step step)
+    void run_calibration_eval(TOpt &options, std::span<ir::evaluator *const> evaluators, eval_step step)
     {
         std::string step_str = step == nncase::ir::eval_step::after_import ? "1" : (step == nncase::ir::eval_step::after_calib ? "4.2" : "4.4");
         const size_t max_stages = options.calibrate_method == "no_clip" ? 1 : 2;
@@ -707,29 +951,25 @@ private:
             else
             {
                 std::cout << step_str + ".2. Collecting distribution..." << std::endl;
-                evaluator.begin_collect_distribution();
+                begin_collect_distribution(evaluators);
             }
 
-            for (size_t i = 0; i < options.samples_count; i++)
-            {
-                uint32_t input_offset = 0;
-                for (uint32_t j = 0; j < evaluator.inputs_size(); j++)
-                {
-                    auto input_buffer = evaluator.input_at(j).buffer();
-                    std::memcpy(input_buffer.data(), options.tensor_data.data() + input_offset + i * input_buffer.size_bytes(), input_buffer.size_bytes());
-                    input_offset += (options.samples_count * input_buffer.size_bytes());
-                }
-
-                evaluator.evaluate(step, stage, compile_options_.dump_quant_error);
-                evaluator.end_sample();
-                if (options.progress)
-                    options.progress(i++, options.samples_count);
-            }
+            run_calibration_samples(
+                evaluators, options.samples_count, step, stage, [&](size_t i, ir::evaluator &evaluator) {
+                    uint32_t input_offset = 0;
+                    for (uint32_t j = 0; j < evaluator.inputs_size(); j++)
+                    {
+                        auto input_buffer = evaluator.input_at(j).buffer();
+                        std::memcpy(input_buffer.data(), options.tensor_data.data() + input_offset + i * input_buffer.size_bytes(), input_buffer.size_bytes());
+                        input_offset += (options.samples_count * input_buffer.size_bytes());
+                    }
+                },
+                options.progress);
 
             if (stage == 1)
             {
                 std::cout << step_str + ".3. Find optimal quantization ranges..." << std::endl;
-                evaluator.end_collect_distribution(options.progress);
+                evaluators[0]->end_collect_distribution(options.progress);
             }
         }
     }
@@ -825,6 +1065,11 @@ private:
     std::string real_inlayout_ = "";
     std::string real_outlayout_ = "";
     quant_param_t output_quant_params_ = { 0, 0 };
+    std::unique_ptr<compile_cache> cache_;
+    compile_cache_key import_key_;
+    std::optional<pending_import> pending_import_;
+    std::optional<compile_cache_key> cache_key_;
+    std::optional<std::vector<uint8_t>> cached_kmodel_;
 };
 }
 
@@ -36,6 +36,12 @@ public:
         interp_.load_model(gsl::as_bytes(gsl::make_span(model_))).unwrap_or_throw();
     }
 
+    simulator_impl(const std::filesystem::path &model_path, const simulate_options &options)
+        : options_(options)
+    {
+        interp_.load_model_from_file(model_path.string().c_str()).unwrap_or_throw();
+    }
+
     void run() override
     {
         if (!std::filesystem::exists(options_.output_path))
@@ -126,3 +132,8 @@ std::unique_ptr<simulator> simulator::create(std::vector<uint8_t> model, const s
 {
     return std::make_unique<simulator_impl>(std::move(model), options);
 }
+
+std::unique_ptr<simulator> simulator::create(const std::filesystem::path &model_path, const simulate_options &options)
+{
+    return std::make_unique<simulator_impl>(model_path, options);
+}
@@ -0,0 +1,126 @@
+/* Copyright 2019-2021 Canaan Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "mapped_file.h"
+#include <nncase/runtime/compiled_model.h>
+#include <nncase/runtime/dbg.h>
+#include <nncase/runtime/error.h>
+#include <nncase/runtime/span_reader.h>
+#ifdef NNCASE_THREAD_POOL
+#include <mutex>
+#endif
+
+using namespace nncase;
+using namespace nncase::runtime;
+
+struct compiled_model::module_states
+{
+#ifdef NNCASE_THREAD_POOL
+    std::mutex lock;
+#endif
+    std::vector<std::shared_ptr<const module_shared_state>> states;
+};
+
+result<std::shared_ptr<const compiled_model>> compiled_model::load(gsl::span<const gsl::byte> buffer) noexcept
+{
+    std::shared_ptr<compiled_model> model(new (std::nothrow) compiled_model());
+    if (!model)
+        return err(std::errc::not_enough_memory);
+    try_(model->parse(buffer));
+    return ok(std::shared_ptr<const compiled_model>(std::move(model)));
+}
+
+result<std::shared_ptr<const compiled_model>> compiled_model::load(std::vector<gsl::byte> buffer) noexcept
+{
+    std::shared_ptr<compiled_model> model(new (std::nothrow) compiled_model());
+    if (!model)
+        return err(std::errc::not_enough_memory);
+    model->storage_ = std::move(buffer);
+    try_(model->parse(model->storage_));
+    return ok(std::shared_ptr<const compiled_model>(std::move(model)));
+}
+
+result<std::shared_ptr<const compiled_model>> compiled_model::load_from_file(const char *path, const model_file_options &options) noexcept
+{
+    std::shared_ptr<compiled_model> model(new (std::nothrow) compiled_model());
+    if (!model)
+        return err(std::errc::not_enough_memory);
+    try_set(model->mapping_, mapped_file::open(path, options));
+    try_(model->parse(model->mapping_->data()));
+    return ok(std::shared_ptr<const compiled_model>(std::move(model)));
+}
+
+compiled_model::compiled_model() = default;
+
+compiled_model::~compiled_model()
+{
+}
+
+const module_type_t &compiled_model::module_type(size_t index) const noexcept
+{
+    assert(index < module_payloads_.size());
+    return *reinterpret_cast<const module_type_t *>(module_payloads_[index].data() + offsetof(module_header, type));
+}
+
+gsl::span<const gsl::byte> compiled_model::module_payload(size_t index) const noexcept
+{
+    assert(index < module_payloads_.size());
+    return module_payloads_[index];
+}
+
+result<std::shared_ptr<const module_shared_state>> compiled_model::module_state(size_t index, const module_shared_state_factory &create) const noexcept
+{
+    CHECK_WITH_ERR(index < module_payloads_.size(), std::errc::result_out_of_range);
+#ifdef NNCASE_THREAD_POOL
+    std::lock_guard<std::mutex> lock(module_states_->lock);
+#endif
+    auto &state = module_states_->states[index];
+    if (!state)
+        try_set(state, create());
+    return ok(state);
+}
+
+result<void> compiled_model::parse(gsl::span<const gsl::byte> buffer) noexcept
+{
+    CHECK_WITH_ERR(buffer.size_bytes() >= sizeof(model_header), std::errc::invalid_argument);
+    span_reader reader(buffer);
+    reader.read(header_);
+    if (header_.identifier != MODEL_IDENTIFIER)
+        return err(nncase_errc::invalid_model_indentifier);
+    if (header_.version != MODEL_VERSION)
+        return err(nncase_errc::invalid_model_version);
+    CHECK_WITH_ERR(header_.entry_module < header_.modules, std::errc::invalid_argument);
+
+    try
+    {
+        module_payloads_.resize(header_.modules);
+        module_states_ = std::make_unique<module_states>();
+        module_states_->states.resize(header_.modules);
+    }
+    catch (...)
+    {
+        return err(std::errc::not_enough_memory);
+    }
+
+    for (auto &payload : module_payloads_)
+    {
+        CHECK_WITH_ERR(reader.avail() >= sizeof(module_header), std::errc::invalid_argument);
+        auto mod_size = reader.peek_with_offset<decltype(module_header::size)>(offsetof(module_header, size));
+        CHECK_WITH_ERR(mod_size <= reader.avail(), std::errc::invalid_argument);
+        payload = reader.read_span(mod_size);
+    }
+
+    buffer_ = buffer;
+    return ok();
+}
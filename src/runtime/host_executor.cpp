@@ -0,0 +1,95 @@
+/* Copyright 2019-2021 Canaan Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "host_executor.h"
+
+using namespace nncase;
+using namespace nncase::runtime;
+
+#ifdef NNCASE_THREAD_POOL
+host_executor::~host_executor()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+
+    task_cv_.notify_all();
+    if (worker_.joinable())
+        worker_.join();
+}
+
+result<void> host_executor::submit(std::function<void()> task) noexcept
+{
+    try
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!worker_.joinable())
+            worker_ = std::thread([this] { worker_main(); });
+        tasks_.emplace_back(std::move(task));
+    }
+    catch (...)
+    {
+        return err(std::errc::resource_unavailable_try_again);
+    }
+
+    task_cv_.notify_one();
+    return ok();
+}
+
+void host_executor::wait_idle() noexcept
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    // A task waiting for itself would never finish.
+    if (worker_.get_id() == std::this_thread::get_id())
+        return;
+    idle_cv_.wait(lock, [this] { return tasks_.empty() && !running_; });
+}
+
+void host_executor::worker_main() noexcept
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true)
+    {
+        // Pending tasks are drained before stopping, so every submitted run completes.
+        task_cv_.wait(lock, [this] { return stop_ || !tasks_.empty(); });
+        if (tasks_.empty())
+            return;
+
+        auto task = std::move(tasks_.front());
+        tasks_.pop_front();
+        running_ = true;
+        lock.unlock();
+        task();
+        lock.lock();
+        running_ = false;
+        if (tasks_.empty())
+            idle_cv_.notify_all();
+    }
+}
+#else
+host_executor::~host_executor()
+{
+}
+
+result<void> host_executor::submit(std::function<void()> task) noexcept
+{
+    task();
+    return ok();
+}
+
+void host_executor::wait_idle() noexcept
+{
+}
+#endif
@@ -0,0 +1,61 @@
+/* Copyright 2019-2021 Canaan Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+#include <functional>
+#include <nncase/runtime/result.h>
+#ifdef NNCASE_THREAD_POOL
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#endif
+
+BEGIN_NS_NNCASE_RUNTIME
+
+/**
+ * @brief Runs submitted tasks one at a time in submission order on a background host thread.
+ *        Without thread support tasks run inline inside submit().
+ */
+class host_executor
+{
+public:
+    host_executor() = default;
+    host_executor(const host_executor &) = delete;
+    host_executor &operator=(const host_executor &) = delete;
+    ~host_executor();
+
+    result<void> submit(std::function<void()> task) noexcept;
+
+    /**
+     * @brief Blocks until every task submitted so far has finished.
+     */
+    void wait_idle() noexcept;
+
+#ifdef NNCASE_THREAD_POOL
+private:
+    void worker_main() noexcept;
+
+private:
+    std::thread worker_;
+    std::mutex mutex_;
+    std::condition_variable task_cv_;
+    std::condition_variable idle_cv_;
+    std::deque<std::function<void()>> tasks_;
+    bool running_ = false;
+    bool stop_ = false;
+#endif
+};
+
+END_NS_NNCASE_RUNTIME
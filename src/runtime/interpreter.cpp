@@ -12,7 +12,10 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  */
+#include "host_executor.h"
+#include <algorithm>
 #include <cassert>
+#include <chrono>
 #include <iostream>
 #include <nncase/runtime/dbg.h>
 #include <nncase/runtime/error.h>
@@ -26,44 +29,68 @@ using namespace nncase::runtime;
 interpreter::interpreter() noexcept
     : entry_function_(nullptr)
 {
+    batch_context_.num_threads = 1;
+}
+
+interpreter::interpreter(interpreter &&) noexcept = default;
+
+interpreter::~interpreter()
+{
+    // Queued runs use modules_, so they must finish before anything else goes away.
+    executor_.reset();
 }
 
 result<void> interpreter::load_model(gsl::span<const gsl::byte> buffer) noexcept
 {
-    span_reader reader(buffer);
-    auto header = reader.get_ref<model_header>();
     // 1. Validate model
-    if (header->identifier != MODEL_IDENTIFIER)
-        return err(nncase_errc::invalid_model_indentifier);
-    if (header->version != MODEL_VERSION)
-        return err(nncase_errc::invalid_model_version);
+    try_var(model, compiled_model::load(buffer));
+    return load_model(std::move(model));
+}
+
+result<void> interpreter::load_model_from_file(const char *path, const model_file_options &options) noexcept
+{
+    try_var(model, compiled_model::load_from_file(path, options));
+    return load_model(std::move(model));
+}
+
+result<void> interpreter::load_model(std::shared_ptr<const compiled_model> model) noexcept
+{
+    CHECK_WITH_ERR(model, std::errc::invalid_argument);
+    auto &header = model->header();
+    wait();
+    entry_function_ = nullptr;
+    modules_.clear();
+    batch_instances_.clear();
+    model_ = std::move(model);
 
-    // 2. Load modules
+    // 2. Load modules, only per-interpreter state is allocated here
     try
     {
-        modules_.resize(header->modules);
+        modules_.resize(header.modules);
     }
     catch (...)
     {
         return err(std::errc::not_enough_memory);
     }
 
-    for (size_t i = 0; i < header->modules; i++)
+    for (size_t i = 0; i < header.modules; i++)
     {
-        auto mod_type = reader.peek_with_offset<decltype(module_header::type)>(offsetof(module_header, type));
-        auto mod_size = reader.peek_with_offset<decltype(module_header::size)>(offsetof(module_header, size));
-        auto payload = reader.read_span(mod_size);
-        try_var(rt_module, runtime_module::create(mod_type));
-
-        try_(rt_module->initialize(payload, *this));
-        if (i == header->entry_module)
-            try_set(entry_function_, rt_module->find_function_by_id(header->entry_function));
+        try_var(rt_module, runtime_module::create(model_->module_type(i)));
+
+        try_(rt_module->initialize(i, *this));
+        if (i == header.entry_module)
+            try_set(entry_function_, rt_module->find_function_by_id(header.entry_function));
         modules_[i] = std::move(rt_module);
     }
 
     return ok();
 }
 
+const std::shared_ptr<const compiled_model> &interpreter::model() const noexcept
+{
+    return model_;
+}
+
 size_t interpreter::inputs_size() const noexcept
 {
     return entry_function_->inputs_size();
@@ -116,9 +143,165 @@ result<void> interpreter::output_tensor(size_t index, runtime_tensor tensor) noe
 
 result<void> interpreter::run() noexcept
 {
+    wait();
+    if (entry_function_->double_buffered())
+        try_(entry_function_->swap_buffers());
     return entry_function_->invoke();
 }
 
+result<void> interpreter::run_async(std::function<void(result<void>)> callback) noexcept
+{
+    CHECK_WITH_ERR(entry_function_, std::errc::invalid_argument);
+    if (!executor_)
+    {
+        executor_.reset(new (std::nothrow) host_executor());
+        CHECK_WITH_ERR(executor_, std::errc::not_enough_memory);
+    }
+
+    // Swapping here rather than on the worker means the back buffers handed
+    // out afterwards are never the ones this run reads or writes.
+    if (entry_function_->double_buffered())
+    {
+        wait();
+        try_(entry_function_->swap_buffers());
+    }
+
+    auto function = entry_function_;
+    return executor_->submit([function, callback = std::move(callback)] {
+        auto ret = function->invoke();
+        if (callback)
+            callback(std::move(ret));
+    });
+}
+
+void interpreter::wait() noexcept
+{
+    if (executor_)
+        executor_->wait_idle();
+}
+
+void interpreter::double_buffered(bool enable) noexcept
+{
+    wait();
+    entry_function_->double_buffered(enable);
+}
+
+bool interpreter::double_buffered() const noexcept
+{
+    return entry_function_->double_buffered();
+}
+
+result<void> interpreter::run_batch(gsl::span<const runtime_tensor> inputs, gsl::span<const runtime_tensor> outputs, batch_run_stats *stats) noexcept
+{
+    CHECK_WITH_ERR(entry_function_, std::errc::invalid_argument);
+    wait();
+    auto count = inputs_size() ? inputs.size() / inputs_size() : outputs.size() / std::max(outputs_size(), size_t(1));
+    try_(check_batch_tensors(inputs, count, true));
+    try_(check_batch_tensors(outputs, count, false));
+
+    if (stats)
+    {
+        try
+        {
+            stats->latencies.assign(count, 0.);
+        }
+        catch (...)
+        {
+            return err(std::errc::not_enough_memory);
+        }
+    }
+
+    size_t instances = 1;
+    auto option = options_.get<int32_t>("batch_instances");
+    if (option.is_ok() && option.unwrap() > 1)
+        instances = std::max(std::min((size_t)option.unwrap(), count), size_t(1));
+    try_(prepare_batch_instances(instances));
+
+    auto run_samples = [&](interpreter &interp, size_t begin, size_t end) -> result<void> {
+        for (size_t i = begin; i < end; i++)
+        {
+            auto start = std::chrono::steady_clock::now();
+            try_(interp.entry_function_->invoke_prechecked(inputs.subspan(i * inputs_size(), inputs_size()),
+                outputs.subspan(i * outputs_size(), outputs_size())));
+            if (stats)
+                stats->latencies[i] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        }
+
+        return ok();
+    };
+
+    // Each instance owns a contiguous run of samples. Kernels called from
+    // these workers run inline, so instances don't oversubscribe the cores.
+    auto start = std::chrono::steady_clock::now();
+    batch_context_.num_threads = (uint32_t)instances;
+    auto ret = kernels::try_parallel_for(batch_context_, instances, 1, [&](size_t begin, size_t end) -> result<void> {
+        for (size_t instance = begin; instance < end; instance++)
+        {
+            auto &interp = instance ? *batch_instances_[instance - 1] : *this;
+            try_(run_samples(interp, count * instance / instances, count * (instance + 1) / instances));
+        }
+
+        return ok();
+    });
+
+    // Instances profile into their own profilers, so they never write this one concurrently.
+    for (size_t instance = 1; instance < instances; instance++)
+    {
+        auto &instance_profiler = batch_instances_[instance - 1]->profiler_;
+        auto merged = profiler_.merge(instance_profiler, (uint32_t)instance);
+        instance_profiler.clear();
+        if (ret.is_ok() && merged.is_err())
+            ret = std::move(merged);
+    }
+
+    try_(ret);
+
+    if (stats)
+        stats->total = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return ok();
+}
+
+result<void> interpreter::check_batch_tensors(gsl::span<const runtime_tensor> tensors, size_t count, bool is_input) noexcept
+{
+    auto per_sample = is_input ? inputs_size() : outputs_size();
+    CHECK_WITH_ERR(tensors.size() == count * per_sample, std::errc::invalid_argument);
+
+    for (size_t i = 0; i < tensors.size(); i++)
+    {
+        auto &tensor = tensors[i];
+        auto index = i % per_sample;
+        auto &desc = is_input ? input_desc(index) : output_desc(index);
+        auto &shape = is_input ? input_shape(index) : output_shape(index);
+        CHECK_WITH_ERR(!tensor.empty(), std::errc::invalid_argument);
+        CHECK_WITH_ERR(tensor.datatype() == desc.datatype, nncase_errc::datatype_mismatch);
+        CHECK_WITH_ERR(tensor.shape() == shape, nncase_errc::shape_mismatch);
+    }
+
+    return ok();
+}
+
+result<void> interpreter::prepare_batch_instances(size_t count) noexcept
+{
+    try
+    {
+        while (batch_instances_.size() + 1 < count)
+        {
+            auto instance = std::make_unique<interpreter>();
+            try_(instance->load_model(model_));
+            batch_instances_.emplace_back(std::move(instance));
+        }
+
+        for (auto &instance : batch_instances_)
+            instance->options_ = options_;
+    }
+    catch (...)
+    {
+        return err(std::errc::not_enough_memory);
+    }
+
+    return ok();
+}
+
 result<runtime_module *> interpreter::find_module_by_id(size_t index) noexcept
 {
     CHECK_WITH_ERR(index < modules_.size(), std::errc::result_out_of_range);
@@ -129,3 +312,8 @@ options_dict &interpreter::options() noexcept
 {
     return options_;
 }
+
+op_profiler &interpreter::profiler() noexcept
+{
+    return profiler_;
+}
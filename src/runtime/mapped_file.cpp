@@ -0,0 +1,177 @@
+/* Copyright 2019-2021 Canaan Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "mapped_file.h"
+#include <cerrno>
+#include <nncase/runtime/dbg.h>
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#elif defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#include <cstdio>
+#endif
+
+using namespace nncase;
+using namespace nncase::runtime;
+
+#if !defined(_WIN32)
+namespace
+{
+std::error_condition last_error() noexcept
+{
+    return std::error_condition(errno, std::generic_category());
+}
+}
+#endif
+
+#if defined(_WIN32)
+result<std::unique_ptr<mapped_file>> mapped_file::open(const char *path, NNCASE_UNUSED const model_file_options &options) noexcept
+{
+    std::unique_ptr<mapped_file> file(new (std::nothrow) mapped_file());
+    if (!file)
+        return err(std::errc::not_enough_memory);
+
+    auto handle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (handle == INVALID_HANDLE_VALUE)
+        return err(std::errc::no_such_file_or_directory);
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(handle, &size) || size.QuadPart == 0)
+    {
+        CloseHandle(handle);
+        return err(std::errc::invalid_argument);
+    }
+
+    // The view keeps the mapping object alive, so both handles can be closed right away.
+    auto mapping = CreateFileMappingA(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(handle);
+    if (!mapping)
+        return err(std::errc::io_error);
+    auto view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+    if (!view)
+        return err(std::errc::not_enough_memory);
+
+    file->data_ = reinterpret_cast<const gsl::byte *>(view);
+    file->size_ = (size_t)size.QuadPart;
+    return ok(std::move(file));
+}
+
+mapped_file::~mapped_file()
+{
+    if (data_)
+        UnmapViewOfFile(data_);
+}
+#elif defined(__unix__) || defined(__APPLE__)
+result<std::unique_ptr<mapped_file>> mapped_file::open(const char *path, const model_file_options &options) noexcept
+{
+    std::unique_ptr<mapped_file> file(new (std::nothrow) mapped_file());
+    if (!file)
+        return err(std::errc::not_enough_memory);
+
+    auto fd = ::open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return err(last_error());
+
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+    {
+        auto error = last_error();
+        ::close(fd);
+        return err(error);
+    }
+
+    if (st.st_size == 0)
+    {
+        ::close(fd);
+        return err(std::errc::invalid_argument);
+    }
+
+    // A shared read-only mapping is backed by the page cache, so every process
+    // mapping the same kmodel reads the same physical weight pages.
+    auto size = (size_t)st.st_size;
+    auto addr = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    auto map_error = last_error();
+    ::close(fd);
+    if (addr == MAP_FAILED)
+        return err(map_error);
+
+    // Hints only: failures leave the mapping usable.
+    if (options.prefetch)
+        madvise(addr, size, MADV_WILLNEED);
+#ifdef MADV_HUGEPAGE
+    if (options.huge_pages)
+        madvise(addr, size, MADV_HUGEPAGE);
+#endif
+
+    file->data_ = reinterpret_cast<const gsl::byte *>(addr);
+    file->size_ = size;
+    return ok(std::move(file));
+}
+
+mapped_file::~mapped_file()
+{
+    if (data_)
+        munmap(const_cast<gsl::byte *>(data_), size_);
+}
+#else
+result<std::unique_ptr<mapped_file>> mapped_file::open(const char *path, NNCASE_UNUSED const model_file_options &options) noexcept
+{
+    std::unique_ptr<mapped_file> file(new (std::nothrow) mapped_file());
+    if (!file)
+        return err(std::errc::not_enough_memory);
+
+    auto stream = std::fopen(path, "rb");
+    if (!stream)
+        return err(last_error());
+
+    long size = -1;
+    if (std::fseek(stream, 0, SEEK_END) == 0)
+        size = std::ftell(stream);
+    if (size <= 0 || std::fseek(stream, 0, SEEK_SET) != 0)
+    {
+        std::fclose(stream);
+        return err(std::errc::invalid_argument);
+    }
+
+    file->buffer_.reset(new (std::nothrow) gsl::byte[(size_t)size]);
+    if (!file->buffer_)
+    {
+        std::fclose(stream);
+        return err(std::errc::not_enough_memory);
+    }
+
+    auto read = std::fread(file->buffer_.get(), 1, (size_t)size, stream);
+    std::fclose(stream);
+    CHECK_WITH_ERR(read == (size_t)size, std::errc::io_error);
+
+    file->data_ = file->buffer_.get();
+    file->size_ = (size_t)size;
+    return ok(std::move(file));
+}
+
+mapped_file::~mapped_file()
+{
+}
+#endif
@@ -0,0 +1,47 @@
+/* Copyright 2019-2021 Canaan Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+#include <memory>
+#include <nncase/runtime/compiled_model.h>
+
+BEGIN_NS_NNCASE_RUNTIME
+
+/**
+ * @brief A read-only view of a whole file. Memory-mapped where the platform supports it,
+ *        otherwise read into a heap buffer.
+ */
+class mapped_file
+{
+public:
+    static result<std::unique_ptr<mapped_file>> open(const char *path, const model_file_options &options) noexcept;
+
+    mapped_file(const mapped_file &) = delete;
+    mapped_file &operator=(const mapped_file &) = delete;
+    ~mapped_file();
+
+    gsl::span<const gsl::byte> data() const noexcept { return { data_, size_ }; }
+
+private:
+    mapped_file() = default;
+
+private:
+    const gsl::byte *data_ = nullptr;
+    size_t size_ = 0;
+#if !(defined(_WIN32) || defined(__unix__) || defined(__APPLE__))
+    std::unique_ptr<gsl::byte[]> buffer_;
+#endif
+};
+
+END_NS_NNCASE_RUNTIME
@@ -0,0 +1,270 @@
+/* Copyright 2019-2021 Canaan Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <nncase/runtime/datatypes.h>
+#include <nncase/runtime/dbg.h>
+#include <nncase/runtime/debug.h>
+#include <nncase/runtime/error.h>
+#include <nncase/runtime/profiler.h>
+#include <string>
+#include <unordered_map>
+
+using namespace nncase;
+using namespace nncase::runtime;
+
+namespace
+{
+// Restores the caller's formatting once the export is done.
+class format_guard
+{
+public:
+    explicit format_guard(std::ostream &stream)
+        : stream_(stream), flags_(stream.flags()), precision_(stream.precision())
+    {
+    }
+
+    ~format_guard()
+    {
+        stream_.flags(flags_);
+        stream_.precision(precision_);
+    }
+
+private:
+    std::ostream &stream_;
+    std::ios_base::fmtflags flags_;
+    std::streamsize precision_;
+};
+
+void write_shape(std::ostream &stream, const runtime_shape_t &shape, char separator)
+{
+    for (size_t i = 0; i < shape.size(); i++)
+    {
+        if (i)
+            stream << separator;
+        stream << shape[i];
+    }
+}
+}
+
+op_profiler::op_profiler() noexcept
+    : epoch_(std::chrono::steady_clock::now())
+{
+}
+
+double op_profiler::now() const noexcept
+{
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - epoch_).count();
+}
+
+void op_profiler::clear() noexcept
+{
+    records_.clear();
+    recording_ = false;
+    epoch_ = std::chrono::steady_clock::now();
+}
+
+void op_profiler::begin(const char *name, uintptr_t pc) noexcept
+{
+    try
+    {
+        records_.push_back({ name, pc, 0, 0 });
+        recording_ = true;
+    }
+    catch (...)
+    {
+        recording_ = false;
+        return;
+    }
+
+    records_.back().start = now();
+}
+
+void op_profiler::end() noexcept
+{
+    if (recording_)
+    {
+        auto &record = records_.back();
+        record.duration = now() - record.start;
+        recording_ = false;
+    }
+}
+
+void op_profiler::details(datatype_t datatype, const runtime_shape_t &in_shape, const runtime_shape_t &out_shape, uint64_t bytes, uint64_t flops) noexcept
+{
+    if (!recording_)
+        return;
+
+    auto &record = records_.back();
+    try
+    {
+        record.in_shape = in_shape;
+        record.out_shape = out_shape;
+    }
+    catch (...)
+    {
+        return;
+    }
+
+    record.has_details = true;
+    record.datatype = datatype;
+    record.bytes = bytes;
+    record.flops = flops;
+}
+
+result<void> op_profiler::merge(const op_profiler &other, uint32_t thread) noexcept
+{
+    auto offset = std::chrono::duration<double, std::micro>(other.epoch_ - epoch_).count();
+    auto middle = records_.size();
+    try
+    {
+        records_.insert(records_.end(), other.records_.begin(), other.records_.end());
+    }
+    catch (...)
+    {
+        records_.erase(records_.begin() + middle, records_.end());
+        return err(std::errc::not_enough_memory);
+    }
+
+    for (auto it = records_.begin() + middle; it != records_.end(); ++it)
+    {
+        it->start += offset;
+        it->thread = thread;
+    }
+
+    std::inplace_merge(records_.begin(), records_.begin() + middle, records_.end(), [](auto &lhs, auto &rhs) { return lhs.start < rhs.start; });
+    return ok();
+}
+
+void op_profiler::write_chrome_trace(std::ostream &stream) const
+{
+    format_guard guard(stream);
+    stream << std::fixed << std::setprecision(3);
+    stream << "{\"traceEvents\":[";
+    for (size_t i = 0; i < records_.size(); i++)
+    {
+        auto &record = records_[i];
+        stream << (i ? ",\n" : "\n")
+               << "{\"name\":\"" << record.name << "\",\"cat\":\"op\",\"ph\":\"X\",\"pid\":0,\"tid\":" << record.thread
+               << ",\"ts\":" << record.start << ",\"dur\":" << record.duration
+               << ",\"args\":{\"pc\":" << record.pc;
+        if (record.has_details)
+        {
+            stream << ",\"datatype\":\"" << datatype_names(record.datatype) << "\",\"in_shape\":\"[";
+            write_shape(stream, record.in_shape, ',');
+            stream << "]\",\"out_shape\":\"[";
+            write_shape(stream, record.out_shape, ',');
+            stream << "]\",\"bytes\":" << record.bytes << ",\"flops\":" << record.flops;
+        }
+
+        stream << "}}";
+    }
+
+    stream << "\n],\"displayTimeUnit\":\"ms\"}\n";
+}
+
+void op_profiler::write_csv(std::ostream &stream) const
+{
+    format_guard guard(stream);
+    stream << std::fixed << std::setprecision(3);
+    stream << "name,pc,start_us,duration_us,datatype,in_shape,out_shape,bytes,flops\n";
+    for (auto &record : records_)
+    {
+        stream << record.name << ',' << record.pc << ',' << record.start << ',' << record.duration << ',';
+        if (record.has_details)
+        {
+            stream << datatype_names(record.datatype) << ',';
+            write_shape(stream, record.in_shape, 'x');
+            stream << ',';
+            write_shape(stream, record.out_shape, 'x');
+            stream << ',' << record.bytes << ',' << record.flops;
+        }
+        else
+        {
+            stream << ",,,,";
+        }
+
+        stream << '\n';
+    }
+}
+
+void op_profiler::write_summary(std::ostream &stream) const
+{
+    struct op_total
+    {
+        double time = 0;
+        size_t count = 0;
+    };
+
+    format_guard guard(stream);
+    double total = 0;
+    std::unordered_map<std::string, op_total> totals;
+    for (auto &record : records_)
+    {
+        auto &op = totals[record.name];
+        op.time += record.duration;
+        op.count++;
+        total += record.duration;
+    }
+
+    std::vector<std::pair<std::string, op_total>> ops(totals.begin(), totals.end());
+    std::sort(ops.begin(), ops.end(), [](auto &a, auto &b) { return a.second.time > b.second.time; });
+
+    stream << std::setw(32) << std::left << "op" << std::setw(12) << std::left << "timing(ms)"
+           << std::setw(10) << std::left << "count" << std::setw(12) << std::left << "percent(%)" << std::endl;
+    for (auto &op : ops)
+    {
+        stream << std::setw(32) << std::left << op.first << std::setw(12) << std::left << op.second.time / 1000
+               << std::setw(10) << std::left << op.second.count
+               << std::setw(12) << std::left << (total > 0 ? op.second.time / total * 100 : 0) << std::endl;
+    }
+
+    stream << std::setw(32) << std::left << "total" << std::setw(12) << std::left << total / 1000 << std::endl;
+}
+
+result<void> op_profiler::save_chrome_trace(const char *path) const noexcept
+{
+    try
+    {
+        std::ofstream file(path);
+        CHECK_WITH_ERR(file.good(), std::errc::io_error);
+        write_chrome_trace(file);
+        CHECK_WITH_ERR(file.good(), std::errc::io_error);
+    }
+    catch (...)
+    {
+        return err(std::errc::io_error);
+    }
+
+    return ok();
+}
+
+result<void> op_profiler::save_csv(const char *path) const noexcept
+{
+    try
+    {
+        std::ofstream file(path);
+        CHECK_WITH_ERR(file.good(), std::errc::io_error);
+        write_csv(file);
+        CHECK_WITH_ERR(file.good(), std::errc::io_error);
+    }
+    catch (...)
+    {
+        return err(std::errc::io_error);
+    }
+
+    return ok();
+}
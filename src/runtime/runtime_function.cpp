@@ -146,11 +146,51 @@ result<void> runtime_function::initialize(gsl::span<const gsl::byte> payload, ru
 
 result<runtime_tensor> runtime_function::input_tensor(size_t index) noexcept
 {
+    if (double_buffered_)
+    {
+        CHECK_WITH_ERR(index < input_tensors_.size(), std::errc::result_out_of_range);
+        auto &info = input_tensors_[index];
+        {
+            std::lock_guard<std::mutex> lock(buffers_lock_);
+            if (!info.next_tensor.empty())
+                return ok(info.next_tensor);
+        }
+
+        // Allocate unlocked, another caller may have installed a tensor meanwhile.
+        try_var(tensor, allocate_input_tensor(index));
+        std::lock_guard<std::mutex> lock(buffers_lock_);
+        if (info.next_tensor.empty())
+            info.next_tensor = std::move(tensor);
+        return ok(info.next_tensor);
+    }
+
     INOUT_TENSOR_GETTER_IMPL(input);
 }
 
 result<runtime_tensor> runtime_function::output_tensor(size_t index) noexcept
 {
+    if (double_buffered_)
+    {
+        CHECK_WITH_ERR(index < output_tensors_.size(), std::errc::result_out_of_range);
+        auto &info = output_tensors_[index];
+        {
+            std::lock_guard<std::mutex> lock(buffers_lock_);
+            if (!info.done_tensor.empty())
+                return ok(info.done_tensor);
+            if (!info.next_tensor.empty())
+                return ok(info.next_tensor);
+        }
+
+        // Allocate unlocked, another caller may have installed a tensor meanwhile.
+        try_var(tensor, allocate_output_tensor(index));
+        std::lock_guard<std::mutex> lock(buffers_lock_);
+        if (!info.done_tensor.empty())
+            return ok(info.done_tensor);
+        if (info.next_tensor.empty())
+            info.next_tensor = std::move(tensor);
+        return ok(info.next_tensor);
+    }
+
     INOUT_TENSOR_GETTER_IMPL(output);
 }
 
@@ -187,6 +227,19 @@ result<void> runtime_function::input_tensor(size_t index, runtime_tensor tensor)
     CHECK_WITH_ERR(info.range.datatype == tensor.datatype(), nncase_errc::datatype_mismatch);
     CHECK_WITH_ERR(info.shape == tensor.shape(), nncase_errc::shape_mismatch);
 
+    if (double_buffered_)
+    {
+        std::lock_guard<std::mutex> lock(buffers_lock_);
+        info.next_tensor = tensor;
+        return ok();
+    }
+
+    return bind_input_tensor(index, tensor);
+}
+
+result<void> runtime_function::bind_input_tensor(size_t index, runtime_tensor tensor) noexcept
+{
+    auto &info = input_tensors_[index];
     if (info.bind_tensor != tensor)
     {
         if (validate_input_tensor(index, tensor).is_err())
@@ -226,6 +279,19 @@ result<void> runtime_function::output_tensor(size_t index, runtime_tensor tensor
     CHECK_WITH_ERR(info.range.datatype == tensor.datatype(), nncase_errc::datatype_mismatch);
     CHECK_WITH_ERR(info.shape == tensor.shape(), nncase_errc::shape_mismatch);
 
+    if (double_buffered_)
+    {
+        std::lock_guard<std::mutex> lock(buffers_lock_);
+        info.next_tensor = tensor;
+        return ok();
+    }
+
+    return bind_output_tensor(index, tensor);
+}
+
+result<void> runtime_function::bind_output_tensor(size_t index, runtime_tensor tensor) noexcept
+{
+    auto &info = output_tensors_[index];
     if (info.bind_tensor != tensor)
     {
         if (validate_output_tensor(index, tensor).is_err())
@@ -256,6 +322,76 @@ result<void> runtime_function::output_tensor(size_t index, runtime_tensor tensor
     return ok();
 }
 
+void runtime_function::double_buffered(bool enable) noexcept
+{
+    std::lock_guard<std::mutex> lock(buffers_lock_);
+    for (auto &info : input_tensors_)
+    {
+        info.next_tensor.reset();
+        info.done_tensor.reset();
+    }
+
+    for (auto &info : output_tensors_)
+    {
+        info.next_tensor.reset();
+        info.done_tensor.reset();
+    }
+
+    double_buffered_ = enable;
+}
+
+bool runtime_function::double_buffered() const noexcept
+{
+    return double_buffered_;
+}
+
+result<void> runtime_function::swap_buffers() noexcept
+{
+    // The back buffer becomes the front one and the old front is handed back
+    // for the caller to fill, unless something else was staged meanwhile.
+    // An input with nothing staged keeps its binding, an output always moves
+    // on so the previous results are left alone.
+    for (size_t i = 0; i < input_tensors_.size(); i++)
+    {
+        auto &info = input_tensors_[i];
+        runtime_tensor next;
+        {
+            std::lock_guard<std::mutex> lock(buffers_lock_);
+            std::swap(next, info.next_tensor);
+        }
+
+        if (next.empty())
+            continue;
+        auto front = info.bind_tensor;
+        try_(bind_input_tensor(i, next));
+
+        std::lock_guard<std::mutex> lock(buffers_lock_);
+        if (info.next_tensor.empty())
+            info.next_tensor = front;
+    }
+
+    for (size_t i = 0; i < output_tensors_.size(); i++)
+    {
+        auto &info = output_tensors_[i];
+        runtime_tensor next;
+        {
+            std::lock_guard<std::mutex> lock(buffers_lock_);
+            std::swap(next, info.next_tensor);
+        }
+
+        if (next.empty())
+            try_set(next, allocate_output_tensor(i));
+        auto front = info.bind_tensor;
+        try_(bind_output_tensor(i, next));
+
+        std::lock_guard<std::mutex> lock(buffers_lock_);
+        if (info.next_tensor.empty())
+            info.next_tensor = front;
+    }
+
+    return ok();
+}
+
 result<void> runtime_function::invoke() noexcept
 {
     // 1. Ensure bindings
@@ -306,5 +442,47 @@ result<void> runtime_function::invoke() noexcept
         }
     }
 
+    if (double_buffered_)
+    {
+        std::lock_guard<std::mutex> lock(buffers_lock_);
+        for (auto &out : output_tensors_)
+            out.done_tensor = out.bind_tensor;
+    }
+
     return ok();
 }
+
+result<void> runtime_function::invoke(gsl::span<const runtime_tensor> inputs, gsl::span<const runtime_tensor> outputs) noexcept
+{
+    CHECK_WITH_ERR(inputs.size() == input_tensors_.size(), std::errc::invalid_argument);
+    CHECK_WITH_ERR(outputs.size() == output_tensors_.size(), std::errc::invalid_argument);
+
+    for (size_t i = 0; i < inputs.size(); i++)
+    {
+        if (double_buffered_ || input_tensors_[i].bind_tensor != inputs[i])
+            try_(input_tensor(i, inputs[i]));
+    }
+
+    for (size_t i = 0; i < outputs.size(); i++)
+    {
+        if (double_buffered_ || output_tensors_[i].bind_tensor != outputs[i])
+            try_(output_tensor(i, outputs[i]));
+    }
+
+    if (double_buffered_)
+        try_(swap_buffers());
+    return invoke();
+}
+
+result<void> runtime_function::invoke_prechecked(gsl::span<const runtime_tensor> inputs, gsl::span<const runtime_tensor> outputs) noexcept
+{
+    // Back buffers are handed over under the buffers lock, leave that to the checked path.
+    if (double_buffered_)
+        return invoke(inputs, outputs);
+
+    for (size_t i = 0; i < inputs.size(); i++)
+        try_(bind_input_tensor(i, inputs[i]));
+    for (size_t i = 0; i < outputs.size(); i++)
+        try_(bind_output_tensor(i, outputs[i]));
+    return invoke();
+}
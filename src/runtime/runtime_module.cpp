@@ -15,6 +15,7 @@
 #include "section.h"
 #include <nncase/runtime/dbg.h>
 #include <nncase/runtime/error.h>
+#include <nncase/runtime/interpreter.h>
 #include <nncase/runtime/runtime_module.h>
 #include <nncase/runtime/span_reader.h>
 
@@ -26,8 +27,8 @@ namespace
 class runtime_module_init_context_impl : public runtime_module_init_context
 {
 public:
-    runtime_module_init_context_impl(const module_header &header, interpreter &interp, gsl::span<const gsl::byte> sections) noexcept
-        : header_(header), interp_(interp), sections_(sections)
+    runtime_module_init_context_impl(const module_header &header, interpreter &interp, size_t index, gsl::span<const gsl::byte> sections) noexcept
+        : header_(header), interp_(interp), index_(index), sections_(sections)
     {
     }
 
@@ -51,9 +52,15 @@ public:
         return find_section(name, sections_);
     }
 
+    result<std::shared_ptr<const module_shared_state>> shared_state(const module_shared_state_factory &create) noexcept override
+    {
+        return interp_.model()->module_state(index_, create);
+    }
+
 private:
     const module_header &header_;
     interpreter &interp_;
+    size_t index_;
     gsl::span<const gsl::byte> sections_;
 };
 
@@ -102,10 +109,10 @@ mempool_desc runtime_module::mempool(memory_location_t location) const noexcept
     return desc;
 }
 
-result<void> runtime_module::initialize(gsl::span<const gsl::byte> payload, interpreter &interp) noexcept
+result<void> runtime_module::initialize(size_t index, interpreter &interp) noexcept
 {
     interp_ = &interp;
-    span_reader reader(payload);
+    span_reader reader(interp.model()->module_payload(index));
     reader.read(header_);
 
     try
@@ -128,7 +135,7 @@ result<void> runtime_module::initialize(gsl::span<const gsl::byte> payload, inte
         reader.read(desc);
 
     span_reader func_reader(read_functions(reader, header_.functions));
-    runtime_module_init_context_impl init_context(header_, interp, read_sections(reader, header_.sections));
+    runtime_module_init_context_impl init_context(header_, interp, index, read_sections(reader, header_.sections));
     try_(initialize_before_functions(init_context));
 
     for (size_t i = 0; i < header_.functions; i++)
@@ -389,3 +389,8 @@ result<void> stackvm_runtime_function::visit(const stpaddings_op_t &op) noexcept
 
     return module().paddings_reg(op.rpaddings, std::move(paddings));
 }
+
+result<void> stackvm_runtime_function::visit(const ldshape_op_t &op) noexcept
+{
+    return module().bind_shape_reg(op.rshape, op.index);
+}
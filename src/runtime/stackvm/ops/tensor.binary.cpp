@@ -16,6 +16,7 @@
 #include <iostream>
 #include <nncase/kernels/tensor_compute.h>
 #include <nncase/runtime/debug.h>
+#include <nncase/runtime/runtime_op_utility.h>
 
 using namespace nncase;
 using namespace nncase::runtime;
@@ -26,12 +27,16 @@ result<void> stackvm_runtime_function::visit(const tensor_binary_op_t &op) noexc
     try_var(output, pop_addr());
     try_var(input_b, pop_addr());
     try_var(input_a, pop_addr());
-    try_var(in_a_shape, module().shape_reg(op.rshape_src1));
-    try_var(in_a_strides, module().shape_reg(op.rstride_src1));
-    try_var(in_b_shape, module().shape_reg(op.rshape_src2));
-    try_var(in_b_strides, module().shape_reg(op.rstride_src2));
-    try_var(out_shape, module().shape_reg(op.rshape_dest));
-    try_var(out_strides, module().shape_reg(op.rstride_dest));
+    try_ref(in_a_shape, module().shape_reg(op.rshape_src1));
+    try_ref(in_a_strides, module().shape_reg(op.rstride_src1));
+    try_ref(in_b_shape, module().shape_reg(op.rshape_src2));
+    try_ref(in_b_strides, module().shape_reg(op.rstride_src2));
+    try_ref(out_shape, module().shape_reg(op.rshape_dest));
+    try_ref(out_strides, module().shape_reg(op.rstride_dest));
+
+    if (profiling())
+        profile_details(op.datatype, in_a_shape, out_shape,
+            get_bytes(op.datatype) * (compute_size(in_a_shape) + compute_size(in_b_shape) + compute_size(out_shape)), compute_size(out_shape));
 
     switch (op.datatype)
     {
@@ -28,9 +28,9 @@ result<void> stackvm_runtime_function::visit(const tensor_call_op_t &op) noexcep
 
     auto create_tensor = [&]() -> result<runtime_tensor> {
         try_var(rstrides, stack_.pop());
-        try_var(strides, module().shape_reg(rstrides.as_u4()));
+        try_ref(strides, module().shape_reg(rstrides.as_u4()));
         try_var(rshape, stack_.pop());
-        try_var(shape, module().shape_reg(rshape.as_u4()));
+        try_ref(shape, module().shape_reg(rshape.as_u4()));
         try_var(e_datatype, stack_.pop());
         try_var(addr, pop_addr());
 
@@ -14,6 +14,8 @@
  */
 #include "../runtime_function.h"
 #include <nncase/kernels/convolution.h>
+#include <nncase/kernels/kernel_utils.h>
+#include <nncase/runtime/runtime_op_utility.h>
 
 using namespace nncase;
 using namespace nncase::runtime;
@@ -27,12 +29,22 @@ result<void> stackvm_runtime_function::visit(const tensor_conv2d_op_t &op) noexc
     try_var(bias, pop_addr());
     try_var(weights, pop_addr());
     try_var(input, pop_addr());
-    try_var(in_shape, module().shape_reg(op.rshape_src));
-    try_var(in_strides, module().shape_reg(op.rstride_src));
-    try_var(w_shape, module().shape_reg(op.rshape_kernel));
-    try_var(w_strides, module().shape_reg(op.rstride_kernel));
-    try_var(bias_strides, module().shape_reg(op.rstride_bias));
-    try_var(out_strides, module().shape_reg(op.rstride_dest));
+    try_ref(in_shape, module().shape_reg(op.rshape_src));
+    try_ref(in_strides, module().shape_reg(op.rstride_src));
+    try_ref(w_shape, module().shape_reg(op.rshape_kernel));
+    try_ref(w_strides, module().shape_reg(op.rstride_kernel));
+    try_ref(bias_strides, module().shape_reg(op.rstride_bias));
+    try_ref(out_strides, module().shape_reg(op.rstride_dest));
+
+    if (profiling())
+    {
+        runtime_shape_t out_shape { in_shape[0], w_shape[0],
+            kernels::detail::get_windowed_output_size(in_shape[2], (int32_t)w_shape[2], op.stride_h, op.dilation_h, padding_h),
+            kernels::detail::get_windowed_output_size(in_shape[3], (int32_t)w_shape[3], op.stride_w, op.dilation_w, padding_w) };
+        profile_details(op.datatype, in_shape, out_shape,
+            get_bytes(op.datatype) * (compute_size(in_shape) + compute_size(w_shape) + w_shape[0] + compute_size(out_shape)),
+            2 * compute_size(out_shape) * w_shape[1] * w_shape[2] * w_shape[3]);
+    }
 
     if (op.datatype != dt_float32)
         return err(nncase_errc::datatype_mismatch);
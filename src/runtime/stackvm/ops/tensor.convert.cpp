@@ -14,6 +14,7 @@
  */
 #include "../runtime_function.h"
 #include <nncase/kernels/tensor_compute.h>
+#include <nncase/runtime/runtime_op_utility.h>
 
 using namespace nncase;
 using namespace nncase::runtime;
@@ -23,9 +24,12 @@ result<void> stackvm_runtime_function::visit(const tensor_convert_op_t &op) noex
 {
     try_var(output, pop_addr());
     try_var(input, pop_addr());
-    try_var(shape, module().shape_reg(op.rshape_src));
-    try_var(in_strides, module().shape_reg(op.rstride_src));
-    try_var(out_strides, module().shape_reg(op.rstride_dest));
+    try_ref(shape, module().shape_reg(op.rshape_src));
+    try_ref(in_strides, module().shape_reg(op.rstride_src));
+    try_ref(out_strides, module().shape_reg(op.rstride_dest));
+
+    if (profiling())
+        profile_details(op.in_datatype, shape, shape, (get_bytes(op.in_datatype) + get_bytes(op.dst_datatype)) * compute_size(shape), compute_size(shape));
 
     return kernels::convert(op.in_datatype, op.dst_datatype, reinterpret_cast<const gsl::byte *>(input), reinterpret_cast<gsl::byte *>(output), shape, in_strides, out_strides, module().kernel_context());
 }
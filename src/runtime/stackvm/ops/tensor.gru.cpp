@@ -31,8 +31,8 @@ result<void> stackvm_runtime_function::visit(const tensor_gru_op_t &op) noexcept
     try_var(w, pop_addr());
     try_var(input, pop_addr());
 
-    try_var(in_shape, module().shape_reg(op.input_shape_src));
-    try_var(w_shape, module().shape_reg(op.w_shape_src));
+    try_ref(in_shape, module().shape_reg(op.input_shape_src));
+    try_ref(w_shape, module().shape_reg(op.w_shape_src));
 
     return kernels::gru(reinterpret_cast<const float *>(input), reinterpret_cast<const float *>(w),
         reinterpret_cast<const float *>(r), reinterpret_cast<const float *>(b),
@@ -14,6 +14,7 @@
  */
 #include "../runtime_function.h"
 #include <nncase/kernels/tensor_compute.h>
+#include <nncase/runtime/runtime_op_utility.h>
 
 using namespace nncase;
 using namespace nncase::runtime;
@@ -26,14 +27,18 @@ result<void> stackvm_runtime_function::visit(const tensor_matmul_op_t &op) noexc
     try_var(input_b, pop_addr());
     try_var(input_a, pop_addr());
 
-    try_var(in_shape_a, module().shape_reg(op.rshape_src1));
-    try_var(in_stride_a, module().shape_reg(op.rstride_src1));
-    try_var(in_shape_b, module().shape_reg(op.rshape_src2));
-    try_var(in_stride_b, module().shape_reg(op.rstride_src2));
-    try_var(out_shape, module().shape_reg(op.rshape_dest));
-    try_var(out_stride, module().shape_reg(op.rstride_dest));
+    try_ref(in_shape_a, module().shape_reg(op.rshape_src1));
+    try_ref(in_stride_a, module().shape_reg(op.rstride_src1));
+    try_ref(in_shape_b, module().shape_reg(op.rshape_src2));
+    try_ref(in_stride_b, module().shape_reg(op.rstride_src2));
+    try_ref(out_shape, module().shape_reg(op.rshape_dest));
+    try_ref(out_stride, module().shape_reg(op.rstride_dest));
+
+    if (profiling())
+        profile_details(dt_float32, in_shape_a, out_shape,
+            sizeof(float) * (compute_size(in_shape_a) + compute_size(in_shape_b) + compute_size(out_shape)), 2 * compute_size(out_shape) * in_shape_a.back());
 
     return kernels::matmul(reinterpret_cast<const float *>(input_a), reinterpret_cast<const float *>(input_b),
         reinterpret_cast<const float *>(bias), reinterpret_cast<float *>(output), in_shape_a, in_stride_a,
-        in_shape_b, in_stride_b, out_shape, out_stride, { op.fused_clamp_low, op.fused_clamp_high });
+        in_shape_b, in_stride_b, out_shape, out_stride, { op.fused_clamp_low, op.fused_clamp_high }, module().kernel_context());
 }
@@ -24,9 +24,9 @@ result<void> stackvm_runtime_function::visit(const tensor_pad_op_t &op) noexcept
     try_var(pad_value, pop_scalar(op.datatype));
     try_var(output, pop_addr());
     try_var(input, pop_addr());
-    try_var(shape, module().shape_reg(op.rshape_src));
-    try_var(in_strides, module().shape_reg(op.rstride_src));
-    try_var(out_strides, module().shape_reg(op.rstride_dest));
+    try_ref(shape, module().shape_reg(op.rshape_src));
+    try_ref(in_strides, module().shape_reg(op.rstride_src));
+    try_ref(out_strides, module().shape_reg(op.rstride_dest));
     try_var(paddings, module().paddings_reg(op.rpaddings));
 
     return kernels::pad(op.datatype, reinterpret_cast<const gsl::byte *>(input), reinterpret_cast<gsl::byte *>(output), shape, in_strides, out_strides, paddings, op.pad_mode, pad_value, module().kernel_context());
@@ -16,6 +16,7 @@
 #include <iostream>
 #include <nncase/kernels/tensor_compute.h>
 #include <nncase/runtime/debug.h>
+#include <nncase/runtime/runtime_op_utility.h>
 
 using namespace nncase;
 using namespace nncase::runtime;
@@ -26,10 +27,18 @@ result<void> stackvm_runtime_function::visit(const tensor_reduce_op_t &op) noexc
     try_var(init_value, stack_.pop());
     try_var(output, pop_addr());
     try_var(input, pop_addr());
-    try_var(in_shape, module().shape_reg(op.rshape_src));
-    try_var(axis, module().shape_reg(op.rshape_axis));
-    try_var(in_strides, module().shape_reg(op.rstride_src));
-    try_var(out_strides, module().shape_reg(op.rstride_dest));
+    try_ref(in_shape, module().shape_reg(op.rshape_src));
+    try_ref(axis, module().shape_reg(op.rshape_axis));
+    try_ref(in_strides, module().shape_reg(op.rstride_src));
+    try_ref(out_strides, module().shape_reg(op.rstride_dest));
+
+    if (profiling())
+    {
+        auto out_shape = in_shape;
+        for (auto a : axis)
+            out_shape[a] = 1;
+        profile_details(op.datatype, in_shape, out_shape, get_bytes(op.datatype) * (compute_size(in_shape) + compute_size(out_shape)), compute_size(in_shape));
+    }
 
     switch (op.datatype)
     {
@@ -25,20 +25,20 @@ result<void> stackvm_runtime_function::visit(const tensor_reduce_prod_op_t &op)
 {
     try_var(output, pop_addr());
     try_var(input, pop_addr());
-    try_var(in_shape, module().shape_reg(op.rshape_src));
-    try_var(in_strides, module().shape_reg(op.rstride_src));
-    try_var(out_strides, module().shape_reg(op.rstride_dest));
-    try_var(axes, module().shape_reg(op.rshape_axes));
+    try_ref(in_shape, module().shape_reg(op.rshape_src));
+    try_ref(in_strides, module().shape_reg(op.rstride_src));
+    try_ref(out_strides, module().shape_reg(op.rstride_dest));
+    try_ref(axes, module().shape_reg(op.rshape_axes));
 
     switch (op.datatype)
     {
     case dt_float32:
         return kernels::reduce_prod(reinterpret_cast<const float *>(input), reinterpret_cast<float *>(output),
-            in_shape, in_strides, out_strides, axes, op.keep_dims);
+            in_shape, in_strides, out_strides, axes, op.keep_dims, module().kernel_context());
         break;
     case dt_int32:
         return kernels::reduce_prod(reinterpret_cast<const int32_t *>(input), reinterpret_cast<int32_t *>(output),
-            in_shape, in_strides, out_strides, axes, op.keep_dims);
+            in_shape, in_strides, out_strides, axes, op.keep_dims, module().kernel_context());
         break;
     default:
         std::cerr << "unsupported dtype for reduce_prod: " + std::string(datatype_names(op.datatype));
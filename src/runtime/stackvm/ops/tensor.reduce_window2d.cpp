@@ -13,7 +13,9 @@
  * limitations under the License.
  */
 #include "../runtime_function.h"
+#include <nncase/kernels/kernel_utils.h>
 #include <nncase/kernels/reduce_window.h>
+#include <nncase/runtime/runtime_op_utility.h>
 
 using namespace nncase;
 using namespace nncase::runtime;
@@ -26,9 +28,18 @@ result<void> stackvm_runtime_function::visit(const tensor_reduce_window2d_op_t &
     try_var(output, pop_addr());
     try_var(init_value, stack_.pop());
     try_var(input, pop_addr());
-    try_var(in_shape, module().shape_reg(op.rshape_src));
-    try_var(in_strides, module().shape_reg(op.rstride_src));
-    try_var(out_strides, module().shape_reg(op.rstride_dest));
+    try_ref(in_shape, module().shape_reg(op.rshape_src));
+    try_ref(in_strides, module().shape_reg(op.rstride_src));
+    try_ref(out_strides, module().shape_reg(op.rstride_dest));
+
+    if (profiling())
+    {
+        runtime_shape_t out_shape { in_shape[0], in_shape[1],
+            kernels::detail::get_windowed_output_size(in_shape[2], op.filter_h, op.stride_h, op.dilation_h, padding_h),
+            kernels::detail::get_windowed_output_size(in_shape[3], op.filter_w, op.stride_w, op.dilation_w, padding_w) };
+        profile_details(op.datatype, in_shape, out_shape, get_bytes(op.datatype) * (compute_size(in_shape) + compute_size(out_shape)),
+            compute_size(out_shape) * op.filter_h * op.filter_w);
+    }
 
     if (op.datatype != dt_float32)
         return err(nncase_errc::datatype_mismatch);
@@ -14,6 +14,7 @@
  */
 #include "../runtime_function.h"
 #include <nncase/kernels/tensor_compute.h>
+#include <nncase/runtime/runtime_op_utility.h>
 
 using namespace nncase;
 using namespace nncase::runtime;
@@ -28,9 +29,17 @@ result<void> stackvm_runtime_function::visit(const tensor_resize_image_op_t &op)
 
     auto out_h = h.as_i4();
     auto out_w = w.as_i4();
-    try_var(in_shape, module().shape_reg(op.rshape_src));
-    try_var(in_strides, module().shape_reg(op.rstride_src));
-    try_var(out_strides, module().shape_reg(op.rstride_dest));
+    try_ref(in_shape, module().shape_reg(op.rshape_src));
+    try_ref(in_strides, module().shape_reg(op.rstride_src));
+    try_ref(out_strides, module().shape_reg(op.rstride_dest));
+
+    if (profiling())
+    {
+        runtime_shape_t out_shape { in_shape[0], in_shape[1], (size_t)out_h, (size_t)out_w };
+        // Bilinear blends four neighbours per output element.
+        auto flops = op.image_resize_mode == image_resize_bilinear ? 8 * compute_size(out_shape) : 0;
+        profile_details(op.datatype, in_shape, out_shape, get_bytes(op.datatype) * (compute_size(in_shape) + compute_size(out_shape)), flops);
+    }
     if (op.image_resize_mode == image_resize_bilinear)
     {
         return kernels::resize_bilinear(op.datatype, reinterpret_cast<gsl::byte *>(input), reinterpret_cast<gsl::byte *>(output),
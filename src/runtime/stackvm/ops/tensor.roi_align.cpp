@@ -28,8 +28,8 @@ result<void> stackvm_runtime_function::visit(const tensor_roi_align_op_t &op) no
     try_var(rois, pop_addr());
     try_var(input, pop_addr());
 
-    try_var(in_shape, module().shape_reg(op.rshape_src));
-    try_var(out_shape, module().shape_reg(op.rshape_dest));
+    try_ref(in_shape, module().shape_reg(op.rshape_src));
+    try_ref(out_shape, module().shape_reg(op.rshape_dest));
 
     switch (op.datatype)
     {
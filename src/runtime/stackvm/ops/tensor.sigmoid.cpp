@@ -16,6 +16,7 @@
 #include <iostream>
 #include <nncase/kernels/tensor_compute.h>
 #include <nncase/runtime/debug.h>
+#include <nncase/runtime/runtime_op_utility.h>
 
 using namespace nncase;
 using namespace nncase::runtime;
@@ -25,9 +26,13 @@ result<void> stackvm_runtime_function::visit(const tensor_sigmoid_op_t &op) noex
 {
     try_var(output, pop_addr());
     try_var(input, pop_addr());
-    try_var(in_shape, module().shape_reg(op.rshape_src));
-    try_var(in_stride, module().shape_reg(op.rstride_src));
-    try_var(out_stride, module().shape_reg(op.rstride_dest));
+    try_ref(in_shape, module().shape_reg(op.rshape_src));
+    try_ref(in_stride, module().shape_reg(op.rstride_src));
+    try_ref(out_stride, module().shape_reg(op.rstride_dest));
+
+    // exp, add and divide per element.
+    if (profiling())
+        profile_details(op.datatype, in_shape, in_shape, 2 * get_bytes(op.datatype, in_shape), 3 * compute_size(in_shape));
 
     switch (op.datatype)
     {
@@ -23,11 +23,11 @@ result<void> stackvm_runtime_function::visit(const tensor_space_to_batch_op_t &o
 {
     try_var(output, pop_addr());
     try_var(input, pop_addr());
-    try_var(in_shape, module().shape_reg(op.rshape_src));
-    try_var(block_shape, module().shape_reg(op.rshape_block));
+    try_ref(in_shape, module().shape_reg(op.rshape_src));
+    try_ref(block_shape, module().shape_reg(op.rshape_block));
     try_var(crops, module().paddings_reg(op.rpad_crops));
-    try_var(in_strides, module().shape_reg(op.rstride_src));
-    try_var(out_strides, module().shape_reg(op.rstride_dest));
+    try_ref(in_strides, module().shape_reg(op.rstride_src));
+    try_ref(out_strides, module().shape_reg(op.rstride_dest));
 
     return kernels::space_to_batch(op.datatype, reinterpret_cast<const gsl::byte *>(input), reinterpret_cast<gsl::byte *>(output),
         in_shape, block_shape, crops, in_strides, out_strides, module().kernel_context());
@@ -31,9 +31,9 @@ result<void> stackvm_runtime_function::visit(const tensor_tflite_detection_postp
     try_var(score, pop_addr());
     try_var(box, pop_addr());
 
-    try_var(box_shape, module().shape_reg(op.box_shape_src));
-    try_var(score_shape, module().shape_reg(op.score_shape_src));
-    try_var(anchor_shape, module().shape_reg(op.anchor_shape_src));
+    try_ref(box_shape, module().shape_reg(op.box_shape_src));
+    try_ref(score_shape, module().shape_reg(op.score_shape_src));
+    try_ref(anchor_shape, module().shape_reg(op.anchor_shape_src));
 
     return kernels::tflite_detection_postprocess(reinterpret_cast<const float *>(box), reinterpret_cast<const float *>(score),
         reinterpret_cast<const float *>(anchor), reinterpret_cast<float *>(output_locations),
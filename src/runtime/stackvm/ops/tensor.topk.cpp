@@ -26,12 +26,12 @@ result<void> stackvm_runtime_function::visit(const tensor_topk_op_t &op) noexcep
     try_var(output_b, pop_addr());
     try_var(output_a, pop_addr());
     try_var(input, pop_addr());
-    try_var(in_shape, module().shape_reg(op.rshape_src));
-    try_var(in_strides, module().shape_reg(op.rstride_src));
-    try_var(out_a_shape, module().shape_reg(op.rshape_dest1));
-    try_var(out_a_strides, module().shape_reg(op.rstride_dest1));
-    try_var(out_b_shape, module().shape_reg(op.rshape_dest2));
-    try_var(out_b_strides, module().shape_reg(op.rstride_dest2));
+    try_ref(in_shape, module().shape_reg(op.rshape_src));
+    try_ref(in_strides, module().shape_reg(op.rstride_src));
+    try_ref(out_a_shape, module().shape_reg(op.rshape_dest1));
+    try_ref(out_a_strides, module().shape_reg(op.rstride_dest1));
+    try_ref(out_b_shape, module().shape_reg(op.rshape_dest2));
+    try_ref(out_b_strides, module().shape_reg(op.rstride_dest2));
 
     switch (op.datatype)
     {
@@ -25,7 +25,7 @@ result<void> stackvm_runtime_function::visit(const tensor_trilu_op_t &op) noexce
 {
     try_var(output, pop_addr());
     try_var(input, pop_addr());
-    try_var(in_shape, module().shape_reg(op.rshape_src));
+    try_ref(in_shape, module().shape_reg(op.rshape_src));
 
     switch (op.datatype)
     {
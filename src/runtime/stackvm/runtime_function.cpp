@@ -15,6 +15,7 @@
 #include "runtime_function.h"
 #include <nncase/runtime/dbg.h>
 #include <nncase/runtime/host_runtime_tensor.h>
+#include <nncase/runtime/interpreter.h>
 #include <nncase/runtime/runtime_op_utility.h>
 
 using namespace nncase;
@@ -28,6 +29,7 @@ stackvm_runtime_module &stackvm_runtime_function::module() const noexcept
 
 result<void> stackvm_runtime_function::initialize_core(runtime_function_init_context &context) noexcept
 {
+    // Decoded once per compiled model by stackvm_runtime_module::initialize_after_functions.
     text_ = context.module_init_context().section(".text").subspan(context.header().entrypoint, context.header().text_size);
     return ok();
 }
@@ -59,19 +61,21 @@ result<void> stackvm_runtime_function::validate_output_tensor(NNCASE_UNUSED size
 result<void> stackvm_runtime_function::invoke_core() noexcept
 {
     call_depth_ = 0;
-    return visit(text_);
+    // profile and num_threads may be changed through interpreter::options() at any time before run().
+    auto profile = module().interp().options().get<int32_t>("profile");
+    profiler_ = profile.is_ok() && profile.unwrap() ? &module().interp().profiler() : nullptr;
+    module().update_kernel_context();
+    return visit(*program_);
 }
 
 uintptr_t stackvm_runtime_function::pc() const noexcept
 {
-    return (uintptr_t)(text_.size_bytes() - reader_.avail());
+    return program_->offset(ip_);
 }
 
 result<void> stackvm_runtime_function::pc(uintptr_t value) noexcept
 {
-    if (value >= text_.size_bytes())
-        return err(nncase_errc::stackvm_illegal_target);
-    reader_ = span_reader(text_.subspan(value));
+    try_set(ip_, program_->index(value));
     return ok();
 }
 
@@ -28,6 +28,11 @@ public:
 
     stackvm_runtime_module &module() const noexcept;
 
+    gsl::span<const gsl::byte> text() const noexcept { return text_; }
+
+    /** @brief Points the function at its .text decoded in the module's shared state. */
+    void program(const decoded_text &program) noexcept { program_ = &program; }
+
 protected:
     result<void> initialize_core(runtime_function_init_context &context) noexcept override;
     result<runtime_tensor> allocate_input_tensor(size_t index) noexcept override;
@@ -96,6 +101,7 @@ protected:
     result<void> visit(const ldarg_5_op_t &op) noexcept override;
     result<void> visit(const stshape_op_t &op) noexcept override;
     result<void> visit(const stpaddings_op_t &op) noexcept override;
+    result<void> visit(const ldshape_op_t &op) noexcept override;
 
     result<void> visit(const dup_op_t &op) noexcept override;
     result<void> visit(const pop_op_t &op) noexcept override;
@@ -185,6 +191,13 @@ private:
     result<scalar> pop_scalar(datatype_t type) noexcept;
     result<runtime_tensor> create_tensor(uintptr_t addr, datatype_t datatype, const runtime_shape_t &shape, const runtime_shape_t &strides) noexcept;
 
+    bool profiling() const noexcept { return profiler_; }
+    void profile_details(datatype_t datatype, const runtime_shape_t &in_shape, const runtime_shape_t &out_shape, uint64_t bytes, uint64_t flops) noexcept
+    {
+        if (profiler_)
+            profiler_->details(datatype, in_shape, out_shape, bytes, flops);
+    }
+
     template <class T>
     result<T> pop_addr() noexcept
     {
@@ -194,6 +207,7 @@ private:
 
 private:
     gsl::span<const gsl::byte> text_;
+    const decoded_text *program_ = nullptr;
     evaluate_stack stack_;
     size_t call_depth_;
 };
@@ -16,12 +16,55 @@
 #include "runtime_function.h"
 #include <nncase/runtime/dbg.h>
 #include <nncase/runtime/host_runtime_tensor.h>
+#include <nncase/runtime/interpreter.h>
 #include <nncase/runtime/runtime_op_utility.h>
 
 using namespace nncase;
 using namespace nncase::runtime;
 using namespace nncase::runtime::stackvm;
 
+namespace
+{
+result<void> load_shape_table(std::vector<runtime_shape_t> &shape_table, gsl::span<const gsl::byte> section) noexcept
+{
+    if (section.empty())
+        return ok();
+
+    span_reader reader(section);
+    CHECK_WITH_ERR(reader.avail() >= sizeof(uint32_t), std::errc::invalid_argument);
+    auto count = reader.read_unaligned<uint32_t>();
+    try
+    {
+        shape_table.resize(count);
+    }
+    catch (...)
+    {
+        return err(std::errc::not_enough_memory);
+    }
+
+    for (auto &shape : shape_table)
+    {
+        CHECK_WITH_ERR(reader.avail() >= sizeof(uint32_t), std::errc::invalid_argument);
+        auto rank = reader.read_unaligned<uint32_t>();
+        CHECK_WITH_ERR(reader.avail() >= rank * sizeof(int32_t), std::errc::invalid_argument);
+        try
+        {
+            shape.resize(rank);
+        }
+        catch (...)
+        {
+            return err(std::errc::not_enough_memory);
+        }
+
+        // Same widening as ldc_i4 + stshape, so negative axes keep their meaning.
+        for (auto &dim : shape)
+            dim = (size_t)(intptr_t)reader.read_unaligned<int32_t>();
+    }
+
+    return ok();
+}
+}
+
 gsl::span<gsl::byte> stackvm_runtime_module::data() const noexcept
 {
     return { data_.get(), mempool(mem_data).size };
@@ -44,9 +87,49 @@ result<void> stackvm_runtime_module::initialize_before_functions(runtime_module_
     }
 
     rdata_ = context.section(".rdata");
+    kernel_context_.constants_begin = rdata_.data();
+    kernel_context_.constants_end = rdata_.data() + rdata_.size();
+    return ok();
+}
+
+result<void> stackvm_runtime_module::initialize_after_functions(runtime_module_init_context &context) noexcept
+{
+    try_var(state, context.shared_state([&] { return create_shared_state(context); }));
+    shared_ = std::static_pointer_cast<const stackvm_shared_state>(std::move(state));
+    kernel_context_.weights = shared_->weights;
+
+    auto funcs = functions();
+    CHECK_WITH_ERR(shared_->programs.size() == funcs.size(), std::errc::invalid_argument);
+    for (size_t i = 0; i < funcs.size(); i++)
+        static_cast<stackvm_runtime_function &>(*funcs[i]).program(shared_->programs[i]);
     return ok();
 }
 
+result<std::shared_ptr<const module_shared_state>> stackvm_runtime_module::create_shared_state(runtime_module_init_context &context) noexcept
+{
+    std::shared_ptr<stackvm_shared_state> state(new (std::nothrow) stackvm_shared_state());
+    if (!state)
+        return err(std::errc::not_enough_memory);
+
+    auto funcs = functions();
+    try
+    {
+        state->programs.resize(funcs.size());
+    }
+    catch (...)
+    {
+        return err(std::errc::not_enough_memory);
+    }
+
+    for (size_t i = 0; i < funcs.size(); i++)
+        try_(state->programs[i].decode(static_cast<stackvm_runtime_function &>(*funcs[i]).text()));
+    try_(load_shape_table(state->shape_table, context.section(SHAPE_SECTION_NAME)));
+    state->weights = kernels::make_weights_cache();
+    if (!state->weights)
+        return err(std::errc::not_enough_memory);
+    return ok(std::shared_ptr<const module_shared_state>(std::move(state)));
+}
+
 result<uintptr_t> stackvm_runtime_module::reg(size_t id) const noexcept
 {
     CHECK_WITH_ERR(id < regs_.size(), std::errc::result_out_of_range);
@@ -60,25 +143,42 @@ result<void> stackvm_runtime_module::reg(size_t id, uintptr_t value) noexcept
     return ok();
 }
 
-result<runtime_shape_t> stackvm_runtime_module::shape_reg(size_t id) const noexcept
-{
-    CHECK_WITH_ERR(id < shape_regs_.size(), std::errc::result_out_of_range);
-    return ok(shape_regs_[id]);
-}
-
-result<void> stackvm_runtime_module::shape_reg(size_t id, runtime_shape_t value) noexcept
+result<stackvm_runtime_module::shape_register *> stackvm_runtime_module::shape_register_at(size_t id) noexcept
 {
     try
     {
         if (id >= shape_regs_.size())
             shape_regs_.resize(id + 1);
-        shape_regs_[id] = std::move(value);
     }
     catch (...)
     {
         return err(std::errc::not_enough_memory);
     }
 
+    return ok(&shape_regs_[id]);
+}
+
+result<const runtime_shape_t *> stackvm_runtime_module::shape_reg(size_t id) const noexcept
+{
+    CHECK_WITH_ERR(id < shape_regs_.size(), std::errc::result_out_of_range);
+    auto &reg = shape_regs_[id];
+    return ok(reg.ref ? reg.ref : &reg.value);
+}
+
+result<void> stackvm_runtime_module::shape_reg(size_t id, runtime_shape_t value) noexcept
+{
+    try_var(reg, shape_register_at(id));
+    reg->value = std::move(value);
+    reg->ref = nullptr;
+    return ok();
+}
+
+result<void> stackvm_runtime_module::bind_shape_reg(size_t id, size_t index) noexcept
+{
+    auto &shape_table = shared_->shape_table;
+    CHECK_WITH_ERR(index < shape_table.size(), std::errc::result_out_of_range);
+    try_var(reg, shape_register_at(id));
+    reg->ref = &shape_table[index];
     return ok();
 }
 
@@ -106,7 +206,17 @@ result<void> stackvm_runtime_module::paddings_reg(size_t id, runtime_paddings_t
 
 kernels::kernel_context &stackvm_runtime_module::kernel_context() noexcept
 {
-    return kernels::default_kernel_context();
+    return kernel_context_;
+}
+
+void stackvm_runtime_module::update_kernel_context() noexcept
+{
+    auto num_threads = interp().options().get<int32_t>("num_threads");
+    if (num_threads.is_ok() && num_threads.unwrap() > 0)
+        kernel_context_.num_threads = (uint32_t)num_threads.unwrap();
+    else
+        kernel_context_.num_threads = kernels::default_kernel_context().num_threads;
+    kernel_context_.pool = kernel_context_.num_threads > 1 ? kernels::shared_thread_pool(kernel_context_.num_threads) : nullptr;
 }
 
 result<std::unique_ptr<runtime_function>> stackvm_runtime_module::create_function() noexcept
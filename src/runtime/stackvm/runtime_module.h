@@ -15,10 +15,22 @@
 #pragma once
 #include "evaluate_stack.h"
 #include <nncase/kernels/kernel_context.h>
+#include <nncase/runtime/stackvm/op_reader.h>
 #include <nncase/runtime/stackvm/runtime_module.h>
 
 BEGIN_NS_NNCASE_RT_MODULE(stackvm)
 
+// Parsed once per compiled model and shared read-only by its interpreters.
+struct stackvm_shared_state : module_shared_state
+{
+    // Decoded .text of each function, in function order.
+    std::vector<decoded_text> programs;
+    // Entries of the .shape section, referred to by ldshape.
+    std::vector<runtime_shape_t> shape_table;
+    // Weights transformed from .rdata by the kernels.
+    std::shared_ptr<kernels::weights_cache> weights;
+};
+
 class stackvm_runtime_module : public runtime_module
 {
 public:
@@ -26,28 +38,49 @@ public:
 
     kernels::kernel_context &kernel_context() noexcept;
 
+    /** @brief Applies the interpreter's num_threads option to the kernel context. */
+    void update_kernel_context() noexcept;
+
     gsl::span<gsl::byte> data() const noexcept;
     gsl::span<const gsl::byte> rdata() const noexcept;
 
     result<uintptr_t> reg(size_t id) const noexcept;
     result<void> reg(size_t id, uintptr_t value) noexcept;
 
-    result<runtime_shape_t> shape_reg(size_t id) const noexcept;
+    result<const runtime_shape_t *> shape_reg(size_t id) const noexcept;
     result<void> shape_reg(size_t id, runtime_shape_t value) noexcept;
 
+    /** @brief Binds a shape register to an entry of the .shape table. */
+    result<void> bind_shape_reg(size_t id, size_t index) noexcept;
+
     result<runtime_paddings_t> paddings_reg(size_t id) const noexcept;
     result<void> paddings_reg(size_t id, runtime_paddings_t value) noexcept;
 
+private:
+    // A shape register either owns a value stored by stshape or refers to a
+    // shape table entry bound by ldshape.
+    struct shape_register
+    {
+        runtime_shape_t value;
+        const runtime_shape_t *ref = nullptr;
+    };
+
+    result<std::shared_ptr<const module_shared_state>> create_shared_state(runtime_module_init_context &context) noexcept;
+    result<shape_register *> shape_register_at(size_t id) noexcept;
+
 protected:
     result<void> initialize_before_functions(runtime_module_init_context &context) noexcept override;
+    result<void> initialize_after_functions(runtime_module_init_context &context) noexcept override;
     result<std::unique_ptr<runtime_function>> create_function() noexcept override;
 
 private:
     std::unique_ptr<gsl::byte[]> data_;
     gsl::span<const gsl::byte> rdata_;
     std::array<uintptr_t, MAX_GENERAL_REGS> regs_;
-    std::vector<runtime_shape_t> shape_regs_;
+    std::shared_ptr<const stackvm_shared_state> shared_;
+    std::vector<shape_register> shape_regs_;
     std::vector<runtime_paddings_t> paddings_regs_;
+    kernels::kernel_context kernel_context_;
 };
 
 END_NS_NNCASE_RT_MODULE
@@ -12,9 +12,11 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  */
+#include <algorithm>
 #include <nncase/ir/op_utils.h>
 #include <nncase/schedule/buffer_allocator.h>
 #include <nncase/schedule/freelist.h>
+#include <numeric>
 #include <stdexcept>
 
 using namespace nncase;
@@ -41,6 +43,11 @@ size_t buffer_allocator::alignment() const noexcept
     return 8;
 }
 
+void buffer_allocator::dump(std::ostream &writer) const
+{
+    writer << max_usage_ << " bytes";
+}
+
 buffer_allocator::allocated_buffer buffer_allocator::make_alloc(const physical_buffer &buffer)
 {
     allocated_buffer alloc;
@@ -109,3 +116,106 @@ void first_fit_allocator::finish()
 {
     max_usage_ = list_.max_usage();
 }
+
+greedy_by_size_allocator::greedy_by_size_allocator(std::optional<size_t> fixed_size)
+    : fixed_size_(fixed_size)
+{
+}
+
+void greedy_by_size_allocator::base_offset([[maybe_unused]] size_t value)
+{
+    throw std::runtime_error("Greedy by size allocator doesn't support base offset");
+}
+
+void greedy_by_size_allocator::mark(const physical_buffer &buffer)
+{
+    buffers_.emplace_back(&buffer);
+}
+
+size_t greedy_by_size_allocator::plan(std::vector<allocated_buffer> &allocs, bool best_fit) const
+{
+    // A buffer is written at its birth, so even an unused one holds its memory for one step.
+    auto live_range = [](const physical_buffer &buffer) {
+        auto &lifetime = buffer.lifetime();
+        return std::make_pair(lifetime.birth, std::max(lifetime.end(), lifetime.birth + 1));
+    };
+
+    std::vector<size_t> order(buffers_.size());
+    std::iota(order.begin(), order.end(), 0);
+    if (best_fit)
+        std::stable_sort(order.begin(), order.end(), [&](size_t lhs, size_t rhs) { return allocs[lhs].size > allocs[rhs].size; });
+    else
+        std::stable_sort(order.begin(), order.end(), [&](size_t lhs, size_t rhs) { return buffers_[lhs]->lifetime().birth < buffers_[rhs]->lifetime().birth; });
+
+    size_t usage = 0;
+    std::vector<const allocated_buffer *> placed, conflicts;
+    placed.reserve(order.size());
+    for (auto idx : order)
+    {
+        auto &alloc = allocs[idx];
+        auto [birth, end] = live_range(*buffers_[idx]);
+        conflicts.clear();
+        for (auto other : placed)
+        {
+            auto [other_birth, other_end] = live_range(*other->buffer);
+            if (birth < other_end && other_birth < end && other->size)
+                conflicts.emplace_back(other);
+        }
+
+        std::sort(conflicts.begin(), conflicts.end(), [](auto lhs, auto rhs) { return lhs->start < rhs->start; });
+
+        // Walk the gaps between the buffers living with this one.
+        const auto alignment = alloc.buffer->alignment();
+        std::optional<size_t> best_start;
+        size_t best_gap = 0, offset = 0;
+        for (auto other : conflicts)
+        {
+            auto start = align(offset, alignment);
+            if (start + alloc.size <= other->start)
+            {
+                auto gap = other->start - offset;
+                if (!best_start || gap < best_gap)
+                {
+                    best_start = start;
+                    best_gap = gap;
+                }
+
+                if (!best_fit)
+                    break;
+            }
+
+            offset = std::max(offset, other->end());
+        }
+
+        alloc.start = best_start ? *best_start : align(offset, alignment);
+        usage = std::max(usage, alloc.end());
+        if (alloc.size)
+            placed.emplace_back(&alloc);
+    }
+
+    return usage;
+}
+
+void greedy_by_size_allocator::finish()
+{
+    std::vector<allocated_buffer> greedy, first_fit;
+    greedy.reserve(buffers_.size());
+    for (auto buffer : buffers_)
+        greedy.emplace_back(make_alloc(*buffer));
+    first_fit = greedy;
+
+    greedy_usage_ = plan(greedy, true);
+    first_fit_usage_ = plan(first_fit, false);
+    auto &allocs = greedy_usage_ <= first_fit_usage_ ? greedy : first_fit;
+    max_usage_ = std::min(greedy_usage_, first_fit_usage_);
+    if (fixed_size_ && max_usage_ > *fixed_size_)
+        throw std::runtime_error("Allocator has ran out of memory");
+
+    for (auto &alloc : allocs)
+        allocations_.emplace(alloc.buffer, alloc);
+}
+
+void greedy_by_size_allocator::dump(std::ostream &writer) const
+{
+    writer << max_usage_ << " bytes (greedy by size: " << greedy_usage_ << ", first fit: " << first_fit_usage_ << ")";
+}
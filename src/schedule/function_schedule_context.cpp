@@ -12,17 +12,22 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  */
+#include <chrono>
 #include <fmt/format.h>
 #include <fstream>
+#include <map>
+#include <numeric>
 #include <nncase/ir/ops/bitcast.h>
 #include <nncase/ir/ops/call.h>
 #include <nncase/ir/ops/concat.h>
 #include <nncase/ir/ops/constant.h>
 #include <nncase/ir/ops/slice.h>
+#include <nncase/ir/op_utils.h>
 #include <nncase/ir/visitor.h>
 #include <nncase/schedule/schedule_context.h>
 #include <nncase/targets/target.h>
 #include <nncase/transforms/neutral/optimize_allocation.h>
+#include <set>
 
 using namespace nncase;
 using namespace nncase::ir;
@@ -31,6 +36,24 @@ using namespace nncase::ir::transforms;
 
 namespace
 {
+class phase_timer
+{
+public:
+    explicit phase_timer(std::chrono::nanoseconds &elapsed) noexcept
+        : elapsed_(elapsed), begin_(std::chrono::steady_clock::now())
+    {
+    }
+
+    ~phase_timer()
+    {
+        elapsed_ += std::chrono::steady_clock::now() - begin_;
+    }
+
+private:
+    std::chrono::nanoseconds &elapsed_;
+    std::chrono::steady_clock::time_point begin_;
+};
+
 memory_location_t decide_memory_location(ir::output_connector &conn, [[maybe_unused]] bool skip_buffer_alias) noexcept
 {
     auto &opcode = conn.owner().runtime_opcode();
@@ -107,6 +130,147 @@ void update_strides_shape(logical_buffer &buffer)
         buffer.strides_shape() = buffer.shape();
     }
 }
+
+// Data buffers each node allocates and the consumers of them, indexed by post order.
+struct order_graph
+{
+    std::vector<node *> nodes;
+    std::unordered_map<node *, size_t> index;
+    std::vector<size_t> alloc_bytes;
+    std::vector<size_t> users;
+    std::vector<std::vector<size_t>> producers;
+    std::vector<std::vector<size_t>> consumers;
+};
+
+order_graph make_order_graph(std::vector<node *> nodes, bool skip_buffer_alias)
+{
+    order_graph g;
+    g.nodes = std::move(nodes);
+    for (size_t i = 0; i < g.nodes.size(); i++)
+        g.index.emplace(g.nodes[i], i);
+
+    const auto count = g.nodes.size();
+    g.alloc_bytes.resize(count);
+    g.users.resize(count);
+    g.producers.resize(count);
+    g.consumers.resize(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        auto &n = *g.nodes[i];
+        for (auto out : n.outputs())
+        {
+            if (decide_memory_location(*out, skip_buffer_alias) == mem_data)
+                g.alloc_bytes[i] += ir::get_bytes(out->type(), out->shape());
+        }
+
+        for (auto in : n.inputs())
+        {
+            auto p = g.index.at(&in->connection()->owner());
+            g.producers[i].emplace_back(p);
+            g.consumers[p].emplace_back(i);
+            g.users[p]++;
+        }
+    }
+
+    return g;
+}
+
+std::vector<physical_buffer *> sorted_by_birth(std::vector<physical_buffer> &buffers)
+{
+    std::vector<physical_buffer *> orders;
+    orders.reserve(buffers.size());
+    for (auto &b : buffers)
+        orders.emplace_back(&b);
+    std::sort(orders.begin(), orders.end(), [](const physical_buffer *lhs, const physical_buffer *rhs) { return lhs->lifetime().birth < rhs->lifetime().birth; });
+    return orders;
+}
+
+std::vector<node *> post_order_nodes(std::span<output_node *> outputs)
+{
+    std::vector<node *> post_order;
+    auto order_visitor = make_relay_ir_visitor([&](node &node) {
+        post_order.emplace_back(&node);
+    });
+    order_visitor.visit(outputs);
+    return post_order;
+}
+
+// Peak bytes of live data buffers when the nodes run in the given order.
+size_t estimate_peak(const order_graph &g, std::span<const size_t> order)
+{
+    auto users = g.users;
+    size_t live = 0, peak = 0;
+    for (auto i : order)
+    {
+        live += g.alloc_bytes[i];
+        peak = std::max(peak, live);
+        if (!users[i])
+            live -= g.alloc_bytes[i];
+        for (auto p : g.producers[i])
+        {
+            if (!--users[p])
+                live -= g.alloc_bytes[p];
+        }
+    }
+
+    return peak;
+}
+
+// List scheduling: among the first `window` ready nodes in post order, run the one that
+// grows live bytes the least. Ties keep post order.
+std::vector<size_t> schedule_min_memory(const order_graph &g, size_t window)
+{
+    const auto count = g.nodes.size();
+    std::vector<size_t> pending(count), users = g.users, order;
+    std::set<size_t> ready;
+    for (size_t i = 0; i < count; i++)
+    {
+        pending[i] = g.producers[i].size();
+        if (!pending[i])
+            ready.emplace(i);
+    }
+
+    order.reserve(count);
+    while (!ready.empty())
+    {
+        auto best = ready.begin();
+        auto best_delta = std::numeric_limits<ptrdiff_t>::max();
+        size_t visited = 0;
+        for (auto it = ready.begin(); it != ready.end() && visited < window; ++it, visited++)
+        {
+            auto i = *it;
+            auto &producers = g.producers[i];
+            auto delta = (ptrdiff_t)(users[i] ? g.alloc_bytes[i] : 0);
+            for (auto p = producers.begin(); p != producers.end(); ++p)
+            {
+                // Count each producer once, and only if this node is its last user.
+                if (std::find(producers.begin(), p, *p) == p
+                    && users[*p] == (size_t)std::count(p, producers.end(), *p))
+                    delta -= (ptrdiff_t)g.alloc_bytes[*p];
+            }
+
+            if (delta < best_delta)
+            {
+                best = it;
+                best_delta = delta;
+            }
+        }
+
+        auto i = *best;
+        ready.erase(best);
+        order.emplace_back(i);
+        for (auto p : g.producers[i])
+            users[p]--;
+        for (auto c : g.consumers[i])
+        {
+            if (!--pending[c])
+                ready.emplace(c);
+        }
+    }
+
+    assert(order.size() == count);
+    return order;
+}
 }
 
 function_schedule_context::function_schedule_context(ir::graph &graph, module_schedule_context &mod_sched)
@@ -135,19 +299,42 @@ void function_schedule_context::create_allocators()
 
 void function_schedule_context::visit_function(caller_context &caller_ctx)
 {
-    make_logical_buffers(caller_ctx);
-    if (!mod_sched_.model_sched().skip_buffer_alias())
-        analyze_buffer_alias();
-    update_offset();
-    fix_lifetime();
-    generate_compute_sequence();
-    make_physical_buffers();
+    auto &timings = mod_sched_.model_sched().model_result().timings;
+    {
+        phase_timer timer(timings.compute_sequence);
+        generate_compute_order();
+    }
 
+    {
+        phase_timer timer(timings.liveness);
+        make_logical_buffers(caller_ctx);
+    }
+
+    {
+        phase_timer timer(timings.buffer_alias);
+        if (!mod_sched_.model_sched().skip_buffer_alias())
+            analyze_buffer_alias();
+        update_offset();
+    }
+
+    {
+        phase_timer timer(timings.liveness);
+        fix_lifetime();
+    }
+
+    {
+        phase_timer timer(timings.compute_sequence);
+        generate_compute_sequence();
+    }
+
+    phase_timer timer(timings.allocation);
+    make_physical_buffers();
     allocate_physical_buffers();
 }
 
 void function_schedule_context::end_schedule()
 {
+    phase_timer timer(mod_sched_.model_sched().model_result().timings.allocation);
     for (auto &allocator : allocator_holder_)
     {
         allocator->finish();
@@ -165,17 +352,102 @@ void function_schedule_context::end_schedule()
         dump(dump_dir);
 }
 
+void function_schedule_context::generate_compute_order()
+{
+    auto post_order = post_order_nodes(outputs_);
+    auto &model_sched = mod_sched_.model_sched();
+    reordered_ = false;
+    if (model_sched.compute_order() == compute_order::post_order)
+    {
+        compute_order_ = std::move(post_order);
+        return;
+    }
+
+    // A narrow window keeps close to post order, a wider one follows the heuristic further.
+    auto g = make_order_graph(post_order, model_sched.skip_buffer_alias());
+    std::vector<size_t> best(g.nodes.size());
+    std::iota(best.begin(), best.end(), size_t(0));
+    auto best_peak = estimate_peak(g, best);
+    for (size_t window : { size_t(8), size_t(64) })
+    {
+        auto order = schedule_min_memory(g, window);
+        auto peak = estimate_peak(g, order);
+        if (peak < best_peak)
+        {
+            best = std::move(order);
+            best_peak = peak;
+        }
+    }
+
+    std::vector<node *> min_peak_order;
+    min_peak_order.reserve(best.size());
+    for (auto i : best)
+        min_peak_order.emplace_back(g.nodes[i]);
+
+    // The estimate ignores buffer aliasing and alignment, so allocate both orders and keep
+    // the reordered one only if its data pool is really smaller.
+    post_order_pool_ = data_pool_usage(post_order);
+    if (post_order_nodes(outputs_) != post_order)
+        throw std::runtime_error("Buffer alias passes changed the nodes of " + graph->name() + " while its compute order was chosen");
+    min_peak_pool_ = min_peak_order == post_order ? post_order_pool_ : data_pool_usage(min_peak_order);
+    reordered_ = min_peak_pool_ < post_order_pool_;
+    compute_order_ = reordered_ ? std::move(min_peak_order) : std::move(post_order);
+}
+
+size_t function_schedule_context::data_pool_usage(std::vector<ir::node *> order)
+{
+    compute_order_ = std::move(order);
+    lifetime_recorder lr(logical_buffers_, logical_buffer_map_);
+    record_lifetimes(lr, false);
+    lr.finish();
+    if (!mod_sched_.model_sched().skip_buffer_alias())
+        analyze_buffer_alias();
+    update_offset();
+    fix_lifetime();
+    make_physical_buffers();
+
+    allocator_map_t allocators;
+    std::vector<std::shared_ptr<buffer_allocator>> allocator_holder;
+    mod_sched_.model_sched().target().register_allocators(module_type(), allocators, allocator_holder);
+    auto &allocator = *allocators.at(mem_data);
+    for (auto b : sorted_by_birth(physical_buffers_))
+    {
+        if (b->owner().memory_location() == mem_data)
+            allocator.mark(*b);
+    }
+
+    allocator.finish();
+    physical_buffers_.clear();
+    logical_buffer_map_.clear();
+    logical_buffers_.clear();
+    return allocator.max_usage();
+}
+
 void function_schedule_context::generate_compute_sequence()
 {
-    std::unordered_set<node *> used_inputs;
-    auto alloc_visitor = make_relay_ir_visitor([&](node &node) {
-        if (node.runtime_opcode() == op_input_node)
-            used_inputs.emplace(&node);
-        else if (mod_sched_.model_sched().skip_buffer_alias() || (node.attributes() & node_attr_action))
-            compute_sequence.emplace_back(&node);
-    });
+    // Lifetimes were recorded in compute_order_, before the alias passes ran. Post order is
+    // walked again as it always was, a reordered schedule is only valid on the same nodes.
+    auto post_order = post_order_nodes(outputs_);
+    if (!reordered_)
+    {
+        compute_order_ = std::move(post_order);
+    }
+    else
+    {
+        std::unordered_set<node *> scheduled(compute_order_.begin(), compute_order_.end());
+        if (post_order.size() != compute_order_.size()
+            || !std::all_of(post_order.begin(), post_order.end(), [&](node *n) { return scheduled.contains(n); }))
+            throw std::runtime_error("Buffer alias passes changed the nodes of " + graph->name() + " after its compute order was chosen");
+    }
 
-    alloc_visitor.visit(outputs_);
+    std::unordered_set<node *> used_inputs;
+    for (auto node : compute_order_)
+    {
+        if (node->runtime_opcode() == op_input_node)
+            used_inputs.emplace(node);
+        else if (mod_sched_.model_sched().skip_buffer_alias() || (node->attributes() & node_attr_action))
+            compute_sequence.emplace_back(node);
+    }
 
     size_t i = 0;
     for (auto in : graph->inputs())
@@ -190,23 +462,39 @@ void function_schedule_context::generate_compute_sequence()
 
 void function_schedule_context::make_logical_buffers(caller_context &caller_ctx)
 {
-    auto skip_buffer_alias = mod_sched_.model_sched().skip_buffer_alias();
     lifetime_recorder lr(logical_buffers_, logical_buffer_map_);
 
     // 1. Adjust base age to caller's age
     lr.current_age(caller_ctx.lifetime.current_age());
 
     // 2. Estimate buffer lifetime
-    auto alloc_visitor = make_relay_ir_visitor([&](node &node) {
+    record_lifetimes(lr, true);
+    lr.finish();
+
+    // 3. Adjust caller's age to now
+    caller_ctx.lifetime.current_age(lr.current_age());
+}
+
+void function_schedule_context::record_lifetimes(lifetime_recorder &lr, bool visit_callees)
+{
+    auto skip_buffer_alias = mod_sched_.model_sched().skip_buffer_alias();
+    for (auto n : compute_order_)
+    {
+        auto &node = *n;
         for (auto out : node.outputs())
             lr.allocate(*out, decide_memory_location(*out, skip_buffer_alias));
 
         lr.grow_age();
 
-        if (auto c = node_cast<call>(node))
+        auto c = node_cast<call>(node);
+        if (c && visit_callees)
         {
+            // The callee times its own phases, keep them out of ours.
+            auto &liveness = mod_sched_.model_sched().model_result().timings.liveness;
+            auto begin = std::chrono::steady_clock::now();
             caller_context new_caller_ctx { lr };
             mod_sched_.model_sched().visit_function(c->target(), new_caller_ctx);
+            liveness -= std::chrono::steady_clock::now() - begin;
         }
 
         for (auto in : node.inputs())
@@ -215,11 +503,7 @@ void function_schedule_context::make_logical_buffers(caller_context &caller_ctx)
             assert(out);
             lr.release(*out);
         }
-    });
-    alloc_visitor.visit(outputs_);
-
-    // 3. Adjust caller's age to now
-    caller_ctx.lifetime.current_age(lr.current_age());
+    }
 }
 
 void function_schedule_context::analyze_buffer_alias()
@@ -297,13 +581,7 @@ void function_schedule_context::make_physical_buffers()
 
 void function_schedule_context::allocate_physical_buffers()
 {
-    std::vector<physical_buffer *> orders;
-    orders.reserve(physical_buffers_.size());
-    for (auto &b : physical_buffers_)
-        orders.emplace_back(&b);
-    std::sort(orders.begin(), orders.end(), [](const physical_buffer *lhs, const physical_buffer *rhs) { return lhs->lifetime().birth < rhs->lifetime().birth; });
-
-    for (auto &b : orders)
+    for (auto b : sorted_by_birth(physical_buffers_))
     {
         auto location = b->owner().memory_location();
         if (location != mem_shared_data)
@@ -358,7 +636,27 @@ void function_schedule_context::dump(const std::filesystem::path &dump_dir)
         };
 
         // 1. allocation
-        writer << ".physical_buffer" << std::endl;
+        std::map<memory_location_t, buffer_allocator *> allocators(allocators_.begin(), allocators_.end());
+        writer << ".allocator" << std::endl;
+        for (auto &[location, allocator] : allocators)
+        {
+            writer << to_string(location) << ": ";
+            allocator->dump(writer);
+            writer << std::endl;
+        }
+
+        if (mod_sched_.model_sched().compute_order() == compute_order::min_peak_memory)
+        {
+            writer << std::endl
+                   << ".compute_order" << std::endl
+                   << fmt::format("post_order: data pool {} bytes", post_order_pool_) << std::endl
+                   << fmt::format("min_peak_memory: data pool {} bytes", min_peak_pool_) << std::endl
+                   << fmt::format("difference: {} bytes", (ptrdiff_t)post_order_pool_ - (ptrdiff_t)min_peak_pool_) << std::endl
+                   << fmt::format("selected: {}", reordered_ ? "min_peak_memory" : "post_order") << std::endl;
+        }
+
+        writer << std::endl
+               << ".physical_buffer" << std::endl;
         for (auto &buf : physical_buffers_)
         {
             auto alloc = buf.allocation();
@@ -43,8 +43,8 @@ void lifetime_recorder::release(ir::output_connector &conn)
         auto &lifetime = node->second->lifetime();
         if (!lifetime.is_alive())
             throw std::runtime_error("Trying to free a released buffer");
-        else
-            lifetime.used_count--;
+        else if (--lifetime.used_count == 0)
+            lifetime.age = cnt_age_ - lifetime.birth;
     }
 }
 
@@ -58,12 +58,16 @@ void lifetime_recorder::current_age(size_t age)
     if (age < cnt_age_)
         throw std::invalid_argument("Cannot set back age");
 
-    auto increase = age - cnt_age_;
+    // Ages are taken from birth when the last user releases a buffer, so nothing to update here.
     cnt_age_ = age;
+}
+
+void lifetime_recorder::finish()
+{
     for (auto &b : buffers_)
     {
         auto &lifetime = b.lifetime();
         if (lifetime.is_alive())
-            lifetime.age += increase;
+            lifetime.age = cnt_age_ - lifetime.birth;
     }
 }
@@ -12,6 +12,8 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  */
+#include <chrono>
+#include <fstream>
 #include <nncase/schedule/schedule_context.h>
 #include <nncase/schedule/scheduler.h>
 #include <nncase/targets/target.h>
@@ -27,10 +29,26 @@ scheduler::scheduler(target &target, ir::graph &main_graph, std::span<ir::output
 
 model_schedule_result scheduler::schedule(bool skip_buffer_alias)
 {
+    auto begin = std::chrono::steady_clock::now();
     model_schedule_result result {};
     model_schedule_context context(result, target_, skip_buffer_alias);
     context.config_dump(dump_dir_);
+    context.config_compute_order(compute_order_);
     context.schedule(main_graph_);
+    result.timings.total = std::chrono::steady_clock::now() - begin;
+
+    if (!dump_dir_.empty())
+    {
+        auto ms = [](std::chrono::nanoseconds duration) { return std::chrono::duration<double, std::milli>(duration).count(); };
+        auto &timings = result.timings;
+        std::ofstream writer(dump_dir_ / "schedule.timing");
+        writer << "liveness: " << ms(timings.liveness) << "ms" << std::endl
+               << "buffer_alias: " << ms(timings.buffer_alias) << "ms" << std::endl
+               << "compute_sequence: " << ms(timings.compute_sequence) << "ms" << std::endl
+               << "allocation: " << ms(timings.allocation) << "ms" << std::endl
+               << "total: " << ms(timings.total) << "ms" << std::endl;
+    }
+
     return result;
 }
 
@@ -38,3 +56,8 @@ void scheduler::config_dump(std::filesystem::path dump_dir)
 {
     dump_dir_ = std::move(dump_dir);
 }
+
+void scheduler::config_compute_order(compute_order order)
+{
+    compute_order_ = order;
+}
@@ -18,9 +18,25 @@
 #include <nncase/runtime/stackvm/runtime_module.h>
 #include <nncase/targets/target.h>
 #include <nncase/transforms/pass.h>
+#include <iomanip>
+#include <sstream>
 
 using namespace nncase;
 
+std::vector<std::pair<std::string, std::string>> target_options::cache_values() const
+{
+    std::ostringstream threshold;
+    threshold << std::setprecision(9) << weights_quantize_threshold;
+    return {
+        { "input_type", input_type },
+        { "inference_type", inference_type },
+        { "weights_quantize_threshold", threshold.str() },
+        { "output_quantize_threshold", std::to_string(output_quantize_threshold) },
+        { "quantize_binary", std::to_string(quantize_binary) },
+        { "is_fpga", std::to_string(is_fpga) }
+    };
+}
+
 target_options &target::options()
 {
     if (!options_)
@@ -88,6 +88,4 @@ void tflite_detection_postprocess_transform::process(transform_context &context)
     new_output_node_1->input().connect(new_tdp->output_classes());
     new_output_node_2->input().connect(new_tdp->output_scores());
     new_output_node_3->input().connect(new_tdp->output_num_detections());
-
-    context.graph.dce();
 }
\ No newline at end of file
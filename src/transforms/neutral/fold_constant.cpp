@@ -13,37 +13,80 @@
  * limitations under the License.
  */
 #include <nncase/ir/evaluator.h>
+#include <nncase/ir/op_utils.h>
 #include <nncase/ir/ops/constant.h>
 #include <nncase/ir/visitor.h>
-#include <nncase/schedule/scheduler.h>
-#include <nncase/targets/target.h>
 #include <nncase/transforms/neutral/fold_constant.h>
+#include <unordered_map>
 #include <unordered_set>
 
 using namespace nncase;
 using namespace nncase::ir;
 using namespace nncase::ir::transforms;
-using namespace nncase::schedule;
 
 namespace
 {
 std::unordered_set<node_opcode> dontfold_ops {};
+
+bool is_foldable(node &node)
+{
+    return (node.attributes() & node_attr_skip_constant_folding) == 0
+        && dontfold_ops.find(node.runtime_opcode()) == dontfold_ops.end()
+        && node.inputs().size();
+}
+
+bool is_constant(input_connector &in)
+{
+    return in.connection()->owner().runtime_opcode() == op_constant;
+}
 }
 
 bool fold_constant_transform::on_try_match(node &node, transform_context &context)
 {
-    if ((node.attributes() & node_attr_skip_constant_folding) == 0
-        && dontfold_ops.find(node.runtime_opcode()) == dontfold_ops.end()
-        && node.inputs().size() && std::all_of(node.inputs().begin(), node.inputs().end(), [](input_connector *in) { return in->connection()->owner().runtime_opcode() == op_constant; }))
+    if (is_foldable(node) && std::all_of(node.inputs().begin(), node.inputs().end(), [](input_connector *in) { return is_constant(*in); }))
     {
-        for (auto &in : node.inputs())
-            context.inputs.emplace_back(in);
-        for (auto out : node.outputs())
-            context.outputs.emplace_back(out);
-
+        // Grow the match over consumers fed only by constants and nodes already matched, so a
+        // constant subgraph folds in one rewrite. Nodes are matched in topological order.
+        std::unordered_set<ir::node *> folded { &node };
         context.matched_nodes.emplace_back(&node);
-        for (auto in : node.inputs())
-            context.matched_nodes.emplace_back(&in->connection()->owner());
+        for (size_t i = 0; i < context.matched_nodes.size(); i++)
+        {
+            for (auto out : context.matched_nodes[i]->outputs())
+            {
+                for (auto conn : out->connections())
+                {
+                    auto &consumer = conn->owner();
+                    if (!folded.contains(&consumer) && is_foldable(consumer)
+                        && std::all_of(consumer.inputs().begin(), consumer.inputs().end(), [&](input_connector *in) { return is_constant(*in) || folded.contains(&in->connection()->owner()); }))
+                    {
+                        folded.emplace(&consumer);
+                        context.matched_nodes.emplace_back(&consumer);
+                    }
+                }
+            }
+        }
+
+        const auto folded_count = context.matched_nodes.size();
+        for (size_t i = 0; i < folded_count; i++)
+        {
+            auto n = context.matched_nodes[i];
+            for (auto in : n->inputs())
+            {
+                if (is_constant(*in))
+                {
+                    context.inputs.emplace_back(in);
+                    context.matched_nodes.emplace_back(&in->connection()->owner());
+                }
+            }
+
+            // Only results used outside of the matched nodes become constants
+            for (auto out : n->outputs())
+            {
+                if (std::any_of(out->connections().begin(), out->connections().end(), [&](input_connector *conn) { return !folded.contains(&conn->owner()); }))
+                    context.outputs.emplace_back(out);
+            }
+        }
+
         return true;
     }
 
@@ -52,51 +95,66 @@ bool fold_constant_transform::on_try_match(node &node, transform_context &contex
 
 void fold_constant_transform::process(transform_context &context)
 {
-    //auto &output = *context.inputs[0]->connection();
-    //auto inputs = context.outputs[0]->connections();
-
-    auto &old_op = *context.matched_nodes[0];
+    std::vector<node *> nodes;
+    for (auto n : context.matched_nodes)
+    {
+        if (n->runtime_opcode() != op_constant)
+            nodes.emplace_back(n);
+    }
 
-    // 1. Construct new eval graph
-    graph new_graph;
-    std::vector<output_node *> op_outputs;
-    std::vector<constant *> output_values;
-    for (auto out : old_op.outputs())
+    // 1. Count the uses of intermediate results, so they can be released after their last consumer
+    std::unordered_map<output_connector *, size_t> uses;
+    for (auto n : nodes)
     {
-        auto node = op_outputs.emplace_back(new_graph.emplace<output_node>(out->type(), out->shape()));
-        if (old_op.outputs().size() > 1)
-            node->name(out->name() + "_F");
-        else
-            node->name(out->owner().name());
-        node->input().connect(*out);
+        for (auto in : n->inputs())
+        {
+            if (!is_constant(*in))
+                uses[in->connection()]++;
+        }
     }
 
-    // 2. Eval
+    for (auto out : context.outputs)
+        uses.erase(out);
+
+    // 2. Eval nodes directly on temporary buffers
+    function_evaluate_context eval;
+    std::unordered_map<output_connector *, std::vector<std::byte>> buffers;
+    for (auto n : nodes)
     {
-        scheduler sch(context.target, new_graph, new_graph.outputs());
-        auto schr = sch.schedule();
-        ir::evaluator eval(schr);
-        eval.evaluate();
+        for (auto in : n->inputs())
+        {
+            if (is_constant(*in))
+            {
+                // Evaluators never write to their inputs, so constant data is bound in place
+                auto data = static_cast<constant &>(in->connection()->owner()).data();
+                eval.bind(*in->connection(), { const_cast<std::byte *>(data.data()), data.size() });
+            }
+        }
+
+        for (auto out : n->outputs())
+            eval.bind(*out, buffers.emplace(out, get_bytes(out->type(), out->shape())).first->second);
+
+        eval.evaluate(*n);
 
-        for (size_t i = 0; i < op_outputs.size(); i++)
+        for (auto in : n->inputs())
         {
-            auto &op_output = *op_outputs[i];
-            // TODO: consider of strides
-            auto mem = eval.output_at(i).buffer().as_span<std::byte>();
-            auto out_val = context.graph.emplace<constant>(op_output.input().type(), op_output.input().shape(), mem.begin(), mem.end());
-            out_val->name(op_output.name());
-            output_values.emplace_back(out_val);
+            auto it = uses.find(in->connection());
+            if (it != uses.end() && --it->second == 0)
+                buffers.erase(in->connection());
         }
     }
 
-    // 3. Clear eval graph connections to main graph
-    for (auto &out : op_outputs)
-        out->input().clear_connection();
-
-    for (size_t i = 0; i < old_op.outputs().size(); i++)
+    // 3. Replace the used results with constants
+    for (auto out : context.outputs)
     {
-        auto &out = old_op.outputs()[i];
+        auto &mem = buffers.at(out);
+        auto out_val = context.graph.emplace<constant>(out->type(), out->shape(), mem.begin(), mem.end());
+        if (out->owner().outputs().size() > 1)
+            out_val->name(out->name() + "_F");
+        else
+            out_val->name(out->owner().name());
+
         for (auto &in : dup(out->connections()))
-            in->connect(output_values[i]->output());
+            in->connect(out_val->output());
     }
 }
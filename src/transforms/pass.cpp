@@ -13,10 +13,17 @@
  * limitations under the License.
  */
 #include <algorithm>
+#include <cstdlib>
 #include <filesystem>
+#include <fstream>
 #include <nncase/ir/debug.h>
 #include <nncase/ir/visitor.h>
 #include <nncase/transforms/pass.h>
+#include <typeinfo>
+#include <unordered_set>
+#ifdef __GNUC__
+#include <cxxabi.h>
+#endif
 
 using namespace nncase;
 using namespace nncase::ir;
@@ -24,34 +31,101 @@ using namespace nncase::ir::transforms;
 
 namespace
 {
-class transform_apply_visitor : public dfs_ir_post_order_visitor
+bool has_consumers(node &n) noexcept
 {
-public:
-    using dfs_ir_post_order_visitor::visit;
-    ir::graph *graph;
-    ir::quantizer *quantizer;
-    nncase::target *target;
-    std::optional<std::filesystem::path> dump_dir;
-    bool need_retry = false;
-    transforms::transform *transform;
-
-protected:
-    bool visit(node &node) override
+    return std::any_of(n.outputs().begin(), n.outputs().end(), [](output_connector *out) { return !out->connections().empty(); });
+}
+
+// An output node is kept alive by its producer rather than by consumers.
+bool is_live_output(node &n) noexcept
+{
+    return n.runtime_opcode() == op_output_node
+        && std::any_of(n.inputs().begin(), n.inputs().end(), [](input_connector *in) { return in->connection(); });
+}
+
+void add_neighbours(node &n, std::vector<node *> &nodes)
+{
+    for (auto in : n.inputs())
     {
-        auto context = transform->create_context(*graph, *target);
-        context->quantizer = quantizer;
-        context->dump_dir = dump_dir;
+        if (in->connection())
+            nodes.emplace_back(&in->connection()->owner());
+    }
 
-        if (transform->try_match(node, *context))
+    for (auto out : n.outputs())
+    {
+        for (auto conn : out->connections())
+            nodes.emplace_back(&conn->owner());
+    }
+}
+
+// Disconnects the touched nodes a rewrite left without consumers, cascading to their producers,
+// and collects them in `dead`. Producers that lose a consumer are added to `touched`.
+void sweep_dead(std::vector<node *> &touched, std::unordered_set<node *> &dead)
+{
+    auto candidates = touched;
+    while (!candidates.empty())
+    {
+        auto n = candidates.back();
+        candidates.pop_back();
+        if (dead.contains(n) || has_consumers(*n) || is_live_output(*n))
+            continue;
+
+        dead.emplace(n);
+        for (auto in : n->inputs())
         {
-            transform->process(*context);
-            need_retry = true;
-            return true;
+            if (auto conn = in->connection())
+            {
+                in->clear_connection();
+                touched.emplace_back(&conn->owner());
+                candidates.emplace_back(&conn->owner());
+            }
         }
+    }
+}
 
-        return false;
+// Nodes within max_radius hops of the touched ones, with their distance, nearest first.
+std::vector<std::pair<node *, size_t>> neighbourhood(const std::vector<node *> &touched, size_t max_radius)
+{
+    std::unordered_set<node *> seen;
+    std::vector<std::pair<node *, size_t>> nodes;
+    std::vector<node *> next;
+    for (auto n : touched)
+    {
+        if (seen.emplace(n).second)
+            nodes.emplace_back(n, 0);
     }
-};
+
+    for (size_t i = 0; i < nodes.size(); i++)
+    {
+        auto [n, hops] = nodes[i];
+        if (hops == max_radius)
+            continue;
+
+        next.clear();
+        add_neighbours(*n, next);
+        for (auto neighbour : next)
+        {
+            if (seen.emplace(neighbour).second)
+                nodes.emplace_back(neighbour, hops + 1);
+        }
+    }
+
+    return nodes;
+}
+
+std::string transform_name(transform &transform)
+{
+    auto name = transform.name();
+    if (name != "noname")
+        return name;
+#ifdef __GNUC__
+    int status;
+    std::unique_ptr<char, decltype(&std::free)> demangled(abi::__cxa_demangle(typeid(transform).name(), nullptr, nullptr, &status), &std::free);
+    if (status == 0)
+        return demangled.get();
+#endif
+    return typeid(transform).name();
+}
 }
 
 void pass::run(graph &graph, target &target, const run_pass_options &options)
@@ -65,37 +139,191 @@ void pass::run(graph &graph, target &target, const run_pass_options &options)
         auto dump_path = *options.dump_dir / "passes" / pass_name;
         std::filesystem::create_directories(dump_path);
         ir::dump_graph(graph, dump_path);
+        dump_core(dump_path);
     }
 }
 
+void pass::dump_core([[maybe_unused]] const std::filesystem::path &dump_path)
+{
+}
+
 void transform_pass::run_core(graph &graph, target &target, const run_pass_options &options)
 {
-    transform_apply_visitor visitor;
-    visitor.graph = &graph;
-    visitor.target = &target;
-    visitor.dump_dir = options.dump_dir;
-    visitor.quantizer = options.quantizer;
-    bool next_pass = false;
-
-    do
+    using clock = std::chrono::steady_clock;
+
+    std::vector<std::unique_ptr<transform_context>> contexts;
+    stats_.clear();
+    for (auto &transform : transforms_)
     {
-        next_pass = false;
+        auto &context = contexts.emplace_back(transform->create_context(graph, target));
+        context->quantizer = options.quantizer;
+        context->dump_dir = options.dump_dir;
+        stats_.emplace_back().name = transform_name(*transform);
+    }
 
-        for (size_t idx = 0; idx < transforms_.size(); idx++)
-        {
-            auto &&transform = transforms_[idx];
-            visitor.transform = transform.get();
-            visitor.need_retry = false;
-            visitor.visit(graph);
+    auto try_match = [&](size_t idx, node &node) {
+        auto &context = *contexts[idx];
+        auto &stat = stats_[idx];
+        context.matched_nodes.clear();
+        context.inputs.clear();
+        context.outputs.clear();
 
-            if (visitor.need_retry)
+        auto begin = clock::now();
+        auto matched = transforms_[idx]->try_match(node, context);
+        stat.match_time += clock::now() - begin;
+        stat.tries++;
+        return matched;
+    };
+
+    // Rewrites are applied exactly as the graph would be rewritten by walking it again after
+    // each of them: the first transform in priority order with a match, at its first match in
+    // post order, with dce run after every rewrite.
+    //
+    // Transforms with a bounded match_radius keep the set of nodes they match. A rewrite can
+    // only change whether a node matches if the node is within that radius of a node the
+    // rewrite created, removed or rewired, so only those are matched again. That assumes
+    // process only rewires the matched nodes, their neighbours and the nodes it creates.
+    // Transforms without a bound are matched over the whole graph after every rewrite,
+    // stopping at their first match. Finding the first match in post order takes a walk of
+    // the graph either way, which is cheap next to matching every transform on every node.
+    auto is_bounded = [&](size_t idx) { return transforms_[idx]->match_radius() != transform::unbounded_match_radius; };
+    size_t max_radius = 0;
+    for (size_t idx = 0; idx < transforms_.size(); idx++)
+    {
+        if (is_bounded(idx))
+            max_radius = std::max(max_radius, transforms_[idx]->match_radius());
+    }
+
+    std::vector<std::unordered_set<node *>> matches(transforms_.size());
+    auto rescan = [&]() {
+        for (auto &nodes : matches)
+            nodes.clear();
+        auto visitor = make_relay_ir_visitor([&](node &node) {
+            for (size_t idx = 0; idx < transforms_.size(); idx++)
             {
-                next_pass = true;
-                graph.dce();
+                if (is_bounded(idx) && try_match(idx, node))
+                    matches[idx].emplace(&node);
+            }
+        });
+        visitor.visit(graph);
+    };
+
+    // Returns the first node in post order the transform matches, with the match left in its
+    // context. A saved match that no longer holds means some match_radius is too small, so
+    // `stale` is set instead of returning a later match a fresh walk would not pick.
+    auto first_match = [&](size_t idx, bool &stale) -> node * {
+        const auto bounded = is_bounded(idx);
+        if (bounded && matches[idx].empty())
+            return nullptr;
+
+        node *found = nullptr;
+        auto visitor = make_relay_ir_visitor([&](node &node) {
+            if (bounded && !matches[idx].contains(&node))
+                return false;
+            if (try_match(idx, node))
+                found = &node;
+            else if (bounded)
+                stale = true;
+            return found || stale;
+        });
+        visitor.visit(graph);
+        return found;
+    };
+
+    std::vector<node *> touched;
+    std::unordered_set<node *> dead;
+    rescan();
+    while (true)
+    {
+        node *target_node = nullptr;
+        bool stale = false;
+        size_t idx = 0;
+        for (; idx < transforms_.size(); idx++)
+        {
+            target_node = first_match(idx, stale);
+            if (target_node || stale)
                 break;
+        }
+
+        if (stale)
+        {
+            rescan();
+            continue;
+        }
+
+        if (!target_node)
+            break;
+
+        // Consumers are relinked by process, so collect the neighbours before it runs.
+        auto &context = *contexts[idx];
+        touched.assign(context.matched_nodes.begin(), context.matched_nodes.end());
+        touched.emplace_back(target_node);
+        for (size_t i = 0, matched = touched.size(); i < matched; i++)
+            add_neighbours(*touched[i], touched);
+
+        const auto old_nodes = graph.nodes().size();
+        auto begin = clock::now();
+        transforms_[idx]->process(context);
+        stats_[idx].process_time += clock::now() - begin;
+        stats_[idx].matches++;
+
+        // A transform that removed nodes itself invalidated every saved pointer.
+        if (graph.nodes().size() < old_nodes)
+        {
+            graph.dce();
+            rescan();
+            continue;
+        }
+
+        for (auto &new_node : graph.nodes().subspan(old_nodes))
+            touched.emplace_back(new_node.get());
+
+        dead.clear();
+        sweep_dead(touched, dead);
+        for (auto &nodes : matches)
+        {
+            for (auto n : dead)
+                nodes.erase(n);
+        }
+
+        std::erase_if(touched, [&](node *n) { return dead.contains(n); });
+        const auto live_nodes = graph.nodes().size() - dead.size();
+        graph.dce();
+
+        // dce also frees nodes that were unreachable before the rewrite. Those were never
+        // matched, but a count that doesn't add up may as well hide a freed node that was.
+        if (graph.nodes().size() != live_nodes)
+        {
+            rescan();
+            continue;
+        }
+
+        for (auto [n, hops] : neighbourhood(touched, max_radius))
+        {
+            for (size_t i = 0; i < transforms_.size(); i++)
+            {
+                if (is_bounded(i) && hops <= transforms_[i]->match_radius())
+                {
+                    if (try_match(i, *n))
+                        matches[i].emplace(n);
+                    else
+                        matches[i].erase(n);
+                }
             }
         }
-    } while (next_pass);
+    }
+}
+
+void transform_pass::dump_core(const std::filesystem::path &dump_path)
+{
+    std::ofstream file(dump_path / "transforms.csv");
+    file << "transform,tries,matches,match_us,process_us" << std::endl;
+    for (auto &stat : stats_)
+    {
+        file << stat.name << ',' << stat.tries << ',' << stat.matches << ','
+             << std::chrono::duration_cast<std::chrono::microseconds>(stat.match_time).count() << ','
+             << std::chrono::duration_cast<std::chrono::microseconds>(stat.process_time).count() << std::endl;
+    }
 }
 
 void pass_manager::dump_dir(const std::filesystem::path &dir)
@@ -70,6 +70,11 @@ bool transform::skip_self_contained_check() const noexcept
     return false;
 }
 
+size_t transform::match_radius() const noexcept
+{
+    return unbounded_match_radius;
+}
+
 void nncase::ir::transforms::link(ir::output_connector &old_c, ir::output_connector &new_c, [[maybe_unused]] ir::quantizer *quantizer)
 {
     new_c.attributes(old_c.attributes());
@@ -0,0 +1,114 @@
+/* Copyright 2019-2021 Canaan Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <gtest/gtest.h>
+#include <list>
+#include <memory>
+#include <nncase/ir/placeholders.h>
+#include <nncase/schedule/buffer_allocator.h>
+#include <vector>
+
+using namespace nncase;
+using namespace nncase::ir;
+using namespace nncase::schedule;
+
+namespace
+{
+struct buffer_desc
+{
+    size_t birth;
+    size_t age;
+    size_t size;
+};
+
+// Logical and physical buffers of uint8 tensors with the given lifetimes, in birth order
+class lifetime_table
+{
+public:
+    lifetime_table(const std::vector<buffer_desc> &descs)
+    {
+        for (auto &desc : descs)
+        {
+            auto &owner = *nodes_.emplace_back(std::make_unique<input_node>(dt_uint8, shape_t { desc.size }));
+            auto &logical = logical_buffers_.emplace_back(logical_buffers_.size(), owner.output(), mem_data);
+            logical.lifetime() = { 1, desc.birth, desc.age };
+            physical_buffers_.emplace_back(physical_buffers_.size(), logical);
+        }
+    }
+
+    void mark(buffer_allocator &allocator) const
+    {
+        for (auto &buffer : physical_buffers_)
+            allocator.mark(buffer);
+        allocator.finish();
+    }
+
+    // Buffers living at the same time must not share memory
+    void check_no_overlap(const buffer_allocator &allocator) const
+    {
+        auto &allocations = allocator.allocations();
+        for (auto &lhs : physical_buffers_)
+        {
+            for (auto &rhs : physical_buffers_)
+            {
+                if (&lhs >= &rhs)
+                    continue;
+
+                auto &l = lhs.lifetime();
+                auto &r = rhs.lifetime();
+                if (l.birth < r.end() && r.birth < l.end())
+                {
+                    auto &la = allocations.at(&lhs);
+                    auto &ra = allocations.at(&rhs);
+                    EXPECT_TRUE(la.end() <= ra.start || ra.end() <= la.start)
+                        << "buffers " << lhs.id() << " and " << rhs.id() << " overlap";
+                }
+            }
+        }
+    }
+
+private:
+    std::vector<std::unique_ptr<input_node>> nodes_;
+    std::list<logical_buffer> logical_buffers_;
+    std::list<physical_buffer> physical_buffers_;
+};
+
+class BufferAllocatorTest : public ::testing::TestWithParam<std::vector<buffer_desc>>
+{
+};
+}
+
+TEST_P(BufferAllocatorTest, greedy_by_size_not_larger_than_first_fit)
+{
+    lifetime_table table(GetParam());
+    first_fit_allocator first_fit;
+    greedy_by_size_allocator greedy;
+    table.mark(first_fit);
+    table.mark(greedy);
+
+    table.check_no_overlap(first_fit);
+    table.check_no_overlap(greedy);
+    EXPECT_LE(greedy.max_usage(), first_fit.max_usage());
+}
+
+INSTANTIATE_TEST_SUITE_P(BufferAllocator, BufferAllocatorTest,
+    testing::Values(
+        // A chain, each buffer freed once its consumer runs
+        std::vector<buffer_desc> { { 0, 2, 64 }, { 1, 2, 64 }, { 2, 2, 64 }, { 3, 2, 64 }, { 4, 1, 64 } },
+        // A small long-lived buffer born early pins first fit's layout
+        std::vector<buffer_desc> { { 0, 1, 256 }, { 0, 6, 16 }, { 1, 2, 128 }, { 2, 2, 512 }, { 3, 2, 128 }, { 4, 2, 512 }, { 5, 1, 64 } },
+        // Residual blocks: a skip connection outlives the branch beside it
+        std::vector<buffer_desc> { { 0, 4, 200 }, { 1, 1, 400 }, { 2, 1, 400 }, { 3, 1, 200 }, { 4, 4, 200 }, { 5, 1, 400 }, { 6, 1, 400 }, { 7, 1, 200 }, { 8, 1, 200 } },
+        // Interleaved lifetimes of varied sizes
+        std::vector<buffer_desc> { { 0, 3, 40 }, { 1, 5, 300 }, { 2, 1, 24 }, { 3, 4, 120 }, { 4, 2, 1000 }, { 5, 3, 8 }, { 6, 2, 600 }, { 7, 1, 72 }, { 8, 1, 16 } }));
@@ -0,0 +1,160 @@
+/* Copyright 2019-2021 Canaan Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "compile_cache.h"
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <vector>
+
+using namespace nncase;
+namespace fs = std::filesystem;
+
+namespace
+{
+std::span<const uint8_t> as_bytes(std::string_view text) noexcept
+{
+    return { reinterpret_cast<const uint8_t *>(text.data()), text.size() };
+}
+
+compile_cache_key make_key(std::string_view target, std::string_view model)
+{
+    compile_cache_key key;
+    key.add("target", target);
+    key.add("model", as_bytes(model));
+    return key;
+}
+}
+
+class CompileCacheTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        auto test = ::testing::UnitTest::GetInstance()->current_test_info();
+        dir_ = fs::temp_directory_path() / (std::string("nncase_compile_cache_") + test->name());
+        fs::remove_all(dir_);
+    }
+
+    void TearDown() override
+    {
+        fs::remove_all(dir_);
+    }
+
+    fs::path dir_;
+    std::vector<uint8_t> kmodel_ { 'K', 'M', 'D', 'L', 1, 2, 3, 4 };
+};
+
+TEST_F(CompileCacheTest, hit)
+{
+    compile_cache cache(dir_, 1 << 20);
+    cache.store(make_key("cpu", "model"), kmodel_);
+
+    auto loaded = cache.load(make_key("cpu", "model"));
+    ASSERT_TRUE(loaded);
+    EXPECT_EQ(kmodel_, *loaded);
+}
+
+TEST_F(CompileCacheTest, miss)
+{
+    compile_cache cache(dir_, 1 << 20);
+    EXPECT_FALSE(cache.load(make_key("cpu", "model")));
+}
+
+TEST_F(CompileCacheTest, key_change)
+{
+    compile_cache cache(dir_, 1 << 20);
+    cache.store(make_key("cpu", "model"), kmodel_);
+
+    EXPECT_FALSE(cache.load(make_key("k210", "model")));
+    EXPECT_FALSE(cache.load(make_key("cpu", "modem")));
+    auto extended = make_key("cpu", "model");
+    extended.add("target.is_fpga", "1");
+    EXPECT_FALSE(cache.load(extended));
+    EXPECT_NE(make_key("cpu", "model").digest(), extended.digest());
+    EXPECT_TRUE(cache.load(make_key("cpu", "model")));
+}
+
+TEST_F(CompileCacheTest, corrupt_entry)
+{
+    compile_cache cache(dir_, 1 << 20);
+    auto key = make_key("cpu", "model");
+    cache.store(key, kmodel_);
+    auto model_path = dir_ / (key.digest() + ".kmodel");
+
+    // Truncated kmodel
+    fs::resize_file(model_path, kmodel_.size() / 2);
+    EXPECT_FALSE(cache.load(key));
+
+    // Same size, different content
+    cache.store(key, kmodel_);
+    {
+        std::ofstream file(model_path, std::ios::binary | std::ios::in);
+        file.put('X');
+    }
+    EXPECT_FALSE(cache.load(key));
+
+    // Missing manifest
+    cache.store(key, kmodel_);
+    fs::remove(fs::path(model_path).replace_extension(".key"));
+    EXPECT_FALSE(cache.load(key));
+
+    // Rewriting the entry repairs it
+    cache.store(key, kmodel_);
+    auto loaded = cache.load(key);
+    ASSERT_TRUE(loaded);
+    EXPECT_EQ(kmodel_, *loaded);
+}
+
+TEST_F(CompileCacheTest, evict_least_recently_used)
+{
+    auto a = make_key("cpu", "model_a"), b = make_key("cpu", "model_b"), c = make_key("cpu", "model_c");
+    {
+        compile_cache cache(dir_, 1 << 20);
+        cache.store(a, kmodel_);
+    }
+
+    uint64_t entry_size = 0;
+    for (auto &file : fs::directory_iterator(dir_))
+        entry_size += file.file_size();
+
+    // Room for two entries: storing a third evicts the one used longest ago
+    compile_cache cache(dir_, 2 * entry_size);
+    cache.store(b, kmodel_);
+    auto now = fs::file_time_type::clock::now();
+    fs::last_write_time(dir_ / (a.digest() + ".kmodel"), now - std::chrono::hours(1));
+    fs::last_write_time(dir_ / (b.digest() + ".kmodel"), now - std::chrono::hours(2));
+    cache.store(c, kmodel_);
+
+    EXPECT_FALSE(fs::exists(dir_ / (b.digest() + ".kmodel")));
+    EXPECT_FALSE(fs::exists(dir_ / (b.digest() + ".key")));
+    EXPECT_FALSE(cache.load(b));
+    EXPECT_TRUE(cache.load(a));
+    EXPECT_TRUE(cache.load(c));
+}
+
+TEST_F(CompileCacheTest, remove_stale_temp_files)
+{
+    fs::create_directories(dir_);
+    auto stale = dir_ / "stale.kmodel.1.tmp", fresh = dir_ / "fresh.kmodel.2.tmp";
+    std::ofstream(stale) << "partial";
+    std::ofstream(fresh) << "partial";
+    fs::last_write_time(stale, fs::file_time_type::clock::now() - std::chrono::hours(2));
+
+    compile_cache cache(dir_, 1 << 20);
+    cache.store(make_key("cpu", "model"), kmodel_);
+    EXPECT_FALSE(fs::exists(stale));
+    EXPECT_TRUE(fs::exists(fresh));
+}
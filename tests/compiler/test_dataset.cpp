@@ -0,0 +1,224 @@
+/* Copyright 2019-2021 Canaan Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <nncase/data/dataset.h>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace nncase;
+using namespace nncase::data;
+
+namespace
+{
+// Samples load out of order: later ones often finish before earlier ones
+void jitter(size_t index)
+{
+    std::this_thread::sleep_for(std::chrono::microseconds((index * 7919) % 5 * 200));
+}
+
+// RGB pixels of a 2x2 image, row by row. Values stay below 128 so the int8 path keeps them.
+constexpr uint8_t image_rgb[2][2][3] = {
+    { { 10, 20, 30 }, { 40, 50, 60 } },
+    { { 70, 80, 90 }, { 100, 110, 127 } }
+};
+
+// Writes image_rgb as a 24-bit BMP, which stores rows bottom-up in BGR order, padded to 4 bytes.
+void write_bmp(const std::filesystem::path &path)
+{
+    constexpr uint32_t row_size = 8, pixels_offset = 54, file_size = pixels_offset + 2 * row_size;
+    std::vector<uint8_t> bmp(file_size, 0);
+    auto put = [&](size_t offset, uint32_t value, size_t bytes) {
+        for (size_t i = 0; i < bytes; i++)
+            bmp[offset + i] = (uint8_t)(value >> (i * 8));
+    };
+
+    bmp[0] = 'B';
+    bmp[1] = 'M';
+    put(2, file_size, 4);
+    put(10, pixels_offset, 4);
+    put(14, 40, 4); // BITMAPINFOHEADER
+    put(18, 2, 4); // width
+    put(22, 2, 4); // height
+    put(26, 1, 2); // planes
+    put(28, 24, 2); // bits per pixel
+    put(34, 2 * row_size, 4);
+    for (size_t y = 0; y < 2; y++)
+    {
+        for (size_t x = 0; x < 2; x++)
+        {
+            for (size_t c = 0; c < 3; c++)
+                bmp[pixels_offset + (1 - y) * row_size + x * 3 + c] = image_rgb[y][x][2 - c];
+        }
+    }
+
+    std::ofstream file(path, std::ios::binary);
+    file.write(reinterpret_cast<const char *>(bmp.data()), bmp.size());
+}
+
+// image_rgb in `layout`: NHWC keeps the pixels together, NCHW gives R, G and B planes.
+std::vector<uint8_t> expected_image(const std::string &layout)
+{
+    std::vector<uint8_t> expected;
+    for (size_t i = 0; i < 12; i++)
+    {
+        const auto pixel = layout == "NHWC" ? i / 3 : i % 4;
+        const auto c = layout == "NHWC" ? i % 3 : i / 4;
+        expected.emplace_back(image_rgb[pixel / 2][pixel % 2][c]);
+    }
+
+    return expected;
+}
+
+template <class T>
+std::vector<T> load_image(const std::filesystem::path &dir, const std::string &layout)
+{
+    auto shape = layout == "NHWC" ? xt::dynamic_shape<size_t> { 1, 2, 2, 3 } : xt::dynamic_shape<size_t> { 1, 3, 2, 2 };
+    image_dataset dataset(dir, shape, layout);
+    auto it = dataset.begin<T>();
+    return std::vector<T>(it->tensor.begin(), it->tensor.end());
+}
+}
+
+TEST(SamplePrefetcherTest, in_order)
+{
+    constexpr size_t count = 40, slots = 3;
+    std::vector<size_t> slot_samples(slots, SIZE_MAX);
+    std::atomic<size_t> in_use = 0, max_in_use = 0;
+    auto main_thread = std::this_thread::get_id();
+    sample_prefetcher prefetcher(count, slots, [&](size_t index, size_t slot) {
+        EXPECT_NE(main_thread, std::this_thread::get_id());
+        auto used = ++in_use;
+        auto max_used = max_in_use.load();
+        while (used > max_used && !max_in_use.compare_exchange_weak(max_used, used))
+            ;
+        jitter(index);
+        slot_samples[slot] = index;
+    });
+
+    for (size_t i = 0; i < count; i++)
+    {
+        EXPECT_EQ(i, prefetcher.next());
+        auto slot = prefetcher.acquire();
+        ASSERT_LT(slot, slots);
+        EXPECT_EQ(i, slot_samples[slot]);
+        in_use--;
+        prefetcher.release(slot);
+    }
+
+    // Loaded samples hold their slots until released, so no more than `slots` are ever ahead
+    EXPECT_LE(max_in_use, slots);
+}
+
+TEST(SamplePrefetcherTest, end_of_data)
+{
+    std::atomic<size_t> loads = 0;
+    sample_prefetcher prefetcher(5, 8, [&](size_t, size_t) { loads++; });
+    for (size_t i = 0; i < 5; i++)
+        prefetcher.release(prefetcher.acquire());
+
+    EXPECT_EQ(5, prefetcher.next());
+    EXPECT_THROW(prefetcher.acquire(), std::out_of_range);
+    EXPECT_EQ(5, loads);
+
+    sample_prefetcher empty(0, 2, [&](size_t, size_t) { loads++; });
+    EXPECT_THROW(empty.acquire(), std::out_of_range);
+    EXPECT_EQ(5, loads);
+}
+
+TEST(SamplePrefetcherTest, load_error)
+{
+    constexpr size_t count = 20, bad = 6;
+    std::atomic<size_t> max_loaded = 0;
+    sample_prefetcher prefetcher(count, 4, [&](size_t index, size_t) {
+        jitter(index);
+        auto loaded = max_loaded.load();
+        while (index > loaded && !max_loaded.compare_exchange_weak(loaded, index))
+            ;
+        if (index == bad)
+            throw std::runtime_error("bad sample");
+    });
+
+    // Samples before the failed one are still delivered
+    for (size_t i = 0; i < bad; i++)
+        prefetcher.release(prefetcher.acquire());
+
+    // The error is thrown on the consumer thread, every time the failed sample is acquired
+    for (size_t attempt = 0; attempt < 2; attempt++)
+    {
+        try
+        {
+            prefetcher.acquire();
+            FAIL() << "expected the load error";
+        }
+        catch (const std::runtime_error &e)
+        {
+            EXPECT_STREQ("bad sample", e.what());
+        }
+    }
+
+    EXPECT_EQ(bad, prefetcher.next());
+
+    // Workers stop taking new samples after an error, only ones already started can finish
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_LT(max_loaded, bad + 4);
+}
+
+TEST(SamplePrefetcherTest, destroy_while_loading)
+{
+    std::atomic<size_t> loads = 0;
+    {
+        sample_prefetcher prefetcher(1000, 4, [&](size_t index, size_t) {
+            jitter(index);
+            loads++;
+        });
+        prefetcher.release(prefetcher.acquire());
+    }
+
+    // Workers are joined on destruction and nothing is loaded afterwards
+    auto loaded = loads.load();
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    EXPECT_EQ(loaded, loads);
+    EXPECT_LT(loaded, 1000);
+}
+
+TEST(ImageDatasetTest, layouts)
+{
+    auto dir = std::filesystem::temp_directory_path() / "nncase_image_dataset_layouts";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+    write_bmp(dir / "image.bmp");
+
+    for (std::string layout : { "NHWC", "NCHW" })
+    {
+        const auto expected = expected_image(layout);
+        EXPECT_EQ(expected, load_image<uint8_t>(dir, layout)) << layout;
+
+        const auto s8 = load_image<int8_t>(dir, layout);
+        EXPECT_EQ(expected, std::vector<uint8_t>(s8.begin(), s8.end())) << layout;
+
+        const auto f32 = load_image<float>(dir, layout);
+        ASSERT_EQ(expected.size(), f32.size()) << layout;
+        for (size_t i = 0; i < expected.size(); i++)
+            EXPECT_FLOAT_EQ(expected[i] / 255.f, f32[i]) << layout << " at " << i;
+    }
+
+    std::filesystem::remove_all(dir);
+}
@@ -0,0 +1,239 @@
+/* Copyright 2019-2021 Canaan Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <algorithm>
+#include <cstring>
+#include <gtest/gtest.h>
+#include <map>
+#include <nncase/ir/evaluator.h>
+#include <nncase/ir/graph.h>
+#include <nncase/ir/op_utils.h>
+#include <nncase/ir/ops/binary.h>
+#include <nncase/ir/ops/constant.h>
+#include <nncase/ir/ops/transpose.h>
+#include <nncase/ir/ops/unary.h>
+#include <nncase/ir/placeholders.h>
+#include <nncase/ir/visitor.h>
+#include <nncase/runtime/stackvm/runtime_module.h>
+#include <nncase/schedule/scheduler.h>
+#include <nncase/targets/neutral_target.h>
+#include <nncase/transforms/neutral/fold_constant.h>
+#include <nncase/transforms/pass.h>
+#include <string>
+#include <vector>
+
+using namespace nncase;
+using namespace nncase::ir;
+using namespace nncase::ir::transforms;
+using namespace nncase::schedule;
+
+namespace
+{
+std::vector<float> make_data(size_t size, float scale, float bias)
+{
+    std::vector<float> data(size);
+    for (size_t i = 0; i < size; i++)
+        data[i] = ((i * 37) % 23) * scale + bias;
+    return data;
+}
+
+// Constant subgraph:  add = c1 + c2 (broadcast), abs(add), transpose(abs), neg(c3)
+// Consumers:          in_a * transpose(abs(add)), in_b - add, in_a + neg(c3)
+// add is used both inside the constant chain and by a node that can't fold.
+void build_graph(graph &graph)
+{
+    shape_t shape { 2, 3, 4 };
+    auto c1 = graph.emplace<constant>(dt_float32, shape, make_data(24, 0.25f, -2.5f));
+    auto c2 = graph.emplace<constant>(dt_float32, shape_t { 4 }, make_data(4, 0.5f, -1.f));
+    auto c3 = graph.emplace<constant>(dt_float32, shape_t { 2, 4, 3 }, make_data(24, -0.125f, 1.f));
+    auto in_a = graph.emplace<input_node>(dt_float32, shape_t { 2, 4, 3 });
+    auto in_b = graph.emplace<input_node>(dt_float32, shape);
+    in_a->name("in_a");
+    in_b->name("in_b");
+
+    auto add = graph.emplace<binary>(binary_add, dt_float32, c1->output().shape(), c2->output().shape(), value_range<float>::full());
+    auto abs = graph.emplace<unary>(unary_abs, add->output().shape());
+    auto tp = graph.emplace<transpose>(dt_float32, abs->output().shape(), axis_t { 0, 2, 1 });
+    auto neg = graph.emplace<unary>(unary_neg, c3->output().shape());
+    add->name("add");
+    abs->name("abs");
+    tp->name("tp");
+    neg->name("neg");
+    add->input_a().connect(c1->output());
+    add->input_b().connect(c2->output());
+    abs->input().connect(add->output());
+    tp->input().connect(abs->output());
+    neg->input().connect(c3->output());
+
+    auto mul = graph.emplace<binary>(binary_mul, dt_float32, in_a->output().shape(), tp->output().shape(), value_range<float>::full());
+    auto sub = graph.emplace<binary>(binary_sub, dt_float32, in_b->output().shape(), add->output().shape(), value_range<float>::full());
+    auto sum = graph.emplace<binary>(binary_add, dt_float32, in_a->output().shape(), neg->output().shape(), value_range<float>::full());
+    mul->name("mul");
+    sub->name("sub");
+    sum->name("sum");
+    mul->input_a().connect(in_a->output());
+    mul->input_b().connect(tp->output());
+    sub->input_a().connect(in_b->output());
+    sub->input_b().connect(add->output());
+    sum->input_a().connect(in_a->output());
+    sum->input_b().connect(neg->output());
+
+    for (auto result : { mul, sub, sum })
+    {
+        auto out = graph.emplace<output_node>(dt_float32, result->output().shape());
+        out->input().connect(result->output());
+    }
+}
+
+bool is_constant(input_connector &in)
+{
+    return in.connection()->owner().runtime_opcode() == op_constant;
+}
+
+// fold_constant as it was before evaluating nodes directly: one node per rewrite,
+// through a scheduled throwaway graph and the evaluator.
+void reference_fold_node(graph &graph, node &old_op, target &target)
+{
+    ir::graph new_graph;
+    std::vector<output_node *> op_outputs;
+    std::vector<constant *> output_values;
+    for (auto out : old_op.outputs())
+    {
+        auto node = op_outputs.emplace_back(new_graph.emplace<output_node>(out->type(), out->shape()));
+        if (old_op.outputs().size() > 1)
+            node->name(out->name() + "_F");
+        else
+            node->name(out->owner().name());
+        node->input().connect(*out);
+    }
+
+    {
+        scheduler sch(target, new_graph, new_graph.outputs());
+        auto schr = sch.schedule();
+        ir::evaluator eval(schr);
+        eval.evaluate();
+
+        for (size_t i = 0; i < op_outputs.size(); i++)
+        {
+            auto &op_output = *op_outputs[i];
+            auto mem = eval.output_at(i).buffer().as_span<std::byte>();
+            auto out_val = graph.emplace<constant>(op_output.input().type(), op_output.input().shape(), mem.begin(), mem.end());
+            out_val->name(op_output.name());
+            output_values.emplace_back(out_val);
+        }
+    }
+
+    for (auto &out : op_outputs)
+        out->input().clear_connection();
+
+    for (size_t i = 0; i < old_op.outputs().size(); i++)
+    {
+        auto &out = old_op.outputs()[i];
+        for (auto &in : dup(out->connections()))
+            in->connect(output_values[i]->output());
+    }
+}
+
+void reference_fold(graph &graph, target &target)
+{
+    while (true)
+    {
+        node *candidate = nullptr;
+        auto visitor = make_relay_ir_visitor([&](node &node) {
+            if (!candidate && node.runtime_opcode() != op_constant && node.inputs().size()
+                && std::all_of(node.inputs().begin(), node.inputs().end(), [](input_connector *in) { return is_constant(*in); }))
+                candidate = &node;
+        });
+        visitor.visit(graph);
+        if (!candidate)
+            break;
+        reference_fold_node(graph, *candidate, target);
+    }
+
+    graph.dce();
+}
+
+// Constant data feeding each input of the nodes left after folding, keyed by "node:input"
+std::map<std::string, std::vector<std::byte>> folded_inputs(graph &graph)
+{
+    std::map<std::string, std::vector<std::byte>> inputs;
+    auto visitor = make_relay_ir_visitor([&](node &node) {
+        if (node.runtime_opcode() == op_constant)
+            return;
+        for (size_t i = 0; i < node.inputs().size(); i++)
+        {
+            auto &in = *node.inputs()[i];
+            if (is_constant(in))
+            {
+                auto data = static_cast<constant &>(in.connection()->owner()).data();
+                inputs.emplace(node.name() + ":" + std::to_string(i), std::vector<std::byte>(data.begin(), data.end()));
+            }
+        }
+    });
+    visitor.visit(graph);
+    return inputs;
+}
+
+size_t count_nodes(graph &graph, node_opcode opcode)
+{
+    size_t count = 0;
+    auto visitor = make_relay_ir_visitor([&](node &node) {
+        if (node.runtime_opcode() == opcode)
+            count++;
+    });
+    visitor.visit(graph);
+    return count;
+}
+}
+
+TEST(FoldConstantTest, same_constants_as_evaluator_fold)
+{
+    targets::neutral_target target;
+    target.register_evaluator_ops();
+
+    graph expected_graph(runtime::stackvm::stackvm_module_type);
+    build_graph(expected_graph);
+    reference_fold(expected_graph, target);
+
+    graph graph(runtime::stackvm::stackvm_module_type);
+    build_graph(graph);
+    transform_pass pass("fold_constant");
+    pass.emplace<fold_constant_transform>();
+    run_pass_options options {};
+    pass.run(graph, target, options);
+    graph.dce();
+
+    // Only the consumers of the graph inputs are left
+    EXPECT_EQ(0, count_nodes(graph, op_unary));
+    EXPECT_EQ(0, count_nodes(graph, op_transpose));
+    EXPECT_EQ(3, count_nodes(graph, op_binary));
+
+    auto expected = folded_inputs(expected_graph);
+    auto actual = folded_inputs(graph);
+    ASSERT_EQ(3, expected.size());
+    for (auto &key : { "mul:1", "sub:1", "sum:1" })
+    {
+        ASSERT_TRUE(actual.contains(key)) << key;
+        EXPECT_EQ(expected.at(key), actual.at(key)) << key;
+    }
+    EXPECT_EQ(expected.size(), actual.size());
+
+    // The shared intermediate keeps its value: add = c1 + c2
+    auto c1 = make_data(24, 0.25f, -2.5f);
+    auto c2 = make_data(4, 0.5f, -1.f);
+    std::vector<float> add(24);
+    std::memcpy(add.data(), actual.at("sub:1").data(), add.size() * sizeof(float));
+    for (size_t i = 0; i < add.size(); i++)
+        EXPECT_EQ(c1[i] + c2[i % 4], add[i]) << i;
+}
@@ -0,0 +1,336 @@
+/* Copyright 2019-2021 Canaan Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <gtest/gtest.h>
+#include <nncase/compiler.h>
+#include <nncase/ir/graph.h>
+#include <nncase/ir/ops/unary.h>
+#include <nncase/ir/placeholders.h>
+#include <nncase/runtime/error.h>
+#include <nncase/runtime/interpreter.h>
+#include <nncase/runtime/runtime_tensor.h>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+using namespace nncase;
+using namespace nncase::ir;
+using namespace nncase::runtime;
+
+namespace
+{
+constexpr size_t elements = 16;
+
+// Compiles in[1, 16] -> neg -> out for the cpu target
+std::vector<gsl::byte> build_neg_kmodel()
+{
+    compile_options options {};
+    options.target = "cpu";
+    auto compiler = nncase::compiler::create(options);
+    auto &graph = compiler->graph(1);
+    auto in = graph.emplace<input_node>(dt_float32, shape_t { 1, elements });
+    auto neg = graph.emplace<unary>(unary_neg, in->output().shape());
+    auto out = graph.emplace<output_node>(dt_float32, neg->output().shape());
+    neg->input().connect(in->output());
+    out->input().connect(neg->output());
+    compiler->compile();
+
+    std::stringstream kmodel;
+    compiler->gencode(kmodel);
+    auto data = kmodel.str();
+    auto begin = reinterpret_cast<const gsl::byte *>(data.data());
+    return { begin, begin + data.size() };
+}
+
+runtime_tensor make_tensor(float value, datatype_t datatype = dt_float32, runtime_shape_t shape = { 1, elements })
+{
+    auto tensor = hrt::create(datatype, shape).unwrap_or_throw();
+    auto map = std::move(hrt::map(tensor, hrt::map_write).unwrap_or_throw());
+    if (datatype == dt_float32)
+        std::fill_n(reinterpret_cast<float *>(map.buffer().data()), map.buffer().size() / sizeof(float), value);
+    return tensor;
+}
+
+std::vector<float> read_tensor(runtime_tensor &tensor)
+{
+    auto map = std::move(hrt::map(tensor, hrt::map_read).unwrap_or_throw());
+    auto data = reinterpret_cast<const float *>(map.buffer().data());
+    return { data, data + map.buffer().size() / sizeof(float) };
+}
+}
+
+class InterpreterTest : public ::testing::Test
+{
+protected:
+    static void SetUpTestSuite()
+    {
+        kmodel_ = build_neg_kmodel();
+    }
+
+    void SetUp() override
+    {
+        ASSERT_TRUE(interp_.load_model(kmodel_).is_ok());
+    }
+
+    // Sample i has every input element set to i + 1, every output to NaN
+    void make_batch(size_t count)
+    {
+        inputs_.clear();
+        outputs_.clear();
+        for (size_t i = 0; i < count; i++)
+        {
+            inputs_.emplace_back(make_tensor(i + 1.f));
+            outputs_.emplace_back(make_tensor(NAN));
+        }
+    }
+
+    void expect_outputs(size_t count)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            for (auto value : read_tensor(outputs_[i]))
+                EXPECT_EQ(-(i + 1.f), value) << "sample " << i;
+        }
+    }
+
+    void expect_untouched()
+    {
+        for (auto &output : outputs_)
+        {
+            for (auto value : read_tensor(output))
+                EXPECT_TRUE(std::isnan(value));
+        }
+    }
+
+    size_t records_per_run()
+    {
+        EXPECT_TRUE(interp_.options().set("profile", 1).is_ok());
+        interp_.profiler().clear();
+        EXPECT_TRUE(interp_.run().is_ok());
+        auto records = interp_.profiler().records().size();
+        interp_.profiler().clear();
+        return records;
+    }
+
+    static inline std::vector<gsl::byte> kmodel_;
+    interpreter interp_;
+    std::vector<runtime_tensor> inputs_;
+    std::vector<runtime_tensor> outputs_;
+};
+
+TEST_F(InterpreterTest, run_batch)
+{
+    make_batch(5);
+    batch_run_stats stats;
+    ASSERT_TRUE(interp_.run_batch(inputs_, outputs_, &stats).is_ok());
+    expect_outputs(5);
+
+    ASSERT_EQ(5, stats.latencies.size());
+    for (auto latency : stats.latencies)
+        EXPECT_GE(latency, 0);
+    EXPECT_GT(stats.total, 0);
+    EXPECT_GT(stats.throughput(), 0);
+}
+
+TEST_F(InterpreterTest, run_batch_instances)
+{
+    auto per_run = records_per_run();
+    ASSERT_GT(per_run, 0);
+
+    // 7 samples on 3 instances run as [0, 2), [2, 4) and [4, 7)
+    ASSERT_TRUE(interp_.options().set("batch_instances", 3).is_ok());
+    make_batch(7);
+    batch_run_stats stats;
+    ASSERT_TRUE(interp_.run_batch(inputs_, outputs_, &stats).is_ok());
+    expect_outputs(7);
+    EXPECT_EQ(7, stats.latencies.size());
+
+    // Every instance's records end up in this interpreter's profiler, in start order
+    auto &records = interp_.profiler().records();
+    ASSERT_EQ(7 * per_run, records.size());
+    std::vector<size_t> per_thread(3);
+    for (auto &record : records)
+    {
+        ASSERT_LT(record.thread, 3);
+        per_thread[record.thread]++;
+    }
+    EXPECT_EQ(2 * per_run, per_thread[0]);
+    EXPECT_EQ(2 * per_run, per_thread[1]);
+    EXPECT_EQ(3 * per_run, per_thread[2]);
+    EXPECT_TRUE(std::is_sorted(records.begin(), records.end(), [](auto &lhs, auto &rhs) { return lhs.start < rhs.start; }));
+
+    // Instance profilers are drained, so a second batch adds the same records again
+    ASSERT_TRUE(interp_.run_batch(inputs_, outputs_).is_ok());
+    EXPECT_EQ(14 * per_run, interp_.profiler().records().size());
+}
+
+TEST_F(InterpreterTest, run_batch_more_instances_than_samples)
+{
+    ASSERT_TRUE(interp_.options().set("batch_instances", 8).is_ok());
+    make_batch(3);
+    ASSERT_TRUE(interp_.run_batch(inputs_, outputs_).is_ok());
+    expect_outputs(3);
+}
+
+TEST_F(InterpreterTest, run_batch_errors)
+{
+    ASSERT_TRUE(interp_.options().set("batch_instances", 2).is_ok());
+
+    // Tensor counts must match
+    make_batch(4);
+    outputs_.pop_back();
+    auto ret = interp_.run_batch(inputs_, outputs_);
+    ASSERT_TRUE(ret.is_err());
+    EXPECT_EQ(std::errc::invalid_argument, ret.unwrap_err());
+    expect_untouched();
+
+    // A bad sample fails the batch before any sample runs
+    make_batch(4);
+    inputs_[2] = make_tensor(1.f, dt_float32, { 1, elements + 1 });
+    ret = interp_.run_batch(inputs_, outputs_);
+    ASSERT_TRUE(ret.is_err());
+    EXPECT_EQ(nncase_errc::shape_mismatch, ret.unwrap_err());
+    expect_untouched();
+
+    make_batch(4);
+    outputs_[3] = make_tensor(0.f, dt_int32);
+    ret = interp_.run_batch(inputs_, outputs_);
+    ASSERT_TRUE(ret.is_err());
+    EXPECT_EQ(nncase_errc::datatype_mismatch, ret.unwrap_err());
+
+    make_batch(4);
+    inputs_[1] = runtime_tensor();
+    ret = interp_.run_batch(inputs_, outputs_);
+    ASSERT_TRUE(ret.is_err());
+    EXPECT_EQ(std::errc::invalid_argument, ret.unwrap_err());
+    expect_untouched();
+
+    // Still usable afterwards
+    make_batch(4);
+    ASSERT_TRUE(interp_.run_batch(inputs_, outputs_).is_ok());
+    expect_outputs(4);
+}
+
+TEST_F(InterpreterTest, run_async)
+{
+    // Queued runs complete in submission order, each callback getting its run's result
+    std::vector<size_t> completed;
+    for (size_t i = 0; i < 4; i++)
+    {
+        auto input = make_tensor(i + 1.f);
+        auto output = make_tensor(NAN);
+        ASSERT_TRUE(interp_.input_tensor(0, input).is_ok());
+        ASSERT_TRUE(interp_.output_tensor(0, output).is_ok());
+        ASSERT_TRUE(interp_.run_async([&, i, output](result<void> ret) mutable {
+                                EXPECT_TRUE(ret.is_ok());
+                                for (auto value : read_tensor(output))
+                                    EXPECT_EQ(-(i + 1.f), value);
+                                completed.emplace_back(i);
+                            })
+                        .is_ok());
+
+        // Without double buffering, bound tensors are only safe to replace once the run is done
+        interp_.wait();
+    }
+
+    EXPECT_EQ((std::vector<size_t> { 0, 1, 2, 3 }), completed);
+
+    // run() waits for queued runs first
+    auto output = make_tensor(NAN);
+    ASSERT_TRUE(interp_.output_tensor(0, output).is_ok());
+    std::atomic<size_t> callbacks = 0;
+    for (size_t i = 0; i < 3; i++)
+        ASSERT_TRUE(interp_.run_async([&](result<void>) { callbacks++; }).is_ok());
+    ASSERT_TRUE(interp_.run().is_ok());
+    EXPECT_EQ(3, callbacks);
+    for (auto value : read_tensor(output))
+        EXPECT_EQ(-4.f, value);
+}
+
+TEST_F(InterpreterTest, run_async_double_buffered)
+{
+    interp_.double_buffered(true);
+    ASSERT_TRUE(interp_.double_buffered());
+
+    // Inputs and outputs alternate between two tensors, each left alone until the run after next
+    std::vector<runtime_tensor> run_inputs, run_outputs;
+    for (size_t i = 0; i < 4; i++)
+    {
+        // The input getter hands out the back buffer, never the one the queued run reads
+        auto input = interp_.input_tensor(0).unwrap_or_throw();
+        if (i == 1)
+        {
+            EXPECT_NE(run_inputs[0], input);
+        }
+        else if (i >= 2)
+        {
+            EXPECT_EQ(run_inputs[i - 2], input);
+        }
+        {
+            auto map = std::move(hrt::map(input, hrt::map_write).unwrap_or_throw());
+            std::fill_n(reinterpret_cast<float *>(map.buffer().data()), elements, i + 1.f);
+        }
+
+        run_inputs.emplace_back(input);
+        ASSERT_TRUE(interp_.run_async([&, i](result<void> ret) {
+                                EXPECT_TRUE(ret.is_ok());
+                                run_outputs.emplace_back(interp_.output_tensor(0).unwrap_or_throw());
+                                for (auto value : read_tensor(run_outputs.back()))
+                                    EXPECT_EQ(-(i + 1.f), value);
+                            })
+                        .is_ok());
+    }
+
+    interp_.wait();
+    ASSERT_EQ(4, run_outputs.size());
+    EXPECT_NE(run_outputs[0], run_outputs[1]);
+    EXPECT_EQ(run_outputs[0], run_outputs[2]);
+    EXPECT_EQ(run_outputs[1], run_outputs[3]);
+    EXPECT_EQ(run_outputs[3], interp_.output_tensor(0).unwrap_or_throw());
+    for (auto value : read_tensor(run_outputs[2]))
+        EXPECT_EQ(-3.f, value);
+
+    interp_.double_buffered(false);
+    EXPECT_FALSE(interp_.double_buffered());
+}
+
+TEST_F(InterpreterTest, destroy_with_queued_runs)
+{
+    // Destruction completes queued runs and their callbacks rather than dropping them
+    std::atomic<size_t> callbacks = 0;
+    {
+        interpreter interp;
+        ASSERT_TRUE(interp.load_model(kmodel_).is_ok());
+        ASSERT_TRUE(interp.run_async([&](result<void> ret) {
+                              EXPECT_TRUE(ret.is_ok());
+                              std::this_thread::sleep_for(std::chrono::milliseconds(20));
+                              callbacks++;
+                          })
+                        .is_ok());
+        for (size_t i = 0; i < 3; i++)
+        {
+            ASSERT_TRUE(interp.run_async([&](result<void> ret) {
+                                  EXPECT_TRUE(ret.is_ok());
+                                  callbacks++;
+                              })
+                            .is_ok());
+        }
+    }
+
+    EXPECT_EQ(4, callbacks);
+}
@@ -0,0 +1,261 @@
+/* Copyright 2019-2021 Canaan Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <algorithm>
+#include <cmath>
+#include <gtest/gtest.h>
+#include <limits>
+#include <nncase/ir/graph.h>
+#include <nncase/ir/placeholders.h>
+#include <nncase/ir/quantizer.h>
+#include <numeric>
+#include <optional>
+#include <vector>
+
+using namespace nncase;
+using namespace nncase::ir;
+
+namespace
+{
+constexpr size_t src_bins = 512;
+constexpr size_t dest_bins = 256;
+
+// The threshold searches as they were before the bounded search, evaluating every candidate.
+std::vector<float> reference_smooth(const std::vector<float> &p, const float eps = 0.0001)
+{
+    size_t n_zeros = std::count(p.begin(), p.end(), 0.f);
+    size_t n_nonzeros = p.size() - n_zeros;
+    if (!n_nonzeros)
+        return {};
+    float eps1 = eps * static_cast<float>(n_zeros) / static_cast<float>(n_nonzeros);
+    if (eps1 >= 1.0)
+        return {};
+    auto ret = p;
+    for (auto &value : ret)
+        value += value == 0.f ? eps : -eps1;
+    return ret;
+}
+
+float reference_kld(std::vector<float> p, std::vector<float> q)
+{
+    if (!(p.size() && q.size()) || p.size() != q.size())
+        return std::numeric_limits<float>::max();
+
+    auto p_sum = std::reduce(p.begin(), p.end());
+    auto q_sum = std::reduce(q.begin(), q.end());
+    for (auto &value : p)
+        value = value / p_sum;
+    for (auto &value : q)
+        value = value / q_sum;
+
+    float d = 0.f;
+    for (size_t i = 0; i < p.size(); i++)
+    {
+        if (p[i])
+            d += q[i] ? p[i] * std::log(p[i] / q[i]) : 1.f;
+    }
+
+    return d;
+}
+
+std::optional<std::pair<size_t, size_t>> reference_kld_m0(const std::vector<float> &bins, size_t zero_threshold)
+{
+    std::optional<std::pair<size_t, size_t>> threshold;
+    auto min_kld = std::numeric_limits<float>::max();
+    for (size_t lower_threshold = 0; lower_threshold <= zero_threshold; lower_threshold++)
+    {
+        for (size_t upper_threshold = bins.size(); upper_threshold >= lower_threshold + dest_bins && upper_threshold >= zero_threshold; upper_threshold--)
+        {
+            auto src_range = upper_threshold - lower_threshold;
+            auto src_per_bin = (float)src_range / dest_bins;
+            std::vector<float> range_dist(bins.begin() + lower_threshold, bins.begin() + upper_threshold);
+            std::vector<float> ref_dist(range_dist);
+            ref_dist.front() += std::reduce(bins.begin(), bins.begin() + lower_threshold);
+            ref_dist.back() += std::reduce(bins.begin() + upper_threshold, bins.end());
+
+            std::vector<float> q_dist(dest_bins);
+            for (size_t i = 0; i < dest_bins; i++)
+            {
+                auto start = i * src_per_bin;
+                auto end = start + src_per_bin;
+                auto value = 0.f;
+                auto left_upper = (size_t)std::ceil(start);
+                auto right_lower = (size_t)std::floor(end);
+                if (left_upper > start)
+                    value += (left_upper - start) * range_dist[left_upper - 1];
+                if (right_lower < end)
+                    value += (end - right_lower) * range_dist[right_lower];
+                value += std::reduce(range_dist.begin() + left_upper, range_dist.begin() + right_lower);
+                q_dist[i] = value;
+            }
+
+            std::vector<float> ups_q_dist(src_range);
+            for (size_t i = 0; i < dest_bins; i++)
+            {
+                auto start = i * src_per_bin;
+                auto end = start + src_per_bin;
+                auto count = 0.f;
+                auto left_upper = (size_t)std::ceil(start);
+                auto right_lower = (size_t)std::floor(end);
+                if (left_upper > start && range_dist[left_upper - 1])
+                    count += (left_upper - start);
+                if (right_lower < end && range_dist[right_lower])
+                    count += (end - right_lower);
+                count += std::count_if(range_dist.begin() + left_upper, range_dist.begin() + right_lower, [](float v) { return v; });
+                if (!count)
+                    continue;
+
+                auto upsample_value = q_dist[i] / count;
+                if (left_upper > start && ref_dist[left_upper - 1])
+                    ups_q_dist[left_upper - 1] += (left_upper - start) * upsample_value;
+                if (right_lower < end && ref_dist[right_lower])
+                    ups_q_dist[right_lower] += (end - right_lower) * upsample_value;
+                for (size_t j = left_upper; j < right_lower; j++)
+                {
+                    if (ref_dist[j])
+                        ups_q_dist[j] += upsample_value;
+                }
+            }
+
+            auto kld = reference_kld(reference_smooth(ref_dist), reference_smooth(ups_q_dist));
+            if (kld < min_kld)
+            {
+                min_kld = kld;
+                threshold = { lower_threshold, upper_threshold };
+            }
+        }
+    }
+
+    return threshold;
+}
+
+float reference_l2(const std::vector<float> &p, value_range<float> p_range, value_range<float> q_range)
+{
+    auto p_interval = (p_range.max - p_range.min) / p.size();
+    auto q_interval = (q_range.max - q_range.min) / (dest_bins - 1);
+    float d = 0.f;
+    for (size_t i = 0; i < p.size(); i++)
+    {
+        auto p_val = p_range.min + p_interval * (i + 0.0f);
+        auto q_idx = std::clamp((int32_t)std::round((p_val - q_range.min) / q_interval), 0, (int32_t)dest_bins - 1);
+        auto q_val = q_range.min + q_interval * (q_idx + 0.0f);
+        d += std::pow(p_val - q_val, 2.f) * p[i];
+    }
+
+    return d;
+}
+
+std::optional<std::pair<size_t, size_t>> reference_l2_search(const std::vector<float> &bins, value_range<float> range, float interval, size_t zero_threshold)
+{
+    std::optional<std::pair<size_t, size_t>> threshold;
+    auto min_loss = std::numeric_limits<float>::max();
+    for (size_t lower_threshold = 0; lower_threshold <= zero_threshold; lower_threshold++)
+    {
+        for (size_t upper_threshold = bins.size(); upper_threshold >= lower_threshold + dest_bins && upper_threshold >= zero_threshold; upper_threshold--)
+        {
+            auto dest_min = lower_threshold * interval + range.min;
+            auto dest_max = upper_threshold * interval + range.min;
+            auto loss = reference_l2(bins, range, { dest_min, dest_max });
+            if (loss < min_loss)
+            {
+                min_loss = loss;
+                threshold = { lower_threshold, upper_threshold };
+            }
+        }
+    }
+
+    return threshold;
+}
+
+// Records `counts` samples at the centre of each bin and returns the range the quantizer picks
+value_range<float> quantizer_range(calibrate_method method, value_range<float> range, const std::vector<uint64_t> &counts)
+{
+    graph graph;
+    auto in = graph.emplace<input_node>(dt_float32, shape_t { 1 });
+    quantizer quantizer(method, src_bins);
+    quantizer.record(in->output(), range);
+    quantizer.begin_collect_distribution();
+
+    auto interval = (range.max - range.min) / src_bins;
+    std::vector<float> data;
+    for (size_t i = 0; i < counts.size(); i++)
+        data.insert(data.end(), counts[i], range.min + (i + 0.5f) * interval);
+    quantizer.record(in->output(), data);
+    quantizer.end_collect_distribution({});
+    return quantizer.get(in->output());
+}
+
+value_range<float> reference_range(calibrate_method method, value_range<float> range, const std::vector<uint64_t> &counts)
+{
+    std::vector<float> bins(counts.begin(), counts.end());
+    auto interval = (range.max - range.min) / src_bins;
+    auto zero_threshold = (size_t)std::clamp((0 - range.min) / interval, 0.f, (float)src_bins - 1);
+    auto threshold = method == calibrate_method::kld_m0
+        ? reference_kld_m0(bins, zero_threshold)
+        : reference_l2_search(bins, range, interval, zero_threshold);
+    if (!threshold)
+        return range;
+    return { (threshold->first - 0.5f) * interval + range.min, (threshold->second + 0.5f) * interval + range.min };
+}
+
+struct histogram_case
+{
+    const char *name;
+    value_range<float> range;
+    std::vector<uint64_t> counts;
+};
+
+std::vector<histogram_case> histogram_cases()
+{
+    std::vector<histogram_case> cases;
+    auto add = [&](const char *name, value_range<float> range, auto &&count) {
+        auto &c = cases.emplace_back(histogram_case { name, range, std::vector<uint64_t>(src_bins) });
+        auto interval = (range.max - range.min) / src_bins;
+        for (size_t i = 0; i < src_bins; i++)
+            c.counts[i] = count(i, range.min + (i + 0.5f) * interval);
+    };
+
+    // Skewed bell with long tails
+    add("gaussian", { -2.f, 3.f }, [](size_t, float x) {
+        auto z = (x - 0.3f) / 0.6f;
+        return (uint64_t)std::round(2000 * std::exp(-z * z / 2) + 3 * std::exp(-std::abs(x)));
+    });
+    // Activation after relu, with a spike at zero
+    add("relu", { 0.f, 6.f }, [](size_t i, float x) {
+        return (uint64_t)std::round(i == 0 ? 50000 : 1500 * std::exp(-1.5f * x));
+    });
+    // Every third bin empty
+    add("sparse", { -1.f, 1.f }, [](size_t i, float x) {
+        return i % 3 ? (uint64_t)std::round(800 * std::exp(-4 * std::abs(x - 0.1f))) : 0;
+    });
+    return cases;
+}
+}
+
+class QuantizerTest : public ::testing::TestWithParam<calibrate_method>
+{
+};
+
+TEST_P(QuantizerTest, same_range_as_full_search)
+{
+    for (auto &c : histogram_cases())
+    {
+        auto expected = reference_range(GetParam(), c.range, c.counts);
+        auto actual = quantizer_range(GetParam(), c.range, c.counts);
+        EXPECT_EQ(expected.min, actual.min) << c.name;
+        EXPECT_EQ(expected.max, actual.max) << c.name;
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(quantizer, QuantizerTest, testing::Values(calibrate_method::kld_m0, calibrate_method::l2));
@@ -0,0 +1,101 @@
+/* Copyright 2019-2021 Canaan Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <gtest/gtest.h>
+#include <nncase/ir/graph.h>
+#include <nncase/ir/ops/binary.h>
+#include <nncase/ir/ops/reduce.h>
+#include <nncase/ir/ops/unary.h>
+#include <nncase/ir/placeholders.h>
+#include <nncase/runtime/stackvm/runtime_module.h>
+#include <nncase/schedule/scheduler.h>
+#include <nncase/targets/neutral_target.h>
+
+using namespace nncase;
+using namespace nncase::ir;
+using namespace nncase::schedule;
+
+namespace
+{
+// out = a + reduce(b2(b1(in1))), where a = unary(in0) is twice as large as b1 and b2.
+// Post order computes a first and keeps it alive across the b chain,
+// running the b chain first never holds a together with b1 and b2.
+void build_late_consumer(graph &graph)
+{
+    shape_t a_shape { 1, 2, 16, 16 };
+    shape_t b_shape { 1, 1, 16, 16 };
+
+    auto in0 = graph.emplace<input_node>(dt_float32, a_shape);
+    auto in1 = graph.emplace<input_node>(dt_float32, b_shape);
+    auto a = graph.emplace<unary>(unary_abs, a_shape);
+    auto b1 = graph.emplace<unary>(unary_neg, b_shape);
+    auto b2 = graph.emplace<unary>(unary_abs, b_shape);
+    auto b3 = graph.emplace<reduce>(reduce_sum, dt_float32, b_shape, axis_t { 2, 3 }, 0.f, true);
+    auto add = graph.emplace<binary>(binary_add, dt_float32, a_shape, b3->output().shape(), value_range<float>::full());
+    auto out = graph.emplace<output_node>(dt_float32, add->output().shape());
+
+    a->input().connect(in0->output());
+    b1->input().connect(in1->output());
+    b2->input().connect(b1->output());
+    b3->input().connect(b2->output());
+    add->input_a().connect(a->output());
+    add->input_b().connect(b3->output());
+    out->input().connect(add->output());
+}
+
+// A plain chain has only one topological order
+void build_chain(graph &graph)
+{
+    shape_t shape { 1, 4, 16, 16 };
+
+    auto in = graph.emplace<input_node>(dt_float32, shape);
+    auto u1 = graph.emplace<unary>(unary_abs, shape);
+    auto u2 = graph.emplace<unary>(unary_neg, shape);
+    auto u3 = graph.emplace<unary>(unary_abs, shape);
+    auto out = graph.emplace<output_node>(dt_float32, shape);
+
+    u1->input().connect(in->output());
+    u2->input().connect(u1->output());
+    u3->input().connect(u2->output());
+    out->input().connect(u3->output());
+}
+
+// Scheduling runs the buffer alias passes, which rewrite the graph,
+// so every schedule gets a freshly built graph.
+size_t data_pool_usage(target &target, void (*build)(graph &), compute_order order)
+{
+    graph graph(runtime::stackvm::stackvm_module_type);
+    build(graph);
+    scheduler sched(target, graph, graph.outputs());
+    sched.config_compute_order(order);
+    auto result = sched.schedule();
+    return result.modules.at(0).max_usages.at(mem_data);
+}
+}
+
+TEST(SchedulerTest, min_peak_memory_order_shrinks_data_pool)
+{
+    targets::neutral_target target;
+    auto post_order = data_pool_usage(target, build_late_consumer, compute_order::post_order);
+    auto min_peak = data_pool_usage(target, build_late_consumer, compute_order::min_peak_memory);
+    EXPECT_LT(min_peak, post_order);
+}
+
+TEST(SchedulerTest, min_peak_memory_order_keeps_post_order_when_not_smaller)
+{
+    targets::neutral_target target;
+    auto post_order = data_pool_usage(target, build_chain, compute_order::post_order);
+    auto min_peak = data_pool_usage(target, build_chain, compute_order::min_peak_memory);
+    EXPECT_EQ(min_peak, post_order);
+}
@@ -0,0 +1,350 @@
+/* Copyright 2019-2021 Canaan Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <gtest/gtest.h>
+#include <iterator>
+#include <memory>
+#include <nncase/ir/debug.h>
+#include <nncase/ir/graph.h>
+#include <nncase/ir/ops/binary.h>
+#include <nncase/ir/ops/bitcast.h>
+#include <nncase/ir/ops/clamp.h>
+#include <nncase/ir/ops/concat.h>
+#include <nncase/ir/ops/constant.h>
+#include <nncase/ir/ops/convert.h>
+#include <nncase/ir/ops/pad.h>
+#include <nncase/ir/ops/reduce.h>
+#include <nncase/ir/ops/sigmoid.h>
+#include <nncase/ir/ops/slice.h>
+#include <nncase/ir/ops/transpose.h>
+#include <nncase/ir/ops/unary.h>
+#include <nncase/ir/placeholders.h>
+#include <nncase/ir/visitor.h>
+#include <nncase/runtime/stackvm/runtime_module.h>
+#include <nncase/targets/neutral_target.h>
+#include <nncase/transforms/neutral/fold_transpose.h>
+#include <nncase/transforms/neutral/transpose_motion.h>
+#include <nncase/transforms/pass.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace nncase;
+using namespace nncase::ir;
+using namespace nncase::ir::transforms;
+
+namespace
+{
+template <class T>
+void add_transform(transform_pass &pass, std::vector<std::unique_ptr<transform>> &probes)
+{
+    pass.emplace<T>();
+    probes.emplace_back(std::make_unique<T>());
+}
+
+size_t count_nodes(graph &graph, node_opcode opcode)
+{
+    size_t count = 0;
+    auto visitor = make_relay_ir_visitor([&](node &node) {
+        if (node.runtime_opcode() == opcode)
+            count++;
+    });
+    visitor.visit(graph);
+    return count;
+}
+
+// in -> tp -> abs -> tp' -> neg -> tp -> tp' -> out, where tp' undoes tp.
+// Each transpose has to move past a unary before it meets its inverse, so the
+// rewrites enable matches on nodes they did not touch.
+void build_transpose_chain(graph &graph)
+{
+    shape_t shape { 1, 3, 8, 4 };
+    axis_t to_nhwc { 0, 2, 3, 1 };
+    axis_t to_nchw { 0, 3, 1, 2 };
+
+    auto in = graph.emplace<input_node>(dt_float32, shape);
+    auto tp1 = graph.emplace<transpose>(dt_float32, in->output().shape(), to_nhwc);
+    auto u1 = graph.emplace<unary>(unary_abs, tp1->output().shape());
+    auto tp2 = graph.emplace<transpose>(dt_float32, u1->output().shape(), to_nchw);
+    auto u2 = graph.emplace<unary>(unary_neg, tp2->output().shape());
+    auto tp3 = graph.emplace<transpose>(dt_float32, u2->output().shape(), to_nhwc);
+    auto tp4 = graph.emplace<transpose>(dt_float32, tp3->output().shape(), to_nchw);
+    auto out = graph.emplace<output_node>(dt_float32, tp4->output().shape());
+
+    tp1->input().connect(in->output());
+    u1->input().connect(tp1->output());
+    tp2->input().connect(u1->output());
+    u2->input().connect(tp2->output());
+    tp3->input().connect(u2->output());
+    tp4->input().connect(tp3->output());
+    out->input().connect(tp4->output());
+}
+
+// Exposes the transform lists neutral_target registers for its target independent passes
+class neutral_pass_lists : public targets::neutral_target
+{
+public:
+    using neutral_target::add_default_transforms;
+    using neutral_target::fold_dilated_conv_transform;
+    using neutral_target::fold_pad_conv_transform;
+};
+
+// transform_pass::run_core as it was before the worklist: walk the whole graph with each
+// transform in turn, apply the first match, run dce and start over from the first transform.
+class reference_apply_visitor : public dfs_ir_post_order_visitor
+{
+public:
+    using dfs_ir_post_order_visitor::visit;
+    ir::graph *graph;
+    nncase::target *target;
+    bool need_retry = false;
+    transforms::transform *transform;
+
+protected:
+    bool visit(node &node) override
+    {
+        auto context = transform->create_context(*graph, *target);
+        context->quantizer = nullptr;
+
+        if (transform->try_match(node, *context))
+        {
+            transform->process(*context);
+            need_retry = true;
+            return true;
+        }
+
+        return false;
+    }
+};
+
+void reference_run(transform_pass &pass, graph &graph, target &target)
+{
+    reference_apply_visitor visitor;
+    visitor.graph = &graph;
+    visitor.target = &target;
+    bool next_pass = false;
+
+    do
+    {
+        next_pass = false;
+
+        for (auto &transform : pass.transforms())
+        {
+            visitor.transform = transform.get();
+            visitor.need_retry = false;
+            visitor.visit(graph);
+
+            if (visitor.need_retry)
+            {
+                next_pass = true;
+                graph.dce();
+                break;
+            }
+        }
+    } while (next_pass);
+
+    // pass::run follows run_core with cse
+    graph.cse();
+}
+
+template <class TNode, class... TArgs>
+TNode *add_node(graph &graph, const std::string &name, TArgs &&...args)
+{
+    auto node = graph.emplace<TNode>(std::forward<TArgs>(args)...);
+    node->name(name);
+    return node;
+}
+
+// Transposes around pads, unaries, a sigmoid, binaries with 1-D constants, a reduce, a
+// concat and a clamp, plus bitcast, convert and slice pairs and a constant subgraph. Most
+// rewrites move a transpose next to another one, so the transforms compete for nodes and
+// the order of rewrites decides the result.
+void build_neutral_graph(graph &graph)
+{
+    shape_t shape { 1, 4, 6, 8 };
+    axis_t to_nhwc { 0, 2, 3, 1 };
+    axis_t to_nchw { 0, 3, 1, 2 };
+    auto in = add_node<input_node>(graph, "in", dt_float32, shape);
+    auto add_output = [&](const std::string &name, output_connector &result) {
+        auto out = add_node<output_node>(graph, name, dt_float32, result.shape());
+        out->input().connect(result);
+    };
+    auto add_transpose = [&](const std::string &name, output_connector &input, const axis_t &perm) {
+        auto tp = add_node<transpose>(graph, name, dt_float32, input.shape(), perm);
+        tp->input().connect(input);
+        return tp;
+    };
+    auto add_constant = [&](const std::string &name, shape_t data_shape, std::vector<float> data) {
+        return add_node<constant>(graph, name, dt_float32, data_shape, data);
+    };
+
+    // in -> tp -> nop pad -> tp' -> abs -> tp -> sigmoid -> tp' -> out_a
+    auto a_tp1 = add_transpose("a_tp1", in->output(), to_nhwc);
+    auto a_pad = add_node<pad>(graph, "a_pad", dt_float32, a_tp1->output().shape(), xt::svector<padding>(4, padding::zero()), pad_constant, 0.f);
+    a_pad->input().connect(a_tp1->output());
+    auto a_tp2 = add_transpose("a_tp2", a_pad->output(), to_nchw);
+    auto a_abs = add_node<unary>(graph, "a_abs", unary_abs, a_tp2->output().shape());
+    a_abs->input().connect(a_tp2->output());
+    auto a_tp3 = add_transpose("a_tp3", a_abs->output(), to_nhwc);
+    auto a_sigmoid = add_node<sigmoid>(graph, "a_sigmoid", dt_float32, a_tp3->output().shape());
+    a_sigmoid->input().connect(a_tp3->output());
+    auto a_tp4 = add_transpose("a_tp4", a_sigmoid->output(), to_nchw);
+    add_output("out_a", a_tp4->output());
+
+    // in -> tp -> + c -> tp' -> mean over h, w -> out_b, with c = tp(c0) folded to a 1-D constant
+    auto b_tp1 = add_transpose("b_tp1", in->output(), to_nhwc);
+    auto b_c0 = add_constant("b_c0", shape_t { 4, 1 }, { 0.5f, -1.f, 1.5f, -2.f });
+    auto b_c = add_transpose("b_c", b_c0->output(), axis_t { 1, 0 });
+    auto b_bitcast = add_node<bitcast>(graph, "b_bitcast", dt_float32, b_c->output().shape(), shape_t { 4 });
+    b_bitcast->input().connect(b_c->output());
+    auto b_add = add_node<binary>(graph, "b_add", binary_add, dt_float32, b_tp1->output().shape(), b_bitcast->output().shape(), value_range<float>::full());
+    b_add->input_a().connect(b_tp1->output());
+    b_add->input_b().connect(b_bitcast->output());
+    auto b_tp2 = add_transpose("b_tp2", b_add->output(), to_nchw);
+    auto b_mean = add_node<reduce>(graph, "b_mean", reduce_mean, dt_float32, b_tp2->output().shape(), axis_t { 2, 3 }, 0.f, true);
+    b_mean->input().connect(b_tp2->output());
+    add_output("out_b", b_mean->output());
+
+    // concat(tp(in), tp(neg(in))) -> tp' -> clamp -> tp -> tp' -> out_c
+    auto c_neg = add_node<unary>(graph, "c_neg", unary_neg, shape);
+    c_neg->input().connect(in->output());
+    auto c_tp1 = add_transpose("c_tp1", in->output(), to_nhwc);
+    auto c_tp2 = add_transpose("c_tp2", c_neg->output(), to_nhwc);
+    std::vector<shape_t> concat_shapes { c_tp1->output().shape(), c_tp2->output().shape() };
+    auto c_concat = add_node<concat>(graph, "c_concat", dt_float32, concat_shapes, 3);
+    c_concat->input_at(0).connect(c_tp1->output());
+    c_concat->input_at(1).connect(c_tp2->output());
+    auto c_tp3 = add_transpose("c_tp3", c_concat->output(), to_nchw);
+    auto c_low = add_constant("c_low", shape_t { 1 }, { -1.f });
+    auto c_high = add_constant("c_high", shape_t { 1 }, { 1.f });
+    auto c_clamp = add_node<clamp>(graph, "c_clamp", c_tp3->output().shape(), c_low->output().shape(), c_high->output().shape());
+    c_clamp->input().connect(c_tp3->output());
+    c_clamp->input_low().connect(c_low->output());
+    c_clamp->input_high().connect(c_high->output());
+    auto c_tp4 = add_transpose("c_tp4", c_clamp->output(), to_nhwc);
+    auto c_tp5 = add_transpose("c_tp5", c_tp4->output(), to_nchw);
+    add_output("out_c", c_tp5->output());
+
+    // in -> reshape -> reshape back -> nop convert -> pad -> tp -> nop slice -> * tp(abs(in)) -> out_d
+    auto d_reshape1 = add_node<bitcast>(graph, "d_reshape1", dt_float32, shape, shape_t { 1, 4, 48 });
+    d_reshape1->input().connect(in->output());
+    auto d_reshape2 = add_node<bitcast>(graph, "d_reshape2", dt_float32, d_reshape1->output().shape(), shape);
+    d_reshape2->input().connect(d_reshape1->output());
+    auto d_convert = add_node<convert>(graph, "d_convert", dt_float32, shape, dt_float32);
+    d_convert->input().connect(d_reshape2->output());
+    xt::svector<padding> paddings { padding::zero(), padding::zero(), { 1, 1 }, { 2, 0 } };
+    auto d_pad = add_node<pad>(graph, "d_pad", dt_float32, shape, paddings, pad_constant, 0.f);
+    d_pad->input().connect(d_convert->output());
+    auto d_tp1 = add_transpose("d_tp1", d_pad->output(), to_nhwc);
+    auto &sliced = d_tp1->output().shape();
+    auto d_slice = add_node<slice>(graph, "d_slice", dt_float32, sliced, axis_t { 0, 0, 0, 0 }, axis_t(sliced.begin(), sliced.end()));
+    d_slice->input().connect(d_tp1->output());
+    auto d_abs = add_node<unary>(graph, "d_abs", unary_abs, d_pad->output().shape());
+    d_abs->input().connect(d_pad->output());
+    auto d_tp2 = add_transpose("d_tp2", d_abs->output(), to_nhwc);
+    auto d_mul = add_node<binary>(graph, "d_mul", binary_mul, dt_float32, d_slice->output().shape(), d_tp2->output().shape(), value_range<float>::full());
+    d_mul->input_a().connect(d_slice->output());
+    d_mul->input_b().connect(d_tp2->output());
+    add_output("out_d", d_mul->output());
+}
+
+std::string read_dump(graph &graph, const std::filesystem::path &dir)
+{
+    ir::dump_graph(graph, dir);
+    std::ifstream file(dir / (graph.escaped_name() + ".nnir.pb"), std::ios::binary);
+    return { std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() };
+}
+}
+
+TEST(TransformPassTest, stops_at_fixpoint)
+{
+    targets::neutral_target target;
+    graph graph(runtime::stackvm::stackvm_module_type);
+    build_transpose_chain(graph);
+
+    transform_pass pass("transpose_chain");
+    std::vector<std::unique_ptr<transform>> probes;
+    add_transform<fold_transpose_transform>(pass, probes);
+    add_transform<fold_nop_transpose_transform>(pass, probes);
+    add_transform<transpose_unary_motion_transform>(pass, probes);
+
+    run_pass_options options {};
+    pass.run(graph, target, options);
+
+    size_t matches = 0;
+    for (auto &stat : pass.stats())
+        matches += stat.matches;
+    EXPECT_GT(matches, 0);
+
+    // No transform may still match anywhere once the pass returns
+    for (auto &probe : probes)
+    {
+        auto context = probe->create_context(graph, target);
+        auto visitor = make_relay_ir_visitor([&](node &node) {
+            context->matched_nodes.clear();
+            context->inputs.clear();
+            context->outputs.clear();
+            EXPECT_FALSE(probe->try_match(node, *context)) << node.name();
+        });
+        visitor.visit(graph);
+    }
+
+    EXPECT_EQ(count_nodes(graph, op_transpose), 0);
+    EXPECT_EQ(count_nodes(graph, op_unary), 2);
+}
+
+TEST(TransformPassTest, same_graph_as_restart_driver)
+{
+    neutral_pass_lists target;
+    target.register_evaluator_ops();
+
+    graph expected(runtime::stackvm::stackvm_module_type);
+    graph actual(runtime::stackvm::stackvm_module_type);
+    build_neutral_graph(expected);
+    build_neutral_graph(actual);
+
+    // In the order register_target_independent_passes runs them
+    std::vector<std::pair<std::string, std::function<void(transform_pass &)>>> pass_lists {
+        { "fold_pad_conv", [&](transform_pass &pass) { target.fold_pad_conv_transform(pass, true); } },
+        { "fold_dilated_conv", [&](transform_pass &pass) { target.fold_dilated_conv_transform(pass, true); } },
+        { "target_independent_pass", [&](transform_pass &pass) { target.add_default_transforms(pass, true); } },
+    };
+
+    auto dump_dir = std::filesystem::temp_directory_path() / "nncase_test_transform_pass";
+    std::filesystem::remove_all(dump_dir);
+    size_t matches = 0;
+    for (auto &[name, add_transforms] : pass_lists)
+    {
+        transform_pass reference(name);
+        add_transforms(reference);
+        reference_run(reference, expected, target);
+
+        transform_pass pass(name);
+        add_transforms(pass);
+        run_pass_options options {};
+        pass.run(actual, target, options);
+        for (auto &stat : pass.stats())
+            matches += stat.matches;
+
+        auto expected_dump = read_dump(expected, dump_dir / "reference" / name);
+        auto actual_dump = read_dump(actual, dump_dir / "worklist" / name);
+        EXPECT_FALSE(expected_dump.empty()) << name;
+        EXPECT_TRUE(expected_dump == actual_dump) << name << ": graphs differ, see " << dump_dir.string();
+    }
+
+    EXPECT_GT(matches, 0);
+}
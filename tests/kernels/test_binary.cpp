@@ -0,0 +1,150 @@
+/* Copyright 2019-2021 Canaan Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "test_util.h"
+#include <gtest/gtest.h>
+#include <nncase/kernels/cpu/optimized/tensor_compute.h>
+#include <nncase/kernels/cpu/reference/tensor_compute.h>
+#include <nncase/runtime/runtime_tensor.h>
+
+runtime_shape_t broadcast_shape(const runtime_shape_t &a, const runtime_shape_t &b)
+{
+    const auto rank = std::max(a.size(), b.size());
+    runtime_shape_t shape(rank);
+    for (size_t i = 0; i < rank; i++)
+    {
+        const auto a_dim = i < a.size() ? a[a.size() - 1 - i] : 1;
+        const auto b_dim = i < b.size() ? b[b.size() - 1 - i] : 1;
+        shape[rank - 1 - i] = std::max(a_dim, b_dim);
+    }
+
+    return shape;
+}
+
+// Divisors are kept away from zero
+template <class T>
+void init_data(std::vector<T> &data, bool divisor)
+{
+    std::mt19937 gen(divisor ? 7 : 42);
+    if constexpr (std::is_floating_point_v<T>)
+    {
+        std::uniform_real_distribution<float> dis(0.1f, 8.f);
+        std::bernoulli_distribution sign;
+        for (auto &v : data)
+            v = sign(gen) ? dis(gen) : -dis(gen);
+    }
+    else
+    {
+        std::uniform_int_distribution<int> dis(1, 100);
+        std::bernoulli_distribution sign;
+        for (auto &v : data)
+            v = sign(gen) ? dis(gen) : -dis(gen);
+    }
+}
+
+template <class T>
+void binary(binary_op_t op, const std::vector<T> &a, const std::vector<T> &b, std::vector<T> &output,
+    const runtime_shape_t &a_shape, const runtime_shape_t &b_shape, const runtime_shape_t &out_shape,
+    value_range<float> fused_activation, OpType type)
+{
+    auto a_strides = get_default_strides(a_shape);
+    auto b_strides = get_default_strides(b_shape);
+    auto out_strides = get_default_strides(out_shape);
+    if (type == OpType::Ref)
+    {
+        NNCASE_UNUSED auto res = cpu::reference::binary(op, a.data(), b.data(), output.data(),
+            a_shape, a_strides, b_shape, b_strides, out_shape, out_strides, fused_activation, default_kernel_context());
+    }
+    else if (type == OpType::Opt)
+    {
+        NNCASE_UNUSED auto res = cpu::optimized::binary(op, a.data(), b.data(), output.data(),
+            a_shape, a_strides, b_shape, b_strides, out_shape, out_strides, fused_activation, default_kernel_context());
+    }
+    else
+    {
+        assert(false);
+    }
+}
+
+class BinaryTest : public ::testing::TestWithParam<
+                       std::tuple<
+                           std::pair<runtime_shape_t, runtime_shape_t>, // a shape, b shape
+                           binary_op_t,
+                           value_range<float>>> // fused activation
+{
+public:
+    void SetUp() override
+    {
+        auto &&[shapes, binary_op, act] = GetParam();
+        a_shape = shapes.first;
+        b_shape = shapes.second;
+        out_shape = broadcast_shape(a_shape, b_shape);
+        op = binary_op;
+        fused_activation = act;
+    }
+
+    template <class T>
+    void run()
+    {
+        std::vector<T> a(kernels::detail::compute_size(a_shape));
+        std::vector<T> b(kernels::detail::compute_size(b_shape));
+        init_data(a, false);
+        init_data(b, true);
+        std::vector<T> output_ref(kernels::detail::compute_size(out_shape), 0);
+        std::vector<T> output_opt(kernels::detail::compute_size(out_shape), 1);
+        binary(op, a, b, output_ref, a_shape, b_shape, out_shape, fused_activation, OpType::Ref);
+        binary(op, a, b, output_opt, a_shape, b_shape, out_shape, fused_activation, OpType::Opt);
+
+        for (size_t i = 0; i < output_ref.size(); i++)
+            ASSERT_EQ(output_ref[i], output_opt[i]) << "at " << i;
+    }
+
+    runtime_shape_t a_shape, b_shape, out_shape;
+    binary_op_t op;
+    value_range<float> fused_activation;
+};
+
+INSTANTIATE_TEST_SUITE_P(
+    BinaryTestBroadcast,
+    BinaryTest,
+    testing::Combine(
+        testing::Values(
+            std::make_pair(runtime_shape_t { 1, 3, 17, 19 }, runtime_shape_t { 1, 3, 17, 19 }), // same shape
+            std::make_pair(runtime_shape_t { 2, 40000 }, runtime_shape_t { 2, 40000 }), // long rows
+            std::make_pair(runtime_shape_t { 1, 8, 5, 7 }, runtime_shape_t { 1 }), // scalar b
+            std::make_pair(runtime_shape_t {}, runtime_shape_t { 3, 33 }), // scalar a
+            std::make_pair(runtime_shape_t { 1, 16, 9, 9 }, runtime_shape_t { 16, 1, 1 }), // per channel
+            std::make_pair(runtime_shape_t { 4, 6, 35 }, runtime_shape_t { 35 }), // inner dim
+            std::make_pair(runtime_shape_t { 5, 1, 3 }, runtime_shape_t { 1, 7, 1 }), // both broadcast
+            std::make_pair(runtime_shape_t { 2, 1, 4, 1, 6 }, runtime_shape_t { 3, 4, 5, 1 }), // mixed
+            std::make_pair(runtime_shape_t { 3, 1, 1, 4 }, runtime_shape_t { 1, 4 })), // unit dims
+        testing::Values(binary_add, binary_sub, binary_mul, binary_div, binary_min, binary_max),
+        testing::Values(
+            value_range<float>::full(),
+            value_range<float> { -10.5f, 6.5f })));
+
+TEST_P(BinaryTest, float32)
+{
+    run<float>();
+}
+
+TEST_P(BinaryTest, int32)
+{
+    run<int32_t>();
+}
+
+TEST_P(BinaryTest, int64)
+{
+    run<int64_t>();
+}
@@ -0,0 +1,141 @@
+/* Copyright 2019-2021 Canaan Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "test_util.h"
+#include <gtest/gtest.h>
+#include <nncase/kernels/cpu/optimized/tensor_compute.h>
+#include <nncase/kernels/cpu/reference/convolution.h>
+#include <nncase/runtime/runtime_tensor.h>
+
+struct conv2d_param
+{
+    size_t batch, in_channels, in_h, in_w, out_channels, filter_h, filter_w;
+    int32_t groups, stride_h, stride_w, dilation_h, dilation_w;
+    padding padding_h, padding_w;
+};
+
+std::ostream &operator<<(std::ostream &os, const conv2d_param &p)
+{
+    return os << "n" << p.batch << "_c" << p.in_channels << "_" << p.in_h << "x" << p.in_w
+              << "_oc" << p.out_channels << "_k" << p.filter_h << "x" << p.filter_w << "_g" << p.groups
+              << "_s" << p.stride_h << "x" << p.stride_w << "_d" << p.dilation_h << "x" << p.dilation_w
+              << "_p" << p.padding_h.before << p.padding_h.after << p.padding_w.before << p.padding_w.after;
+}
+
+class Conv2DTest : public ::testing::TestWithParam<std::tuple<conv2d_param, value_range<float>>>
+{
+public:
+    void SetUp() override
+    {
+        auto &&[p, act] = GetParam();
+        param = p;
+        fused_activation = act;
+
+        in_shape = { p.batch, p.in_channels, p.in_h, p.in_w };
+        w_shape = { p.out_channels, p.in_channels / p.groups, p.filter_h, p.filter_w };
+        out_shape = { p.batch, p.out_channels,
+            kernels::detail::get_windowed_output_size(p.in_h, (int32_t)p.filter_h, p.stride_h, p.dilation_h, p.padding_h),
+            kernels::detail::get_windowed_output_size(p.in_w, (int32_t)p.filter_w, p.stride_w, p.dilation_w, p.padding_w) };
+
+        input.resize(kernels::detail::compute_size(in_shape));
+        weights.resize(kernels::detail::compute_size(w_shape));
+        bias.resize(p.out_channels);
+        init_float_data(input);
+        init_float_data(weights);
+        init_float_data(bias);
+        output_ref.assign(kernels::detail::compute_size(out_shape), 0.f);
+        output_opt.assign(kernels::detail::compute_size(out_shape), 1.f);
+    }
+
+    result<void> conv2d(std::vector<float> &output, OpType type)
+    {
+        return conv2d(output, type, default_kernel_context());
+    }
+
+    result<void> conv2d(std::vector<float> &output, OpType type, kernel_context &context)
+    {
+        auto in_strides = get_default_strides(in_shape);
+        auto w_strides = get_default_strides(w_shape);
+        auto out_strides = get_default_strides(out_shape);
+        runtime_shape_t bias_strides { 1 };
+        auto &p = param;
+        if (type == OpType::Ref)
+            return cpu::reference::conv2d(input.data(), weights.data(), bias.data(), output.data(), in_shape, in_strides,
+                w_shape, w_strides, bias_strides, out_strides, p.padding_h, p.padding_w, p.groups, p.stride_h, p.stride_w,
+                p.dilation_h, p.dilation_w, fused_activation, context);
+        return cpu::optimized::conv2d(input.data(), weights.data(), bias.data(), output.data(), in_shape, in_strides,
+            w_shape, w_strides, bias_strides, out_strides, p.padding_h, p.padding_w, p.groups, p.stride_h, p.stride_w,
+            p.dilation_h, p.dilation_w, fused_activation, context);
+    }
+
+    conv2d_param param;
+    runtime_shape_t in_shape, w_shape, out_shape;
+    value_range<float> fused_activation;
+    std::vector<float> input, weights, bias, output_ref, output_opt;
+};
+
+INSTANTIATE_TEST_SUITE_P(
+    Conv2DTestShapes,
+    Conv2DTest,
+    testing::Combine(
+        testing::Values(
+            // winograd
+            conv2d_param { 1, 16, 8, 8, 16, 3, 3, 1, 1, 1, 1, 1, { 1, 1 }, { 1, 1 } },
+            conv2d_param { 2, 19, 13, 11, 23, 3, 3, 1, 1, 1, 1, 1, { 1, 1 }, { 1, 1 } },
+            conv2d_param { 1, 32, 17, 9, 20, 3, 3, 1, 1, 1, 1, 1, { 0, 2 }, { 2, 1 } },
+            conv2d_param { 1, 16, 4, 6, 16, 3, 3, 1, 1, 1, 1, 1, { 0, 0 }, { 0, 0 } },
+            conv2d_param { 1, 64, 28, 28, 64, 3, 3, 1, 1, 1, 1, 1, { 0, 0 }, { 0, 0 } },
+            // im2col + gemm
+            conv2d_param { 1, 8, 15, 15, 12, 3, 3, 1, 2, 2, 1, 1, { 1, 1 }, { 1, 1 } },
+            conv2d_param { 1, 12, 14, 10, 24, 3, 3, 3, 1, 1, 1, 1, { 1, 1 }, { 1, 1 } },
+            conv2d_param { 2, 16, 12, 12, 16, 3, 3, 1, 1, 1, 2, 2, { 2, 2 }, { 2, 2 } },
+            conv2d_param { 1, 24, 9, 7, 40, 1, 1, 1, 1, 1, 1, 1, { 0, 0 }, { 0, 0 } },
+            conv2d_param { 1, 24, 9, 7, 40, 1, 1, 1, 2, 2, 1, 1, { 0, 0 }, { 0, 0 } },
+            conv2d_param { 1, 5, 20, 18, 7, 5, 3, 1, 1, 2, 1, 3, { 2, 1 }, { 0, 3 } },
+            conv2d_param { 1, 64, 28, 28, 64, 3, 3, 1, 2, 2, 1, 1, { 1, 1 }, { 1, 1 } },
+            // direct
+            conv2d_param { 1, 1, 10, 10, 8, 3, 3, 1, 1, 1, 1, 1, { 0, 0 }, { 0, 0 } },
+            conv2d_param { 1, 8, 10, 10, 8, 3, 3, 8, 2, 2, 1, 1, { 0, 0 }, { 0, 0 } }),
+        testing::Values(
+            value_range<float>::full(),
+            value_range<float> { 0.f, 6.f })));
+
+TEST_P(Conv2DTest, normal)
+{
+    ASSERT_TRUE(conv2d(output_ref, OpType::Ref).is_ok());
+    ASSERT_TRUE(conv2d(output_opt, OpType::Opt).is_ok());
+
+    const auto k = w_shape[1] * w_shape[2] * w_shape[3];
+    for (size_t i = 0; i < output_ref.size(); i++)
+        ASSERT_NEAR(output_ref[i], output_opt[i], 1e-5f * (k + 1)) << "at " << i;
+}
+
+TEST_P(Conv2DTest, constant_weights)
+{
+    // Weights inside the context's constants are transformed once and reused by later calls.
+    auto context = default_kernel_context();
+    context.constants_begin = weights.data();
+    context.constants_end = weights.data() + weights.size();
+    context.weights = make_weights_cache();
+
+    ASSERT_TRUE(conv2d(output_ref, OpType::Ref).is_ok());
+    const auto k = w_shape[1] * w_shape[2] * w_shape[3];
+    for (size_t run = 0; run < 2; run++)
+    {
+        std::fill(output_opt.begin(), output_opt.end(), 1.f);
+        ASSERT_TRUE(conv2d(output_opt, OpType::Opt, context).is_ok());
+        for (size_t i = 0; i < output_ref.size(); i++)
+            ASSERT_NEAR(output_ref[i], output_opt[i], 1e-5f * (k + 1)) << "run " << run << " at " << i;
+    }
+}
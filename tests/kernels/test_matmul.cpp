@@ -0,0 +1,122 @@
+/* Copyright 2019-2021 Canaan Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "test_util.h"
+#include <gtest/gtest.h>
+#include <nncase/kernels/cpu/optimized/tensor_compute.h>
+#include <nncase/kernels/cpu/reference/tensor_compute.h>
+#include <nncase/runtime/runtime_tensor.h>
+
+void matmul(const std::vector<float> &a, const std::vector<float> &b, const std::vector<float> &bias, std::vector<float> &output,
+    const runtime_shape_t &a_shape, const runtime_shape_t &b_shape, const runtime_shape_t &out_shape,
+    value_range<float> fused_activation, OpType type)
+{
+    auto a_strides = get_default_strides(a_shape);
+    auto b_strides = get_default_strides(b_shape);
+    auto out_strides = get_default_strides(out_shape);
+    if (type == OpType::Ref)
+    {
+        NNCASE_UNUSED auto res = cpu::reference::matmul(a.data(), b.data(), bias.data(), output.data(),
+            a_shape, a_strides, b_shape, b_strides, out_shape, out_strides, fused_activation);
+    }
+    else if (type == OpType::Opt)
+    {
+        NNCASE_UNUSED auto res = cpu::optimized::matmul(a.data(), b.data(), bias.data(), output.data(),
+            a_shape, a_strides, b_shape, b_strides, out_shape, out_strides, fused_activation);
+    }
+    else
+    {
+        assert(false);
+    }
+}
+
+class MatMulTest : public ::testing::TestWithParam<
+                       std::tuple<
+                           size_t, size_t, // batch a, batch b
+                           size_t, size_t, size_t, // M, K, N
+                           value_range<float>>> // fused activation
+{
+public:
+    void SetUp() override
+    {
+        auto &&[batch_a, batch_b, m, k, n, act] = GetParam();
+
+        a_shape = batch_a == 0 ? runtime_shape_t { m, k } : runtime_shape_t { batch_a, m, k };
+        b_shape = batch_b == 0 ? runtime_shape_t { k, n } : runtime_shape_t { batch_b, k, n };
+        const auto batch_out = std::max(batch_a, batch_b);
+        out_shape = batch_out == 0 ? runtime_shape_t { m, n } : runtime_shape_t { batch_out, m, n };
+        fused_activation = act;
+
+        a.resize(kernels::detail::compute_size(a_shape));
+        b.resize(kernels::detail::compute_size(b_shape));
+        bias.resize(n);
+        init_float_data(a);
+        init_float_data(b);
+        init_float_data(bias);
+        output_ref.assign(kernels::detail::compute_size(out_shape), 0.f);
+        output_opt.assign(kernels::detail::compute_size(out_shape), 1.f);
+    }
+
+    runtime_shape_t a_shape, b_shape, out_shape;
+    value_range<float> fused_activation;
+    std::vector<float> a, b, bias, output_ref, output_opt;
+};
+
+INSTANTIATE_TEST_SUITE_P(
+    MatMulTestSizes,
+    MatMulTest,
+    testing::Combine(
+        testing::Values(0), // batch a
+        testing::Values(0), // batch b
+        testing::Values(1, 5, 6, 13, 97), // M
+        testing::Values(0, 1, 7, 64, 300), // K
+        testing::Values(1, 15, 16, 33, 70, 2100), // N
+        testing::Values(
+            value_range<float>::full(),
+            value_range<float> { 0.f, 6.f })));
+
+INSTANTIATE_TEST_SUITE_P(
+    MatMulTestBatch,
+    MatMulTest,
+    testing::Combine(
+        testing::Values(0, 1, 3), // batch a
+        testing::Values(0, 1, 3), // batch b
+        testing::Values(7, 24), // M
+        testing::Values(31), // K
+        testing::Values(17, 48), // N
+        testing::Values(value_range<float> { -0.5f, 0.5f })));
+
+TEST_P(MatMulTest, normal)
+{
+    matmul(a, b, bias, output_ref, a_shape, b_shape, out_shape, fused_activation, OpType::Ref);
+    matmul(a, b, bias, output_opt, a_shape, b_shape, out_shape, fused_activation, OpType::Opt);
+
+    const auto k = a_shape.back();
+    for (size_t i = 0; i < output_ref.size(); i++)
+        ASSERT_NEAR(output_ref[i], output_opt[i], 1e-5f * (k + 1)) << "at " << i;
+}
+
+TEST(MatMulEmptyTest, empty_m_threads)
+{
+    // An empty batch leaves no row blocks to hand out to the threads.
+    auto context = default_kernel_context();
+    context.num_threads = 4;
+    const runtime_shape_t a_shape { 0, 4 }, b_shape { 4, 8 }, out_shape { 0, 8 };
+    std::vector<float> a, b(32), bias(8), output;
+    init_float_data(b);
+    init_float_data(bias);
+    EXPECT_TRUE(cpu::optimized::matmul(a.data(), b.data(), bias.data(), output.data(), a_shape, get_default_strides(a_shape),
+        b_shape, get_default_strides(b_shape), out_shape, get_default_strides(out_shape), value_range<float>::full(), context)
+                    .is_ok());
+}
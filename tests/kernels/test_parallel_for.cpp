@@ -0,0 +1,192 @@
+/* Copyright 2019-2021 Canaan Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "test_util.h"
+#include <atomic>
+#include <gtest/gtest.h>
+#include <nncase/kernels/cpu/reference/tensor_compute.h>
+#include <nncase/kernels/tensor_compute.h>
+
+namespace
+{
+kernel_context make_context(uint32_t num_threads)
+{
+    kernel_context context {};
+    context.num_threads = num_threads;
+    return context;
+}
+
+std::vector<float> make_float_data(size_t size)
+{
+    std::vector<float> data(size);
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<float> dis(-1.0f, 1.0f);
+    for (auto &v : data)
+        v = dis(gen);
+    return data;
+}
+}
+
+class ParallelForTest : public ::testing::TestWithParam<std::tuple<uint32_t, size_t, size_t>> // threads, count, grain
+{
+};
+
+INSTANTIATE_TEST_SUITE_P(
+    ParallelFor,
+    ParallelForTest,
+    testing::Combine(
+        testing::Values(1, 2, 4, 7), // threads
+        testing::Values(0, 1, 5, 64, 1000), // count
+        testing::Values(1, 3, 64))); // grain
+
+TEST_P(ParallelForTest, covers_each_index_once)
+{
+    auto &&[threads, count, grain] = GetParam();
+    auto context = make_context(threads);
+    std::vector<std::atomic<int>> hits(count);
+    for (auto &h : hits)
+        h = 0;
+
+    // Run twice so the second call reuses the shared pool.
+    for (int round = 0; round < 2; round++)
+    {
+        parallel_for(context, count, grain, [&](size_t begin, size_t end) {
+            EXPECT_LE(begin, end);
+            EXPECT_LE(end, count);
+            EXPECT_TRUE(end - begin >= grain || end == count);
+            for (size_t i = begin; i < end; i++)
+                hits[i]++;
+        });
+    }
+
+    for (size_t i = 0; i < count; i++)
+        ASSERT_EQ(2, hits[i].load()) << "at " << i;
+}
+
+TEST(ParallelForTest, nested_runs_inline)
+{
+    auto context = make_context(4);
+    std::atomic<size_t> total { 0 };
+    parallel_for(context, 16, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++)
+        {
+            parallel_for(context, 8, [&](size_t inner_begin, size_t inner_end) {
+                EXPECT_EQ(0u, inner_begin);
+                EXPECT_EQ(8u, inner_end);
+                total += inner_end - inner_begin;
+            });
+        }
+    });
+
+    EXPECT_EQ(16u * 8u, total.load());
+}
+
+TEST(ParallelForTest, first_error_is_returned)
+{
+    auto context = make_context(4);
+    auto ret = try_parallel_for(context, 100, 1, [&](size_t begin, size_t) -> result<void> {
+        if (begin == 42)
+            return err(std::errc::invalid_argument);
+        return ok();
+    });
+
+    ASSERT_TRUE(ret.is_err());
+    EXPECT_EQ(std::errc::invalid_argument, ret.unwrap_err());
+}
+
+TEST(ParallelKernelTest, matches_reference)
+{
+    auto context = make_context(4);
+    const runtime_shape_t shape { 3, 17, 9, 40 };
+    const auto strides = get_default_strides(shape);
+    const auto size = compute_size(shape);
+    const auto a = make_float_data(size);
+    const auto b = make_float_data(size);
+    std::vector<float> expected(size), actual(size);
+
+    // binary
+    ASSERT_TRUE(cpu::reference::binary(binary_add, a.data(), b.data(), expected.data(), shape, strides, shape, strides, shape, strides,
+        value_range<float>::full(), context)
+                    .is_ok());
+    ASSERT_TRUE(kernels::binary(binary_add, a.data(), b.data(), actual.data(), shape, strides, shape, strides, shape, strides,
+        value_range<float>::full(), context)
+                    .is_ok());
+    EXPECT_EQ(expected, actual);
+
+    // unary
+    ASSERT_TRUE(cpu::reference::unary(unary_abs, a.data(), expected.data(), shape, strides, strides, context).is_ok());
+    ASSERT_TRUE(kernels::unary(unary_abs, a.data(), actual.data(), shape, strides, strides, context).is_ok());
+    EXPECT_EQ(expected, actual);
+
+    // transpose
+    const runtime_shape_t perm { 2, 0, 3, 1 };
+    const runtime_shape_t transposed { shape[2], shape[0], shape[3], shape[1] };
+    const auto transposed_strides = get_default_strides(transposed);
+    ASSERT_TRUE(cpu::reference::transpose(dt_float32, reinterpret_cast<const gsl::byte *>(a.data()), reinterpret_cast<gsl::byte *>(expected.data()),
+        shape, perm, strides, transposed_strides, context)
+                    .is_ok());
+    ASSERT_TRUE(kernels::transpose(dt_float32, reinterpret_cast<const gsl::byte *>(a.data()), reinterpret_cast<gsl::byte *>(actual.data()),
+        shape, perm, strides, transposed_strides, context)
+                    .is_ok());
+    EXPECT_EQ(expected, actual);
+
+    // reduce over axes 0 and 2, dropping them
+    const runtime_shape_t axis { 0, 2 };
+    const runtime_shape_t reduced { shape[1], shape[3] };
+    const auto reduced_strides = get_default_strides(reduced);
+    std::vector<float> expected_reduced(compute_size(reduced)), actual_reduced(compute_size(reduced));
+    ASSERT_TRUE(cpu::reference::reduce(reduce_sum, 0.f, a.data(), expected_reduced.data(), shape, axis, strides, reduced_strides, false, context).is_ok());
+    ASSERT_TRUE(kernels::reduce(reduce_sum, 0.f, a.data(), actual_reduced.data(), shape, axis, strides, reduced_strides, false, context).is_ok());
+    EXPECT_EQ(expected_reduced, actual_reduced);
+
+    // pad the last two axes
+    runtime_paddings_t paddings(4, padding::zero());
+    paddings[2] = { 1, 2 };
+    paddings[3] = { 3, 0 };
+    const runtime_shape_t padded { shape[0], shape[1], shape[2] + 3, shape[3] + 3 };
+    const auto padded_strides = get_default_strides(padded);
+    std::vector<float> expected_padded(compute_size(padded)), actual_padded(compute_size(padded));
+    for (auto mode : { pad_constant, pad_reflect, pad_edge })
+    {
+        ASSERT_TRUE(cpu::reference::pad(dt_float32, reinterpret_cast<const gsl::byte *>(a.data()), reinterpret_cast<gsl::byte *>(expected_padded.data()),
+            shape, strides, padded_strides, paddings, mode, 1.5f, context)
+                        .is_ok());
+        ASSERT_TRUE(kernels::pad(dt_float32, reinterpret_cast<const gsl::byte *>(a.data()), reinterpret_cast<gsl::byte *>(actual_padded.data()),
+            shape, strides, padded_strides, paddings, mode, 1.5f, context)
+                        .is_ok());
+        EXPECT_EQ(expected_padded, actual_padded);
+    }
+
+    // matmul, batched over the two outer axes
+    const runtime_shape_t a_shape { 51, 9, 40 }, b_shape { 40, 70 }, out_shape { 51, 9, 70 };
+    const auto bias = make_float_data(70);
+    std::vector<float> expected_mm(compute_size(out_shape)), actual_mm(compute_size(out_shape));
+    ASSERT_TRUE(cpu::reference::matmul(a.data(), b.data(), bias.data(), expected_mm.data(), a_shape, get_default_strides(a_shape),
+        b_shape, get_default_strides(b_shape), out_shape, get_default_strides(out_shape), value_range<float>::full())
+                    .is_ok());
+    ASSERT_TRUE(kernels::matmul(a.data(), b.data(), bias.data(), actual_mm.data(), a_shape, get_default_strides(a_shape),
+        b_shape, get_default_strides(b_shape), out_shape, get_default_strides(out_shape), value_range<float>::full(), context)
+                    .is_ok());
+    for (size_t i = 0; i < expected_mm.size(); i++)
+        ASSERT_NEAR(expected_mm[i], actual_mm[i], 1e-4f) << "at " << i;
+}
+
+TEST(SharedThreadPoolTest, same_size_shares_workers)
+{
+    // Builds without a thread pool return nullptr for every size.
+    auto pool = shared_thread_pool(3);
+    EXPECT_EQ(pool, shared_thread_pool(3));
+    if (pool)
+        EXPECT_NE(pool, shared_thread_pool(2));
+}
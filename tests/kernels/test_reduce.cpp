@@ -0,0 +1,156 @@
+/* Copyright 2019-2021 Canaan Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "test_util.h"
+#include <gtest/gtest.h>
+#include <nncase/kernels/cpu/optimized/tensor_compute.h>
+#include <nncase/kernels/cpu/reference/tensor_compute.h>
+#include <nncase/runtime/runtime_tensor.h>
+
+class ReduceTest : public ::testing::TestWithParam<
+                       std::tuple<
+                           std::pair<runtime_shape_t, runtime_shape_t>, // input shape, axes
+                           bool>> // keep dims
+{
+public:
+    void SetUp() override
+    {
+        auto &&[shape_axes, keep] = GetParam();
+        in_shape = shape_axes.first;
+        axes = shape_axes.second;
+        keep_dims = keep;
+        out_shape = kernels::detail::get_reduced_shape(in_shape, axes, keep_dims);
+        in_strides = get_default_strides(in_shape);
+        out_strides = get_default_strides(out_shape);
+    }
+
+    // Small integers give exact int32 results and ties for the arg reductions
+    template <class T>
+    std::vector<T> make_input(int low, int high)
+    {
+        std::mt19937 gen(42);
+        std::uniform_int_distribution<int> dis(low, high);
+        std::vector<T> input(kernels::detail::compute_size(in_shape));
+        for (auto &v : input)
+            v = (T)dis(gen);
+        return input;
+    }
+
+    runtime_shape_t in_shape, axes, out_shape, in_strides, out_strides;
+    bool keep_dims;
+};
+
+INSTANTIATE_TEST_SUITE_P(
+    ReduceTestAxes,
+    ReduceTest,
+    testing::Combine(
+        testing::Values(
+            std::make_pair(runtime_shape_t { 1, 16, 14, 14 }, runtime_shape_t { 2, 3 }), // global pool, NCHW
+            std::make_pair(runtime_shape_t { 1, 14, 14, 70 }, runtime_shape_t { 1, 2 }), // global pool, NHWC
+            std::make_pair(runtime_shape_t { 3, 1000 }, runtime_shape_t { 1 }), // long rows
+            std::make_pair(runtime_shape_t { 2, 300, 5 }, runtime_shape_t { 1 }), // middle axis
+            std::make_pair(runtime_shape_t { 4, 3, 5, 7 }, runtime_shape_t { 0, 2 }), // split axes
+            std::make_pair(runtime_shape_t { 4, 3, 5, 7 }, runtime_shape_t { 1, 3 }), // split axes, inner
+            std::make_pair(runtime_shape_t { 5, 1, 9 }, runtime_shape_t { 0, 1, 2 }), // all axes
+            std::make_pair(runtime_shape_t { 6, 1, 8 }, runtime_shape_t { 1 })), // unit axis
+        testing::Bool()));
+
+TEST_P(ReduceTest, float32)
+{
+    const auto input = make_input<float>(-50, 50);
+    const auto out_size = kernels::detail::compute_size(out_shape);
+    for (auto op : { reduce_mean, reduce_sum, reduce_min, reduce_max })
+    {
+        std::vector<float> output_ref(out_size, 0.f), output_opt(out_size, 1.f);
+        NNCASE_UNUSED auto res = cpu::reference::reduce(op, 0.5f, input.data(), output_ref.data(), in_shape, axes, in_strides, out_strides, keep_dims, default_kernel_context());
+        res = cpu::optimized::reduce(op, 0.5f, input.data(), output_opt.data(), in_shape, axes, in_strides, out_strides, keep_dims, default_kernel_context());
+        for (size_t i = 0; i < out_size; i++)
+            ASSERT_NEAR(output_ref[i], output_opt[i], 1e-5f * std::max(1.f, std::fabs(output_ref[i]))) << "op " << op << " at " << i;
+    }
+}
+
+TEST_P(ReduceTest, int32)
+{
+    const auto input = make_input<int32_t>(-50, 50);
+    const auto out_size = kernels::detail::compute_size(out_shape);
+    for (auto op : { reduce_mean, reduce_sum, reduce_min, reduce_max })
+    {
+        std::vector<int32_t> output_ref(out_size, 0), output_opt(out_size, 1);
+        NNCASE_UNUSED auto res = cpu::reference::reduce(op, 3, input.data(), output_ref.data(), in_shape, axes, in_strides, out_strides, keep_dims, default_kernel_context());
+        res = cpu::optimized::reduce(op, 3, input.data(), output_opt.data(), in_shape, axes, in_strides, out_strides, keep_dims, default_kernel_context());
+        for (size_t i = 0; i < out_size; i++)
+            ASSERT_EQ(output_ref[i], output_opt[i]) << "op " << op << " at " << i;
+    }
+}
+
+TEST_P(ReduceTest, prod)
+{
+    // Values around 1 keep long products finite
+    auto input = make_input<float>(900, 1100);
+    for (auto &v : input)
+        v /= 1000.f;
+    const auto out_size = kernels::detail::compute_size(out_shape);
+    std::vector<float> output_ref(out_size, 0.f), output_opt(out_size, 1.f);
+    NNCASE_UNUSED auto res = cpu::reference::reduce_prod(input.data(), output_ref.data(), in_shape, in_strides, out_strides, axes, keep_dims);
+    res = cpu::optimized::reduce_prod(input.data(), output_opt.data(), in_shape, in_strides, out_strides, axes, keep_dims, default_kernel_context());
+    for (size_t i = 0; i < out_size; i++)
+        ASSERT_NEAR(output_ref[i], output_opt[i], 1e-4f * std::fabs(output_ref[i])) << "at " << i;
+}
+
+TEST_P(ReduceTest, arg)
+{
+    if (axes.size() != 1)
+        GTEST_SKIP() << "reduce_arg takes a single axis";
+
+    const auto input = make_input<float>(-5, 5);
+    const auto out_size = kernels::detail::compute_size(out_shape);
+    for (auto op : { reduce_arg_min, reduce_arg_max })
+    {
+        for (auto select_last_idx : { false, true })
+        {
+            std::vector<int64_t> output_ref(out_size, 0), output_opt(out_size, 1);
+            NNCASE_UNUSED auto res = cpu::reference::reduce_arg(op, input.data(), output_ref.data(), in_shape, in_strides, out_strides,
+                axes, keep_dims, select_last_idx, default_kernel_context());
+            res = cpu::optimized::reduce_arg(op, input.data(), output_opt.data(), in_shape, in_strides, out_strides,
+                axes, keep_dims, select_last_idx);
+            for (size_t i = 0; i < out_size; i++)
+                ASSERT_EQ(output_ref[i], output_opt[i]) << "op " << op << " at " << i;
+        }
+    }
+}
+
+TEST(ReduceAccuracyTest, float32_long_row)
+{
+    // A running float sum of this row is off by about 1e-5 relative, the pairwise sum by about 3e-8.
+    const runtime_shape_t in_shape { 1, 1000000 }, axes { 1 }, out_shape { 1 };
+    std::mt19937 gen(1);
+    std::uniform_real_distribution<float> dis(0.f, 1.f);
+    std::vector<float> input(in_shape[1]);
+    double expected = 0;
+    for (auto &v : input)
+    {
+        v = dis(gen);
+        expected += v;
+    }
+
+    for (auto op : { reduce_sum, reduce_mean })
+    {
+        const auto exact = op == reduce_mean ? expected / input.size() : expected;
+        float output = 0.f;
+        ASSERT_TRUE(cpu::optimized::reduce(op, 0.f, input.data(), &output, in_shape, axes, get_default_strides(in_shape),
+            get_default_strides(out_shape), false, default_kernel_context())
+                        .is_ok());
+        EXPECT_NEAR(exact, output, 1e-6 * exact) << "op " << op;
+    }
+}
@@ -0,0 +1,98 @@
+/* Copyright 2019-2021 Canaan Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "test_util.h"
+#include <gtest/gtest.h>
+#include <nncase/kernels/cpu/optimized/tensor_compute.h>
+#include <nncase/kernels/cpu/reference/reduce_window.h>
+#include <nncase/runtime/runtime_tensor.h>
+
+struct window_params
+{
+    int32_t filter_h, filter_w, stride_h, stride_w;
+    padding padding_h, padding_w;
+};
+
+class ReduceWindowTest : public ::testing::TestWithParam<
+                             std::tuple<
+                                 runtime_shape_t, // input shape
+                                 window_params,
+                                 reduce_op_t>>
+{
+public:
+    void SetUp() override
+    {
+        auto &&[shape, params, reduce_op] = GetParam();
+        in_shape = shape;
+        window = params;
+        op = reduce_op;
+
+        // Global windows cover the whole input
+        if (window.filter_h == 0)
+        {
+            window.filter_h = (int32_t)in_shape[2];
+            window.filter_w = (int32_t)in_shape[3];
+        }
+
+        out_shape = { in_shape[0], in_shape[1],
+            kernels::detail::get_windowed_output_size(in_shape[2], window.filter_h, window.stride_h, 1, window.padding_h),
+            kernels::detail::get_windowed_output_size(in_shape[3], window.filter_w, window.stride_w, 1, window.padding_w) };
+
+        std::mt19937 gen(42);
+        std::uniform_real_distribution<float> dis(-10.f, 10.f);
+        input.resize(kernels::detail::compute_size(in_shape));
+        for (auto &v : input)
+            v = dis(gen);
+        output_ref.assign(kernels::detail::compute_size(out_shape), 0.f);
+        output_opt.assign(output_ref.size(), 1.f);
+    }
+
+    runtime_shape_t in_shape, out_shape;
+    window_params window;
+    reduce_op_t op;
+    std::vector<float> input, output_ref, output_opt;
+};
+
+INSTANTIATE_TEST_SUITE_P(
+    ReduceWindowTestWindows,
+    ReduceWindowTest,
+    testing::Combine(
+        testing::Values(
+            runtime_shape_t { 1, 3, 56, 56 },
+            runtime_shape_t { 2, 4, 17, 23 },
+            runtime_shape_t { 1, 2, 3, 40 }),
+        testing::Values(
+            window_params { 2, 2, 2, 2, { 0, 0 }, { 0, 0 } },
+            window_params { 3, 3, 1, 1, { 1, 1 }, { 1, 1 } },
+            window_params { 3, 3, 2, 2, { 1, 1 }, { 1, 1 } },
+            window_params { 3, 3, 2, 2, { 0, 1 }, { 0, 1 } },
+            window_params { 5, 4, 3, 2, { 2, 1 }, { 1, 2 } },
+            window_params { 0, 0, 1, 1, { 0, 0 }, { 0, 0 } }), // global
+        testing::Values(reduce_mean, reduce_sum, reduce_min, reduce_max)));
+
+TEST_P(ReduceWindowTest, normal)
+{
+    const auto in_strides = get_default_strides(in_shape);
+    const auto out_strides = get_default_strides(out_shape);
+    const auto init_value = op == reduce_max ? -5.f : op == reduce_min ? 5.f : 0.5f;
+    const value_range<float> activation { -20.f, 30.f };
+    NNCASE_UNUSED auto res = cpu::reference::reduce_window2d(op, input.data(), init_value, output_ref.data(), in_shape, in_strides, out_strides,
+        window.padding_h, window.padding_w, window.filter_h, window.filter_w, window.stride_h, window.stride_w, 1, 1, activation, default_kernel_context());
+    ASSERT_TRUE(cpu::optimized::reduce_window2d(op, input.data(), init_value, output_opt.data(), in_shape, in_strides, out_strides,
+        window.padding_h, window.padding_w, window.filter_h, window.filter_w, window.stride_h, window.stride_w, 1, 1, activation)
+                    .is_ok());
+
+    for (size_t i = 0; i < output_ref.size(); i++)
+        ASSERT_NEAR(output_ref[i], output_opt[i], 1e-5f * std::max(1.f, std::fabs(output_ref[i]))) << "at " << i;
+}
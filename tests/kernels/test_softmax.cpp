@@ -0,0 +1,70 @@
+/* Copyright 2019-2021 Canaan Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "test_util.h"
+#include <gtest/gtest.h>
+#include <nncase/kernels/cpu/optimized/tensor_compute.h>
+#include <nncase/kernels/cpu/reference/tensor_compute.h>
+#include <nncase/runtime/runtime_tensor.h>
+
+class SoftmaxTest : public ::testing::TestWithParam<
+                        std::tuple<
+                            runtime_shape_t, // input shape
+                            int32_t, // axis
+                            float>> // beta
+{
+public:
+    void SetUp() override
+    {
+        auto &&[shape, softmax_axis, softmax_beta] = GetParam();
+        in_shape = shape;
+        axis = softmax_axis;
+        beta = softmax_beta;
+
+        std::mt19937 gen(42);
+        std::uniform_real_distribution<float> dis(-20.f, 20.f);
+        input.resize(kernels::detail::compute_size(in_shape));
+        for (auto &v : input)
+            v = dis(gen);
+        output_ref.assign(input.size(), 0.f);
+        output_opt.assign(input.size(), 1.f);
+    }
+
+    runtime_shape_t in_shape;
+    int32_t axis;
+    float beta;
+    std::vector<float> input, output_ref, output_opt;
+};
+
+INSTANTIATE_TEST_SUITE_P(
+    SoftmaxTestAxes,
+    SoftmaxTest,
+    testing::Combine(
+        testing::Values(
+            runtime_shape_t { 1, 1000 },
+            runtime_shape_t { 3, 5, 7 },
+            runtime_shape_t { 2, 37, 19 },
+            runtime_shape_t { 1, 16, 12, 40 }),
+        testing::Values(-1, 0, 1),
+        testing::Values(1.f, 0.5f)));
+
+TEST_P(SoftmaxTest, normal)
+{
+    const auto strides = get_default_strides(in_shape);
+    NNCASE_UNUSED auto res = cpu::reference::softmax(input.data(), output_ref.data(), in_shape, strides, strides, axis, beta);
+    res = cpu::optimized::softmax(input.data(), output_opt.data(), in_shape, strides, strides, axis, beta);
+
+    for (size_t i = 0; i < output_ref.size(); i++)
+        ASSERT_NEAR(output_ref[i], output_opt[i], 1e-6f) << "at " << i;
+}
@@ -0,0 +1,109 @@
+/* Copyright 2019-2021 Canaan Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "test_util.h"
+#include <gtest/gtest.h>
+#include <nncase/kernels/cpu/optimized/tensor_compute.h>
+#include <nncase/kernels/cpu/reference/tensor_compute.h>
+#include <nncase/runtime/runtime_tensor.h>
+
+class TransposeTest : public ::testing::TestWithParam<
+                          std::tuple<
+                              std::pair<runtime_shape_t, runtime_shape_t>, // input shape, perm
+                              datatype_t>>
+{
+public:
+    void SetUp() override
+    {
+        auto &&[shape_perm, datatype] = GetParam();
+        in_shape = shape_perm.first;
+        perm = shape_perm.second;
+        type = datatype;
+        out_shape.resize(in_shape.size());
+        for (size_t i = 0; i < in_shape.size(); i++)
+            out_shape[i] = in_shape[perm[i]];
+
+        const auto bytes = kernels::detail::compute_size(in_shape) * runtime::get_bytes(type);
+        std::mt19937 gen(42);
+        std::uniform_int_distribution<int> dis(0, 255);
+        input.resize(bytes);
+        for (auto &v : input)
+            v = static_cast<uint8_t>(dis(gen));
+        output_ref.assign(bytes, 0);
+        output_opt.assign(bytes, 1);
+    }
+
+    runtime_shape_t in_shape, perm, out_shape;
+    datatype_t type;
+    std::vector<uint8_t> input, output_ref, output_opt;
+};
+
+INSTANTIATE_TEST_SUITE_P(
+    TransposeTestPerms,
+    TransposeTest,
+    testing::Combine(
+        testing::Values(
+            std::make_pair(runtime_shape_t { 37, 53 }, runtime_shape_t { 1, 0 }), // ragged 2-D
+            std::make_pair(runtime_shape_t { 64, 48 }, runtime_shape_t { 1, 0 }), // whole tiles
+            std::make_pair(runtime_shape_t { 130, 70 }, runtime_shape_t { 1, 0 }), // several stripes, ragged tiles
+            std::make_pair(runtime_shape_t { 2, 70, 130 }, runtime_shape_t { 0, 2, 1 }), // batched stripes
+            std::make_pair(runtime_shape_t { 2, 24, 13, 11 }, runtime_shape_t { 0, 2, 3, 1 }), // NCHW to NHWC
+            std::make_pair(runtime_shape_t { 2, 13, 11, 24 }, runtime_shape_t { 0, 3, 1, 2 }), // NHWC to NCHW
+            std::make_pair(runtime_shape_t { 3, 4, 5, 6 }, runtime_shape_t { 2, 0, 3, 1 }), // mixed
+            std::make_pair(runtime_shape_t { 4, 5, 6, 7 }, runtime_shape_t { 1, 0, 2, 3 }), // inner axes kept
+            std::make_pair(runtime_shape_t { 1, 17, 1, 70 }, runtime_shape_t { 2, 3, 0, 1 }), // unit axes
+            std::make_pair(runtime_shape_t { 3, 4, 5 }, runtime_shape_t { 0, 1, 2 }), // identity
+            std::make_pair(runtime_shape_t { 1, 1 }, runtime_shape_t { 1, 0 })), // single element
+        testing::Values(dt_uint8, dt_float16, dt_float32, dt_int64)));
+
+TEST_P(TransposeTest, contiguous)
+{
+    const auto in_strides = get_default_strides(in_shape);
+    const auto out_strides = get_default_strides(out_shape);
+    auto &context = default_kernel_context();
+    ASSERT_TRUE(cpu::reference::transpose(type, reinterpret_cast<const gsl::byte *>(input.data()),
+        reinterpret_cast<gsl::byte *>(output_ref.data()), in_shape, perm, in_strides, out_strides, context)
+                    .is_ok());
+    ASSERT_TRUE(cpu::optimized::transpose(type, reinterpret_cast<const gsl::byte *>(input.data()),
+        reinterpret_cast<gsl::byte *>(output_opt.data()), in_shape, perm, in_strides, out_strides, context)
+                    .is_ok());
+
+    for (size_t i = 0; i < output_ref.size(); i++)
+        ASSERT_EQ(output_ref[i], output_opt[i]) << "at byte " << i;
+}
+
+TEST_P(TransposeTest, strided_input)
+{
+    // The input is a view of a buffer whose rows are 3 elements longer than the shape.
+    auto padded_shape = in_shape;
+    padded_shape.back() += 3;
+    const auto in_strides = get_default_strides(padded_shape);
+    const auto out_strides = get_default_strides(out_shape);
+    input.resize(kernels::detail::compute_size(padded_shape) * runtime::get_bytes(type));
+    std::mt19937 gen(7);
+    std::uniform_int_distribution<int> dis(0, 255);
+    for (auto &v : input)
+        v = static_cast<uint8_t>(dis(gen));
+
+    auto &context = default_kernel_context();
+    ASSERT_TRUE(cpu::reference::transpose(type, reinterpret_cast<const gsl::byte *>(input.data()),
+        reinterpret_cast<gsl::byte *>(output_ref.data()), in_shape, perm, in_strides, out_strides, context)
+                    .is_ok());
+    ASSERT_TRUE(cpu::optimized::transpose(type, reinterpret_cast<const gsl::byte *>(input.data()),
+        reinterpret_cast<gsl::byte *>(output_opt.data()), in_shape, perm, in_strides, out_strides, context)
+                    .is_ok());
+
+    for (size_t i = 0; i < output_ref.size(); i++)
+        ASSERT_EQ(output_ref[i], output_opt[i]) << "at byte " << i;
+}
@@ -0,0 +1,108 @@
+/* Copyright 2019-2021 Canaan Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "test_util.h"
+#include <gtest/gtest.h>
+#include <nncase/kernels/cpu/optimized/tensor_compute.h>
+#include <nncase/kernels/cpu/reference/tensor_compute.h>
+#include <nncase/runtime/runtime_tensor.h>
+
+// Inputs cover the op's domain, plus values that take the special paths
+void init_unary_data(std::vector<float> &data, float min, float max)
+{
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<float> dis(min, max);
+    for (auto &v : data)
+        v = dis(gen);
+
+    const float specials[] = { 0.f, -0.f, 1e-40f, -1e-40f, 100.f, -100.f, 20000.f, -1e6f, INFINITY, -INFINITY, NAN };
+    for (size_t i = 0; i < std::size(specials) && i < data.size(); i++)
+        data[data.size() - 1 - i] = specials[i];
+}
+
+// Relative error allowed by the vector math, against libm
+void expect_close(const std::vector<float> &expected, const std::vector<float> &actual, const std::vector<float> &input)
+{
+    for (size_t i = 0; i < expected.size(); i++)
+    {
+        if (std::isnan(expected[i]))
+            ASSERT_TRUE(std::isnan(actual[i])) << "at " << i << ", input " << input[i];
+        else if (std::isinf(expected[i]))
+            ASSERT_EQ(expected[i], actual[i]) << "at " << i << ", input " << input[i];
+        else
+            ASSERT_NEAR(expected[i], actual[i], 1e-6f * std::max(1.f, std::abs(expected[i]))) << "at " << i << ", input " << input[i];
+    }
+}
+
+class UnaryTest : public ::testing::TestWithParam<std::tuple<unary_op_t, size_t>>
+{
+public:
+    void SetUp() override
+    {
+        auto &&[unary_op, size] = GetParam();
+        op = unary_op;
+        shape = { size };
+        const bool positive = op == unary_log || op == unary_sqrt || op == unary_rsqrt;
+        input.resize(size);
+        init_unary_data(input, positive ? 1e-3f : -10.f, 10.f);
+        output_ref.assign(size, 0.f);
+        output_opt.assign(size, 1.f);
+    }
+
+    unary_op_t op;
+    runtime_shape_t shape;
+    std::vector<float> input, output_ref, output_opt;
+};
+
+INSTANTIATE_TEST_SUITE_P(
+    UnaryTestOps,
+    UnaryTest,
+    testing::Combine(
+        testing::Values(unary_abs, unary_ceil, unary_cos, unary_erf, unary_exp, unary_floor, unary_log, unary_neg, unary_round,
+            unary_rsqrt, unary_sign, unary_sin, unary_sqrt, unary_square, unary_tanh),
+        testing::Values(1, 7, 16, 45, 100000)));
+
+TEST_P(UnaryTest, normal)
+{
+    const auto strides = get_default_strides(shape);
+    NNCASE_UNUSED auto res = cpu::reference::unary(op, input.data(), output_ref.data(), shape, strides, strides, default_kernel_context());
+    res = cpu::optimized::unary(op, input.data(), output_opt.data(), shape, strides, strides, default_kernel_context());
+    expect_close(output_ref, output_opt, input);
+}
+
+TEST_P(UnaryTest, sigmoid)
+{
+    const auto strides = get_default_strides(shape);
+    NNCASE_UNUSED auto res = cpu::reference::sigmoid(input.data(), output_ref.data(), shape, strides, strides);
+    res = cpu::optimized::sigmoid(input.data(), output_opt.data(), shape, strides, strides);
+    expect_close(output_ref, output_opt, input);
+}
+
+TEST(UnaryExpTest, overflow_threshold)
+{
+    // e^0x1.62e42ep+6 is 3.40279852e38, e^0x1.62e43p+6 lies past FLT_MAX + ulp / 2 and rounds to inf.
+    const runtime_shape_t shape { 32 };
+    const auto strides = get_default_strides(shape);
+    std::vector<float> input(shape[0], 0x1.62e42ep+6f), output(shape[0]);
+    input[shape[0] / 2] = 0x1.62e43p+6f;
+    input.back() = 0x1.62e43p+6f;
+    ASSERT_TRUE(cpu::optimized::unary(unary_exp, input.data(), output.data(), shape, strides, strides, default_kernel_context()).is_ok());
+    for (size_t i = 0; i < output.size(); i++)
+    {
+        if (input[i] == 0x1.62e43p+6f)
+            EXPECT_EQ(INFINITY, output[i]) << "at " << i;
+        else
+            EXPECT_NEAR(3.40279852e38f, output[i], 2 * 2.03e31f) << "at " << i;
+    }
+}
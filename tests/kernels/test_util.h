@@ -77,6 +77,14 @@ uint32_t &get(runtime_tensor &t, const runtime_shape_t &index)
     return data[offset(t.strides(), index)];
 }
 
+void init_float_data(std::vector<float> &data)
+{
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<float> dis(-1.0f, 1.0f);
+    for (auto &v : data)
+        v = dis(gen);
+}
+
 void init_tensor_data(runtime_tensor &tensor)
 {
     std::random_device rd;
@@ -16,6 +16,7 @@ set(CMAKE_FIND_ROOT_PATH_MODE_LIBRARY ONLY)
 set(CMAKE_FIND_ROOT_PATH_MODE_INCLUDE ONLY)
 set(ENABLE_VULKAN_RUNTIME OFF)
 set(ENABLE_OPENMP OFF)
+set(ENABLE_THREAD_POOL OFF)
 set(ENABLE_VULKAN OFF)
 set(ENABLE_HALIDE OFF)
 set(BUILD_PYTHON_BINDING OFF)
@@ -138,6 +138,8 @@ namespace IsaGen
         BREAK,
 
         TENSOR,
+
+        LDSHAPE,
     }
 
     [BitLength(16)]
@@ -700,6 +702,22 @@ namespace IsaGen
         public byte Rank { get; set; }
     }
 
+    [DisplayName("LDSHAPE")]
+    [Category("Load Store Instructions")]
+    [Description("Load a shape from the module's shape table")]
+    public class LdShapeInstruction : Instruction
+    {
+        public override OpCode OpCode => OpCode.LDSHAPE;
+
+        [DisplayName("rshape")]
+        [Description("Shape register index")]
+        public byte Rshape { get; set; }
+
+        [DisplayName("index")]
+        [Description("Shape table index")]
+        public uint Index { get; set; }
+    }
+
     [DisplayName("DUP")]
     [Category("Stack Instructions")]
     [Description("Duplicate the top item of stack")]